@@ -10,6 +10,7 @@
 #include "Knowrob/SLKRMsgDispatcher.h"
 #include "Viz/SLVizStructs.h"
 #include "VizQ/SLVizQBase.h"
+#include "VizQ/SLVizQScheduler.h"
 #include "Runtime/SLLoggerStructs.h"
 #include "SLKnowrobManager.generated.h"
 
@@ -244,6 +245,13 @@ private:
 	UPROPERTY(EditAnywhere, Category = "Semantic Logger|VizQ")
 	bool bTriggerButtonHack;
 
+	// Fetch the data of the whole query tree concurrently in the background, then apply the scene changes in order
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger|VizQ")
+	bool bPipelineQueries = true;
+
+	// Pipelined execution of the query trees
+	TSharedPtr<FSLVizQScheduler, ESPMode::ThreadSafe> VizQScheduler;
+
 	// Current active query
 	int32 QueryIndex = INDEX_NONE;
 
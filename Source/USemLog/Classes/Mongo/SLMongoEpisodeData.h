@@ -0,0 +1,192 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Algo/BinarySearch.h"
+
+/*
+* Cheap to query episode metadata, used to check if locally cached data is still up to date
+*/
+struct FSLMongoEpisodeMetadata
+{
+	// Number of documents in the episode collection
+	int64 NumDocuments = INDEX_NONE;
+
+	// First timestamp of the episode
+	double StartTs = 0.0;
+
+	// Last timestamp of the episode
+	double EndTs = 0.0;
+
+	// Check if the metadata was read
+	bool IsValid() const { return NumDocuments >= 0; };
+
+	// Check if both metadata describe the same episode data
+	bool Matches(const FSLMongoEpisodeMetadata& Other) const
+	{
+		return IsValid() && NumDocuments == Other.NumDocuments && StartTs == Other.StartTs && EndTs == Other.EndTs;
+	};
+
+	// Serialization
+	friend FArchive& operator<<(FArchive& Ar, FSLMongoEpisodeMetadata& Metadata)
+	{
+		Ar << Metadata.NumDocuments;
+		Ar << Metadata.StartTs;
+		Ar << Metadata.EndTs;
+		return Ar;
+	};
+};
+
+/*
+* Columnar episode data, every individual has a dense index with a sparse column of its recorded samples,
+* (sorted frame indexes and the poses recorded in them), the frames in between keep the previous pose
+*/
+struct FSLMongoEpisodeData
+{
+	// Individual ids (array index is the dense individual index)
+	TArray<FString> IndividualIds;
+
+	// Individual id to its dense index
+	TMap<FString, int32> IdToIndex;
+
+	// Array of the timestamps (one per frame)
+	TArray<float> Timestamps;
+
+	// Per individual sorted indexes of the frames in which its pose was recorded
+	TArray<TArray<int32>> FrameIndexes;
+
+	// Per individual recorded poses (one entry per frame index)
+	TArray<TArray<FTransform>> Poses;
+
+	// Default ctor
+	FSLMongoEpisodeData() {};
+
+	// Reserve frame array size ctor
+	FSLMongoEpisodeData(int32 NumFramesToReserve)
+	{
+		Timestamps.Reserve(NumFramesToReserve);
+	};
+
+	// Number of frames
+	int32 NumFrames() const { return Timestamps.Num(); };
+
+	// Number of individuals
+	int32 NumIndividuals() const { return IndividualIds.Num(); };
+
+	// Number of recorded poses of the individual
+	int32 NumSamples(int32 IndividualIndex) const { return FrameIndexes[IndividualIndex].Num(); };
+
+	// Check if there is any data
+	bool IsEmpty() const { return Timestamps.Num() == 0; };
+
+	// Get the dense index of the individual, add it if it is new (with no recorded poses)
+	int32 FindOrAddIndividual(const FString& Id)
+	{
+		if (const int32* IndexPtr = IdToIndex.Find(Id))
+		{
+			return *IndexPtr;
+		}
+		const int32 Index = IndividualIds.Add(Id);
+		IdToIndex.Add(Id, Index);
+		FrameIndexes.AddDefaulted();
+		Poses.AddDefaulted();
+		return Index;
+	};
+
+	// Add a new frame (returns the frame index)
+	int32 AddFrame(float Ts)
+	{
+		return Timestamps.Add(Ts);
+	};
+
+	// Set the pose of the individual in the given frame (appending in frame order is constant time)
+	void SetPose(int32 IndividualIndex, int32 FrameIndex, const FTransform& Pose)
+	{
+		TArray<int32>& Frames = FrameIndexes[IndividualIndex];
+		if (Frames.Num() == 0 || Frames.Last() < FrameIndex)
+		{
+			Frames.Add(FrameIndex);
+			Poses[IndividualIndex].Add(Pose);
+			return;
+		}
+		const int32 SampleIndex = Algo::LowerBound(Frames, FrameIndex);
+		if (Frames[SampleIndex] == FrameIndex)
+		{
+			Poses[IndividualIndex][SampleIndex] = Pose;
+		}
+		else
+		{
+			Frames.Insert(FrameIndex, SampleIndex);
+			Poses[IndividualIndex].Insert(Pose, SampleIndex);
+		}
+	};
+
+	// Get the sample index of the pose recorded in the given frame (INDEX_NONE if it was not recorded)
+	int32 FindSample(int32 IndividualIndex, int32 FrameIndex) const
+	{
+		const TArray<int32>& Frames = FrameIndexes[IndividualIndex];
+		const int32 SampleIndex = Algo::LowerBound(Frames, FrameIndex);
+		return Frames.IsValidIndex(SampleIndex) && Frames[SampleIndex] == FrameIndex ? SampleIndex : INDEX_NONE;
+	};
+
+	// Check if the individual pose was recorded in the given frame
+	bool IsValid(int32 IndividualIndex, int32 FrameIndex) const
+	{
+		return FindSample(IndividualIndex, FrameIndex) != INDEX_NONE;
+	};
+
+	// Get the pose recorded in the given frame (nullptr if it was not recorded)
+	const FTransform* FindPose(int32 IndividualIndex, int32 FrameIndex) const
+	{
+		const int32 SampleIndex = FindSample(IndividualIndex, FrameIndex);
+		return SampleIndex != INDEX_NONE ? &Poses[IndividualIndex][SampleIndex] : nullptr;
+	};
+
+	// Append the frames of the given episode data (the first frame of the appended data has to be newer than the last one)
+	void Append(const FSLMongoEpisodeData& Other)
+	{
+		const int32 FrameOffset = Timestamps.Num();
+		Timestamps.Append(Other.Timestamps);
+
+		// The appended samples come after the existing ones, the columns stay sorted
+		for (int32 OtherIdx = 0; OtherIdx < Other.NumIndividuals(); ++OtherIdx)
+		{
+			const int32 Idx = FindOrAddIndividual(Other.IndividualIds[OtherIdx]);
+			TArray<int32>& Frames = FrameIndexes[Idx];
+			Frames.Reserve(Frames.Num() + Other.NumSamples(OtherIdx));
+			for (const int32 OtherFrameIdx : Other.FrameIndexes[OtherIdx])
+			{
+				Frames.Add(FrameOffset + OtherFrameIdx);
+			}
+			Poses[Idx].Append(Other.Poses[OtherIdx]);
+		}
+	};
+
+	// Clear all the data
+	void Clear()
+	{
+		IndividualIds.Empty();
+		IdToIndex.Empty();
+		Timestamps.Empty();
+		FrameIndexes.Empty();
+		Poses.Empty();
+	};
+
+	// Approximate memory footprint in bytes
+	SIZE_T GetAllocatedSize() const
+	{
+		SIZE_T Size = IndividualIds.GetAllocatedSize() + IdToIndex.GetAllocatedSize()
+			+ Timestamps.GetAllocatedSize() + FrameIndexes.GetAllocatedSize() + Poses.GetAllocatedSize();
+		for (const auto& Id : IndividualIds)
+		{
+			Size += Id.GetAllocatedSize();
+		}
+		for (int32 Idx = 0; Idx < Poses.Num(); ++Idx)
+		{
+			Size += FrameIndexes[Idx].GetAllocatedSize() + Poses[Idx].GetAllocatedSize();
+		}
+		return Size;
+	};
+};
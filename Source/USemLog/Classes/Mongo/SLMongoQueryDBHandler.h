@@ -4,6 +4,8 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Mongo/SLMongoEpisodeData.h"
+#include "Mongo/SLMongoQueryProfiler.h"
 
 #if SL_WITH_LIBMONGO_C
 class ASLVisionPoseableMeshActor;
@@ -45,6 +47,15 @@ public:
 	// Everything is set in order to query the data
 	bool IsReady() const { return bConnected && bDatabaseSet && bCollectionSet; };
 
+	// Enable/disable query profiling (queries slower than the threshold are explained if bCaptureExplain is set)
+	void SetProfiling(bool bEnable, float SlowQueryThreshold = 0.5f, bool bCaptureExplain = false);
+
+	// Log and write the profiling summary of the current session to file (returns the file path)
+	FString DumpProfilingSummary() const;
+
+	// Get the query profiler
+	FSLMongoQueryProfiler& GetProfiler() const { return Profiler; };
+
 	/* Queries */
 	// Get the pose of the individual at the given time
 	FTransform GetIndividualPoseAt(const FString& Id, float Ts) const;
@@ -52,17 +63,40 @@ public:
 	// Get the poses of the individual between the given timestamps
 	TArray<FTransform> GetIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT = -1.f) const;
 
-	// Get skeletal individual pose
-	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& Id, float Ts) const;
+	// Get skeletal individual pose (only the given bones are projected, all if empty)
+	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& Id, float Ts, 
+		const TArray<int32>& BoneIndexes = TArray<int32>()) const;
+
+	// Get skeletal individual trajectory (only the given bones are projected, all if empty)
+	TArray<TPair<FTransform, TMap<int32, FTransform>>> GetSkeletalIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT = -1.f,
+		const TArray<int32>& BoneIndexes = TArray<int32>()) const;
+
+	// Get the whole episode data (columnar form, the rotations are not fetched if only the locations are needed)
+	FSLMongoEpisodeData GetEpisodeData(bool bLocationsOnly = false) const;
+
+	// Get the whole episode data by fetching K timestamp range partitions in parallel (NumPartitions <= 0 uses the number of worker threads)
+	FSLMongoEpisodeData GetEpisodeDataParallel(int32 NumPartitions = 0, bool bLocationsOnly = false) const;
 
-	// Get skeletal individual trajectory
-	TArray<TPair<FTransform, TMap<int32, FTransform>>> GetSkeletalIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT = -1.f) const;
+	// Get the whole episode data of the given database and collection using a pooled connection (safe to call from worker threads)
+	FSLMongoEpisodeData GetEpisodeDataPooled(const FString& DBName, const FString& CollName) const;
 
-	// Get the whole episode data
-	TArray<TPair<float, TMap<FString, FTransform>>> GetEpisodeData() const;
+	// Get the document count and time range of the given database and collection using a pooled connection (safe to call from worker threads)
+	bool GetEpisodeMetadataPooled(const FString& DBName, const FString& CollName, FSLMongoEpisodeMetadata& OutMetadata) const;
 
-	// Get the whole episode data in an async thread
-	TArray<TPair<float, TMap<FString, FTransform>>> GetEpisodeDataAsync() const;
+	// Get the pose of the individual at the given time using a pooled connection (safe to call from worker threads)
+	FTransform GetIndividualPoseAtPooled(const FString& DBName, const FString& CollName, const FString& Id, float Ts) const;
+
+	// Get the poses of the individual between the given timestamps using a pooled connection (safe to call from worker threads)
+	TArray<FTransform> GetIndividualTrajectoryPooled(const FString& DBName, const FString& CollName, const FString& Id,
+		float StartTs, float EndTs, float DeltaT = -1.f) const;
+
+	// Get skeletal individual pose using a pooled connection (safe to call from worker threads)
+	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAtPooled(const FString& DBName, const FString& CollName, const FString& Id,
+		float Ts, const TArray<int32>& BoneIndexes = TArray<int32>()) const;
+
+	// Get skeletal individual trajectory using a pooled connection (safe to call from worker threads)
+	TArray<TPair<FTransform, TMap<int32, FTransform>>> GetSkeletalIndividualTrajectoryPooled(const FString& DBName, const FString& CollName, const FString& Id,
+		float StartTs, float EndTs, float DeltaT = -1.f, const TArray<int32>& BoneIndexes = TArray<int32>()) const;
 
 	// Get the episode data at the given timestamp (frame)
 	TMap<FString, FTransform> GetFrameData(float Ts);
@@ -70,6 +104,20 @@ public:
 private:
 #if SL_WITH_LIBMONGO_C
 	/* Helpers */
+	// Get the pose of the individual at the given time (uses the given collection handle)
+	FTransform GetIndividualPoseAt(mongoc_collection_t* coll, const FString& Id, float Ts) const;
+
+	// Get the poses of the individual between the given timestamps (uses the given collection handle)
+	TArray<FTransform> GetIndividualTrajectory(mongoc_collection_t* coll, const FString& Id, float StartTs, float EndTs, float DeltaT) const;
+
+	// Get skeletal individual pose (uses the given collection handle)
+	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(mongoc_collection_t* coll, const FString& Id, float Ts,
+		const TArray<int32>& BoneIndexes) const;
+
+	// Get skeletal individual trajectory (uses the given collection handle)
+	TArray<TPair<FTransform, TMap<int32, FTransform>>> GetSkeletalIndividualTrajectory(mongoc_collection_t* coll, const FString& Id, float StartTs, float EndTs, float DeltaT,
+		const TArray<int32>& BoneIndexes) const;
+
 	// Get the pose data from bson document
 	FTransform GetPose(const bson_t* doc) const;
 
@@ -78,6 +126,32 @@ private:
 
 	// Get the timestamp value from document (used for trajectory delta time comparison)
 	double GetTs(const bson_t* doc) const;
+
+	// Get the bone poses from the skeletal document
+	void GetBonePoses(const bson_t* doc, TMap<int32, FTransform>& OutBonePoses) const;
+
+	// Create the skeletal projection stage, the bones array is filtered in the stage if a subset is given
+	bson_t* CreateSkeletalProjectStage(const TArray<int32>& BoneIndexes) const;
+
+	// Create the episode frame projection stage (the rotations are dropped server side if only the locations are needed)
+	bson_t* CreateEpisodeFrameProjectStage(bool bLocationsOnly) const;
+
+	// Read the episode frame document into a new column entry
+	void ReadEpisodeFrame(const bson_t* doc, FSLMongoEpisodeData& OutEpisodeData) const;
+
+	// Get the first and last timestamp of the episode (uses the given collection handle)
+	bool GetEpisodeTimeRange(mongoc_collection_t* coll, double& OutStartTs, double& OutEndTs) const;
+
+	// Record the query in the profiler, explain it if it is slow (the heavy downloads only get their query plan explained)
+	void ProfileQuery(const FString& Type, mongoc_collection_t* coll, const bson_t* pipeline, double Duration, int32 NumReturned,
+		bool bExecutionStats = true) const;
+
+	// Recursively read the documents examined and the scan stages from the explain output
+	void ReadExplainStats(bson_iter_t* iter, FSLMongoSlowQuery& OutSlowQuery) const;
+
+	// Get the episode frames in the given timestamp range [StartTs, EndTs) or [StartTs, EndTs] (uses the given collection handle)
+	void GetEpisodeDataRange(mongoc_collection_t* coll, double StartTs, double EndTs, bool bEndInclusive,
+		bool bLocationsOnly, FSLMongoEpisodeData& OutEpisodeData) const;
 #endif // SL_WITH_LIBMONGO_C
 
 private:
@@ -90,6 +164,9 @@ private:
 	// Connected to a database
 	bool bCollectionSet;
 
+	// Query latency and explain recorder (queries are const and can run on worker threads)
+	mutable FSLMongoQueryProfiler Profiler;
+
 #if SL_WITH_LIBMONGO_C
 	// Server uri
 	mongoc_uri_t* uri;
@@ -97,6 +174,9 @@ private:
 	// MongoC connection client
 	mongoc_client_t* client;
 
+	// Thread safe client pool (used for the parallel queries)
+	mongoc_client_pool_t* client_pool;
+
 	// Database to access
 	mongoc_database_t* database;
 
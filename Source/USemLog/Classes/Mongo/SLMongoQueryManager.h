@@ -6,6 +6,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Info.h"
 #include "Mongo/SLMongoQueryDBHandler.h"
+#include "Mongo/SLMongoSpatialIndex.h"
 #include "SLMongoQueryManager.generated.h"
 
 /**
@@ -20,6 +21,10 @@ public:
 	// Sets default values for this actor's properties
 	ASLMongoQueryManager();
 
+protected:
+	// Called every update interval while disconnected handlers wait for their background fetches
+	virtual void Tick(float DeltaTime) override;
+
 //#if WITH_EDITOR
 //	// Called when a property is changed in the editor
 //	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
@@ -47,6 +52,12 @@ public:
 	// Check if the episode is selected
 	bool IsEpisodeSet() const { return bEpisodeSet; };
 
+	// Enable/disable query profiling (the session summary is dumped on disconnect)
+	void SetQueryProfiling(bool bEnable, float SlowQueryThreshold = 0.5f, bool bCaptureExplain = false);
+
+	// Log and write the current query profiling summary to file (returns the file path)
+	FString DumpQueryProfile() const;
+
 	/* Queries */
 	// Get the individual pose
 	FTransform GetIndividualPoseAt(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts);
@@ -58,24 +69,66 @@ public:
 	TArray<FTransform> GetIndividualTrajectory(const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f);
 	TArray<FTransform> GetIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f) const;
 
-	// Get skeletal individual pose
-	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts);
-	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& InEpisodeId, const FString& IndividualId, float Ts);
-	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& IndividualId, float Ts) const;
-
-	// Get skeletal individual trajectory
-	TArray<TPair<FTransform, TMap<int32, FTransform>>>  GetSkeletalIndividualTrajectory(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f);
-	TArray<TPair<FTransform, TMap<int32, FTransform>>>  GetSkeletalIndividualTrajectory(const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f);
-	TArray<TPair<FTransform, TMap<int32, FTransform>>>  GetSkeletalIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f) const;
-
-	// Get the episode data
-	TArray<TPair<float, TMap<FString, FTransform>>> GetEpisodeData(const FString& InTaskId, const FString& InEpisodeId);
-	TArray<TPair<float, TMap<FString, FTransform>>> GetEpisodeData(const FString& InEpisodeId);
-	TArray<TPair<float, TMap<FString, FTransform>>> GetEpisodeData() const;
+	// Get skeletal individual pose (only the given bones are queried, all if empty)
+	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts, const TArray<int32>& BoneIndexes = TArray<int32>());
+	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& InEpisodeId, const FString& IndividualId, float Ts, const TArray<int32>& BoneIndexes = TArray<int32>());
+	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& IndividualId, float Ts, const TArray<int32>& BoneIndexes = TArray<int32>()) const;
+
+	// Get skeletal individual pose of the given bone names
+	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts, const TArray<FName>& BoneNames);
+	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& InEpisodeId, const FString& IndividualId, float Ts, const TArray<FName>& BoneNames);
+	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& IndividualId, float Ts, const TArray<FName>& BoneNames) const;
+
+	// Get skeletal individual trajectory (only the given bones are queried, all if empty)
+	TArray<TPair<FTransform, TMap<int32, FTransform>>>  GetSkeletalIndividualTrajectory(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f, const TArray<int32>& BoneIndexes = TArray<int32>());
+	TArray<TPair<FTransform, TMap<int32, FTransform>>>  GetSkeletalIndividualTrajectory(const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f, const TArray<int32>& BoneIndexes = TArray<int32>());
+	TArray<TPair<FTransform, TMap<int32, FTransform>>>  GetSkeletalIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f, const TArray<int32>& BoneIndexes = TArray<int32>()) const;
+
+	// Get skeletal individual trajectory of the given bone names
+	TArray<TPair<FTransform, TMap<int32, FTransform>>>  GetSkeletalIndividualTrajectory(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT, const TArray<FName>& BoneNames);
+	TArray<TPair<FTransform, TMap<int32, FTransform>>>  GetSkeletalIndividualTrajectory(const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT, const TArray<FName>& BoneNames);
+	TArray<TPair<FTransform, TMap<int32, FTransform>>>  GetSkeletalIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT, const TArray<FName>& BoneNames) const;
+
+	// Get the episode data (columnar form), fetched in NumPartitions parallel timestamp ranges (<= 0 uses the number of worker threads)
+	FSLMongoEpisodeData GetEpisodeData(const FString& InTaskId, const FString& InEpisodeId, int32 NumPartitions = 0);
+	FSLMongoEpisodeData GetEpisodeData(const FString& InEpisodeId, int32 NumPartitions = 0);
+	FSLMongoEpisodeData GetEpisodeData(int32 NumPartitions = 0) const;
+
+	// Get the episode document count and time range without changing the active task and episode
+	bool GetEpisodeMetadata(const FString& InTaskId, const FString& InEpisodeId, FSLMongoEpisodeMetadata& OutMetadata) const;
+
+	// Get the database handler for the pooled queries of the background fetches (nullptr if not connected),
+	// the fetches keep it alive, the manager can be destroyed or disconnected while they are running
+	TSharedPtr<const FSLMongoQueryDBHandler, ESPMode::ThreadSafe> GetSharedDBHandler() const;
+
+	// Build (or rebuild) the spatio-temporal index of the episode (CellSize in cm, SegmentDuration in seconds)
+	bool BuildSpatialIndex(const FString& InTaskId, const FString& InEpisodeId, float CellSize = 50.f, float SegmentDuration = 10.f);
+	bool BuildSpatialIndex(const FString& InEpisodeId, float CellSize = 50.f, float SegmentDuration = 10.f);
+	bool BuildSpatialIndex(float CellSize = 50.f, float SegmentDuration = 10.f);
+
+	// Get the individuals which were inside the region between the timestamps (the index is built if missing)
+	TArray<FString> GetIndividualsInRegion(const FString& InTaskId, const FString& InEpisodeId, const FBox& Region, float StartTs, float EndTs);
+	TArray<FString> GetIndividualsInRegion(const FString& InEpisodeId, const FBox& Region, float StartTs, float EndTs);
+	TArray<FString> GetIndividualsInRegion(const FBox& Region, float StartTs, float EndTs);
+
+	// Get the individuals (with their min distance) which were within the radius of the individual between the timestamps (the index is built if missing)
+	TMap<FString, float> GetIndividualsNear(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Radius, float StartTs, float EndTs);
+	TMap<FString, float> GetIndividualsNear(const FString& InEpisodeId, const FString& IndividualId, float Radius, float StartTs, float EndTs);
+	TMap<FString, float> GetIndividualsNear(const FString& IndividualId, float Radius, float StartTs, float EndTs);
 
 	// Spawn or get manager from the world
 	static ASLMongoQueryManager* GetExistingOrSpawnNew(UWorld* World);
 
+private:
+	// Get the bone indexes of the skeletal individual from the bone names (uses the individual manager from the world)
+	TArray<int32> GetBoneIndexes(const FString& IndividualId, const TArray<FName>& BoneNames) const;
+
+	// Get the spatial index of the active episode, build it if missing (nullptr on failure)
+	FSLMongoSpatialIndex* GetSpatialIndex();
+
+	// Destroy the disconnected handlers which are no longer used by any background fetch (game thread)
+	void ReleaseRetiredDBHandlers();
+
 protected:
 	// True when successfully connected to the server
 	bool bConnected : 1;
@@ -93,8 +146,14 @@ private:
 	// Current active episode
 	FString EpisodeId;
 
-	// Database handler
-	FSLMongoQueryDBHandler DBHandler;
+	// Database handler (shared with the background fetches)
+	TSharedPtr<FSLMongoQueryDBHandler, ESPMode::ThreadSafe> DBHandler;
+
+	// Disconnected handlers still referenced by background fetches, released here so they are never destroyed on a worker
+	TArray<TSharedPtr<FSLMongoQueryDBHandler, ESPMode::ThreadSafe>> RetiredDBHandlers;
+
+	// Spatial indexes of the episodes (key: Task.Episode)
+	TMap<FString, TSharedPtr<FSLMongoSpatialIndex>> SpatialIndexes;
 
 	///* Editor button hacks */
 	//// Server ip to connect to
@@ -0,0 +1,151 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+/*
+* Aggregated statistics of a query type
+*/
+struct FSLMongoQueryStats
+{
+	// Upper bounds (in milliseconds) of the latency histogram buckets, the last bucket is unbounded
+	static constexpr int32 NumBuckets = 12;
+	static const float BucketBoundsMs[NumBuckets - 1];
+
+	// Number of executed queries
+	int32 Count = 0;
+
+	// Latency values in seconds
+	double TotalDuration = 0.0;
+	double MinDuration = TNumericLimits<double>::Max();
+	double MaxDuration = 0.0;
+
+	// Latency histogram
+	int32 Histogram[NumBuckets] = {};
+
+	// Number of documents returned
+	int64 NumReturned = 0;
+
+	// Number of documents examined by the server (only available for the queries explained with execution stats)
+	int64 NumExamined = 0;
+
+	// Number of documents returned by the queries counted in NumExamined (the two are comparable)
+	int64 NumExaminedReturned = 0;
+
+	// Number of explained queries
+	int32 NumExplained = 0;
+
+	// Number of queries explained with execution stats
+	int32 NumExplainedWithStats = 0;
+
+	// Number of explained queries which used an index scan
+	int32 NumIndexScans = 0;
+
+	// Number of explained queries which used a collection scan
+	int32 NumCollectionScans = 0;
+
+	// Add the duration to the histogram and the latency values
+	void AddDuration(double Duration);
+
+	// Average latency in seconds
+	double GetAvgDuration() const { return Count > 0 ? TotalDuration / Count : 0.0; };
+};
+
+/*
+* Explain output of a slow query
+*/
+struct FSLMongoSlowQuery
+{
+	// Query type
+	FString Type;
+
+	// Query latency in seconds
+	double Duration = 0.0;
+
+	// Documents examined by the server (only set with execution stats)
+	int64 NumExamined = 0;
+
+	// Documents returned
+	int64 NumReturned = 0;
+
+	// True if an index scan was used
+	bool bIndexScan = false;
+
+	// True if a collection scan was used
+	bool bCollectionScan = false;
+
+	// True if explained with execution stats (otherwise only the query plan is available)
+	bool bExecutionStats = false;
+
+	// Raw explain output (relaxed extended json)
+	FString Explain;
+};
+
+/**
+ * Thread safe query profiler, records per query type latency histograms,
+ * documents examined vs returned, and the explain output of the slow queries
+ */
+class FSLMongoQueryProfiler
+{
+public:
+	// Ctor
+	FSLMongoQueryProfiler();
+
+	// Enable/disable profiling (slow queries are explained if bCaptureExplain is set)
+	void SetEnabled(bool bEnable, float InSlowQueryThreshold = 0.5f, bool bInCaptureExplain = false);
+
+	// Check if profiling is enabled
+	bool IsEnabled() const;
+
+	// Check if the query duration qualifies it for an explain capture
+	bool ShouldExplain(double Duration) const;
+
+	// Record a query
+	void Record(const FString& Type, double Duration, int32 NumReturned);
+
+	// Record the explain output of a slow query
+	void RecordExplain(const FSLMongoSlowQuery& SlowQuery);
+
+	// Start a new session (clears all the data)
+	void StartSession(const FString& InSessionName);
+
+	// Get the session summary as json
+	FString GetSummaryAsJson() const;
+
+	// Log the session summary
+	void LogSummary() const;
+
+	// Write the session summary to file (returns the path, or empty on error)
+	FString WriteSummaryToFile(const FString& DirPath) const;
+
+private:
+	// True if the queries are recorded
+	bool bEnabled;
+
+	// True if the slow queries should be explained
+	bool bCaptureExplain;
+
+	// Queries slower than this (seconds) are explained
+	float SlowQueryThreshold;
+
+	// Max number of kept slow query explains
+	int32 MaxNumSlowQueries;
+
+	// Name of the session
+	FString SessionName;
+
+	// Session start time
+	FDateTime SessionStart;
+
+	// Query type to its stats
+	TMap<FString, FSLMongoQueryStats> Stats;
+
+	// Explained slow queries
+	TArray<FSLMongoSlowQuery> SlowQueries;
+
+	// Queries are recorded from worker threads as well, the settings are read under the lock too
+	mutable FCriticalSection CriticalSection;
+};
@@ -0,0 +1,139 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Forward declaration
+struct FSLMongoEpisodeData;
+
+/*
+* Location of an individual which holds between the two frames (inclusive)
+*/
+struct FSLMongoSpatialSample
+{
+	// Dense individual index (from the episode data)
+	int32 IndividualIndex;
+
+	// First frame where the location holds
+	int32 FirstFrame;
+
+	// Last frame where the location holds
+	int32 LastFrame;
+
+	// Location of the individual
+	FVector Location;
+
+	// Default ctor
+	FSLMongoSpatialSample() : IndividualIndex(INDEX_NONE), FirstFrame(INDEX_NONE), LastFrame(INDEX_NONE), Location(FVector::ZeroVector) {};
+
+	// Init ctor
+	FSLMongoSpatialSample(int32 InIndividualIndex, int32 InFirstFrame, int32 InLastFrame, const FVector& InLocation) :
+		IndividualIndex(InIndividualIndex), FirstFrame(InFirstFrame), LastFrame(InLastFrame), Location(InLocation) {};
+
+	// Check if the sample holds in the given frame range
+	bool OverlapsFrames(int32 InFirstFrame, int32 InLastFrame) const { return FirstFrame <= InLastFrame && LastFrame >= InFirstFrame; };
+};
+
+/*
+* Uniform grid over the samples of a time segment of the episode
+*/
+struct FSLMongoSpatialSegment
+{
+	// First frame of the segment
+	int32 FirstFrame;
+
+	// Last frame of the segment
+	int32 LastFrame;
+
+	// Samples of the segment
+	TArray<FSLMongoSpatialSample> Samples;
+
+	// Grid cell to the sample indexes
+	TMap<FIntVector, TArray<int32>> Cells;
+
+	// Individual index to its sample indexes
+	TMap<int32, TArray<int32>> IndividualSamples;
+
+	// Bounds of the occupied cells
+	FIntVector MinCell;
+	FIntVector MaxCell;
+
+	// Default ctor
+	FSLMongoSpatialSegment() : FirstFrame(INDEX_NONE), LastFrame(INDEX_NONE), MinCell(MAX_int32), MaxCell(MIN_int32) {};
+};
+
+/**
+ * Spatio-temporal index of an episode, the episode is split into time segments,
+ * every segment has a uniform grid over the locations of the individuals,
+ * built once per episode from its locations, the queries then never touch the raw trajectories
+ */
+class FSLMongoSpatialIndex
+{
+public:
+	// Ctor
+	FSLMongoSpatialIndex();
+
+	// Build the index from the episode data (CellSize in cm, SegmentDuration in seconds)
+	bool Build(const FSLMongoEpisodeData& InEpisodeData, float InCellSize = 50.f, float InSegmentDuration = 10.f);
+
+	// Check if the index is built
+	bool IsBuilt() const { return bIsBuilt; };
+
+	// Clear the index
+	void Clear();
+
+	// Get the individuals which were inside the region between the given timestamps
+	TArray<FString> GetIndividualsInRegion(const FBox& Region, float StartTs, float EndTs) const;
+
+	// Get the individuals which were within the radius of the given individual between the timestamps (with their min distance)
+	TMap<FString, float> GetIndividualsNear(const FString& Id, float Radius, float StartTs, float EndTs) const;
+
+	// Get the individuals which were within the radius of the given location between the timestamps (with their min distance)
+	TMap<FString, float> GetIndividualsNear(const FVector& Location, float Radius, float StartTs, float EndTs) const;
+
+	// Approximate memory footprint in bytes
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	// Add the sample to the segment
+	void AddSample(FSLMongoSpatialSegment& Segment, const FSLMongoSpatialSample& Sample) const;
+
+	// Get the grid cell of the location (clamped to avoid overflows for far away locations)
+	FIntVector GetCell(const FVector& Location) const;
+
+	// Call the function with the sample indexes of the occupied cells in the cell box (clamped to the occupied bounds,
+	// the occupied cells are iterated directly if the box has more cells)
+	void ForEachCellInBox(const FSLMongoSpatialSegment& Segment, const FIntVector& InMinCell, const FIntVector& InMaxCell,
+		TFunctionRef<void(const TArray<int32>&)> Func) const;
+
+	// Get the frame range from the timestamps (returns false if the range is outside the episode)
+	bool GetFrameRange(float StartTs, float EndTs, int32& OutFirstFrame, int32& OutLastFrame) const;
+
+	// Collect the samples within the radius of the location in the given frame range (keeps the min distance per individual)
+	void CollectNear(const FSLMongoSpatialSegment& Segment, const FVector& Location, float Radius,
+		int32 FirstFrame, int32 LastFrame, TMap<int32, float>& OutMinDistances) const;
+
+private:
+	// True if the index is built
+	bool bIsBuilt;
+
+	// Size of the grid cells in cm
+	float CellSize;
+
+	// Duration of a segment in seconds
+	float SegmentDuration;
+
+	// Individual ids (the dense index from the episode data)
+	TArray<FString> IndividualIds;
+
+	// Individual id to its dense index
+	TMap<FString, int32> IdToIndex;
+
+	// Timestamps of the episode frames
+	TArray<float> Timestamps;
+
+	// Time segments of the episode
+	TArray<FSLMongoSpatialSegment> Segments;
+};
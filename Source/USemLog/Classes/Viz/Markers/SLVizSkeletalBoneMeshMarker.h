@@ -4,14 +4,19 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Viz/Markers/SLVizSkeletalMeshMarker.h"
+#include "Viz/Markers/SLVizStaticMeshMarker.h"
 #include "SLVizSkeletalBoneMeshMarker.generated.h"
 
+// Forward declarations
+class USkeletalMesh;
+class UStaticMesh;
+
 /**
- * Class capable of visualizing skeletal meshe bones as arrays of poseable meshes
+ * Class capable of visualizing skeletal mesh bones as instances of a static mesh of the bone geometry,
+ * the geometry is extracted once per bone (see CreateBoneStaticMesh) and shared by all the samples
  */
 UCLASS()
-class USEMLOG_API USLVizSkeletalBoneMeshMarker : public USLVizSkeletalMeshMarker
+class USEMLOG_API USLVizSkeletalBoneMeshMarker : public USLVizStaticMeshMarker
 {
 	GENERATED_BODY()
 
@@ -19,17 +24,8 @@ public:
 	// Constructor
 	USLVizSkeletalBoneMeshMarker();
 
-	// Set the visual properties of the skeletal mesh, visualize only selected material index (use original materials)
-	void SetVisual(USkeletalMesh* SkelMesh, int32 MaterialIndex);
-
-	// Set the visual properties of the skeletal mesh, visualize only selected material index
-	void SetVisual(USkeletalMesh* SkelMesh, int32 MaterialIndex, const FLinearColor& InColor,
-		ESLVizMaterialType InMaterialType = ESLVizMaterialType::Unlit);
-
-	// Visualize only selected material indexes (use original materials)
-	void SetVisual(USkeletalMesh* SkelMesh, const TArray<int32>& MaterialIndexes);
-
-	// Visualize only selected material indexes
-	void SetVisual(USkeletalMesh* SkelMesh, const TArray<int32>& MaterialIndexes, const FLinearColor& InColor,
-		ESLVizMaterialType InMaterialType = ESLVizMaterialType::Unlit);
+	// Extract the reference pose geometry of the material sections (the triangles mostly skinned to the bone) into a transient static mesh
+	// in the bone space, the instances are then placed with the bone world poses (requires CPU access to the mesh data in cooked builds)
+	static UStaticMesh* CreateBoneStaticMesh(UObject* Outer, USkeletalMesh* SkelMesh, int32 BoneIndex,
+		const TArray<int32>& MaterialIndexes);
 };
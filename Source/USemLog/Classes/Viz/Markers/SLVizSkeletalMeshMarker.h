@@ -49,6 +49,9 @@ public:
 	void AddInstances(const TArray<TPair<FTransform, TMap<int32, FTransform>>>& SkeletalPoses,
 		const FSLVizTimelineParams& TimelineParams);
 
+	// Set the max number of poseable mesh instances, the oldest instances are recycled when it is reached
+	void SetMaxNumInstances(int32 Value);
+
 	//~ Begin ActorComponent Interface
 	// Unregister the component, remove it from its outer Actor's Components array and mark for pending kill
 	virtual void DestroyComponent(bool bPromoteChildren = false) override;
@@ -90,6 +93,21 @@ protected:
 	// Create poseable mesh component instance attached and registered to this marker
 	UPoseableMeshComponent* CreateNewPoseableMeshInstance();
 
+	// Get a visible instance from the pool (creates one, or recycles the oldest one if the limit is reached)
+	UPoseableMeshComponent* AcquireInstance();
+
+	// Set the pose and the bone poses of the instance
+	void SetInstancePose(UPoseableMeshComponent* PMC, const TPair<FTransform, TMap<int32, FTransform>>& SkeletalPose) const;
+
+	// Hide the active instances and move them to the free pool
+	void ReleaseInstances();
+
+	// Destroy the active and the pooled instances
+	void EmptyPool();
+
+	// Max number of active instances (the timeline limit or the pool limit)
+	int32 GetInstancesLimit() const;
+
 protected:
 	// Poseable mesh reference
 	UPROPERTY()
@@ -99,6 +117,16 @@ protected:
 	UPROPERTY()
 	TArray<UPoseableMeshComponent*> PMCInstances;
 
+	// Hidden instances ready to be reused
+	UPROPERTY()
+	TArray<UPoseableMeshComponent*> FreePMCInstances;
+
+	// Max number of poseable mesh instances, the oldest ones are recycled when reached
+	int32 MaxNumInstances;
+
+	// Index of the next instance to recycle once the limit is reached
+	int32 RecycleIndex;
+
 	// Timeline poses
 	TArray<TPair<FTransform, TMap<int32, FTransform>>> TimelinePoses;
 };
@@ -45,6 +45,9 @@ public:
 	// Add instances with timeline update
 	void AddInstances(const TArray<FTransform>& Poses, const FSLVizTimelineParams& TimelineParams);
 
+	// Replace the current instances with the poses
+	void SetInstances(const TArray<FTransform>& Poses);
+
 	//~ Begin ActorComponent Interface
 	// Unregister the component, remove it from its outer Actor's Components array and mark for pending kill
 	virtual void DestroyComponent(bool bPromoteChildren = false) override;
@@ -71,6 +74,9 @@ protected:
 	// Virtual add instances function
 	virtual void AddInstancesChecked(const TArray<FTransform>& Poses);
 
+	// Virtual instance transform of the pose (e.g. markers with a custom scale)
+	virtual FTransform GetInstanceTransform(const FTransform& Pose) const { return Pose; };
+
 	// Clear the timeline and the related members
 	void ClearAndStopTimeline();
 
@@ -80,6 +86,15 @@ protected:
 	// Update timeline with max number of instances
 	void UpdateTimelineWithMaxNumInstances(int32 NumNewInstances);
 
+	// Add the timeline poses in the given range as instances in a single batch
+	void AddTimelineInstances(int32 FromIndex, int32 ToIndex);
+
+	// Create the timeline ring buffer instances as hidden instances
+	void PreallocateTimelinePool();
+
+	// Hide the timeline ring buffer instances in a single batch
+	void HideTimelinePool();
+
 protected:
 	// A component that efficiently renders multiple instances of the same StaticMesh.
 	UPROPERTY()
@@ -87,4 +102,10 @@ protected:
 
 	// Timeline poses
 	TArray<FTransform> TimelinePoses;
+
+	// Index of the first timeline instance (instances added before the timeline are kept)
+	int32 TimelineFirstInstance;
+
+	// Instance transforms of the current batch (kept between the ticks to avoid reallocations)
+	TArray<FTransform> TimelineBatch;
 };
@@ -0,0 +1,153 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Viz/Markers/SLVizBaseMarker.h"
+#include "Viz/SLVizStructs.h"
+#include "SLVizTrajectoryMarker.generated.h"
+
+// Forward declarations
+class UProceduralMeshComponent;
+class UMaterialInterface;
+class UMaterialInstanceDynamic;
+
+/*
+* Geometry of a trajectory mesh section
+*/
+struct FSLVizTrajectoryMeshData
+{
+	// Vertex positions
+	TArray<FVector> Vertices;
+
+	// Triangle vertex indexes (both windings, the strips are visible from both sides)
+	TArray<int32> Triangles;
+
+	// Vertex normals
+	TArray<FVector> Normals;
+
+	// Vertex colors
+	TArray<FLinearColor> Colors;
+
+	// First vertex of every pose (its cross section, followed by its orientation tick if any)
+	TArray<int32> PoseFirstVertices;
+};
+
+/**
+ * Class capable of visualizing pose arrays as a single procedural line or ribbon mesh
+ */
+UCLASS()
+class USEMLOG_API USLVizTrajectoryMarker : public USLVizBaseMarker
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor
+	USLVizTrajectoryMarker();
+
+	// Called every frame, used for timeline visualizations, activated and deactivated on request
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Set the visual properties of the trajectory
+	void SetVisual(const FSLVizTrajectoryParams& InParams, ESLVizMaterialType InMaterialType = ESLVizMaterialType::Unlit);
+
+	// Set the trajectory poses (the mesh is built on a background thread)
+	void SetPoses(const TArray<FTransform>& Poses);
+
+	// Set the trajectory poses with timeline update (the max number of instances is not used)
+	void SetPoses(const TArray<FTransform>& Poses, const FSLVizTimelineParams& TimelineParams);
+
+	//~ Begin ActorComponent Interface
+	// Unregister the component, remove it from its outer Actor's Components array and mark for pending kill
+	virtual void DestroyComponent(bool bPromoteChildren = false) override;
+	//~ End ActorComponent Interface
+
+	/* Begin VizMarker interface */
+	// Reset visuals and poses
+	virtual void Reset() override;
+
+protected:
+	// Reset visual related data
+	virtual void ResetVisuals() override;
+
+	// Reset instances (poses of the visuals)
+	virtual void ResetPoses() override;
+	/* End VizMarker interface */
+
+	// Clear the timeline and the related members
+	void ClearAndStopTimeline();
+
+	// Update timeline with the given number of new poses (only the sections of the new poses are updated)
+	void UpdateTimeline(int32 NumNewPoses);
+
+	// Create the hidden timeline sections from the background build and start the timeline
+	void StartTimeline(TArray<FSLVizTrajectoryMeshData>&& Sections);
+
+	// Show the first poses of the timeline section, skipped if the section visible range did not change
+	void ApplyTimelineSection(int32 SectionIndex, int32 NumVisibleSectionPoses);
+
+	// Patch the uploaded vertices of the timeline section, the newly visible poses are restored and the hidden ones
+	// collapsed onto the last visible cross section (the topology stays the same), false if nothing changed
+	bool UpdateTimelineVertices(int32 SectionIndex, int32 NumVisibleSectionPoses);
+
+	// Build all the sections on a background thread and apply them (or start the timeline with them) on the game thread
+	void BuildSectionsAsync(const TArray<FTransform>& Poses, bool bTimeline);
+
+	// Create the mesh section with the trajectory material
+	void ApplySection(int32 SectionIndex, const FSLVizTrajectoryMeshData& MeshData, const TArray<FVector>& Vertices);
+
+	// Material of the trajectory section (vertex colors, or a section colored dynamic material if the asset is missing)
+	UMaterialInterface* GetSectionMaterial(int32 SectionIndex, const FSLVizTrajectoryMeshData& MeshData);
+
+	// Number of poses per section, time coloring without vertex colors uses smaller sections as color bands
+	int32 GetNumPosesPerSection(int32 NumPoses) const;
+
+	// Build the geometry of all the sections, every section shares its last pose with the next one, no UObject access
+	static void BuildSections(const TArray<FTransform>& Poses, int32 InNumPosesPerSection,
+		const FSLVizTrajectoryParams& InParams, TArray<FSLVizTrajectoryMeshData>& OutSections);
+
+	// Build the geometry of the section poses (the last one connects to the next section), no UObject access
+	static void BuildSection(const FTransform* SectionPoses, int32 NumSectionPoses, int32 FirstPoseIndex,
+		int32 NumOwnedPoses, int32 NumTotalPoses, const FSLVizTrajectoryParams& InParams, FSLVizTrajectoryMeshData& OutMeshData);
+
+	// Append a strip quad with both windings
+	static void AddQuad(FSLVizTrajectoryMeshData& OutMeshData, int32 V0, int32 V1, int32 V2, int32 V3);
+
+protected:
+	// Trajectory mesh
+	UPROPERTY()
+	UProceduralMeshComponent* ProcMeshComp;
+
+	// Trajectory visual parameters
+	FSLVizTrajectoryParams Params;
+
+	// Section colored materials, used for time coloring if the vertex color material is missing
+	UPROPERTY()
+	TArray<UMaterialInstanceDynamic*> SectionMaterials;
+
+	// Number of timeline poses
+	int32 TimelineNumPoses;
+
+	// Number of poses per timeline section
+	int32 TimelinePosesPerSection;
+
+	// Complete geometry of the created timeline sections
+	TArray<FSLVizTrajectoryMeshData> TimelineSections;
+
+	// Uploaded vertices of the timeline sections (hidden poses collapsed), patched in place between updates
+	TArray<TArray<FVector>> TimelineSectionVertices;
+
+	// Number of visible poses of every timeline section
+	TArray<int32> TimelineSectionNumVisiblePoses;
+
+	// Id of the latest background build, older results are discarded
+	int32 BuildId;
+
+	/* Constants */
+	// Number of poses in a mesh section (one draw call)
+	static constexpr int32 PosesPerSection = 2048;
+
+	// Number of color bands of time colored trajectories without the vertex color material
+	static constexpr int32 NumTimeColorBands = 32;
+};
@@ -62,4 +62,8 @@ public:
 
 	UPROPERTY(EditAnywhere, Category = "Material")
 	UMaterial* MaterialHighlightTranslucent;
+
+	// Unlit material using the vertex colors (time colored trajectories)
+	UPROPERTY(EditAnywhere, Category = "Material")
+	UMaterial* MaterialVertexColor;
 };
@@ -5,10 +5,12 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Viz/SLVizCameraPath.h"
 #include "SLVizCameraDirector.generated.h"
 
 // Forward declarations
 class APawn;
+class ASLVizEpisodeManager;
 
 UCLASS(ClassGroup = (SL), DisplayName = "SL Viz Camera Director")
 class ASLVizCameraDirector : public AActor
@@ -39,6 +41,15 @@ public:
 	// Make sure the camera is detached
 	void DetachCamera();
 
+	// Drive the camera along the precomputed path with the episode time of the manager (replaces any active movement)
+	void SetCameraPath(const FSLVizCameraPath& Path, ASLVizEpisodeManager* EpisodeManager);
+
+	// Stop following the camera path (the camera keeps its current pose)
+	void ClearCameraPath();
+
+	// True if the camera is following a path
+	bool HasCameraPath() const { return bCameraPathActive; };
+
 private:
 	// Start blend movement (set target and enable tick)
 	void StartBlendMovement(const FTransform& Target, float BlendTime);
@@ -49,6 +60,9 @@ private:
 	// Update blend movement (interapolate and update pose)
 	void UpdateBlendMovement(float DeltaTime);
 
+	// Set the camera to the path pose of the current episode time
+	void UpdateCameraPath();
+
 	// Trigger test function
 	void TriggerTest();
 
@@ -80,4 +94,13 @@ private:
 
 	// View target to move the camera to
 	FTransform BlendMoveToTarget;
+
+	// True if the camera follows the path
+	bool bCameraPathActive;
+
+	// Precomputed camera path
+	FSLVizCameraPath CameraPath;
+
+	// Provides the episode time the path is evaluated with
+	TWeakObjectPtr<ASLVizEpisodeManager> CameraPathTimeSource;
 };
@@ -0,0 +1,62 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/InterpCurve.h"
+#include "Viz/SLVizStructs.h"
+
+/**
+ * Precomputed camera path, spline curves through timed camera poses evaluated directly with the episode time,
+ * the pose only depends on the time (deterministic, independent of the tick rate and of the previous updates)
+ */
+class FSLVizCameraPath
+{
+public:
+	// Default ctor
+	FSLVizCameraPath() {};
+
+	// Build the curves from the keyframes (sorted by time, returns false if there are no keyframes)
+	bool Build(const TArray<FSLVizCameraKeyframe>& InKeyframes);
+
+	// Build the path framing the targets, the locations are given for every sample time (returns false on invalid input)
+	bool BuildFraming(const TArray<float>& SampleTimes, const TArray<TArray<FVector>>& TargetLocations,
+		const FSLVizCameraFramingParams& Params);
+
+	// Evaluate the camera pose at the given time (clamped to the path time range)
+	FTransform Eval(float Time) const;
+
+	// Evaluate the field of view at the given time (negative if the path does not change the field of view)
+	float EvalFieldOfView(float Time) const;
+
+	// True if the path has been built
+	bool IsValid() const { return LocationCurve.Points.Num() > 0; };
+
+	// Path time range
+	float GetStartTime() const { return StartTime; };
+	float GetEndTime() const { return EndTime; };
+
+	// Keyframes used to build the path
+	const TArray<FSLVizCameraKeyframe>& GetKeyframes() const { return Keyframes; };
+
+	// Clear the curves
+	void Reset();
+
+private:
+	// Keyframes used to build the path (sorted by time)
+	TArray<FSLVizCameraKeyframe> Keyframes;
+
+	// Location spline
+	FInterpCurveVector LocationCurve;
+
+	// Rotation spline
+	FInterpCurveQuat RotationCurve;
+
+	// Field of view spline (empty if no keyframe sets the field of view)
+	FInterpCurveFloat FieldOfViewCurve;
+
+	// Path time range
+	float StartTime = 0.f;
+	float EndTime = 0.f;
+};
@@ -0,0 +1,129 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Viz/SLVizEpisodeManager.h"
+
+// Forward declaration
+class ASLIndividualManager;
+
+/*
+* Episode cache statistics
+*/
+struct FSLVizEpisodeCacheStats
+{
+	// Lookups served from memory
+	int32 Hits = 0;
+
+	// Lookups of episodes which were not in memory (including the ones reloaded from disk)
+	int32 Misses = 0;
+
+	// Episodes evicted from memory
+	int32 Evictions = 0;
+
+	// Evicted episodes written to disk
+	int32 Spills = 0;
+
+	// Spilled episodes reloaded from disk
+	int32 Reloads = 0;
+
+	// Current memory footprint in bytes
+	int64 CurrentBytes = 0;
+
+	// Largest memory footprint in bytes
+	int64 PeakBytes = 0;
+
+	// Episodes currently in memory
+	int32 NumInMemory = 0;
+
+	// Episodes currently spilled to disk
+	int32 NumSpilled = 0;
+};
+
+/**
+ * Memory budgeted episode cache with least recently used eviction,
+ * evicted episodes can be spilled to disk and reloaded on demand
+ */
+class FSLVizEpisodeCache
+{
+public:
+	// Ctor
+	FSLVizEpisodeCache();
+
+	// Set the memory budget in bytes (0 for unlimited), and if the evicted episodes are written to disk
+	void SetBudget(int64 InMaxBytes, bool bInSpillToDisk = false);
+
+	// Set the individual manager used to resolve the actors of the reloaded episodes
+	void SetIndividualManager(ASLIndividualManager* InIndividualManager) { IndividualManager = InIndividualManager; };
+
+	// Add the episode, evicts the least recently used ones if the budget is exceeded
+	void Add(const FString& Id, FSLVizEpisodeData&& InEpisodeData);
+
+	// Check if the episode is in memory or spilled to disk
+	bool Contains(const FString& Id) const { return Episodes.Contains(Id) || SpilledEpisodes.Contains(Id); };
+
+	// Get the episode (reloads it if it was spilled), marks it as the most recently used (nullptr if not available),
+	// the pointer stays valid until the episode is removed or evicted
+	const FSLVizEpisodeData* Find(const FString& Id);
+
+	// Get the episode shared with the cache (reloads it if it was spilled), stays valid after an eviction (nullptr if not available)
+	TSharedPtr<const FSLVizEpisodeData> FindShared(const FString& Id);
+
+	// Remove the episode from memory and disk
+	void Remove(const FString& Id);
+
+	// Remove all the episodes from memory and disk
+	void Empty();
+
+	// Get the cache statistics
+	const FSLVizEpisodeCacheStats& GetStats() const { return Stats; };
+
+	// Log the cache statistics
+	void LogStats() const;
+
+private:
+	// Mark the episode as the most recently used
+	void Touch(const FString& Id);
+
+	// Evict the least recently used episodes until the budget is satisfied (the given episode is kept)
+	void EnforceBudget(const FString& KeepId);
+
+	// Evict the episode from memory (spill it to disk if enabled)
+	void Evict(const FString& Id);
+
+	// Get the spill file path of the episode
+	FString GetSpillPath(const FString& Id) const;
+
+	// Update the memory statistics
+	void UpdateMemoryStats();
+
+private:
+	// Memory budget in bytes (0 for unlimited)
+	int64 MaxBytes;
+
+	// Write the evicted episodes to disk
+	bool bSpillToDisk;
+
+	// Directory of the spill files
+	FString SpillDir;
+
+	// Used to resolve the actors of the reloaded episodes
+	ASLIndividualManager* IndividualManager;
+
+	// Episodes in memory (heap allocated, the addresses do not change when the map grows)
+	TMap<FString, TSharedPtr<const FSLVizEpisodeData>> Episodes;
+
+	// Memory footprint of the episodes in memory
+	TMap<FString, int64> EpisodeBytes;
+
+	// Episode ids ordered from the least to the most recently used
+	TArray<FString> UsageOrder;
+
+	// Episode ids spilled to disk
+	TSet<FString> SpilledEpisodes;
+
+	// Statistics
+	FSLVizEpisodeCacheStats Stats;
+};
@@ -0,0 +1,65 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Viz/SLVizEpisodeManager.h"
+#include "Mongo/SLMongoEpisodeData.h"
+
+/**
+ * Persistent on-disk cache of the built replay episodes, keyed by task, episode and file version,
+ * the entries are validated against the episode metadata and read through a memory mapped view,
+ * the least recently read or written files are removed when the size limit is exceeded,
+ * the class only holds its settings so it can be copied to worker threads
+ */
+class FSLVizEpisodeDiskCache
+{
+public:
+	// Ctor
+	FSLVizEpisodeDiskCache();
+
+	// Enable/disable the cache
+	void SetEnabled(bool bEnable) { bEnabled = bEnable; };
+
+	// Check if the cache is enabled
+	bool IsEnabled() const { return bEnabled; };
+
+	// Set the max size of the cache files in bytes (0 for unlimited), the least recently used files are removed
+	void SetMaxBytes(int64 InMaxBytes) { MaxBytes = FMath::Max<int64>(InMaxBytes, 0); };
+
+	// Remove the least recently used files until the cache fits its max size (the given file is kept)
+	void EnforceMaxBytes(const FString& KeepPath = FString()) const;
+
+	// Read the cached episode if it matches the metadata, the actors and bones are not resolved (safe to call from worker threads)
+	bool Read(const FString& TaskId, const FString& EpisodeId, const FSLMongoEpisodeMetadata& Metadata,
+		FSLVizEpisodeData& OutVizEpisodeData) const;
+
+	// Write the episode with its metadata (safe to call from worker threads)
+	bool Write(const FString& TaskId, const FString& EpisodeId, const FSLMongoEpisodeMetadata& Metadata,
+		const FSLVizEpisodeData& InVizEpisodeData) const;
+
+	// Remove the cached episode
+	void Remove(const FString& TaskId, const FString& EpisodeId) const;
+
+	// Get the cache file path of the episode
+	FString GetPath(const FString& TaskId, const FString& EpisodeId) const;
+
+private:
+	// Read the header and the episode data from the archive (returns false on mismatch)
+	bool ReadFromArchive(FArchive& Ar, const FString& TaskId, const FString& EpisodeId,
+		const FSLMongoEpisodeMetadata& Metadata, FSLVizEpisodeData& OutVizEpisodeData) const;
+
+private:
+	// Identifies the cache files
+	static constexpr uint32 FileMagic = 0x534C4550; // "SLEP"
+
+	// Use the cache
+	bool bEnabled;
+
+	// Max size of the cache files in bytes (0 for unlimited)
+	int64 MaxBytes;
+
+	// Directory of the cache files
+	FString CacheDir;
+};
@@ -6,26 +6,76 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Info.h"
 #include "SLVizStructs.h"
+#include "SLVizSkeletalPoseApplier.h"
+#include "SLVizReplayClock.h"
 #include "SLVizEpisodeManager.generated.h"
 
 // Forward declaration
 class UPoseableMeshComponent;
 class APlayerController;
+class FSLVizScopedMovementBatch;
 
 /*
-* Holds the poses of all the individuals in the world
+* Bone pose target (poseable mesh component and the bone index)
 */
-struct FSLVizEpisodeFrameData
+struct FSLVizEpisodeBoneTarget
 {
-	// Array of the actors and their poses
-	TMap<AActor*, FTransform> ActorPoses;
+	// Poseable mesh component of the skeletal actor
+	UPoseableMeshComponent* PoseableMeshComponent;
 
-	// Array of the skeletal components and their bone poses (the actor locations are included above)
-	TMap<UPoseableMeshComponent*, TMap<int32, FTransform>> BonePoses;
+	// Index of the bone in the component
+	int32 BoneIndex;
+
+	// Default ctor
+	FSLVizEpisodeBoneTarget() : PoseableMeshComponent(nullptr), BoneIndex(INDEX_NONE) {};
+
+	// Init ctor
+	FSLVizEpisodeBoneTarget(UPoseableMeshComponent* InPMC, int32 InBoneIndex) :
+		PoseableMeshComponent(InPMC), BoneIndex(InBoneIndex) {};
+};
+
+/*
+* Per frame change lists stored contiguously, the changes of frame F are the
+* entries in [Offsets[F], Offsets[F + 1]) of the index and pose arrays
+*/
+struct FSLVizEpisodeChangeList
+{
+	// Start offset of every frame (one extra entry marks the end of the last frame)
+	TArray<int32> Offsets;
+
+	// Column index (actor / bone) of the change
+	TArray<int32> Indexes;
+
+	// New pose of the column
+	TArray<FTransform> Poses;
+
+	// First change of the frame
+	int32 Begin(int32 FrameIndex) const { return Offsets[FrameIndex]; };
+
+	// One past the last change of the frame
+	int32 End(int32 FrameIndex) const { return Offsets[FrameIndex + 1]; };
+
+	// Number of all the changes
+	int32 Num() const { return Indexes.Num(); };
+
+	// Clear all the data
+	void Clear()
+	{
+		Offsets.Empty();
+		Indexes.Empty();
+		Poses.Empty();
+	};
+
+	// Approximate memory footprint in bytes
+	SIZE_T GetAllocatedSize() const
+	{
+		return Offsets.GetAllocatedSize() + Indexes.GetAllocatedSize() + Poses.GetAllocatedSize();
+	};
 };
 
 /*
-* Holds the frames from the recorded episode
+* Holds the frames from the recorded episode as periodic keyframes (full state of every actor / bone, used for gotos)
+* and per frame change lists (only the actors / bones which moved in the frame, used for sequential replays)
 */
 struct FSLVizEpisodeData
 {
@@ -35,11 +85,32 @@ struct FSLVizEpisodeData
 	// Array of the timestamps
 	TArray<float> Timestamps;
 
-	// Array of the compact frames (used for fast gotos)
-	TArray<FSLVizEpisodeFrameData> FullFrames;
+	// Number of frames between two keyframes
+	int32 KeyframeInterval = 128;
+
+	// Actors driven by the episode (the array index is the actor column index)
+	TArray<AActor*> Actors;
+
+	// Individual ids of the actor columns (used to re-resolve the actors of serialized episodes)
+	TArray<FString> ActorIds;
 
-	// Array of the compact frames (used for fast replays)
-	TArray<FSLVizEpisodeFrameData> CompactFrames;
+	// Full actor poses of every keyframe
+	TArray<TArray<FTransform>> ActorKeyframes;
+
+	// Actor changes of every frame
+	FSLVizEpisodeChangeList ActorChanges;
+
+	// Bones driven by the episode (the array index is the bone column index)
+	TArray<FSLVizEpisodeBoneTarget> Bones;
+
+	// Individual ids of the bone columns (used to re-resolve the bones of serialized episodes)
+	TArray<FString> BoneIds;
+
+	// Full bone poses of every keyframe
+	TArray<TArray<FTransform>> BoneKeyframes;
+
+	// Bone changes of every frame
+	FSLVizEpisodeChangeList BoneChanges;
 
 	// Default ctor
 	FSLVizEpisodeData() {};
@@ -48,14 +119,95 @@ struct FSLVizEpisodeData
 	FSLVizEpisodeData(int32 ArraySize)
 	{
 		Timestamps.Reserve(ArraySize);
-		FullFrames.Reserve(ArraySize);
-		CompactFrames.Reserve(ArraySize);
 	};
 
+	// Number of frames
+	int32 NumFrames() const { return Timestamps.Num(); };
+
+	// Index of the keyframe at or before the frame
+	int32 GetKeyframeIndex(int32 FrameIndex) const { return FrameIndex / KeyframeInterval; };
+
 	// Check if there is data in the episode and it is in sync
 	bool IsValid() const 
 	{
-		return Timestamps.Num() > 2 && Timestamps.Num() == FullFrames.Num();
+		return Timestamps.Num() > 2 
+			&& KeyframeInterval > 0
+			&& ActorKeyframes.Num() == (Timestamps.Num() - 1) / KeyframeInterval + 1
+			&& ActorKeyframes.Num() == BoneKeyframes.Num()
+			&& ActorChanges.Offsets.Num() == Timestamps.Num() + 1
+			&& BoneChanges.Offsets.Num() == Timestamps.Num() + 1;
+	};
+
+	// Get the full state in the given frame (seek the keyframe and roll the changes forward)
+	void GetStateAt(int32 FrameIndex, TArray<FTransform>& OutActorPoses, TArray<FTransform>& OutBonePoses) const
+	{
+		const int32 KeyframeIdx = GetKeyframeIndex(FrameIndex);
+		OutActorPoses = ActorKeyframes[KeyframeIdx];
+		OutBonePoses = BoneKeyframes[KeyframeIdx];
+		for (int32 FrameIdx = KeyframeIdx * KeyframeInterval + 1; FrameIdx <= FrameIndex; ++FrameIdx)
+		{
+			for (int32 ChangeIdx = ActorChanges.Begin(FrameIdx); ChangeIdx < ActorChanges.End(FrameIdx); ++ChangeIdx)
+			{
+				OutActorPoses[ActorChanges.Indexes[ChangeIdx]] = ActorChanges.Poses[ChangeIdx];
+			}
+			for (int32 ChangeIdx = BoneChanges.Begin(FrameIdx); ChangeIdx < BoneChanges.End(FrameIdx); ++ChangeIdx)
+			{
+				OutBonePoses[BoneChanges.Indexes[ChangeIdx]] = BoneChanges.Poses[ChangeIdx];
+			}
+		}
+	};
+
+	// Move the state from one frame to another, marks the columns which differ between the two frames
+	// (large jumps are rebuilt from the nearest keyframe and every column is marked)
+	void SeekState(int32 FromFrameIndex, int32 ToFrameIndex, TArray<FTransform>& InOutActorPoses, TArray<FTransform>& InOutBonePoses,
+		TBitArray<>& OutChangedActors, TBitArray<>& OutChangedBones) const
+	{
+		if (FromFrameIndex == ToFrameIndex)
+		{
+			return;
+		}
+
+		const int32 FirstChangedFrame = FMath::Min(FromFrameIndex, ToFrameIndex) + 1;
+		const int32 LastChangedFrame = FMath::Max(FromFrameIndex, ToFrameIndex);
+		if (FromFrameIndex < 0 || LastChangedFrame - FirstChangedFrame >= KeyframeInterval)
+		{
+			GetStateAt(ToFrameIndex, InOutActorPoses, InOutBonePoses);
+			OutChangedActors.Init(true, InOutActorPoses.Num());
+			OutChangedBones.Init(true, InOutBonePoses.Num());
+			return;
+		}
+
+		for (int32 FrameIdx = FirstChangedFrame; FrameIdx <= LastChangedFrame; ++FrameIdx)
+		{
+			for (int32 ChangeIdx = ActorChanges.Begin(FrameIdx); ChangeIdx < ActorChanges.End(FrameIdx); ++ChangeIdx)
+			{
+				OutChangedActors[ActorChanges.Indexes[ChangeIdx]] = true;
+			}
+			for (int32 ChangeIdx = BoneChanges.Begin(FrameIdx); ChangeIdx < BoneChanges.End(FrameIdx); ++ChangeIdx)
+			{
+				OutChangedBones[BoneChanges.Indexes[ChangeIdx]] = true;
+			}
+		}
+
+		// Forward seeks roll the changes on top of the state, backward seeks start from the keyframe
+		if (ToFrameIndex > FromFrameIndex)
+		{
+			for (int32 FrameIdx = FirstChangedFrame; FrameIdx <= LastChangedFrame; ++FrameIdx)
+			{
+				for (int32 ChangeIdx = ActorChanges.Begin(FrameIdx); ChangeIdx < ActorChanges.End(FrameIdx); ++ChangeIdx)
+				{
+					InOutActorPoses[ActorChanges.Indexes[ChangeIdx]] = ActorChanges.Poses[ChangeIdx];
+				}
+				for (int32 ChangeIdx = BoneChanges.Begin(FrameIdx); ChangeIdx < BoneChanges.End(FrameIdx); ++ChangeIdx)
+				{
+					InOutBonePoses[BoneChanges.Indexes[ChangeIdx]] = BoneChanges.Poses[ChangeIdx];
+				}
+			}
+		}
+		else
+		{
+			GetStateAt(ToFrameIndex, InOutActorPoses, InOutBonePoses);
+		}
 	};
 
 	// Clear all the data in the episode
@@ -63,8 +215,39 @@ struct FSLVizEpisodeData
 	{
 		Id = "";
 		Timestamps.Empty(); 
-		FullFrames.Empty();
-		CompactFrames.Empty();
+		Actors.Empty();
+		ActorIds.Empty();
+		ActorKeyframes.Empty();
+		ActorChanges.Clear();
+		Bones.Empty();
+		BoneIds.Empty();
+		BoneKeyframes.Empty();
+		BoneChanges.Clear();
+	};
+
+	// Approximate memory footprint in bytes
+	SIZE_T GetAllocatedSize() const
+	{
+		SIZE_T Size = Timestamps.GetAllocatedSize() + Actors.GetAllocatedSize() + ActorIds.GetAllocatedSize()
+			+ ActorKeyframes.GetAllocatedSize() + ActorChanges.GetAllocatedSize() + Bones.GetAllocatedSize()
+			+ BoneIds.GetAllocatedSize() + BoneKeyframes.GetAllocatedSize() + BoneChanges.GetAllocatedSize();
+		for (const auto& ActorId : ActorIds)
+		{
+			Size += ActorId.GetAllocatedSize();
+		}
+		for (const auto& BoneId : BoneIds)
+		{
+			Size += BoneId.GetAllocatedSize();
+		}
+		for (const auto& Keyframe : ActorKeyframes)
+		{
+			Size += Keyframe.GetAllocatedSize();
+		}
+		for (const auto& Keyframe : BoneKeyframes)
+		{
+			Size += Keyframe.GetAllocatedSize();
+		}
+		return Size;
 	};
 };
 
@@ -76,6 +259,9 @@ UCLASS(ClassGroup = (SL), DisplayName = "SL Viz Episode Replay Manager")
 class USEMLOG_API ASLVizEpisodeManager : public AInfo
 {
 	GENERATED_BODY()
+
+	// Drives the replay paths directly
+	friend class FSLVizReplayBenchmark;
 	
 public:	
 	// Sets default values for this actor's properties
@@ -131,16 +317,38 @@ public:
 	// Stop replay, goto first frame
 	void StopReplay();
 
+	// Set the replay speed factor (negative values replay in reverse)
+	void SetReplaySpeed(float Speed) { ReplayClock.SetSpeed(Speed); };
+
+	// Get the current episode time (replay clock time, or the timestamp of the active frame)
+	float GetReplayTime() const;
+
+	// Sample the locations of the episode actors every interval of episode time (returns false if none of the actors is in the episode)
+	bool SampleActorLocations(const TArray<AActor*>& InActors, float SampleInterval,
+		TArray<float>& OutTimes, TArray<TArray<FVector>>& OutLocations) const;
+
 private:
 	// Start replay
 	void StartReplay();
 
-	// Apply frame poses
-	void ApplyPoses(const FSLVizEpisodeFrameData& Frame);
+	// Apply the full state of the active frame
+	void ApplyPoses();
+
+	// Apply the changes of the given frame on top of the active state
+	void ApplyFrameChanges(int32 FrameIndex);
+
+	// Move the actor to its active state pose, the attached components are updated when the batch ends
+	void MoveActor(int32 ActorIdx, FSLVizScopedMovementBatch& MovementBatch);
 
 	// Apply next frame changes (return false if there are no more frames)
 	bool ApplyNextFrameChanges();
 
+	// Apply the state of the replay clock time (return false if the replay reached its end)
+	bool ApplyClockTime();
+
+	// Move the active state to the given frame, marks the actors and meshes which need to be re-applied
+	void SeekFrame(int32 FrameIndex, TBitArray<>& OutDirtyActors, TBitArray<>& OutDirtyMeshes);
+
 	// Calculate an approximation of the update rate value to coincide with realtime
 	void CalcRealtimeAproxUpdateRateValue(int32 MaxNumSteps);
 
@@ -157,9 +365,30 @@ protected:
 	// True if it currently in an active replay
 	uint8 bReplayRunning : 1;
 
+	// True if the replay follows the wall time clock (otherwise it steps frame by frame)
+	uint8 bClockReplay : 1;
+
+	// True if the poses are interpolated between the recorded frames
+	uint8 bInterpolateReplay : 1;
+
+	// Tick interval of the fixed step replays, restored when a clock replay stops
+	float FixedStepTickInterval;
+
 	// Episode data
 	FSLVizEpisodeData EpisodeData;
 
+	// Current actor poses (full state of the active frame)
+	TArray<FTransform> ActorState;
+
+	// Current bone poses (full state of the active frame)
+	TArray<FTransform> BoneState;
+
+	// Movable flag of every episode actor (static actors are never moved, computed once per episode)
+	TBitArray<> MovableActors;
+
+	// Applies the bone poses of the skeletal meshes
+	FSLVizSkeletalPoseApplier SkeletalPoseApplier;
+
 	// Current frame index
 	int32 ActiveFrameIndex;
 
@@ -174,6 +403,15 @@ protected:
 
 	// Default replay update rate
 	float EpisodeDefaultUpdateRate;
+
+	// Maps the wall time to the episode time
+	FSLVizReplayClock ReplayClock;
+
+	// Actors which were moved to an interpolated pose in the last update
+	TArray<int32> InterpolatedActors;
+
+	// Skeletal meshes which were set with interpolated bone poses in the last update
+	TBitArray<> InterpolatedMeshes;
 };
 
 
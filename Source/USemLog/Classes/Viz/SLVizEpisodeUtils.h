@@ -9,8 +9,12 @@
 // Forward declarations
 class UWorld;
 class AActor;
+class USceneComponent;
+class FScopedMovementUpdate;
 class ASLIndividualManager;
 struct FSLVizEpisodeData;
+struct FSLVizEpisodeChangeList;
+struct FSLMongoEpisodeData;
 
 /**
  * Viz visual parameters (color and material type)
@@ -24,21 +28,87 @@ public:
 	// Add a poseable mesh component clone to the skeletal actors
 	static void AddPoseablMeshComponentsToSkeletalActors(UWorld* World);	
 
-	// Build the full replay episode data from the mongo compact form (returns true if no errors occured)
+	// Build the replay episode data from the mongo columnar form (returns true if no errors occured)
 	static bool BuildEpisodeData(ASLIndividualManager* IndividualManager, 
-		const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData,
+		const FSLMongoEpisodeData& InMongoEpisodeData,
 		FSLVizEpisodeData& OutVizEpisodeData);
 
+	// Resolve the individuals of the episode to their actors and bones (game thread), outputs the mongo column index of every actor and bone
+	static bool BindEpisodeData(ASLIndividualManager* IndividualManager,
+		const FSLMongoEpisodeData& InMongoEpisodeData,
+		FSLVizEpisodeData& OutVizEpisodeData,
+		TArray<int32>& OutActorSources, TArray<int32>& OutBoneSources);
+
+	// Fill the timestamps, keyframes and change lists of the bound episode (no UObject access, safe to call from worker threads)
+	static void FillEpisodeData(const FSLMongoEpisodeData& InMongoEpisodeData,
+		const TArray<int32>& ActorSources, const TArray<int32>& BoneSources,
+		FSLVizEpisodeData& OutVizEpisodeData);
+
+	// Write the episode data to a binary file (the actors and bones are stored as individual ids)
+	static bool SaveEpisodeData(const FSLVizEpisodeData& InVizEpisodeData, const FString& Path);
+
+	// Read the episode data from a binary file and re-resolve its actors and bones (returns false on errors or version mismatch)
+	static bool LoadEpisodeData(ASLIndividualManager* IndividualManager, const FString& Path,
+		FSLVizEpisodeData& OutVizEpisodeData);
+
+	// Serialize the episode data with its file version (the actors and bones are stored as individual ids, returns false on errors or version mismatch)
+	static bool SerializeEpisodeData(FArchive& Ar, FSLVizEpisodeData& VizEpisodeData);
+
+	// Resolve the actors and bones of the deserialized episode data from their individual ids (game thread)
+	static bool ResolveEpisodeData(ASLIndividualManager* IndividualManager, FSLVizEpisodeData& VizEpisodeData);
+
+	// Check the array count at the archive position against the remaining bytes before the array is allocated
+	// (always true when saving, sets the archive error if the count does not fit)
+	static bool IsArrayNumInBounds(FArchive& Ar, int32 MinElementBytes);
+
 	// Executes a binary search for element Item in array Array using the <= operator (from ProfilerCommon::FBinaryFindIndex)
 	static int32 BinarySearchLessEqual(const TArray<float>& Array, float Value);
 
+public:
+	// Version of the episode data file format (increase on any layout change)
+	static constexpr int32 EpisodeDataFileVersion = 1;
+
 private:
 	// Check if actor requires any special attention when switching to visual only world (return true if the components should be left alone)
 	static bool IsSpecialCaseActor(AActor* Actor);
 
 	// Remove actor components that are not required in the 'visual only' world (e.g. controllers)
 	static void RemoveUnnecessaryComponents(AActor* Actor);
+
+	// Serialize the change list
+	static void SerializeChangeList(FArchive& Ar, FSLVizEpisodeChangeList& ChangeList);
+
+	// Serialize the individual ids, every string count is checked when loading
+	static void SerializeIds(FArchive& Ar, TArray<FString>& Ids);
+
+	// Serialize the keyframes, every pose array count is checked when loading
+	static void SerializeKeyframes(FArchive& Ar, TArray<TArray<FTransform>>& Keyframes);
+
+	// Min serialized size of a transform (rotation, translation and scale)
+	static constexpr int32 MinTransformBytes = 10 * sizeof(float);
+
+	// Fill the keyframes and the per frame change lists of the given mongo columns (the poses are carried forward between the recorded frames)
+	static void FillKeyframesAndChanges(const FSLMongoEpisodeData& InMongoEpisodeData, const TArray<int32>& SourceIndexes,
+		int32 KeyframeInterval, TArray<TArray<FTransform>>& OutKeyframes, FSLVizEpisodeChangeList& OutChanges);
 };
 
+/**
+ * Deferred movement scopes kept open while a whole frame is applied, the attached components
+ * of every moved root are updated once when the batch ends (scopes are closed in reverse order)
+ */
+class USEMLOG_API FSLVizScopedMovementBatch : private FNoncopyable
+{
+public:
+	// Reserve the scopes for the expected number of moved roots
+	explicit FSLVizScopedMovementBatch(int32 ExpectedNum = 0);
+
+	// Close the scopes in reverse order
+	~FSLVizScopedMovementBatch();
 
+	// Teleport the root component without sweeping, its deferred scope is opened on the first move
+	void Move(USceneComponent* RootComponent, const FTransform& Pose);
 
+private:
+	// Open deferred scopes
+	TArray<TUniquePtr<FScopedMovementUpdate>> Scopes;
+};
@@ -0,0 +1,164 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "Viz/SLVizStructs.h"
+#include "Viz/SLVizEpisodeManager.h"
+#include "Viz/SLVizReplayClock.h"
+#include "SLVizGhostReplayManager.generated.h"
+
+// Forward declarations
+class USLVizAssets;
+class UMeshComponent;
+class UMaterialInstanceDynamic;
+
+/*
+* Episode replayed on a set of ghost clones
+*/
+struct FSLVizGhostEpisode
+{
+	// Episode data shared with the episode cache (the actor and bone columns point to the level actors)
+	TSharedPtr<const FSLVizEpisodeData> EpisodeData;
+
+	// Offset added to the episode timestamps on the shared clock
+	float TimeOffset = 0.f;
+
+	// Tint material of the clones (nullptr keeps the original materials)
+	UMaterialInstanceDynamic* Material = nullptr;
+
+	// Ghost clone of every actor column (nullptr if the actor could not be cloned)
+	TArray<AActor*> Ghosts;
+
+	// Level actor to its ghost clone (includes the skeletal actors which only drive bones)
+	TMap<AActor*, AActor*> SourceToGhost;
+
+	// Applies the bone poses on the ghost poseable meshes
+	FSLVizSkeletalPoseApplier SkeletalPoseApplier;
+
+	// Current actor poses
+	TArray<FTransform> ActorState;
+
+	// Current bone poses
+	TArray<FTransform> BoneState;
+
+	// Current frame index
+	int32 ActiveFrameIndex = INDEX_NONE;
+};
+
+/**
+ * Replays multiple episodes at once on ghost clones of the level actors,
+ * the clones are taken from a pool shared by all episodes and reused between sessions,
+ * all the episodes are advanced by a single clock
+ */
+UCLASS(ClassGroup = (SL), DisplayName = "SL Viz Ghost Replay Manager")
+class USEMLOG_API ASLVizGhostReplayManager : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASLVizGhostReplayManager();
+
+protected:
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	// Called when actor removed from game or game ended
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	// Add an episode replayed on ghost clones with the given time offset and tint (returns the episode index, INDEX_NONE on error)
+	int32 AddEpisode(TSharedPtr<const FSLVizEpisodeData> InEpisodeData, float TimeOffset = 0.f,
+		const FSLVizVisualParams& VisualParams = FSLVizVisualParams(FLinearColor(0.2f, 0.6f, 1.f, 0.4f), ESLVizMaterialType::Translucent));
+
+	// Change the time offset of the episode
+	void SetEpisodeTimeOffset(int32 EpisodeIndex, float TimeOffset);
+
+	// Get the number of ghost episodes
+	int32 NumEpisodes() const { return Episodes.Num(); };
+
+	// Release all the episode clones back to the pool
+	void ClearEpisodes();
+
+	// Spawn the clones of the given episode ahead of time (NumSets clones for every actor)
+	void PrewarmPool(const FSLVizEpisodeData& InEpisodeData, int32 NumSets = 1);
+
+	// Destroy all the pooled clones
+	void EmptyPool();
+
+	// Play all the episodes from a single clock (the time range covers all the offset episodes)
+	bool Play(const FSLVizEpisodePlayParams& PlayParams = FSLVizEpisodePlayParams());
+
+	// Set all the episodes as in the given time of the shared clock
+	void GotoTime(float Time);
+
+	// Set replay to pause or play
+	void SetPauseReplay(bool bPause);
+
+	// Stop the replay
+	void StopReplay();
+
+	// Set the replay speed factor (negative values replay in reverse)
+	void SetReplaySpeed(float Speed) { ReplayClock.SetSpeed(Speed); };
+
+private:
+	// Load container with the vizual assets
+	bool LoadAssetsContainer();
+
+	// Get a ghost clone of the actor from the pool (spawns a new one if the pool is empty)
+	AActor* AcquireGhost(AActor* SourceActor);
+
+	// Hide the ghost and return it to the pool
+	void ReleaseGhost(AActor* Ghost);
+
+	// Spawn a new ghost clone of the source mesh component (not added to the pool)
+	AActor* SpawnGhost(UMeshComponent* SourceMC);
+
+	// Get the mesh component which is cloned from the source actor (poseable, skeletal or static)
+	UMeshComponent* GetSourceMeshComponent(AActor* SourceActor) const;
+
+	// Get the mesh asset of the component (used as the pool key)
+	UObject* GetMeshAsset(UMeshComponent* MC) const;
+
+	// Set the tint material on the ghost, or the materials of the source mesh if no tint is given
+	void SetGhostMaterials(AActor* Ghost, UMeshComponent* SourceMC, UMaterialInstanceDynamic* Material) const;
+
+	// Get the time range of the shared clock
+	void GetTimeRange(float& OutStartTime, float& OutEndTime) const;
+
+	// Apply the state of every episode at the given clock time
+	void ApplyTime(float Time);
+
+	// Apply the state of the episode at its local time
+	void ApplyEpisodeTime(FSLVizGhostEpisode& Episode, float LocalTime);
+
+protected:
+	// True if it currently in an active replay
+	uint8 bReplayRunning : 1;
+
+	// Maps the wall time to the shared episode time
+	FSLVizReplayClock ReplayClock;
+
+	// Replayed episodes
+	TArray<FSLVizGhostEpisode> Episodes;
+
+	// Every spawned clone (keeps them referenced)
+	UPROPERTY(VisibleAnywhere, Transient, Category = "Semantic Logger")
+	TArray<AActor*> PooledGhosts;
+
+	// Tint materials of the episodes (keeps them referenced)
+	UPROPERTY(Transient)
+	TArray<UMaterialInstanceDynamic*> EpisodeMaterials;
+
+	// Mesh asset to the free clones
+	TMap<UObject*, TArray<AActor*>> FreeGhosts;
+
+	// Viz assets container
+	USLVizAssets* VizAssetsContainer;
+
+	/* Constants */
+	static constexpr auto AssetsContainerPath = TEXT("SLVizAssets'/USemLog/Viz/SL_VizAssetsContainer.SL_VizAssetsContainer'");
+};
@@ -12,10 +12,63 @@
 class USLVizAssets;
 class UMeshComponent;
 class UMaterialInterface;
+class UMaterialInstanceDynamic;
+
+/**
+ * Visual values identifying a pooled highlight material
+ */
+USTRUCT()
+struct USEMLOG_API FSLVizHighlightMaterialKey
+{
+	GENERATED_BODY()
+
+	// Color of the material
+	UPROPERTY()
+	FLinearColor Color = FLinearColor::Green;
+
+	// Type of the material
+	UPROPERTY()
+	ESLVizMaterialType MaterialType = ESLVizMaterialType::Unlit;
+
+	// Default ctor
+	FSLVizHighlightMaterialKey() {};
+
+	// Init ctor
+	FSLVizHighlightMaterialKey(const FSLVizVisualParams& VisualParams)
+		: Color(VisualParams.Color), MaterialType(VisualParams.MaterialType) {};
+
+	// Equality operator
+	bool operator==(const FSLVizHighlightMaterialKey& Other) const
+	{
+		return Color == Other.Color && MaterialType == Other.MaterialType;
+	};
+
+	// Hash function
+	friend uint32 GetTypeHash(const FSLVizHighlightMaterialKey& Key)
+	{
+		return HashCombine(GetTypeHash(Key.Color), GetTypeHash(static_cast<uint8>(Key.MaterialType)));
+	};
+};
+
+/**
+ * Highlight material shared by all the highlights with the same visual values
+ */
+USTRUCT()
+struct USEMLOG_API FSLVizHighlightPooledMaterial
+{
+	GENERATED_BODY()
+
+	// The shared material
+	UPROPERTY()
+	UMaterialInstanceDynamic* Material = nullptr;
+
+	// Number of highlights using the material
+	int32 NumUsers = 0;
+};
 
 /**
  * Stores the original materials for re-applying them
- * and the dynamic material for allowing dynamic color updates
+ * and the pooled material key of every highlighted slot (individuals can share the mesh, e.g. skeletal bones)
  */
 USTRUCT()
 struct USEMLOG_API FSLVizHighlightData
@@ -26,19 +79,15 @@ struct USEMLOG_API FSLVizHighlightData
 	UPROPERTY()
 	TArray<UMaterialInterface*> OriginalMaterials;
 
-	// Material slots to which to apply the visual parameters (if empty, apply to all slots)
+	// Highlighted material slots with the key of their pooled highlight material
 	UPROPERTY()
-	TArray<int32> MaterialSlots;
+	TMap<int32, FSLVizHighlightMaterialKey> SlotKeys;
 
 	// Default ctor
 	FSLVizHighlightData() {};
 
 	// Init ctor
 	FSLVizHighlightData(const TArray<UMaterialInterface*>& InMaterials) : OriginalMaterials(InMaterials) {};
-
-	// Init ctor
-	FSLVizHighlightData(const TArray<UMaterialInterface*>& InMaterials, const TArray<int32>& InMaterialSlots) 
-		: OriginalMaterials(InMaterials), MaterialSlots(InMaterialSlots){};
 };
 
 
@@ -78,18 +127,27 @@ protected:
 	void RestoreOriginalMaterials();
 
 public:
-	// Highlight the given mesh component
+	// Highlight the given slots of the mesh component (all slots if the params slots are empty)
 	void Highlight(UMeshComponent* MC, const FSLVizVisualParams& VisualParams = FSLVizVisualParams());
 
-	// Update the visual of the given mesh component
+	// Update the visual of the already highlighted slots of the mesh component (all its highlighted slots if the params slots are empty)
 	void UpdateHighlight(UMeshComponent* MC, const FSLVizVisualParams& VisualParams);
 
-	// Clear highlight of a static mesh
-	void ClearHighlight(UMeshComponent* MC);
+	// Clear the highlight of the given slots of the mesh component (all slots if empty), the other slots keep their highlight
+	void ClearHighlight(UMeshComponent* MC, const TArray<int32>& MaterialSlots = TArray<int32>());
 
 	// Clear all highlights
 	void ClearAllHighlights();
 
+	// Highlight (or update) the given mesh components in one pass sharing a single material (target slots overwrite the params slots)
+	void HighlightBatch(const TArray<FSLVizIndividualHighlightData>& Targets, const FSLVizVisualParams& VisualParams);
+
+	// Clear the highlights of the given mesh component slots in one pass
+	void ClearHighlightBatch(const TArray<FSLVizIndividualHighlightData>& Targets);
+
+	// Set the max number of unused materials kept in the pool
+	void SetMaxNumPooledMaterials(int32 Value);
+
 private:
 	// Bind delegates
 	void BindDelgates();
@@ -100,12 +158,39 @@ private:
 	// Create a dynamic material instance
 	UMaterialInstanceDynamic* CreateTransientMID(ESLVizMaterialType InMaterialType);
 
+	// Get the shared material of the visual values from the pool (created if missing), increases its users count
+	UMaterialInstanceDynamic* AcquireMaterial(const FSLVizHighlightMaterialKey& Key, int32 NumNewUsers = 1);
+
+	// Decrease the users count of the pooled material, unused materials above the pool limit are removed
+	void ReleaseMaterial(const FSLVizHighlightMaterialKey& Key);
+
+	// Remove the unused materials if the pool is above its limit
+	void TrimMaterialPool();
+
+	// Set the material key of the slots (all slots if empty), outputs the slots which changed and the keys they used before
+	void AssignSlotKeys(UMeshComponent* MC, const TArray<int32>& MaterialSlots, const FSLVizHighlightMaterialKey& Key,
+		bool bOnlyHighlighted, TArray<int32>& OutChangedSlots, TArray<FSLVizHighlightMaterialKey>& OutReleasedKeys);
+
+	// Restore the original materials of the slots (all highlighted slots if empty), outputs the keys they used
+	void ClearSlotKeys(UMeshComponent* MC, const TArray<int32>& MaterialSlots, TArray<FSLVizHighlightMaterialKey>& OutReleasedKeys);
+
+	// Apply the material to the given slots
+	static void ApplyMaterial(UMeshComponent* MC, const TArray<int32>& MaterialSlots, UMaterialInterface* Material);
+
 
 protected:
-	// List of the highlighted static meshes with their original materials
+	// List of the highlighted meshes with their original materials and highlighted slots
 	//UPROPERTY()
 	TMap<UMeshComponent*, FSLVizHighlightData> HighlightedStaticMeshes;
 
+	// Highlight materials shared between the highlights with the same visual values
+	UPROPERTY()
+	TMap<FSLVizHighlightMaterialKey, FSLVizHighlightPooledMaterial> MaterialPool;
+
+	// Max number of materials kept in the pool, the unused ones above the limit are removed
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	int32 MaxNumPooledMaterials = 64;
+
 private:
 	// Viz assets container
 	USLVizAssets* VizAssetsContainer;
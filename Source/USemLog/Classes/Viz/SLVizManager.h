@@ -7,6 +7,9 @@
 #include "GameFramework/Info.h"
 #include "Viz/SLVizStructs.h"
 #include "Viz/SLVizEpisodeManager.h"
+#include "Viz/SLVizEpisodeCache.h"
+#include "Viz/SLVizEpisodeDiskCache.h"
+#include "Mongo/SLMongoEpisodeData.h"
 #include "SLVizManager.generated.h"
 
 // Forward declarations
@@ -15,9 +18,55 @@ class ASLVizMarkerManager;
 //class ASLVizEpisodeManager;
 class ASLIndividualManager;
 class ASLVizCameraDirector;
+class ASLVizGhostReplayManager;
 class USLVizBaseMarker;
 class UMeshComponent;
 
+// Notify when a background cached episode is ready
+DECLARE_MULTICAST_DELEGATE_TwoParams(FSLVizEpisodeCachedSignature, const FString& /*Id*/, bool /*bSuccess*/);
+
+/*
+* Background episode caching request
+*/
+struct FSLVizEpisodeCacheRequest
+{
+	// Id of the episode
+	FString Id;
+
+	// Fetches the mongo episode data (called on a worker thread)
+	TFunction<FSLMongoEpisodeData()> FetchFunc;
+
+	// Called on the game thread when the episode is cached (or failed)
+	TFunction<void(const FString&, bool)> OnCached;
+
+	// Task of the episode (the disk cache is used if set)
+	FString TaskId;
+
+	// Reads the episode metadata for the disk cache validation (called on a worker thread)
+	TFunction<bool(FSLMongoEpisodeMetadata&)> MetadataFunc;
+
+	// Metadata of the episode (valid if read)
+	FSLMongoEpisodeMetadata Metadata;
+
+	// True if the viz data was read from the disk cache
+	bool bReadFromDisk = false;
+
+	// Fetched mongo data
+	FSLMongoEpisodeData MongoEpisodeData;
+
+	// Built viz data
+	FSLVizEpisodeData VizEpisodeData;
+
+	// Mongo column index of the actors
+	TArray<int32> ActorSources;
+
+	// Mongo column index of the bones
+	TArray<int32> BoneSources;
+
+	// Set on reset, the workers skip their remaining stages (a running database query still finishes)
+	FThreadSafeBool bCancelled;
+};
+
 /*
 *
 */
@@ -65,6 +114,13 @@ public:
 	// Remove all individual highlights
 	void RemoveAllIndividualHighlights();
 
+	// Highlight (or update) the individuals in one pass sharing a single material (returns the number of highlighted individuals)
+	int32 HighlightIndividuals(const TArray<FString>& Ids,
+		const FLinearColor& Color = FLinearColor::Green, ESLVizMaterialType MaterialType = ESLVizMaterialType::Translucent);
+
+	// Remove the highlights of the individuals in one pass (returns the number of removed highlights)
+	int32 RemoveIndividualHighlights(const TArray<FString>& Ids);
+
 	// Spawn or get manager from the world
 	static ASLVizManager* GetExistingOrSpawnNew(UWorld* World);
 
@@ -102,7 +158,34 @@ public:
 		const FSLVizTimelineParams& TimelineParams);
 
 
+	/* Trajectory level of detail markers */
+	// Create a primitive marker at the trajectory poses simplified with the camera distance
+	bool CreatePrimitiveMarkerLOD(const FString& MarkerId, const TArray<FTransform>& Poses,
+		ESLVizPrimitiveMarkerType PrimitiveType, float Size,
+		const FLinearColor& Color, ESLVizMaterialType MaterialType,
+		const FSLVizTrajectoryLODParams& LODParams);
+
+	// Create a marker by cloning the visual of the given individual at the trajectory poses simplified with the camera distance
+	bool CreateStaticMeshMarkerLOD(const FString& MarkerId, const TArray<FTransform>& Poses,
+		const FString& IndividualId, const FLinearColor& Color, ESLVizMaterialType MaterialType,
+		const FSLVizTrajectoryLODParams& LODParams);
+
+
+	/* Trajectory (single mesh) markers */
+	// Create a line or ribbon trajectory marker
+	bool CreateTrajectoryMarker(const FString& MarkerId, const TArray<FTransform>& Poses,
+		const FSLVizTrajectoryParams& TrajectoryParams, ESLVizMaterialType MaterialType = ESLVizMaterialType::Unlit);
+
+	// Create a line or ribbon trajectory marker timeline
+	bool CreateTrajectoryMarkerTimeline(const FString& MarkerId, const TArray<FTransform>& Poses,
+		const FSLVizTrajectoryParams& TrajectoryParams, ESLVizMaterialType MaterialType,
+		const FSLVizTimelineParams& TimelineParams);
+
+
 	/* Skeletal mesh markers */
+	// Set the max number of poseable mesh instances of the next skeletal markers (more poses are evenly subsampled)
+	void SetSkeletalMarkerMaxNumInstances(int32 Value);
+
 	// Create a marker by cloning the visual of the given skeletal individual (use original materials)
 	bool CreateSkeletalMeshMarker(const FString& MarkerId,
 		const TArray<TPair<FTransform, TMap<int32, FTransform>>>& SkeletalPoses,
@@ -162,10 +245,40 @@ public:
 	bool IsWorldConvertedToVisualizationMode() const;
 
 	// Cache the mongo data into an episode format
-	bool CacheEpisodeData(const FString& Id, const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData);
+	bool CacheEpisodeData(const FString& Id, const FSLMongoEpisodeData& InMongoEpisodeData);
 
 	// Check if the episode is already cached
-	bool IsEpisodeCached(const FString& Id) const { return CachedEpisodeData.Contains(Id); };
+	bool IsEpisodeCached(const FString& Id) const { return EpisodeCache.Contains(Id); };
+
+	// Cache the episode in the background, the data is fetched on a worker thread, only the actor binding runs on the game thread,
+	// if the task and metadata function are given the episode is read from (and written to) the disk cache
+	bool CacheEpisodeDataAsync(const FString& Id, TFunction<FSLMongoEpisodeData()> FetchFunc,
+		TFunction<void(const FString&, bool)> OnCached = nullptr,
+		const FString& TaskId = FString(), TFunction<bool(FSLMongoEpisodeMetadata&)> MetadataFunc = nullptr);
+
+	// Cache the episode from the disk cache if it matches the metadata (returns false if not available or stale)
+	bool CacheEpisodeDataFromDisk(const FString& TaskId, const FString& Id, const FSLMongoEpisodeMetadata& Metadata);
+
+	// Write the cached episode with its metadata to the disk cache
+	bool WriteEpisodeDataToDisk(const FString& TaskId, const FString& Id, const FSLMongoEpisodeMetadata& Metadata);
+
+	// Enable/disable the persistent disk cache
+	void SetEpisodeDiskCacheEnabled(bool bEnable) { bUseEpisodeDiskCache = bEnable; EpisodeDiskCache.SetEnabled(bEnable); };
+
+	// Set the persistent disk cache size budget in MB (0 for unlimited), the least recently used episodes are removed
+	void SetEpisodeDiskCacheBudget(int32 MaxMB);
+
+	// Check if the episode is queued or being cached in the background
+	bool IsEpisodeBeingCached(const FString& Id) const;
+
+	// Set the max number of episodes cached in parallel in the background
+	void SetMaxConcurrentEpisodeCaching(int32 Value) { MaxConcurrentEpisodeCaching = FMath::Max(Value, 1); };
+
+	// Set the episode cache memory budget in MB (0 for unlimited), evicted episodes are written to disk if bSpillToDisk is set
+	void SetEpisodeCacheBudget(int32 MaxMB, bool bSpillToDisk = false);
+
+	// Get the episode cache statistics (hits, misses, evictions, memory)
+	const FSLVizEpisodeCacheStats& GetEpisodeCacheStats() const { return EpisodeCache.GetStats(); };
 
 	// Load cached episode data
 	bool LoadCachedEpisodeData(const FString& Id);
@@ -177,7 +290,7 @@ public:
 	bool GotoCachedEpisodeFrame(const FString& Id, float Ts);
 
 	// Change the data into an episode format and load it to the episode replay manager
-	void LoadEpisodeData(const TArray<TPair<float, TMap<FString, FTransform>>>& InCompactEpisodeData);
+	void LoadEpisodeData(const FSLMongoEpisodeData& InMongoEpisodeData);
 
 	// Check if any episode is loaded (return the name of the episode)
 	bool IsEpisodeLoaded() const;
@@ -197,6 +310,32 @@ public:
 	// Stop replay (if active, and goto frame 0)
 	void StopReplay();
 
+	// Set the replay speed factor (negative values replay in reverse)
+	void SetReplaySpeed(float Speed);
+
+	/* Ghost replay */
+	// Add the cached episode to the multi episode ghost replay (replayed on pooled clones with the given tint and time offset)
+	bool AddGhostEpisode(const FString& Id, float TimeOffset = 0.f,
+		const FSLVizVisualParams& VisualParams = FSLVizVisualParams(FLinearColor(0.2f, 0.6f, 1.f, 0.4f), ESLVizMaterialType::Translucent));
+
+	// Remove all the ghost episodes (the clones are kept in the pool for the next session)
+	void ClearGhostEpisodes();
+
+	// Spawn the ghost clones of the cached episode ahead of time
+	void PrewarmGhostPool(const FString& Id, int32 NumSets = 1);
+
+	// Replay all the ghost episodes from a single clock
+	bool PlayGhostEpisodes(const FSLVizEpisodePlayParams& Params = FSLVizEpisodePlayParams());
+
+	// Set the ghost episodes as in the given time
+	void GotoGhostEpisodesTime(float Ts);
+
+	// Pause/unpause the ghost replay
+	void PauseGhostReplay(bool bPause);
+
+
+	// Called when a background cached episode is ready
+	FSLVizEpisodeCachedSignature OnEpisodeCached;
 
 	/* View */
 	// Move the view to a given position
@@ -211,6 +350,15 @@ public:
 	// Make sure the camera view is detached
 	void DetachCameraView();
 
+	// Move the camera view along a spline through the keyframes, driven by the episode replay time
+	bool SetCameraViewPath(const TArray<FSLVizCameraKeyframe>& Keyframes);
+
+	// Move the camera view along a precomputed path framing the individuals over the loaded episode
+	bool SetCameraViewFramingPath(const TArray<FString>& Ids, const FSLVizCameraFramingParams& Params = FSLVizCameraFramingParams());
+
+	// Stop following the camera view path
+	void ClearCameraViewPath();
+
 private:
 	/* Managers */
 	// Get the individual manager from the world (or spawn a new one)
@@ -219,6 +367,9 @@ private:
 	// Get the vizualization highlight manager from the world (or spawn a new one)
 	bool SetVizHighlightManager();
 
+	// Get the mesh component and the material slots to highlight of the individual (returns false if not of a supported visual type)
+	bool GetIndividualHighlightTarget(const FString& Id, FSLVizIndividualHighlightData& OutTarget) const;
+
 	// Get the vizualization marker manager from the world (or spawn a new one)
 	bool SetVizMarkerManager();
 
@@ -227,6 +378,22 @@ private:
 
 	// Get the vizualization camera director from the world (or spawn a new one)
 	bool SetCameraDirector();
+
+	// Get the ghost replay manager from the world (or spawn a new one)
+	bool SetGhostReplayManager();
+
+	/* Background caching */
+	// Start the queued caching requests up to the concurrency limit
+	void StartQueuedCacheRequests();
+
+	// Read the request data on a worker thread (from the disk cache if allowed and up to date, otherwise from the database)
+	void DispatchCacheRequestRead(TSharedPtr<FSLVizEpisodeCacheRequest> Request, bool bAllowDiskCache);
+
+	// Bind the fetched episode on the game thread and fill it in the background
+	void OnCacheRequestFetched(TSharedPtr<FSLVizEpisodeCacheRequest> Request);
+
+	// Add the filled episode to the cache and notify the listeners
+	void FinishCacheRequest(TSharedPtr<FSLVizEpisodeCacheRequest> Request, bool bSuccess);
 	
 private:
 	// True if the manager is initialized
@@ -263,8 +430,41 @@ private:
 	UPROPERTY(VisibleAnywhere, Transient, Category = "Semantic Logger")
 	ASLVizCameraDirector* CameraDirector;
 
+	// Replays multiple episodes on pooled ghost clones
+	UPROPERTY(VisibleAnywhere, Transient, Category = "Semantic Logger")
+	ASLVizGhostReplayManager* GhostReplayManager;
+
 
 	/* Cached data */
-	// Episode id to viz episode data
-	TMap<FString, FSLVizEpisodeData> CachedEpisodeData;
+	// Memory budget of the cached episodes in MB (0 for unlimited)
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	int32 EpisodeCacheBudgetMB = 0;
+
+	// Write the episodes evicted from the cache to disk and reload them on demand
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	bool bSpillEvictedEpisodes = false;
+
+	// Episode id to viz episode data (memory budgeted)
+	FSLVizEpisodeCache EpisodeCache;
+
+	// Keep the built episodes on disk between sessions, validated against the episode metadata
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	bool bUseEpisodeDiskCache = true;
+
+	// Size budget of the episodes on disk in MB (0 for unlimited)
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bUseEpisodeDiskCache"))
+	int32 EpisodeDiskCacheBudgetMB = 4096;
+
+	// Task and episode id to the built episode on disk
+	FSLVizEpisodeDiskCache EpisodeDiskCache;
+
+	// Max number of episodes cached in parallel in the background
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	int32 MaxConcurrentEpisodeCaching = 2;
+
+	// Background caching requests waiting to start
+	TArray<TSharedPtr<FSLVizEpisodeCacheRequest>> QueuedCacheRequests;
+
+	// Background caching requests in progress
+	TMap<FString, TSharedPtr<FSLVizEpisodeCacheRequest>> ActiveCacheRequests;
 };
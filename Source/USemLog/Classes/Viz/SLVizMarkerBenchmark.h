@@ -0,0 +1,85 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+* Parameters of the marker and highlight stress benchmark
+*/
+struct FSLVizMarkerBenchmarkParams
+{
+	// Number of primitive and static mesh markers
+	int32 NumMarkers = 500;
+
+	// Number of poses (instances) of every marker
+	int32 NumPoses = 200;
+
+	// Number of skeletal markers (requires a skeletal mesh)
+	int32 NumSkeletal = 0;
+
+	// Number of poses of every skeletal marker
+	int32 NumSkeletalPoses = 8;
+
+	// Number of highlighted mesh actors
+	int32 NumHighlights = 2000;
+
+	// Number of update rounds (new poses and colors)
+	int32 NumUpdates = 4;
+
+	// Static mesh used for the static mesh markers and the highlighted actors
+	FString StaticMeshPath = TEXT("/Engine/BasicShapes/Cube.Cube");
+
+	// Skeletal mesh used for the skeletal markers
+	FString SkeletalMeshPath;
+
+	// Seed of the random poses and colors
+	int32 Seed = 0;
+};
+
+/*
+* Engine counters snapshot used to measure a benchmark operation
+*/
+struct FSLVizBenchmarkCounters
+{
+	// Wall time on the game thread
+	double Time = 0.0;
+
+	// Number of live UObjects
+	int32 NumObjects = 0;
+
+	// Number of allocator calls (-1 if not tracked in this build)
+	int64 MallocCalls = -1;
+	int64 FreeCalls = -1;
+	int64 ReallocCalls = -1;
+
+	// Used physical memory
+	uint64 UsedPhysical = 0;
+
+	// Take a snapshot of the current counters
+	static FSLVizBenchmarkCounters Capture();
+};
+
+/**
+ * Headless stress benchmark of the marker and highlight managers, creates, updates and destroys
+ * large numbers of primitive, static and skeletal markers and highlights in a transient world,
+ * reports per operation the game thread time, object, allocation and garbage collection counts as json,
+ * run with: -nullrhi -ExecCmds="SL.Viz.MarkerBenchmark Markers=500 Poses=200 Highlights=2000 Updates=4, Quit"
+ */
+class FSLVizMarkerBenchmark
+{
+public:
+	// Run the benchmark, outputs the results as json (returns false on errors)
+	static bool Run(const FSLVizMarkerBenchmarkParams& Params, FString& OutJson);
+
+	// Run the benchmark from the console command arguments and write the results to file
+	static void RunFromArgs(const TArray<FString>& Args);
+
+private:
+	// Run the operation and append its measurements to the json operations array
+	static void Measure(const FString& Name, int32 NumItems, TFunctionRef<void()> Operation, TArray<FString>& OutOperations);
+
+	// Run a full garbage collection and append its measurements (objects purged, duration)
+	static void MeasureGC(const FString& Name, TArray<FString>& OutOperations);
+};
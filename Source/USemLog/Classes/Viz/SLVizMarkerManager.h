@@ -9,8 +9,24 @@
 #include "Viz/Markers/SLVizStaticMeshMarker.h"
 #include "Viz/Markers/SLVizSkeletalMeshMarker.h"
 #include "Viz/Markers/SLVizSkeletalBoneMeshMarker.h"
+#include "Viz/Markers/SLVizTrajectoryMarker.h"
+#include "Viz/SLVizTrajectoryLOD.h"
 #include "SLVizMarkerManager.generated.h"
 
+/*
+* Level of detail data of a trajectory marker
+*/
+struct FSLVizTrajectoryLODMarker
+{
+	// Ranked poses of the trajectory
+	FSLVizTrajectoryLOD LOD;
+
+	// Level of detail parameters
+	FSLVizTrajectoryLODParams Params;
+
+	// Tolerance scale of the current level (negative if not set)
+	float ToleranceScale = -1.f;
+};
 
 /*
 * Spawns and keeps track of markers
@@ -30,6 +46,9 @@ protected:
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
+	// Called every update interval, sets the camera distance based trajectory levels
+	virtual void Tick(float DeltaTime) override;
+
 	// Clear marker
 	void ClearMarker(USLVizBaseMarker* Marker);
 	
@@ -80,7 +99,37 @@ public:
 		const FSLVizTimelineParams& TimelineParams);
 
 
+	/* Trajectory level of detail markers */
+	// Create a static mesh visual marker at the simplified poses
+	USLVizStaticMeshMarker* CreateStaticMeshMarkerLOD(const TArray<FTransform>& Poses, UStaticMesh* SM,
+		const FLinearColor& InColor, ESLVizMaterialType MaterialType,
+		const FSLVizTrajectoryLODParams& LODParams);
+
+	// Create a primitive marker at the simplified poses
+	USLVizPrimitiveMarker* CreatePrimitiveMarkerLOD(const TArray<FTransform>& Poses,
+		ESLVizPrimitiveMarkerType PrimitiveType, float Size,
+		const FLinearColor& InColor, ESLVizMaterialType MaterialType,
+		const FSLVizTrajectoryLODParams& LODParams);
+
+	// Update the level of detail parameters of a trajectory marker (the poses are kept)
+	void SetMarkerLODParams(USLVizStaticMeshMarker* Marker, const FSLVizTrajectoryLODParams& LODParams);
+
+
+	/* Trajectory (single mesh) markers */
+	// Create a line or ribbon trajectory marker at the given poses
+	USLVizTrajectoryMarker* CreateTrajectoryMarker(const TArray<FTransform>& Poses,
+		const FSLVizTrajectoryParams& TrajectoryParams, ESLVizMaterialType MaterialType = ESLVizMaterialType::Unlit);
+
+	// Create a line or ribbon trajectory marker timeline at the given poses
+	USLVizTrajectoryMarker* CreateTrajectoryMarkerTimeline(const TArray<FTransform>& Poses,
+		const FSLVizTrajectoryParams& TrajectoryParams, ESLVizMaterialType MaterialType,
+		const FSLVizTimelineParams& TimelineParams);
+
+
 	/* Skeletal mesh markers */
+	// Set the max number of poseable mesh instances of the new skeletal markers (more poses are evenly subsampled)
+	void SetSkeletalMarkerMaxNumInstances(int32 Value) { SkeletalMarkerMaxNumInstances = FMath::Max(Value, 1); };
+
 	// Create a skeletal mesh based marker at the given pose (use original material)
 	USLVizSkeletalMeshMarker* CreateSkeletalMarker(const TPair<FTransform, TMap<int32, FTransform>>& SkeletalPose,
 		USkeletalMesh* SkelMesh);
@@ -113,21 +162,55 @@ public:
 
 	/* Skeletal mesh (bone) markers */
 	// Create a skeletal bone visual marker at the given pose (use original material)
-	USLVizSkeletalMeshMarker* CreateSkeletalBoneMarker(const FTransform& Pose, USkeletalMesh* SkelMesh, int32 MaterialIndex);
+	USLVizSkeletalBoneMeshMarker* CreateSkeletalBoneMarker(const FTransform& Pose, USkeletalMesh* SkelMesh, int32 BoneIndex,
+		int32 MaterialIndex);
 
 	// Create a skeletal bone visual marker at the given pose
-	USLVizSkeletalMeshMarker* CreateSkeletalBoneMarker(const FTransform& Pose, USkeletalMesh* SkelMesh, int32 MaterialIndex,
+	USLVizSkeletalBoneMeshMarker* CreateSkeletalBoneMarker(const FTransform& Pose, USkeletalMesh* SkelMesh, int32 BoneIndex,
+		int32 MaterialIndex,
 		const FLinearColor& InColor, ESLVizMaterialType MaterialType);
 
 	// Create a skeletal bone visual marker at the given poses (use original material)
-	USLVizSkeletalMeshMarker* CreateSkeletalBoneMarker(const TArray<FTransform>& Poses, USkeletalMesh* SkelMesh, int32 MaterialIndex);
+	USLVizSkeletalBoneMeshMarker* CreateSkeletalBoneMarker(const TArray<FTransform>& Poses, USkeletalMesh* SkelMesh, int32 BoneIndex,
+		int32 MaterialIndex);
 
 	// Create a skeletal bone visual marker at the given poses
-	USLVizSkeletalMeshMarker* CreateSkeletalBoneMarker(const TArray<FTransform>& Poses, USkeletalMesh* SkelMesh, int32 MaterialIndex,
+	USLVizSkeletalBoneMeshMarker* CreateSkeletalBoneMarker(const TArray<FTransform>& Poses, USkeletalMesh* SkelMesh, int32 BoneIndex,
+		int32 MaterialIndex,
 		const FLinearColor& InColor, ESLVizMaterialType MaterialType);
 
+	// Create a skeletal bone timeline marker at the given poses (use original material)
+	USLVizSkeletalBoneMeshMarker* CreateSkeletalBoneMarkerTimeline(const TArray<FTransform>& Poses, USkeletalMesh* SkelMesh, int32 BoneIndex,
+		int32 MaterialIndex,
+		const FSLVizTimelineParams& TimelineParams);
+
+	// Create a skeletal bone timeline marker at the given poses
+	USLVizSkeletalBoneMeshMarker* CreateSkeletalBoneMarkerTimeline(const TArray<FTransform>& Poses, USkeletalMesh* SkelMesh, int32 BoneIndex,
+		int32 MaterialIndex,
+		const FLinearColor& InColor, ESLVizMaterialType MaterialType,
+		const FSLVizTimelineParams& TimelineParams);
+
+	// Clear the cached bone meshes (the markers using them are cleared as well)
+	void ClearBoneMeshCache();
+
 
 private:
+	// Rank the trajectory poses of the marker and set its initial level
+	void AddTrajectoryLODMarker(USLVizStaticMeshMarker* Marker, const TArray<FTransform>& Poses,
+		const FSLVizTrajectoryLODParams& LODParams);
+
+	// Set the marker instances to the level of the tolerance scale (skipped if the level is unchanged)
+	void ApplyTrajectoryLOD(USLVizStaticMeshMarker* Marker, FSLVizTrajectoryLODMarker& LODMarker, float ToleranceScale);
+
+	// Get the (power of two) tolerance scale of the trajectory from the camera distance
+	float GetCameraToleranceScale(const FSLVizTrajectoryLODMarker& LODMarker, const FVector& CameraLocation) const;
+
+	// Enable the tick only if there are camera distance based trajectory markers
+	void UpdateTickEnabled();
+
+	// Get the cached static mesh of the bone geometry (extracted on the first request)
+	UStaticMesh* GetBoneStaticMesh(USkeletalMesh* SkelMesh, int32 BoneIndex, int32 MaterialIndex);
+
 	// Create and store marker helper function
 	template <class T>
 	T* CreateAndAddNewMarker(UObject* Outer)
@@ -146,4 +229,19 @@ protected:
 	// Collection of the markers
 	UPROPERTY(VisibleAnywhere, Transient, Category = "Semantic Logger")
 	TSet<USLVizBaseMarker*> Markers;
+
+	// Max number of poseable mesh instances of the new skeletal markers
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (ClampMin = 1))
+	int32 SkeletalMarkerMaxNumInstances = 128;
+
+	// Level of detail data of the trajectory markers (the markers are kept alive by the markers set)
+	TMap<USLVizStaticMeshMarker*, FSLVizTrajectoryLODMarker> TrajectoryLODMarkers;
+
+	// Static meshes of the bone geometries shared by all the bone markers (key: skeletal mesh path, bone and material index)
+	UPROPERTY(Transient)
+	TMap<FString, UStaticMesh*> BoneMeshCache;
+
+	/* Constants */
+	// Interval of the camera distance level updates
+	static constexpr float TrajectoryLODUpdateInterval = 0.2f;
 };
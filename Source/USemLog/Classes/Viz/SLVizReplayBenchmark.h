@@ -0,0 +1,62 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Forward declarations
+struct FSLMongoEpisodeData;
+class USkeletalMesh;
+
+/*
+* Synthetic episode parameters of the replay benchmark
+*/
+struct FSLVizReplayBenchmarkParams
+{
+	// Number of rigid individuals
+	int32 NumIndividuals = 1000;
+
+	// Number of skeletal individuals (requires a skeletal mesh, every bone is a column)
+	int32 NumSkeletal = 0;
+
+	// Number of frames
+	int32 NumFrames = 10000;
+
+	// Recording rate of the synthetic episode
+	float FrameRate = 60.f;
+
+	// Ratio of the individuals which move in a frame
+	float MovingRatio = 0.1f;
+
+	// Number of random gotos
+	int32 NumGotos = 256;
+
+	// Frames between two keyframes
+	int32 KeyframeInterval = 128;
+
+	// Skeletal mesh used for the skeletal individuals
+	FString SkeletalMeshPath;
+
+	// Seed of the synthetic data
+	int32 Seed = 0;
+};
+
+/**
+ * Headless replay throughput benchmark, generates a synthetic episode (no database required),
+ * builds the replay data and applies it in a transient world, the results are written as json,
+ * run with: -nullrhi -ExecCmds="SL.Viz.ReplayBenchmark Individuals=1000 Skeletal=0 Frames=10000 Gotos=256, Quit"
+ */
+class FSLVizReplayBenchmark
+{
+public:
+	// Run the benchmark, outputs the results as json (returns false on errors)
+	static bool Run(const FSLVizReplayBenchmarkParams& Params, FString& OutJson);
+
+	// Run the benchmark from the console command arguments and write the results to file
+	static void RunFromArgs(const TArray<FString>& Args);
+
+private:
+	// Generate the synthetic mongo episode data (rigid columns, skeletal root columns, then the bone columns)
+	static void GenerateEpisodeData(const FSLVizReplayBenchmarkParams& Params, int32 NumBones, FSLMongoEpisodeData& OutEpisodeData);
+};
@@ -0,0 +1,82 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+
+/*
+* Maps the elapsed wall time to the episode time with a speed factor (negative for reverse),
+* the episode time is independent of the tick rate, late ticks jump ahead instead of accumulating lag
+*/
+struct FSLVizReplayClock
+{
+	// Start the clock in the given episode time range (reverse replays start from the end)
+	void Start(float InStartTime, float InEndTime, float InSpeed, bool bInLoop)
+	{
+		StartTime = InStartTime;
+		EndTime = FMath::Max(InStartTime, InEndTime);
+		Speed = InSpeed;
+		bLoop = bInLoop;
+		Time = Speed < 0.f ? EndTime : StartTime;
+		LastWallTime = FPlatformTime::Seconds();
+	};
+
+	// Resume after a pause (the paused wall time is not counted)
+	void Resume() { LastWallTime = FPlatformTime::Seconds(); };
+
+	// Move the clock to the given episode time (seek), the replay continues from there
+	void SetTime(float InTime)
+	{
+		Time = InTime;
+		LastWallTime = FPlatformTime::Seconds();
+	};
+
+	// Change the speed factor (negative for reverse)
+	void SetSpeed(float InSpeed) { Speed = InSpeed; };
+
+	// Get the speed factor
+	float GetSpeed() const { return Speed; };
+
+	// Get the current episode time
+	float GetTime() const { return static_cast<float>(Time); };
+
+	// Advance the episode time with the elapsed wall time (returns false if a boundary was reached without loop)
+	bool Advance()
+	{
+		const double Now = FPlatformTime::Seconds();
+		Time += (Now - LastWallTime) * Speed;
+		LastWallTime = Now;
+		if (Time >= StartTime && Time <= EndTime)
+		{
+			return true;
+		}
+
+		const double Duration = EndTime - StartTime;
+		if (bLoop && Duration > 0.0)
+		{
+			Time -= Duration * FMath::FloorToDouble((Time - StartTime) / Duration);
+			return true;
+		}
+		Time = FMath::Clamp(Time, double(StartTime), double(EndTime));
+		return false;
+	};
+
+private:
+	// Episode time range
+	float StartTime = 0.f;
+	float EndTime = 0.f;
+
+	// Episode seconds per wall second (negative for reverse)
+	float Speed = 1.f;
+
+	// Wrap around at the boundaries
+	bool bLoop = false;
+
+	// Current episode time
+	double Time = 0.0;
+
+	// Wall time of the last advance
+	double LastWallTime = 0.0;
+};
@@ -53,6 +53,26 @@ public:
 	// Iterate callback
 	void SetIndividualsHiddenIterateCallback();
 
+	// Hide/show the individuals in one indexed pass (only the actors changing their state are touched)
+	void SetIndividualsHiddenBatch(const TArray<FString>& Ids, bool bNewHidden);
+
+	// Hide/show all the individuals of the given semantic classes
+	void SetClassesHidden(const TArray<FString>& Classes, bool bNewHidden);
+
+	// Hide/show all the individuals of the given types (grouped by their individual type name, e.g. SkeletalIndividual)
+	void SetTypesHidden(const TArray<FString>& Types, bool bNewHidden);
+
+	// Hide/show all the individuals except the given ids, classes and types (which get the opposite value),
+	// repeated queries with the same value only touch the previously and newly excepted actors
+	void SetAllIndividualsHiddenExcept(const TArray<FString>& Ids, const TArray<FString>& Classes,
+		const TArray<FString>& Types, bool bNewHidden);
+
+	// Rebuild the id, class and type lookup of the individual actors
+	void BuildVisibilityIndex();
+
+	// Rebuild the lookup before the next visibility change (call if the individuals changed)
+	void MarkVisibilityIndexDirty() { bVisibilityIndexDirty = true; };
+
 	// Spawn or get manager from the world
 	static ASLVizSemMapManager* GetExistingOrSpawnNew(UWorld* World);
 
@@ -64,6 +84,19 @@ protected:
 	// Get the viz manager from the world (or spawn a new one)
 	bool SetVizManager();
 
+	// Rebuild the lookup if it was marked dirty or the number of individuals changed
+	void UpdateVisibilityIndex();
+
+	// Set the hidden value of the indexed actor (skipped if unchanged)
+	void SetIndexedActorHidden(int32 ActorIndex, bool bNewHidden);
+
+	// Set the hidden value of the indexed actors of the groups (classes or types)
+	void SetGroupsHidden(const TMap<FString, TArray<int32>>& GroupToActorIndexes, const TArray<FString>& Groups, bool bNewHidden);
+
+	// Collect the indexed actors of the ids, classes and types
+	void CollectIndexedActors(const TArray<FString>& Ids, const TArray<FString>& Classes,
+		const TArray<FString>& Types, TSet<int32>& OutActorIndexes) const;
+
 protected:
 	// True when successfully initialized
 	bool bIsInit;
@@ -79,6 +112,37 @@ protected:
 	UPROPERTY(VisibleAnywhere, Transient, Category = "Semantic Logger")
 	ASLVizManager* VizManager;
 
+	// Unique actors of the individuals (several individuals can share an actor, e.g. bones)
+	UPROPERTY(Transient)
+	TArray<AActor*> IndexedActors;
+
+	// Individual id to the index of its actor
+	TMap<FString, int32> IdToActorIndex;
+
+	// Semantic class to the indexes of its actors
+	TMap<FString, TArray<int32>> ClassToActorIndexes;
+
+	// Individual type name to the indexes of its actors
+	TMap<FString, TArray<int32>> TypeToActorIndexes;
+
+	// Number of individuals when the lookup was built
+	int32 NumIndexedIndividuals;
+
+	// True if the lookup needs to be rebuilt
+	bool bVisibilityIndexDirty;
+
+	// True if all the actors were set to the base hidden value (the actors listed as off base can differ)
+	bool bHasBaseHidden;
+
+	// Hidden value set to all the actors by the last hide/show all
+	bool bBaseHidden;
+
+	// Actors which might differ from the base hidden value
+	TArray<int32> OffBaseActorIndexes;
+
+	// Flags of the actors listed as off base
+	TBitArray<> OffBaseFlags;
+
 private:
 	// Iterate execution timer handle
 	FTimerHandle IterateTimerHandle;
@@ -0,0 +1,65 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Forward declaration
+class UPoseableMeshComponent;
+struct FSLVizEpisodeBoneTarget;
+
+/*
+* Bone mappings of a poseable mesh driven by the episode
+*/
+struct FSLVizSkeletalPoseMesh
+{
+	// The poseable mesh
+	UPoseableMeshComponent* PoseableMeshComponent = nullptr;
+
+	// Parent index of every bone (from the reference skeleton)
+	TArray<int32> ParentIndexes;
+
+	// Episode bone column of every bone (INDEX_NONE if the bone is not recorded)
+	TArray<int32> Columns;
+
+	// Scratch component space transforms used during the hierarchical pass
+	TArray<FTransform> ComponentSpaceTransforms;
+};
+
+/**
+ * Applies the world space bone poses of an episode to the poseable meshes, the bone mappings are
+ * precomputed once per episode and every mesh is posed in a single parent-first pass
+ */
+struct FSLVizSkeletalPoseApplier
+{
+public:
+	// Precompute the mesh and bone mappings of the episode bone columns
+	void Init(const TArray<FSLVizEpisodeBoneTarget>& Bones);
+
+	// Clear the mappings
+	void Reset();
+
+	// Number of driven meshes
+	int32 NumMeshes() const { return Meshes.Num(); };
+
+	// Mesh index of the bone column
+	int32 GetMeshIndex(int32 BoneColumnIndex) const { return BoneColumnToMesh[BoneColumnIndex]; };
+
+	// Apply the bone poses of all the meshes
+	void Apply(const TArray<FTransform>& BoneState);
+
+	// Apply the bone poses of the meshes set in the mask
+	void Apply(const TArray<FTransform>& BoneState, const TBitArray<>& MeshMask);
+
+private:
+	// Pose the mesh in a single parent-first pass, and mark its transforms dirty once
+	void ApplyMesh(FSLVizSkeletalPoseMesh& Mesh, const TArray<FTransform>& BoneState);
+
+private:
+	// Driven meshes
+	TArray<FSLVizSkeletalPoseMesh> Meshes;
+
+	// Mesh index of every bone column
+	TArray<int32> BoneColumnToMesh;
+};
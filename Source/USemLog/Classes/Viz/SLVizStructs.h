@@ -87,6 +87,16 @@ enum class ESLVizPrimitiveMarkerType : uint8
 	Axis			UMETA(DisplayName = "Axis")
 };
 
+/**
+* Trajectory marker mesh types
+*/
+UENUM()
+enum class ESLVizTrajectoryType : uint8
+{
+	Line			UMETA(DisplayName = "Line"),
+	Ribbon			UMETA(DisplayName = "Ribbon")
+};
+
 
 /**
  * Data about the currently highlighted individuals (mesh, material index)
@@ -148,6 +158,18 @@ struct FSLVizEpisodePlayParams
 	UPROPERTY(EditAnywhere, Category = "Properties")
 	int32 StepSize = 1;
 
+	// Episode seconds per wall second (negative values replay in reverse)
+	UPROPERTY(EditAnywhere, Category = "Properties")
+	float Speed = 1.f;
+
+	// Interpolate the actor and bone poses between the recorded frames
+	UPROPERTY(EditAnywhere, Category = "Properties")
+	bool bInterpolate = true;
+
+	// Step frame by frame with the update rate and step size instead of following the wall time
+	UPROPERTY(EditAnywhere, Category = "Properties")
+	bool bFixedStep = false;
+
 	// Default ctor
 	FSLVizEpisodePlayParams() {};
 
@@ -183,3 +205,123 @@ struct FSLVizTimelineParams
 	bool bLoop = false;
 };
 
+/**
+ * Parameters for trajectory markers level of detail
+ */
+USTRUCT()
+struct FSLVizTrajectoryLODParams
+{
+	GENERATED_BODY()
+
+	// Max position deviation (cm) of the skipped poses from the simplified trajectory
+	UPROPERTY(EditAnywhere, Category = "LOD")
+	float PositionTolerance = 1.f;
+
+	// Max orientation deviation (degrees) of the skipped poses from the simplified trajectory
+	UPROPERTY(EditAnywhere, Category = "LOD")
+	float AngleTolerance = 5.f;
+
+	// Maximum number of instances to draw (negative values ignored)
+	UPROPERTY(EditAnywhere, Category = "LOD")
+	int32 MaxNumInstances = INDEX_NONE;
+
+	// Scale the tolerances with the distance to the camera
+	UPROPERTY(EditAnywhere, Category = "LOD")
+	bool bUseCameraDistance = false;
+
+	// Camera distance (cm) up to which the tolerances are not scaled (they grow linearly further away)
+	UPROPERTY(EditAnywhere, Category = "LOD")
+	float ReferenceDistance = 200.f;
+};
+
+
+/**
+ * Parameters for trajectory markers
+ */
+USTRUCT()
+struct FSLVizTrajectoryParams
+{
+	GENERATED_BODY()
+
+	// Line (crossed strips, visible from any side) or ribbon (strip in the XY plane of the poses)
+	UPROPERTY(EditAnywhere, Category = "Properties")
+	ESLVizTrajectoryType Type = ESLVizTrajectoryType::Line;
+
+	// Width of the trajectory (cm)
+	UPROPERTY(EditAnywhere, Category = "Properties")
+	float Width = 0.5f;
+
+	// Color of the trajectory (start color if time coloring is used)
+	UPROPERTY(EditAnywhere, Category = "Color")
+	FLinearColor Color = FLinearColor::Green;
+
+	// Interpolate from the start to the end color with time (per vertex with the MaterialVertexColor asset, else per color band)
+	UPROPERTY(EditAnywhere, Category = "Color")
+	bool bTimeColoring = false;
+
+	// Color of the trajectory end if time coloring is used
+	UPROPERTY(EditAnywhere, Category = "Color")
+	FLinearColor EndColor = FLinearColor::Red;
+
+	// Length of the orientation ticks (along the X axis of the poses, no ticks if not positive)
+	UPROPERTY(EditAnywhere, Category = "Ticks")
+	float TickLength = -1.f;
+
+	// Number of poses between two orientation ticks
+	UPROPERTY(EditAnywhere, Category = "Ticks")
+	int32 TickInterval = 10;
+};
+
+/**
+ * Timed camera pose used to build camera paths
+ */
+USTRUCT()
+struct FSLVizCameraKeyframe
+{
+	GENERATED_BODY()
+
+	// Episode time of the pose
+	UPROPERTY(EditAnywhere, Category = "Properties")
+	float Time = 0.f;
+
+	// Camera pose
+	UPROPERTY(EditAnywhere, Category = "Properties")
+	FTransform Pose = FTransform::Identity;
+
+	// Field of view (degrees, the field of view is not changed if not positive)
+	UPROPERTY(EditAnywhere, Category = "Properties")
+	float FieldOfView = -1.f;
+};
+
+/**
+ * Parameters for camera paths framing recorded individuals
+ */
+USTRUCT()
+struct FSLVizCameraFramingParams
+{
+	GENERATED_BODY()
+
+	// Episode time (seconds) between two path samples
+	UPROPERTY(EditAnywhere, Category = "Properties")
+	float SampleInterval = 0.5f;
+
+	// Viewing direction of the camera
+	UPROPERTY(EditAnywhere, Category = "Properties")
+	FRotator ViewRotation = FRotator(-30.f, 0.f, 0.f);
+
+	// Scale of the framed radius (larger values leave more space around the targets)
+	UPROPERTY(EditAnywhere, Category = "Properties")
+	float DistanceScale = 1.5f;
+
+	// Minimal distance (cm) of the camera to the targets center
+	UPROPERTY(EditAnywhere, Category = "Properties")
+	float MinDistance = 150.f;
+
+	// Number of neighbour samples on each side averaged to smooth the path
+	UPROPERTY(EditAnywhere, Category = "Properties")
+	int32 SmoothingWindow = 4;
+
+	// Field of view (degrees) used to compute the framing distance
+	UPROPERTY(EditAnywhere, Category = "Properties")
+	float FieldOfView = 90.f;
+};
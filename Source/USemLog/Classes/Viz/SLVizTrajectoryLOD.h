@@ -0,0 +1,56 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Error bounded simplification of pose trajectories (position and orientation), the poses are ranked once
+ * by their simplification error, any tolerance or instance budget level is then a prefix of the ranking
+ */
+class FSLVizTrajectoryLOD
+{
+public:
+	// Default ctor
+	FSLVizTrajectoryLOD() {};
+
+	// Rank the poses, the errors are normalized with the given tolerances (cm, degrees)
+	void Init(const TArray<FTransform>& InPoses, float PositionTolerance, float AngleTolerance);
+
+	// Get the simplified poses, skipped poses deviate less than the tolerances times the scale (budget ignored if negative)
+	void GetPoses(float ToleranceScale, int32 MaxNumPoses, TArray<FTransform>& OutPoses) const;
+
+	// Get the number of poses kept at the given tolerance scale and budget
+	int32 GetNumPoses(float ToleranceScale, int32 MaxNumPoses) const;
+
+	// Bounds of the trajectory
+	const FBox& GetBounds() const { return Bounds; };
+
+	// Original poses
+	const TArray<FTransform>& GetOriginalPoses() const { return Poses; };
+
+	// Number of the original poses
+	int32 Num() const { return Poses.Num(); };
+
+private:
+	// Normalized error of the pose if it is skipped between the first and the last pose
+	float GetPoseError(int32 FirstIndex, int32 LastIndex, int32 Index) const;
+
+private:
+	// Original poses
+	TArray<FTransform> Poses;
+
+	// Normalized simplification error of every pose (never larger than the error of its parent split)
+	TArray<float> Errors;
+
+	// Pose indexes sorted by their errors (descending)
+	TArray<int32> Ranking;
+
+	// Bounds of the trajectory
+	FBox Bounds = FBox(ForceInit);
+
+	// Tolerances used to normalize the errors
+	float InvPositionTolerance = 1.f;
+	float InvAngleTolerance = 1.f;
+};
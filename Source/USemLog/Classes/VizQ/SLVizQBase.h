@@ -10,6 +10,12 @@
 // Forward declaration
 class ASLKnowrobManager;
 
+// Scene change applied on the game thread with the fetched data
+typedef TFunction<void(ASLKnowrobManager*)> FSLVizQApplyFunc;
+
+// Data fetch running in the background, returns the scene change to apply on the game thread
+typedef TFunction<FSLVizQApplyFunc()> FSLVizQFetchFunc;
+
 /**
  * Base class for viz queries
  */
@@ -22,7 +28,13 @@ public:
 	// Public execute function
 	void Execute(ASLKnowrobManager* KRManager);
 
+	// Check if the knowrob manager can be used for the execution
+	static bool IsKRManagerValid(ASLKnowrobManager* KRManager);
+
 protected:
+	// The pipelined execution calls the implementation functions directly
+	friend class FSLVizQScheduler;
+
 #if WITH_EDITOR
 	// Execute function called from the editor, references need to be set manually
 	void ManualExecute();
@@ -40,6 +52,12 @@ protected:
 	// Virtual implementation of the execute function
 	virtual void ExecuteImpl(ASLKnowrobManager* KRManager);
 
+	// Called on the game thread when the tree is scheduled, returns true if the command only dispatched background work and is done
+	virtual bool PreDispatch(ASLKnowrobManager* KRManager) { return false; };
+
+	// Called on the game thread when the tree is scheduled, returns the data fetch of the command (nullptr if ExecuteImpl should be used)
+	virtual FSLVizQFetchFunc CreateFetchTask(ASLKnowrobManager* KRManager) { return nullptr; };
+
 protected:
 	/* Children to be called in a batch */
 	UPROPERTY(EditAnywhere, Category = "Children")
@@ -22,10 +22,25 @@ protected:
 	// Virtual implementation of the execute function
 	virtual void ExecuteImpl(ASLKnowrobManager* KRManager) override;
 
+	// The async caching only dispatches background work, it can start as soon as the query tree is scheduled
+	virtual bool PreDispatch(ASLKnowrobManager* KRManager) override;
+
+public:
+	// Queue the episode for background caching, returns false if it could not be queued
+	static bool CacheEpisodeAsync(ASLKnowrobManager* KRManager, const FString& Task, const FString& Episode);
+
 protected:
 	UPROPERTY(EditAnywhere, Category = "Cache Episodes")
 	FString Task;
 
 	UPROPERTY(EditAnywhere, Category = "Cache Episodes")
 	TArray<FString> Episodes;
+
+	// Fetch and build the episodes concurrently on background workers
+	UPROPERTY(EditAnywhere, Category = "Cache Episodes")
+	bool bAsync = true;
+
+	// Max number of episodes fetched in parallel
+	UPROPERTY(EditAnywhere, Category = "Cache Episodes", meta = (editcondition = "bAsync", ClampMin = 1))
+	int32 MaxConcurrency = 2;
 };
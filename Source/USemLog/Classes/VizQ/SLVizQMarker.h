@@ -10,6 +10,21 @@
 
 // Forward declaration
 class ASLKnowrobManager;
+class ASLMongoQueryManager;
+class FSLMongoQueryDBHandler;
+class ASLVizManager;
+
+/**
+ * Pose/trajectory data of the marker queries
+ */
+struct FSLVizQMarkerData
+{
+	// Static mesh and primitive poses
+	TArray<FTransform> Poses;
+
+	// Skeletal poses
+	TArray<TPair<FTransform, TMap<int32, FTransform>>> SkeletalPoses;
+};
 
 /**
  *
@@ -20,6 +35,7 @@ enum class ESLVizQMarkerMeshType : uint8
 	Primitive			UMETA(DisplayName = "Primitive"),
 	StaticMesh			UMETA(DisplayName = "Static Mesh"),
 	SkeletalMesh		UMETA(DisplayName = "Skeletal Mesh"),
+	TrajectoryMesh		UMETA(DisplayName = "Trajectory Mesh"),
 };
 
 /**
@@ -50,6 +66,17 @@ protected:
 	// Virtual implementation of the execute function
 	virtual void ExecuteImpl(ASLKnowrobManager* KRManager) override;
 
+	// Returns the pose/trajectory fetch of the marker, the marker is drawn on the game thread
+	virtual FSLVizQFetchFunc CreateFetchTask(ASLKnowrobManager* KRManager) override;
+
+	// Draw the marker from the fetched data
+	void DrawMarker(ASLVizManager* VizManager, const FSLVizQMarkerData& Data);
+
+public:
+	// Fetch the pose/trajectory data with pooled connections of the shared handler (safe to call from worker threads)
+	static void FetchDataThreadSafe(const FSLMongoQueryDBHandler& DBHandler, const FString& InTask, const FString& InEpisode, const FString& InIndividual,
+		bool bSkeletal, bool bSinglePose, float InStartTime, float InEndTime, float InDeltaT, FSLVizQMarkerData& OutData);
+
 public:	
 	UPROPERTY(EditAnywhere, Category = "Marker|Edit")
 	FString MarkerIdPrefix = "";
@@ -101,12 +128,27 @@ public:
 
 
 	/* Visual params */
+	UPROPERTY(EditAnywhere, Category = "Marker|Visual|Skeletal", meta = (editcondition = "MeshType==ESLVizQMarkerMeshType::SkeletalMesh", ClampMin = 1))
+	int32 MaxNumSkeletalInstances = 128;
+
 	UPROPERTY(EditAnywhere, Category = "Marker|Visual|Primitive", meta = (editcondition = "MeshType==ESLVizQMarkerMeshType::Primitive"))
 	ESLVizPrimitiveMarkerType PrimitiveType = ESLVizPrimitiveMarkerType::Box;
 
 	UPROPERTY(EditAnywhere, Category = "Marker|Visual|Primitive", meta = (editcondition = "MeshType==ESLVizQMarkerMeshType::Primitive"))
 	float Size = 0.05f;
 
+	/* Trajectory params */
+	// Draw the poses as a single line or ribbon mesh
+	UPROPERTY(EditAnywhere, Category = "Marker|Visual|Trajectory", meta = (editcondition = "MeshType==ESLVizQMarkerMeshType::TrajectoryMesh"))
+	FSLVizTrajectoryParams TrajectoryParams;
+
+	// Simplify the primitive and static mesh trajectories with the camera distance
+	UPROPERTY(EditAnywhere, Category = "Marker|Visual|Trajectory", meta = (editcondition = "Type==ESLVizQMarkerType::Trajectory && !bUseOriginalColor"))
+	bool bUseLOD = false;
+
+	UPROPERTY(EditAnywhere, Category = "Marker|Visual|Trajectory", meta = (editcondition = "bUseLOD"))
+	FSLVizTrajectoryLODParams LODParams;
+
 
 protected:
 	/* Manual interaction */
@@ -5,11 +5,13 @@
 
 #include "CoreMinimal.h"
 #include "VizQ/SLVizQBase.h"
+#include "VizQ/SLVizQMarker.h"
 #include "Viz/SLVizStructs.h"
 #include "SLVizQMarkerArray.generated.h"
 
 // Forward declaration
 class ASLKnowrobManager;
+class ASLVizManager;
 
 /**
  *
@@ -20,6 +22,7 @@ enum class ESLVizQMarkerArrayMeshType : uint8
 	Primitive			UMETA(DisplayName = "Primitive"),
 	StaticMesh			UMETA(DisplayName = "Static Mesh"),
 	SkeletalMesh		UMETA(DisplayName = "Skeletal Mesh"),
+	TrajectoryMesh		UMETA(DisplayName = "Trajectory Mesh"),
 };
 
 /**
@@ -50,6 +53,18 @@ protected:
 	// Virtual implementation of the execute function
 	virtual void ExecuteImpl(ASLKnowrobManager* KRManager) override;
 
+	// Returns the pose/trajectory fetch of all the markers (in parallel), the markers are drawn on the game thread
+	virtual FSLVizQFetchFunc CreateFetchTask(ASLKnowrobManager* KRManager) override;
+
+	// Check the marker ids and the time interval
+	bool IsValidQuery() const;
+
+	// Draw the markers from the fetched data (one entry per individual)
+	void DrawMarkers(ASLVizManager* VizManager, const TArray<FSLVizQMarkerData>& Data);
+
+	// Draw the marker of the individual
+	void DrawMarker(ASLVizManager* VizManager, const FString& MarkerId, const FString& Individual, const FSLVizQMarkerData& Data);
+
 public:	
 	UPROPERTY(EditAnywhere, Category = "MarkerArray|Edit")
 	FString MarkerIdPrefix = "";
@@ -101,12 +116,27 @@ public:
 
 
 	/* Visual params */
+	UPROPERTY(EditAnywhere, Category = "MarkerArray|Visual|Skeletal", meta = (editcondition = "MeshType==ESLVizQMarkerArrayMeshType::SkeletalMesh", ClampMin = 1))
+	int32 MaxNumSkeletalInstances = 128;
+
 	UPROPERTY(EditAnywhere, Category = "MarkerArray|Visual|Primitive", meta = (editcondition = "MeshType==ESLVizQMarkerArrayMeshType::Primitive"))
 	ESLVizPrimitiveMarkerType PrimitiveType = ESLVizPrimitiveMarkerType::Box;
 
 	UPROPERTY(EditAnywhere, Category = "MarkerArray|Visual|Primitive", meta = (editcondition = "MeshType==ESLVizQMarkerArrayMeshType::Primitive"))
 	float Size = 0.05f;
 
+	/* Trajectory params */
+	// Draw the poses as a single line or ribbon mesh
+	UPROPERTY(EditAnywhere, Category = "MarkerArray|Visual|Trajectory", meta = (editcondition = "MeshType==ESLVizQMarkerArrayMeshType::TrajectoryMesh"))
+	FSLVizTrajectoryParams TrajectoryParams;
+
+	// Simplify the primitive and static mesh trajectories with the camera distance
+	UPROPERTY(EditAnywhere, Category = "MarkerArray|Visual|Trajectory", meta = (editcondition = "Type==ESLVizQMarkerArrayType::Trajectory && !bUseOriginalColor"))
+	bool bUseLOD = false;
+
+	UPROPERTY(EditAnywhere, Category = "MarkerArray|Visual|Trajectory", meta = (editcondition = "bUseLOD"))
+	FSLVizTrajectoryLODParams LODParams;
+
 protected:
 	/* Manual interaction */
 	UPROPERTY(EditAnywhere, Category = "Manual Interaction|MarkerArray")
@@ -9,6 +9,7 @@
 
 // Forward declaration
 class ASLKnowrobManager;
+class ASLVizManager;
 
 UENUM()
 enum class ESLVizQReplayType : uint8
@@ -34,6 +35,12 @@ protected:
 	// Virtual implementation of the execute function
 	virtual void ExecuteImpl(ASLKnowrobManager* KRManager) override;
 
+	// Start caching the episode in the background as soon as the query tree is scheduled (the replay waits for it)
+	virtual bool PreDispatch(ASLKnowrobManager* KRManager) override;
+
+	// Goto or replay the cached episode
+	void ExecuteOnCachedEpisode(ASLVizManager* VizManager);
+
 protected:
 	/* Replay parameters */
 	UPROPERTY(EditAnywhere, Category = "Replay")
@@ -60,6 +67,15 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Replay", meta = (editcondition = "Type==ESLVizQReplayType::Replay"))
 	int32 StepSize = 1;
 
+	UPROPERTY(EditAnywhere, Category = "Replay", meta = (editcondition = "Type==ESLVizQReplayType::Replay"))
+	float Speed = 1.f;
+
+	UPROPERTY(EditAnywhere, Category = "Replay", meta = (editcondition = "Type==ESLVizQReplayType::Replay"))
+	bool bInterpolate = true;
+
+	UPROPERTY(EditAnywhere, Category = "Replay", meta = (editcondition = "Type==ESLVizQReplayType::Replay"))
+	bool bFixedStep = false;
+
 
 	/* Manual interaction */
 	UPROPERTY(EditAnywhere, Category = "Manual Interaction|Replay", meta = (editcondition = "Type==ESLVizQReplayType::Replay"))
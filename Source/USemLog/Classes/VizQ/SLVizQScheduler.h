@@ -0,0 +1,75 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VizQ/SLVizQBase.h"
+#include "Async/Future.h"
+
+// Forward declaration
+class ASLKnowrobManager;
+
+/**
+ * Query tree waiting for its data fetches before applying its scene changes
+ */
+struct FSLVizQScheduledBatch
+{
+	// Unique id of the batch
+	int32 Id = INDEX_NONE;
+
+	// Commands in execution order (tree flattened)
+	TArray<TWeakObjectPtr<USLVizQBase>> Commands;
+
+	// Fetched scene changes of the commands (unbound if the command executes directly)
+	TArray<FSLVizQApplyFunc> ApplyFuncs;
+
+	// Number of background fetches still running
+	int32 NumPendingFetches = 0;
+
+	// Time when the batch was scheduled
+	double ScheduleTime = 0.0;
+};
+
+/**
+ * Pipelined execution of VizQ query trees, all the data fetches of a tree run concurrently
+ * in the background, the scene changes are then applied in order on the game thread
+ */
+class FSLVizQScheduler : public TSharedFromThis<FSLVizQScheduler, ESPMode::ThreadSafe>
+{
+public:
+	// Set the knowrob manager used for the execution
+	void Init(ASLKnowrobManager* InKRManager);
+
+	// Schedule the query tree, returns false if nothing could be scheduled
+	bool Execute(USLVizQBase* Root);
+
+	// True if there are batches waiting for their data
+	bool IsBusy() const { return Batches.Num() > 0; };
+
+	// Wait for the running fetches and drop the scheduled batches (the fetched results are ignored)
+	void Reset();
+
+private:
+	// Flatten the tree into execution order (ignored commands and their children are skipped)
+	static void FlattenTree(USLVizQBase* Query, TArray<USLVizQBase*>& OutOrder, TSet<USLVizQBase*>& Visited);
+
+	// Called on the game thread when a background fetch of the batch finished
+	void OnFetchDone(int32 BatchId, int32 CommandIdx, FSLVizQApplyFunc&& ApplyFunc);
+
+	// Apply the scene changes of the finished batches (in schedule order)
+	void ApplyReadyBatches();
+
+private:
+	// Knowrob manager owning the viz and mongo managers
+	TWeakObjectPtr<ASLKnowrobManager> KRManager;
+
+	// Batches in schedule order
+	TArray<FSLVizQScheduledBatch> Batches;
+
+	// Id of the next scheduled batch
+	int32 NextBatchId = 0;
+
+	// Background fetches which might still be running (the finished ones are pruned when new fetches start)
+	TArray<TFuture<void>> RunningFetches;
+};
@@ -38,6 +38,18 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Semantic Map", meta=(editcondition = "!bAllIndividuals"))
 	TArray<FString> Ids;
 
+	// Semantic classes of the individuals
+	UPROPERTY(EditAnywhere, Category = "Semantic Map", meta = (editcondition = "!bAllIndividuals"))
+	TArray<FString> Classes;
+
+	// Individual types (e.g. RigidIndividual, SkeletalIndividual)
+	UPROPERTY(EditAnywhere, Category = "Semantic Map", meta = (editcondition = "!bAllIndividuals"))
+	TArray<FString> Types;
+
+	// Apply the value to all the other individuals, the given ids, classes and types get the opposite value
+	UPROPERTY(EditAnywhere, Category = "Semantic Map", meta = (editcondition = "!bAllIndividuals"))
+	bool bAllExcept = false;
+
 	UPROPERTY(EditAnywhere, Category = "Semantic Map")
 	bool bIterate = false;
 
@@ -297,6 +297,9 @@ void ASLKnowrobManager::Init()
 		return;
 	}
 
+	VizQScheduler = MakeShared<FSLVizQScheduler, ESPMode::ThreadSafe>();
+	VizQScheduler->Init(this);
+
 	bIsInit = true;
 	UE_LOG(LogTemp, Warning, TEXT("%s::%d %s succesfully initialized.."),
 		*FString(__FUNCTION__), __LINE__, *GetName());
@@ -373,6 +376,12 @@ void ASLKnowrobManager::Finish(bool bForced)
 		KRWSClient.Reset();
 	}
 
+	if (VizQScheduler.IsValid())
+	{
+		VizQScheduler->Reset();
+		VizQScheduler.Reset();
+	}
+
 	bIsStarted = false;
 	bIsInit = false;
 	bIsFinished = true;
@@ -714,7 +723,14 @@ bool ASLKnowrobManager::ExecuteQuery(int32 Index)
 		USLVizQBase* QueryObj = Queries[Index];
 		if (QueryObj && QueryObj->IsValidLowLevel())
 		{
-			QueryObj->Execute(this);
+			if (bPipelineQueries && VizQScheduler.IsValid())
+			{
+				VizQScheduler->Execute(QueryObj);
+			}
+			else
+			{
+				QueryObj->Execute(this);
+			}
 			return true;
 		}
 	}
@@ -2,6 +2,8 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #include "Mongo/SLMongoQueryDBHandler.h"
+#include "Async/ParallelFor.h"
+#include "Misc/Paths.h"
 
 #if SL_WITH_ROS_CONVERSIONS
 #include "Conversions.h"
@@ -13,6 +15,15 @@ FSLMongoQueryDBHandler::FSLMongoQueryDBHandler()
 	bConnected = false;
 	bDatabaseSet = false;
 	bCollectionSet = false;
+
+#if SL_WITH_LIBMONGO_C
+	uri = nullptr;
+	client = nullptr;
+	client_pool = nullptr;
+	database = nullptr;
+	collection = nullptr;
+	meta_collection = nullptr;
+#endif // SL_WITH_LIBMONGO_C
 }
 
 // Dtor
@@ -34,9 +45,6 @@ bool FSLMongoQueryDBHandler::Connect(const FString& ServerIp, uint16 ServerPort)
 	const bool bCheckConnection = true;
 
 #if SL_WITH_LIBMONGO_C
-	// Required to initialize libmongoc's internals
-	mongoc_init();
-
 	// Stores any error that might appear during the connection
 	bson_error_t error;
 
@@ -63,6 +71,17 @@ bool FSLMongoQueryDBHandler::Connect(const FString& ServerIp, uint16 ServerPort)
 	// Register the application name so we can track it in the profile logs on the server
 	mongoc_client_set_appname(client, "MongoQA");
 
+	// Create the client pool used by the parallel queries (clients are created lazily by the pool)
+	client_pool = mongoc_client_pool_new(uri);
+	if (client_pool)
+	{
+		mongoc_client_pool_set_appname(client_pool, "MongoQAPool");
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not create the mongo client pool, parallel queries will be serial.."), *FString(__FUNCTION__), __LINE__);
+	}
+
 	if (bCheckConnection)
 	{
 		// Check server. Ping the "admin" database
@@ -80,6 +99,7 @@ bool FSLMongoQueryDBHandler::Connect(const FString& ServerIp, uint16 ServerPort)
 	}
 
 	//UE_LOG(LogTemp, Log, TEXT("%s::%d Succesfully connected to: %s"), *FString(__func__), __LINE__, *Uri);		
+	Profiler.StartSession(ServerIp + TEXT("_") + FString::FromInt(ServerPort));
 	bConnected = true;
 	return true;
 #else
@@ -199,36 +219,64 @@ bool FSLMongoQueryDBHandler::SetCollection(const FString& InCollName)
 // Clear and disconnect from db
 void FSLMongoQueryDBHandler::Disconnect()
 {
+	// Dump the profiling summary of the session
+	if (bConnected && Profiler.IsEnabled())
+	{
+		DumpProfilingSummary();
+	}
+
 	bConnected = false;
 	bDatabaseSet = false;
 	bCollectionSet = false;
 
 #if SL_WITH_LIBMONGO_C
-	// Release handles and clean up libmongoc
+	// Release the handles (libmongoc itself is initialized and cleaned up once by the module)
 	if (meta_collection)
 	{
 		mongoc_collection_destroy(meta_collection);
+		meta_collection = nullptr;
 	}
 	if (collection)
 	{
 		mongoc_collection_destroy(collection);
+		collection = nullptr;
 	}
 	if (database)
 	{
 		mongoc_database_destroy(database);
+		database = nullptr;
 	}
 	if (uri)
 	{
 		mongoc_uri_destroy(uri);
+		uri = nullptr;
 	}
 	if (client)
 	{
 		mongoc_client_destroy(client);
+		client = nullptr;
+	}
+	if (client_pool)
+	{
+		mongoc_client_pool_destroy(client_pool);
+		client_pool = nullptr;
 	}
-	mongoc_cleanup();
 #endif //SL_WITH_LIBMONGO_C
 }
 
+// Enable/disable query profiling
+void FSLMongoQueryDBHandler::SetProfiling(bool bEnable, float SlowQueryThreshold, bool bCaptureExplain)
+{
+	Profiler.SetEnabled(bEnable, SlowQueryThreshold, bCaptureExplain);
+}
+
+// Log and write the profiling summary of the current session to file (returns the file path)
+FString FSLMongoQueryDBHandler::DumpProfilingSummary() const
+{
+	Profiler.LogSummary();
+	return Profiler.WriteSummaryToFile(FPaths::ProjectDir() + TEXT("/SL/Profiling/"));
+}
+
 /* Queries */
 // Get the pose of the individual at the given time
 FTransform FSLMongoQueryDBHandler::GetIndividualPoseAt(const FString& Id, float Ts) const
@@ -240,62 +288,115 @@ FTransform FSLMongoQueryDBHandler::GetIndividualPoseAt(const FString& Id, float
 		return Pose;
 	}
 
-#if SL_WITH_LIBMONGO_C	
+#if SL_WITH_LIBMONGO_C
+	Pose = GetIndividualPoseAt(collection, Id, Ts);
+#endif // SL_WITH_LIBMONGO_C
+	return Pose;
+}
+
+// Get the poses of the individual between the given timestamps
+TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT) const
+{
+	TArray<FTransform> Trajectory;
+	if (!IsReady())
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		return Trajectory;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	Trajectory = GetIndividualTrajectory(collection, Id, StartTs, EndTs, DeltaT);
+#endif // SL_WITH_LIBMONGO_C
+	return Trajectory;
+}
+
+// Get skeletal individual pose
+TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIndividualPoseAt(const FString& Id, float Ts,
+	const TArray<int32>& BoneIndexes) const
+{
+	TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
+	if (!IsReady())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		return SkeletalPosePair;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	SkeletalPosePair = GetSkeletalIndividualPoseAt(collection, Id, Ts, BoneIndexes);
+#endif // SL_WITH_LIBMONGO_C
+	return SkeletalPosePair;
+}
+
+// Get skeletal individual trajectory
+TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetSkeletalIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT,
+	const TArray<int32>& BoneIndexes) const
+{
+	TArray<TPair<FTransform, TMap<int32, FTransform>>> SkeletalTrajectoryPair;
+	if (!IsReady())
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		return SkeletalTrajectoryPair;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	SkeletalTrajectoryPair = GetSkeletalIndividualTrajectory(collection, Id, StartTs, EndTs, DeltaT, BoneIndexes);
+#endif // SL_WITH_LIBMONGO_C
+	return SkeletalTrajectoryPair;
+}
+
+// Get the whole episode data (columnar form)
+FSLMongoEpisodeData FSLMongoQueryDBHandler::GetEpisodeData(bool bLocationsOnly) const
+{
+	FSLMongoEpisodeData EpisodeData;
+	if (!IsReady())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		return EpisodeData;
+	}	
+
+#if SL_WITH_LIBMONGO_C
 	double ExecBegin = FPlatformTime::Seconds();
 
 	bson_error_t error;
+	bson_t opts;
 	const bson_t *doc;
 	mongoc_cursor_t *cursor;
 	bson_t *pipeline;
+	bson_t *project_stage = CreateEpisodeFrameProjectStage(bLocationsOnly);
 
 	pipeline = BCON_NEW("pipeline", "[",
 		"{",
 			"$match",
 			"{",
-				"timestamp", "{", "$lte", BCON_DOUBLE(Ts), "}",
-				"individuals.id", BCON_UTF8(TCHAR_TO_ANSI(*Id)),		// yields faster results if we match against the id from the start
+				"timestamp", 
+				"{",
+					"$exists", BCON_BOOL(true),
+				"}",
 			"}",
 		"}",
 		"{",
 			"$sort",
 			"{",
-				"timestamp", BCON_INT32(-1),							// required to get the last pose (no time penalty if the collection is indexed)
-			"}",
-		"}",
-		"{",
-			"$limit", BCON_INT32(1),
-		"}",
-		"{",
-			"$unwind", BCON_UTF8("$individuals"),
-		"}",
-		"{",
-			"$match",
-			"{",
-				"individuals.id", BCON_UTF8(TCHAR_TO_ANSI(*Id)),		// match against the searched id in the unwinded array (has all individuals from the doc)
-			"}",
-		"}",
-		"{",
-			"$project",
-			"{",
-				"_id", BCON_INT32(0),
 				"timestamp", BCON_INT32(1),
-				"loc", BCON_UTF8("$individuals.loc"),
-				"quat", BCON_UTF8("$individuals.quat"),
-				"pose", BCON_UTF8("$individuals.pose"),
 			"}",
 		"}",
+		BCON_DOCUMENT(project_stage),							// full poses, or only the locations
 		"]");
 
+	// If the episode is very large the hard drive needs to be used to cache results
+	bson_init(&opts);
+	BSON_APPEND_BOOL(&opts, "allowDiskUse", true);
 	cursor = mongoc_collection_aggregate(
-		collection, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
+		collection, MONGOC_QUERY_NONE, pipeline, &opts, NULL);
+
 	double QueryDuration = FPlatformTime::Seconds() - ExecBegin;
 
 	// Read cursor if no errors occured
 	if (!mongoc_cursor_error(cursor, &error))
 	{
-		if (mongoc_cursor_next(cursor, &doc))
+		while (mongoc_cursor_next(cursor, &doc))
 		{
-			Pose = GetPose(doc);
+			ReadEpisodeFrame(doc, EpisodeData);
 		}
 	}
 	else
@@ -305,25 +406,249 @@ FTransform FSLMongoQueryDBHandler::GetIndividualPoseAt(const FString& Id, float
 	}
 	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
 
+	ProfileQuery(TEXT("EpisodeData"), collection, pipeline, FPlatformTime::Seconds() - ExecBegin, EpisodeData.NumFrames(), false);
 	mongoc_cursor_destroy(cursor);
 	bson_destroy(pipeline);
-	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor=[%f], total=[%f] seconds..;"),
-		*FString(__func__), __LINE__, QueryDuration, CursorReadDuration, FPlatformTime::Seconds() - ExecBegin);
+	bson_destroy(project_stage);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor(num=%d)=[%f], total=[%f] seconds..;"),
+		*FString(__func__), __LINE__, QueryDuration, EpisodeData.NumFrames(), CursorReadDuration, FPlatformTime::Seconds() - ExecBegin);
 #endif
+	return EpisodeData;
+}
+
+// Get the whole episode data by fetching K timestamp range partitions in parallel
+FSLMongoEpisodeData FSLMongoQueryDBHandler::GetEpisodeDataParallel(int32 NumPartitions, bool bLocationsOnly) const
+{
+	if (!IsReady())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		return FSLMongoEpisodeData();
+	}
+
+	if (NumPartitions <= 0)
+	{
+		NumPartitions = FMath::Clamp(FTaskGraphInterface::Get().GetNumWorkerThreads(), 1, 16);
+	}
+
+#if SL_WITH_LIBMONGO_C
+	if (NumPartitions == 1 || !client_pool)
+	{
+		return GetEpisodeData(bLocationsOnly);
+	}
+
+	double ExecBegin = FPlatformTime::Seconds();
+
+	double StartTs = 0.0;
+	double EndTs = 0.0;
+	if (!GetEpisodeTimeRange(collection, StartTs, EndTs))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not read the episode time range, falling back to the serial query.."), *FString(__FUNCTION__), __LINE__);
+		return GetEpisodeData(bLocationsOnly);
+	}
+
+	// Split the timestamp range into equal partitions, the last one includes the end timestamp
+	const double PartitionDuration = (EndTs - StartTs) / NumPartitions;
+	const FString DBName = FString(mongoc_database_get_name(database));
+	const FString CollName = FString(mongoc_collection_get_name(collection));
+
+	// Fetch and decode every partition on a worker thread with its own pooled connection
+	TArray<FSLMongoEpisodeData> Partitions;
+	Partitions.SetNum(NumPartitions);
+	ParallelFor(NumPartitions, [&](int32 PartitionIdx)
+	{
+		const double PartitionStartTs = StartTs + PartitionIdx * PartitionDuration;
+		const bool bLastPartition = PartitionIdx == NumPartitions - 1;
+		const double PartitionEndTs = bLastPartition ? EndTs : PartitionStartTs + PartitionDuration;
+
+		mongoc_client_t* pool_client = mongoc_client_pool_pop(client_pool);
+		mongoc_collection_t* pool_coll = mongoc_client_get_collection(pool_client, TCHAR_TO_UTF8(*DBName), TCHAR_TO_UTF8(*CollName));
+		GetEpisodeDataRange(pool_coll, PartitionStartTs, PartitionEndTs, bLastPartition, bLocationsOnly, Partitions[PartitionIdx]);
+		mongoc_collection_destroy(pool_coll);
+		mongoc_client_pool_push(client_pool, pool_client);
+	});
+	double FetchDuration = FPlatformTime::Seconds() - ExecBegin;
+
+	// Stitch the partitions in order
+	int32 NumFrames = 0;
+	for (const auto& Partition : Partitions)
+	{
+		NumFrames += Partition.NumFrames();
+	}
+	FSLMongoEpisodeData EpisodeData(NumFrames);
+	for (const auto& Partition : Partitions)
+	{
+		EpisodeData.Append(Partition);
+	}
+
+	Profiler.Record(TEXT("EpisodeDataParallel"), FPlatformTime::Seconds() - ExecBegin, EpisodeData.NumFrames());
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: partitions(num=%d) fetch=[%f], stitch(num=%d)=[%f], total=[%f] seconds..;"),
+		*FString(__func__), __LINE__, NumPartitions, FetchDuration, EpisodeData.NumFrames(),
+		FPlatformTime::Seconds() - ExecBegin - FetchDuration, FPlatformTime::Seconds() - ExecBegin);
+	return EpisodeData;
+#else
+	return FSLMongoEpisodeData();
+#endif // SL_WITH_LIBMONGO_C
+}
+
+// Get the whole episode data of the given database and collection using a pooled connection (safe to call from worker threads)
+FSLMongoEpisodeData FSLMongoQueryDBHandler::GetEpisodeDataPooled(const FString& DBName, const FString& CollName) const
+{
+	FSLMongoEpisodeData EpisodeData;
+#if SL_WITH_LIBMONGO_C
+	if (!client_pool)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Client pool is not available, connect first.."), *FString(__FUNCTION__), __LINE__);
+		return EpisodeData;
+	}
+
+	// The active database and collection handles are not touched, every call has its own connection
+	mongoc_client_t* pool_client = mongoc_client_pool_pop(client_pool);
+	mongoc_collection_t* pool_coll = mongoc_client_get_collection(pool_client, TCHAR_TO_UTF8(*DBName), TCHAR_TO_UTF8(*CollName));
+	double StartTs = 0.0;
+	double EndTs = 0.0;
+	if (GetEpisodeTimeRange(pool_coll, StartTs, EndTs))
+	{
+		GetEpisodeDataRange(pool_coll, StartTs, EndTs, true, false, EpisodeData);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not read the time range of %s.%s.."),
+			*FString(__FUNCTION__), __LINE__, *DBName, *CollName);
+	}
+	mongoc_collection_destroy(pool_coll);
+	mongoc_client_pool_push(client_pool, pool_client);
+#endif // SL_WITH_LIBMONGO_C
+	return EpisodeData;
+}
+
+// Get the document count and time range of the given database and collection using a pooled connection (safe to call from worker threads)
+bool FSLMongoQueryDBHandler::GetEpisodeMetadataPooled(const FString& DBName, const FString& CollName, FSLMongoEpisodeMetadata& OutMetadata) const
+{
+	bool bSuccess = false;
+#if SL_WITH_LIBMONGO_C
+	if (!client_pool)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Client pool is not available, connect first.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	mongoc_client_t* pool_client = mongoc_client_pool_pop(client_pool);
+	mongoc_collection_t* pool_coll = mongoc_client_get_collection(pool_client, TCHAR_TO_UTF8(*DBName), TCHAR_TO_UTF8(*CollName));
+
+	// The estimate is read from the collection metadata instead of scanning the documents
+	bson_error_t error;
+	const int64_t count = mongoc_collection_estimated_document_count(pool_coll, NULL, NULL, NULL, &error);
+	if (count < 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+	}
+	else if (GetEpisodeTimeRange(pool_coll, OutMetadata.StartTs, OutMetadata.EndTs))
+	{
+		OutMetadata.NumDocuments = count;
+		bSuccess = true;
+	}
+	mongoc_collection_destroy(pool_coll);
+	mongoc_client_pool_push(client_pool, pool_client);
+#endif // SL_WITH_LIBMONGO_C
+	return bSuccess;
+}
+
+// Get the pose of the individual at the given time using a pooled connection (safe to call from worker threads)
+FTransform FSLMongoQueryDBHandler::GetIndividualPoseAtPooled(const FString& DBName, const FString& CollName, const FString& Id, float Ts) const
+{
+	FTransform Pose;
+#if SL_WITH_LIBMONGO_C
+	if (!client_pool)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Client pool is not available, connect first.."), *FString(__FUNCTION__), __LINE__);
+		return Pose;
+	}
+
+	mongoc_client_t* pool_client = mongoc_client_pool_pop(client_pool);
+	mongoc_collection_t* pool_coll = mongoc_client_get_collection(pool_client, TCHAR_TO_UTF8(*DBName), TCHAR_TO_UTF8(*CollName));
+	Pose = GetIndividualPoseAt(pool_coll, Id, Ts);
+	mongoc_collection_destroy(pool_coll);
+	mongoc_client_pool_push(client_pool, pool_client);
+#endif // SL_WITH_LIBMONGO_C
 	return Pose;
 }
 
-// Get the poses of the individual between the given timestamps
-TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT) const
+// Get the poses of the individual between the given timestamps using a pooled connection (safe to call from worker threads)
+TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectoryPooled(const FString& DBName, const FString& CollName, const FString& Id,
+	float StartTs, float EndTs, float DeltaT) const
 {
 	TArray<FTransform> Trajectory;
-	if (!IsReady())
+#if SL_WITH_LIBMONGO_C
+	if (!client_pool)
 	{
-		UE_LOG(LogTemp, Log, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Client pool is not available, connect first.."), *FString(__FUNCTION__), __LINE__);
 		return Trajectory;
 	}
 
+	mongoc_client_t* pool_client = mongoc_client_pool_pop(client_pool);
+	mongoc_collection_t* pool_coll = mongoc_client_get_collection(pool_client, TCHAR_TO_UTF8(*DBName), TCHAR_TO_UTF8(*CollName));
+	Trajectory = GetIndividualTrajectory(pool_coll, Id, StartTs, EndTs, DeltaT);
+	mongoc_collection_destroy(pool_coll);
+	mongoc_client_pool_push(client_pool, pool_client);
+#endif // SL_WITH_LIBMONGO_C
+	return Trajectory;
+}
+
+// Get skeletal individual pose using a pooled connection (safe to call from worker threads)
+TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIndividualPoseAtPooled(const FString& DBName, const FString& CollName, const FString& Id,
+	float Ts, const TArray<int32>& BoneIndexes) const
+{
+	TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
+#if SL_WITH_LIBMONGO_C
+	if (!client_pool)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Client pool is not available, connect first.."), *FString(__FUNCTION__), __LINE__);
+		return SkeletalPosePair;
+	}
+
+	mongoc_client_t* pool_client = mongoc_client_pool_pop(client_pool);
+	mongoc_collection_t* pool_coll = mongoc_client_get_collection(pool_client, TCHAR_TO_UTF8(*DBName), TCHAR_TO_UTF8(*CollName));
+	SkeletalPosePair = GetSkeletalIndividualPoseAt(pool_coll, Id, Ts, BoneIndexes);
+	mongoc_collection_destroy(pool_coll);
+	mongoc_client_pool_push(client_pool, pool_client);
+#endif // SL_WITH_LIBMONGO_C
+	return SkeletalPosePair;
+}
+
+// Get skeletal individual trajectory using a pooled connection (safe to call from worker threads)
+TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetSkeletalIndividualTrajectoryPooled(const FString& DBName, const FString& CollName, const FString& Id,
+	float StartTs, float EndTs, float DeltaT, const TArray<int32>& BoneIndexes) const
+{
+	TArray<TPair<FTransform, TMap<int32, FTransform>>> SkeletalTrajectoryPair;
+#if SL_WITH_LIBMONGO_C
+	if (!client_pool)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Client pool is not available, connect first.."), *FString(__FUNCTION__), __LINE__);
+		return SkeletalTrajectoryPair;
+	}
+
+	mongoc_client_t* pool_client = mongoc_client_pool_pop(client_pool);
+	mongoc_collection_t* pool_coll = mongoc_client_get_collection(pool_client, TCHAR_TO_UTF8(*DBName), TCHAR_TO_UTF8(*CollName));
+	SkeletalTrajectoryPair = GetSkeletalIndividualTrajectory(pool_coll, Id, StartTs, EndTs, DeltaT, BoneIndexes);
+	mongoc_collection_destroy(pool_coll);
+	mongoc_client_pool_push(client_pool, pool_client);
+#endif // SL_WITH_LIBMONGO_C
+	return SkeletalTrajectoryPair;
+}
+
+// Get the episode data at the given timestamp (frame)
+TMap<FString, FTransform> FSLMongoQueryDBHandler::GetFrameData(float Ts)
+{
+	return TMap<FString, FTransform>();
+}
+
+/* Helpers */
 #if SL_WITH_LIBMONGO_C
+// Get the pose of the individual at the given time (uses the given collection handle)
+FTransform FSLMongoQueryDBHandler::GetIndividualPoseAt(mongoc_collection_t* coll, const FString& Id, float Ts) const
+{
+	FTransform Pose;
 	double ExecBegin = FPlatformTime::Seconds();
 
 	bson_error_t error;
@@ -335,20 +660,19 @@ TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectory(const FString
 		"{",
 			"$match",
 			"{",
-				"timestamp", 
-				"{", 
-					"$gte", BCON_DOUBLE(StartTs),
-					"$lte", BCON_DOUBLE(EndTs),
-				"}",
+				"timestamp", "{", "$lte", BCON_DOUBLE(Ts), "}",
 				"individuals.id", BCON_UTF8(TCHAR_TO_ANSI(*Id)),		// yields faster results if we match against the id from the start
 			"}",
 		"}",
 		"{",
 			"$sort",
 			"{",
-				"timestamp", BCON_INT32(1),								// no time penalty if the collection is indexed
+				"timestamp", BCON_INT32(-1),							// required to get the last pose (no time penalty if the collection is indexed)
 			"}",
 		"}",
+		"{",
+			"$limit", BCON_INT32(1),
+		"}",
 		"{",
 			"$unwind", BCON_UTF8("$individuals"),
 		"}",
@@ -371,31 +695,17 @@ TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectory(const FString
 		"]");
 
 	cursor = mongoc_collection_aggregate(
-		collection, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
+		coll, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
 	double QueryDuration = FPlatformTime::Seconds() - ExecBegin;
+	int32 NumDocs = 0;
 
 	// Read cursor if no errors occured
 	if (!mongoc_cursor_error(cursor, &error))
 	{
-		if (DeltaT > 0.f)
+		if (mongoc_cursor_next(cursor, &doc))
 		{
-			double PrevTs = -BIG_NUMBER;
-			while (mongoc_cursor_next(cursor, &doc))
-			{
-				double CurrTs = GetTs(doc);
-				if (CurrTs - PrevTs > DeltaT)
-				{
-					Trajectory.Add(GetPose(doc));
-					PrevTs = CurrTs;
-				}
-			}
-		}
-		else
-		{
-			while (mongoc_cursor_next(cursor, &doc))
-			{
-				Trajectory.Add(GetPose(doc));
-			}
+			Pose = GetPose(doc);
+			NumDocs++;
 		}
 	}
 	else
@@ -405,29 +715,18 @@ TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectory(const FString
 	}
 	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
 
+	ProfileQuery(TEXT("IndividualPoseAt"), coll, pipeline, FPlatformTime::Seconds() - ExecBegin, NumDocs);
 	mongoc_cursor_destroy(cursor);
 	bson_destroy(pipeline);
-	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor=[%f], total=[%f] seconds, Num=[%d]..;"),
-		*FString(__func__), __LINE__, QueryDuration, CursorReadDuration, FPlatformTime::Seconds() - ExecBegin, Trajectory.Num());
-#endif
-	if (Trajectory.Num() == 0)
-	{
-		Trajectory.Add(GetIndividualPoseAt(Id, StartTs));
-	}
-	return Trajectory;
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor=[%f], total=[%f] seconds..;"),
+		*FString(__func__), __LINE__, QueryDuration, CursorReadDuration, FPlatformTime::Seconds() - ExecBegin);
+	return Pose;
 }
 
-// Get skeletal individual pose
-TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIndividualPoseAt(const FString& Id, float Ts) const
+// Get the poses of the individual between the given timestamps (uses the given collection handle)
+TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectory(mongoc_collection_t* coll, const FString& Id, float StartTs, float EndTs, float DeltaT) const
 {
-	TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
-	if (!IsReady())
-	{
-		UE_LOG(LogTemp, Warning, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
-		return SkeletalPosePair;
-	}
-
-#if SL_WITH_LIBMONGO_C	
+	TArray<FTransform> Trajectory;
 	double ExecBegin = FPlatformTime::Seconds();
 
 	bson_error_t error;
@@ -439,26 +738,27 @@ TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIn
 		"{",
 			"$match",
 			"{",
-				"timestamp", "{", "$lte", BCON_DOUBLE(Ts), "}",
-				"skel_individuals.id", BCON_UTF8(TCHAR_TO_ANSI(*Id)),		// yields faster results if we match against the id from the start
+				"timestamp", 
+				"{", 
+					"$gte", BCON_DOUBLE(StartTs),
+					"$lte", BCON_DOUBLE(EndTs),
+				"}",
+				"individuals.id", BCON_UTF8(TCHAR_TO_ANSI(*Id)),		// yields faster results if we match against the id from the start
 			"}",
 		"}",
 		"{",
 			"$sort",
 			"{",
-				"timestamp", BCON_INT32(-1),
+				"timestamp", BCON_INT32(1),								// no time penalty if the collection is indexed
 			"}",
 		"}",
 		"{",
-			"$limit", BCON_INT32(1),
-		"}",
-		"{",
-			"$unwind", BCON_UTF8("$skel_individuals"),
+			"$unwind", BCON_UTF8("$individuals"),
 		"}",
 		"{",
 			"$match",
 			"{",
-				"skel_individuals.id", BCON_UTF8(TCHAR_TO_ANSI(*Id)),		// match against the searched id in the unwinded array (has all individuals from the doc)
+				"individuals.id", BCON_UTF8(TCHAR_TO_ANSI(*Id)),		// match against the searched id in the unwinded array (has all individuals from the doc)
 			"}",
 		"}",
 		"{",
@@ -466,46 +766,43 @@ TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIn
 			"{",
 				"_id", BCON_INT32(0),
 				"timestamp", BCON_INT32(1),
-				"bones", BCON_UTF8("$skel_individuals.bones"),		// bones data (index, loc, quat)
-				"loc", BCON_UTF8("$skel_individuals.loc"),			// actor loc
-				"quat", BCON_UTF8("$skel_individuals.quat"),		// actor quat
-				"pose", BCON_UTF8("$skel_individuals.pose"),
+				"loc", BCON_UTF8("$individuals.loc"),
+				"quat", BCON_UTF8("$individuals.quat"),
+				"pose", BCON_UTF8("$individuals.pose"),
 			"}",
 		"}",
 		"]");
 
 	cursor = mongoc_collection_aggregate(
-		collection, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
+		coll, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
 	double QueryDuration = FPlatformTime::Seconds() - ExecBegin;
-
+	int32 NumDocs = 0;
 
 	// Read cursor if no errors occured
 	if (!mongoc_cursor_error(cursor, &error))
 	{
-		if (mongoc_cursor_next(cursor, &doc))
+		if (DeltaT > 0.f)
 		{
-			SkeletalPosePair.Key = GetPose(doc);
-
-			// Get bones data
-			bson_iter_t bones;
-			if (bson_iter_init(&bones, doc) && bson_iter_find(&bones, "bones"))
+			double PrevTs = -BIG_NUMBER;
+			while (mongoc_cursor_next(cursor, &doc))
 			{
-				bson_iter_t bone;
-				if (bson_iter_recurse(&bones, &bone))
+				NumDocs++;
+				double CurrTs = GetTs(doc);
+				if (CurrTs - PrevTs > DeltaT)
 				{
-					int32 BoneIndex;
-					bson_iter_t value;
-					while (bson_iter_next(&bone))
-					{
-						if (bson_iter_recurse(&bone, &value) && bson_iter_find(&value, "idx"))
-						{
-							BoneIndex = bson_iter_int32(&value);							
-						}
-						SkeletalPosePair.Value.Emplace(BoneIndex, GetPose(&bone));
-					}
+					Trajectory.Add(GetPose(doc));
+					PrevTs = CurrTs;
 				}
 			}
 		}
+		else
+		{
+			while (mongoc_cursor_next(cursor, &doc))
+			{
+				Trajectory.Add(GetPose(doc));
+				NumDocs++;
+			}
+		}
 	}
 	else
 	{
@@ -514,50 +811,48 @@ TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIn
 	}
 	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
 
+	ProfileQuery(TEXT("IndividualTrajectory"), coll, pipeline, FPlatformTime::Seconds() - ExecBegin, NumDocs, false);
 	mongoc_cursor_destroy(cursor);
 	bson_destroy(pipeline);
-	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor=[%f], total=[%f] seconds..;"),
-		*FString(__func__), __LINE__, QueryDuration, CursorReadDuration, FPlatformTime::Seconds() - ExecBegin);
-#endif
-	return SkeletalPosePair;
-}
-
-// Get skeletal individual trajectory
-TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetSkeletalIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT) const
-{
-	TArray<TPair<FTransform, TMap<int32, FTransform>>> SkeletalTrajectoryPair;
-	if (!IsReady())
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor=[%f], total=[%f] seconds, Num=[%d]..;"),
+		*FString(__func__), __LINE__, QueryDuration, CursorReadDuration, FPlatformTime::Seconds() - ExecBegin, Trajectory.Num());
+	if (Trajectory.Num() == 0)
 	{
-		UE_LOG(LogTemp, Log, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
-		return SkeletalTrajectoryPair;
+		Trajectory.Add(GetIndividualPoseAt(coll, Id, StartTs));
 	}
+	return Trajectory;
+}
 
-#if SL_WITH_LIBMONGO_C
+// Get skeletal individual pose (uses the given collection handle)
+TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIndividualPoseAt(mongoc_collection_t* coll, const FString& Id, float Ts,
+	const TArray<int32>& BoneIndexes) const
+{
+	TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
 	double ExecBegin = FPlatformTime::Seconds();
 
 	bson_error_t error;
 	const bson_t *doc;
 	mongoc_cursor_t *cursor;
 	bson_t *pipeline;
+	bson_t *project_stage = CreateSkeletalProjectStage(BoneIndexes);
 
 	pipeline = BCON_NEW("pipeline", "[",
 		"{",
 			"$match",
 			"{",
-				"timestamp", 
-				"{", 
-					"$gte", BCON_DOUBLE(StartTs),
-					"$lte", BCON_DOUBLE(EndTs),
-				"}",
+				"timestamp", "{", "$lte", BCON_DOUBLE(Ts), "}",
 				"skel_individuals.id", BCON_UTF8(TCHAR_TO_ANSI(*Id)),		// yields faster results if we match against the id from the start
 			"}",
 		"}",
 		"{",
 			"$sort",
 			"{",
-				"timestamp", BCON_INT32(1),								// if sort if right after match it barely adds any time penalty
+				"timestamp", BCON_INT32(-1),
 			"}",
 		"}",
+		"{",
+			"$limit", BCON_INT32(1),
+		"}",
 		"{",
 			"$unwind", BCON_UTF8("$skel_individuals"),
 		"}",
@@ -567,90 +862,24 @@ TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetSk
 				"skel_individuals.id", BCON_UTF8(TCHAR_TO_ANSI(*Id)),		// match against the searched id in the unwinded array (has all individuals from the doc)
 			"}",
 		"}",
-		"{",
-			"$project",
-			"{",
-				"_id", BCON_INT32(0),
-				"timestamp", BCON_INT32(1),
-				"bones", BCON_UTF8("$skel_individuals.bones"),		// bones data (index, loc, quat)
-				"loc", BCON_UTF8("$skel_individuals.loc"),			// actor loc
-				"quat", BCON_UTF8("$skel_individuals.quat"),		// actor quat
-				"pose", BCON_UTF8("$skel_individuals.pose"),
-
-			"}",
-		"}",
+		BCON_DOCUMENT(project_stage),								// actor pose and the (filtered) bones data (index, loc, quat)
 		"]");
 
 	cursor = mongoc_collection_aggregate(
-		collection, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
+		coll, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
 	double QueryDuration = FPlatformTime::Seconds() - ExecBegin;
+	int32 NumDocs = 0;
+
 
 	// Read cursor if no errors occured
 	if (!mongoc_cursor_error(cursor, &error))
 	{
-		if (DeltaT > 0.f)
-		{
-			double PrevTs = -BIG_NUMBER;
-			while (mongoc_cursor_next(cursor, &doc))
-			{
-				double CurrTs = GetTs(doc);
-				if (CurrTs - PrevTs > DeltaT)
-				{
-					TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
-					SkeletalPosePair.Key = GetPose(doc);
-
-					// Get bones data
-					bson_iter_t bones;
-					if (bson_iter_init(&bones, doc) && bson_iter_find(&bones, "bones"))
-					{
-						bson_iter_t bone;
-						if (bson_iter_recurse(&bones, &bone))
-						{
-							int32 BoneIndex;
-							bson_iter_t value;
-							while (bson_iter_next(&bone))
-							{
-								if (bson_iter_recurse(&bone, &value) && bson_iter_find(&value, "idx"))
-								{
-									BoneIndex = bson_iter_int32(&value);
-								}
-								SkeletalPosePair.Value.Emplace(BoneIndex, GetPose(&bone));
-							}
-						}
-					}
-					SkeletalTrajectoryPair.Add(SkeletalPosePair);
-					PrevTs = CurrTs;
-				}
-			}
-		}
-		else
+		if (mongoc_cursor_next(cursor, &doc))
 		{
-			while (mongoc_cursor_next(cursor, &doc))
-			{
-				TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
-				SkeletalPosePair.Key = GetPose(doc);
+			SkeletalPosePair.Key = GetPose(doc);
+			NumDocs++;
 
-				// Get bones data
-				bson_iter_t bones;
-				if (bson_iter_init(&bones, doc) && bson_iter_find(&bones, "bones"))
-				{
-					bson_iter_t bone;
-					if (bson_iter_recurse(&bones, &bone))
-					{
-						int32 BoneIndex;
-						bson_iter_t value;
-						while (bson_iter_next(&bone))
-						{
-							if (bson_iter_recurse(&bone, &value) && bson_iter_find(&value, "idx"))
-							{
-								BoneIndex = bson_iter_int32(&value);
-							}
-							SkeletalPosePair.Value.Emplace(BoneIndex, GetPose(&bone));
-						}
-					}
-				}
-				SkeletalTrajectoryPair.Add(SkeletalPosePair);
-			}
+			GetBonePoses(doc, SkeletalPosePair.Value);
 		}
 	}
 	else
@@ -660,104 +889,94 @@ TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetSk
 	}
 	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
 
+	ProfileQuery(TEXT("SkeletalIndividualPoseAt"), coll, pipeline, FPlatformTime::Seconds() - ExecBegin, NumDocs);
 	mongoc_cursor_destroy(cursor);
 	bson_destroy(pipeline);
-	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor=[%f], total=[%f] seconds, Num=[%d]..;"),
-		*FString(__func__), __LINE__, QueryDuration, CursorReadDuration, FPlatformTime::Seconds() - ExecBegin, SkeletalTrajectoryPair.Num());
-#endif
-	if (SkeletalTrajectoryPair.Num() == 0)
-	{
-		SkeletalTrajectoryPair.Add(GetSkeletalIndividualPoseAt(Id, StartTs));
-	}
-	return SkeletalTrajectoryPair;
+	bson_destroy(project_stage);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor=[%f], total=[%f] seconds..;"),
+		*FString(__func__), __LINE__, QueryDuration, CursorReadDuration, FPlatformTime::Seconds() - ExecBegin);
+	return SkeletalPosePair;
 }
 
-// Get the whole episode data
-TArray<TPair<float, TMap<FString, FTransform>>> FSLMongoQueryDBHandler::GetEpisodeData() const
+// Get skeletal individual trajectory (uses the given collection handle)
+TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetSkeletalIndividualTrajectory(mongoc_collection_t* coll, const FString& Id, float StartTs, float EndTs, float DeltaT,
+	const TArray<int32>& BoneIndexes) const
 {
-	TArray<TPair<float, TMap<FString, FTransform>>> EpisodeData;
-	if (!IsReady())
-	{
-		UE_LOG(LogTemp, Warning, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
-		return EpisodeData;
-	}	
-
-#if SL_WITH_LIBMONGO_C
+	TArray<TPair<FTransform, TMap<int32, FTransform>>> SkeletalTrajectoryPair;
 	double ExecBegin = FPlatformTime::Seconds();
 
 	bson_error_t error;
-	bson_t opts;
 	const bson_t *doc;
 	mongoc_cursor_t *cursor;
 	bson_t *pipeline;
+	bson_t *project_stage = CreateSkeletalProjectStage(BoneIndexes);
 
 	pipeline = BCON_NEW("pipeline", "[",
 		"{",
 			"$match",
 			"{",
 				"timestamp", 
-				"{",
-					"$exists", BCON_BOOL(true),
+				"{", 
+					"$gte", BCON_DOUBLE(StartTs),
+					"$lte", BCON_DOUBLE(EndTs),
 				"}",
+				"skel_individuals.id", BCON_UTF8(TCHAR_TO_ANSI(*Id)),		// yields faster results if we match against the id from the start
 			"}",
 		"}",
 		"{",
 			"$sort",
 			"{",
-				"timestamp", BCON_INT32(1),
+				"timestamp", BCON_INT32(1),								// if sort if right after match it barely adds any time penalty
 			"}",
 		"}",
 		"{",
-			"$project",
+			"$unwind", BCON_UTF8("$skel_individuals"),
+		"}",
+		"{",
+			"$match",
 			"{",
-				"_id", BCON_INT32(0),
-				"timestamp", BCON_INT32(1),
-				"individuals", BCON_UTF8("$individuals"),
+				"skel_individuals.id", BCON_UTF8(TCHAR_TO_ANSI(*Id)),		// match against the searched id in the unwinded array (has all individuals from the doc)
 			"}",
 		"}",
+		BCON_DOCUMENT(project_stage),								// actor pose and the (filtered) bones data (index, loc, quat)
 		"]");
 
-	// If the episode is very large the hard drive needs to be used to cache results
-	bson_init(&opts);
-	BSON_APPEND_BOOL(&opts, "allowDiskUse", true);
 	cursor = mongoc_collection_aggregate(
-		collection, MONGOC_QUERY_NONE, pipeline, &opts, NULL);
-
+		coll, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
 	double QueryDuration = FPlatformTime::Seconds() - ExecBegin;
+	int32 NumDocs = 0;
 
-	int32 FrameIdx = 0;
 	// Read cursor if no errors occured
 	if (!mongoc_cursor_error(cursor, &error))
 	{
-		while (mongoc_cursor_next(cursor, &doc))
+		if (DeltaT > 0.f)
 		{
-			if (FrameIdx++ % 250 == 0) { UE_LOG(LogTemp, Log, TEXT(" mongo processing frame %d .."), FrameIdx++); }
-			bson_iter_t frame_iter;
-			if (bson_iter_init(&frame_iter, doc))
+			double PrevTs = -BIG_NUMBER;
+			while (mongoc_cursor_next(cursor, &doc))
 			{
-				TMap<FString, FTransform> CurrIndividualsData;
-				float CurrTs;
-				
-				if (bson_iter_find(&frame_iter, "timestamp"))
+				NumDocs++;
+				double CurrTs = GetTs(doc);
+				if (CurrTs - PrevTs > DeltaT)
 				{
-					CurrTs = bson_iter_double(&frame_iter);
-				}
+					TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
+					SkeletalPosePair.Key = GetPose(doc);
 
-				bson_iter_t individuals_iter;
-				if (bson_iter_find(&frame_iter, "individuals") && bson_iter_recurse(&frame_iter, &individuals_iter))
-				{
-					while (bson_iter_next(&individuals_iter))
-					{
-						FString Id;
-						bson_iter_t individual_val_iter;
-						if (bson_iter_recurse(&individuals_iter, &individual_val_iter) && bson_iter_find(&individual_val_iter, "id"))
-						{
-							Id = FString(bson_iter_utf8(&individual_val_iter, NULL));
-						}
-						CurrIndividualsData.Emplace(Id, GetPose(&individuals_iter));
-					}
+					GetBonePoses(doc, SkeletalPosePair.Value);
+					SkeletalTrajectoryPair.Add(SkeletalPosePair);
+					PrevTs = CurrTs;
 				}
-				EpisodeData.Emplace(CurrTs, CurrIndividualsData);
+			}
+		}
+		else
+		{
+			while (mongoc_cursor_next(cursor, &doc))
+			{
+				TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
+				SkeletalPosePair.Key = GetPose(doc);
+
+				GetBonePoses(doc, SkeletalPosePair.Value);
+				SkeletalTrajectoryPair.Add(SkeletalPosePair);
+				NumDocs++;
 			}
 		}
 	}
@@ -768,29 +987,19 @@ TArray<TPair<float, TMap<FString, FTransform>>> FSLMongoQueryDBHandler::GetEpiso
 	}
 	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
 
+	ProfileQuery(TEXT("SkeletalIndividualTrajectory"), coll, pipeline, FPlatformTime::Seconds() - ExecBegin, NumDocs, false);
 	mongoc_cursor_destroy(cursor);
 	bson_destroy(pipeline);
-	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor(num=%d)=[%f], total=[%f] seconds..;"),
-		*FString(__func__), __LINE__, QueryDuration, EpisodeData.Num(), CursorReadDuration, FPlatformTime::Seconds() - ExecBegin);
-#endif
-	return EpisodeData;
-}
-
-// Get the whole episode data in an async thread
-TArray<TPair<float, TMap<FString, FTransform>>> FSLMongoQueryDBHandler::GetEpisodeDataAsync() const
-{
-	// TODO
-	return TArray<TPair<float, TMap<FString, FTransform>>>();
-}
-
-// Get the episode data at the given timestamp (frame)
-TMap<FString, FTransform> FSLMongoQueryDBHandler::GetFrameData(float Ts)
-{
-	return TMap<FString, FTransform>();
+	bson_destroy(project_stage);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor=[%f], total=[%f] seconds, Num=[%d]..;"),
+		*FString(__func__), __LINE__, QueryDuration, CursorReadDuration, FPlatformTime::Seconds() - ExecBegin, SkeletalTrajectoryPair.Num());
+	if (SkeletalTrajectoryPair.Num() == 0)
+	{
+		SkeletalTrajectoryPair.Add(GetSkeletalIndividualPoseAt(coll, Id, StartTs, BoneIndexes));
+	}
+	return SkeletalTrajectoryPair;
 }
 
-/* Helpers */
-#if SL_WITH_LIBMONGO_C
 // Get the pose data from document
 FTransform FSLMongoQueryDBHandler::GetPose(const bson_t* doc) const
 {
@@ -868,8 +1077,9 @@ FTransform FSLMongoQueryDBHandler::GetPose(const bson_t* doc) const
 // Get the pose data from iterator
 FTransform FSLMongoQueryDBHandler::GetPose(const bson_iter_t* iter) const
 {
-	FVector Loc;
-	FQuat Quat;
+	// Location only projections have no rotation
+	FVector Loc = FVector::ZeroVector;
+	FQuat Quat = FQuat::Identity;
 
 	bson_iter_t value;
 	bson_iter_t sub_value;
@@ -949,4 +1159,317 @@ double FSLMongoQueryDBHandler::GetTs(const bson_t* doc) const
 	}
 	return -1.f;
 }
-#endif // SL_WITH_LIBMONGO_C
\ No newline at end of file
+
+// Get the bone poses from the skeletal document
+void FSLMongoQueryDBHandler::GetBonePoses(const bson_t* doc, TMap<int32, FTransform>& OutBonePoses) const
+{
+	bson_iter_t bones;
+	if (bson_iter_init(&bones, doc) && bson_iter_find(&bones, "bones"))
+	{
+		bson_iter_t bone;
+		if (bson_iter_recurse(&bones, &bone))
+		{
+			bson_iter_t value;
+			while (bson_iter_next(&bone))
+			{
+				if (bson_iter_recurse(&bone, &value) && bson_iter_find(&value, "idx"))
+				{
+					OutBonePoses.Emplace(bson_iter_int32(&value), GetPose(&bone));
+				}
+			}
+		}
+	}
+}
+
+// Create the skeletal projection stage, the bones array is filtered in the stage if a subset is given
+bson_t* FSLMongoQueryDBHandler::CreateSkeletalProjectStage(const TArray<int32>& BoneIndexes) const
+{
+	bson_t* stage = bson_new();
+	bson_t project_doc;
+	BSON_APPEND_DOCUMENT_BEGIN(stage, "$project", &project_doc);
+	BSON_APPEND_INT32(&project_doc, "_id", 0);
+	BSON_APPEND_INT32(&project_doc, "timestamp", 1);
+	if (BoneIndexes.Num() == 0)
+	{
+		BSON_APPEND_UTF8(&project_doc, "bones", "$skel_individuals.bones");
+	}
+	else
+	{
+		// "bones" : { "$filter" : { "input" : "$skel_individuals.bones", "as" : "bone", "cond" : { "$in" : ["$$bone.idx", [..]] } } }
+		bson_t bones_doc;
+		bson_t filter_doc;
+		bson_t cond_doc;
+		bson_t in_arr;
+		bson_t idx_arr;
+		char idx_str[16];
+		const char* idx_key;
+
+		BSON_APPEND_DOCUMENT_BEGIN(&project_doc, "bones", &bones_doc);
+		BSON_APPEND_DOCUMENT_BEGIN(&bones_doc, "$filter", &filter_doc);
+			BSON_APPEND_UTF8(&filter_doc, "input", "$skel_individuals.bones");
+			BSON_APPEND_UTF8(&filter_doc, "as", "bone");
+			BSON_APPEND_DOCUMENT_BEGIN(&filter_doc, "cond", &cond_doc);
+			BSON_APPEND_ARRAY_BEGIN(&cond_doc, "$in", &in_arr);
+				BSON_APPEND_UTF8(&in_arr, "0", "$$bone.idx");
+				BSON_APPEND_ARRAY_BEGIN(&in_arr, "1", &idx_arr);
+				for (int32 Idx = 0; Idx < BoneIndexes.Num(); ++Idx)
+				{
+					bson_uint32_to_string(Idx, &idx_key, idx_str, sizeof idx_str);
+					BSON_APPEND_INT32(&idx_arr, idx_key, BoneIndexes[Idx]);
+				}
+				bson_append_array_end(&in_arr, &idx_arr);
+			bson_append_array_end(&cond_doc, &in_arr);
+			bson_append_document_end(&filter_doc, &cond_doc);
+		bson_append_document_end(&bones_doc, &filter_doc);
+		bson_append_document_end(&project_doc, &bones_doc);
+	}
+	BSON_APPEND_UTF8(&project_doc, "loc", "$skel_individuals.loc");			// actor loc
+	BSON_APPEND_UTF8(&project_doc, "quat", "$skel_individuals.quat");		// actor quat
+	BSON_APPEND_UTF8(&project_doc, "pose", "$skel_individuals.pose");
+	bson_append_document_end(stage, &project_doc);
+	return stage;
+}
+
+// Create the episode frame projection stage (the rotations are dropped server side if only the locations are needed)
+bson_t* FSLMongoQueryDBHandler::CreateEpisodeFrameProjectStage(bool bLocationsOnly) const
+{
+	bson_t* stage = bson_new();
+	bson_t project_doc;
+	BSON_APPEND_DOCUMENT_BEGIN(stage, "$project", &project_doc);
+	BSON_APPEND_INT32(&project_doc, "_id", 0);
+	BSON_APPEND_INT32(&project_doc, "timestamp", 1);
+	if (bLocationsOnly)
+	{
+		BSON_APPEND_INT32(&project_doc, "individuals.id", 1);
+		BSON_APPEND_INT32(&project_doc, "individuals.loc", 1);
+	}
+	else
+	{
+		BSON_APPEND_UTF8(&project_doc, "individuals", "$individuals");
+	}
+	bson_append_document_end(stage, &project_doc);
+	return stage;
+}
+
+// Read the episode frame document into a new column entry
+void FSLMongoQueryDBHandler::ReadEpisodeFrame(const bson_t* doc, FSLMongoEpisodeData& OutEpisodeData) const
+{
+	bson_iter_t frame_iter;
+	if (!bson_iter_init(&frame_iter, doc) || !bson_iter_find(&frame_iter, "timestamp"))
+	{
+		return;
+	}
+	const int32 FrameIndex = OutEpisodeData.AddFrame(bson_iter_double(&frame_iter));
+
+	bson_iter_t individuals_iter;
+	if (bson_iter_find(&frame_iter, "individuals") && bson_iter_recurse(&frame_iter, &individuals_iter))
+	{
+		while (bson_iter_next(&individuals_iter))
+		{
+			bson_iter_t individual_val_iter;
+			if (bson_iter_recurse(&individuals_iter, &individual_val_iter) && bson_iter_find(&individual_val_iter, "id"))
+			{
+				const int32 IndividualIndex = OutEpisodeData.FindOrAddIndividual(FString(bson_iter_utf8(&individual_val_iter, NULL)));
+				OutEpisodeData.SetPose(IndividualIndex, FrameIndex, GetPose(&individuals_iter));
+			}
+		}
+	}
+}
+
+// Get the first and last timestamp of the episode (uses the given collection handle)
+bool FSLMongoQueryDBHandler::GetEpisodeTimeRange(mongoc_collection_t* coll, double& OutStartTs, double& OutEndTs) const
+{
+	bool bStartFound = false;
+	bool bEndFound = false;
+	for (int32 SortOrder : {1, -1})
+	{
+		bson_t* filter = BCON_NEW("timestamp", "{", "$exists", BCON_BOOL(true), "}");
+		bson_t* opts = BCON_NEW(
+			"projection", "{", "_id", BCON_INT32(0), "timestamp", BCON_INT32(1), "}",
+			"sort", "{", "timestamp", BCON_INT32(SortOrder), "}",
+			"limit", BCON_INT64(1));
+
+		const bson_t* doc;
+		mongoc_cursor_t* cursor = mongoc_collection_find_with_opts(coll, filter, opts, NULL);
+		if (mongoc_cursor_next(cursor, &doc))
+		{
+			if (SortOrder == 1)
+			{
+				OutStartTs = GetTs(doc);
+				bStartFound = true;
+			}
+			else
+			{
+				OutEndTs = GetTs(doc);
+				bEndFound = true;
+			}
+		}
+
+		bson_error_t error;
+		if (mongoc_cursor_error(cursor, &error))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+				*FString(__func__), __LINE__, *FString(error.message));
+		}
+
+		mongoc_cursor_destroy(cursor);
+		bson_destroy(filter);
+		bson_destroy(opts);
+	}
+	return bStartFound && bEndFound && OutEndTs >= OutStartTs;
+}
+
+// Get the episode frames in the given timestamp range (uses the given collection handle)
+void FSLMongoQueryDBHandler::GetEpisodeDataRange(mongoc_collection_t* coll, double StartTs, double EndTs, bool bEndInclusive,
+	bool bLocationsOnly, FSLMongoEpisodeData& OutEpisodeData) const
+{
+	double ExecBegin = FPlatformTime::Seconds();
+
+	bson_error_t error;
+	bson_t opts;
+	const bson_t *doc;
+	mongoc_cursor_t *cursor;
+	bson_t *pipeline;
+	bson_t *project_stage = CreateEpisodeFrameProjectStage(bLocationsOnly);
+
+	pipeline = BCON_NEW("pipeline", "[",
+		"{",
+			"$match",
+			"{",
+				"timestamp",
+				"{",
+					"$gte", BCON_DOUBLE(StartTs),
+					bEndInclusive ? "$lte" : "$lt", BCON_DOUBLE(EndTs),
+				"}",
+			"}",
+		"}",
+		"{",
+			"$sort",
+			"{",
+				"timestamp", BCON_INT32(1),
+			"}",
+		"}",
+		BCON_DOCUMENT(project_stage),							// full poses, or only the locations
+		"]");
+
+	bson_init(&opts);
+	BSON_APPEND_BOOL(&opts, "allowDiskUse", true);
+	cursor = mongoc_collection_aggregate(
+		coll, MONGOC_QUERY_NONE, pipeline, &opts, NULL);
+
+	// Read cursor if no errors occured
+	if (!mongoc_cursor_error(cursor, &error))
+	{
+		while (mongoc_cursor_next(cursor, &doc))
+		{
+			ReadEpisodeFrame(doc, OutEpisodeData);
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+	}
+
+	ProfileQuery(TEXT("EpisodeDataRange"), coll, pipeline, FPlatformTime::Seconds() - ExecBegin, OutEpisodeData.NumFrames(), false);
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(pipeline);
+	bson_destroy(project_stage);
+	bson_destroy(&opts);
+}
+
+// Record the query in the profiler, explain it if it is slow (the heavy downloads only get their query plan explained)
+void FSLMongoQueryDBHandler::ProfileQuery(const FString& Type, mongoc_collection_t* coll, const bson_t* pipeline, double Duration, int32 NumReturned,
+	bool bExecutionStats) const
+{
+	if (!Profiler.IsEnabled())
+	{
+		return;
+	}
+	Profiler.Record(Type, Duration, NumReturned);
+
+	if (!Profiler.ShouldExplain(Duration))
+	{
+		return;
+	}
+
+	// Wrap the pipeline in an explain command, executionStats runs the whole pipeline again on the server
+	bson_iter_t pipeline_iter;
+	if (!bson_iter_init_find(&pipeline_iter, pipeline, "pipeline"))
+	{
+		return;
+	}
+	bson_t explain_cmd;
+	bson_t aggregate_doc;
+	bson_t cursor_doc;
+	bson_init(&explain_cmd);
+	BSON_APPEND_DOCUMENT_BEGIN(&explain_cmd, "explain", &aggregate_doc);
+		BSON_APPEND_UTF8(&aggregate_doc, "aggregate", mongoc_collection_get_name(coll));
+		bson_append_iter(&aggregate_doc, "pipeline", -1, &pipeline_iter);
+		BSON_APPEND_DOCUMENT_BEGIN(&aggregate_doc, "cursor", &cursor_doc);
+		bson_append_document_end(&aggregate_doc, &cursor_doc);
+	bson_append_document_end(&explain_cmd, &aggregate_doc);
+	BSON_APPEND_UTF8(&explain_cmd, "verbosity", bExecutionStats ? "executionStats" : "queryPlanner");
+
+	bson_t reply;
+	bson_error_t error;
+	FSLMongoSlowQuery SlowQuery;
+	SlowQuery.Type = Type;
+	SlowQuery.Duration = Duration;
+	SlowQuery.NumReturned = NumReturned;
+	SlowQuery.bExecutionStats = bExecutionStats;
+	if (mongoc_collection_command_simple(coll, &explain_cmd, NULL, &reply, &error))
+	{
+		bson_iter_t reply_iter;
+		if (bson_iter_init(&reply_iter, &reply))
+		{
+			ReadExplainStats(&reply_iter, SlowQuery);
+		}
+		size_t len;
+		char* explain_str = bson_as_relaxed_extended_json(&reply, &len);
+		SlowQuery.Explain = FString(UTF8_TO_TCHAR(explain_str));
+		bson_free(explain_str);
+		Profiler.RecordExplain(SlowQuery);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not explain the %s query, err.:%s"),
+			*FString(__func__), __LINE__, *Type, *FString(error.message));
+	}
+	bson_destroy(&reply);
+	bson_destroy(&explain_cmd);
+}
+
+// Recursively read the documents examined and the scan stages from the explain output
+void FSLMongoQueryDBHandler::ReadExplainStats(bson_iter_t* iter, FSLMongoSlowQuery& OutSlowQuery) const
+{
+	while (bson_iter_next(iter))
+	{
+		const char* key = bson_iter_key(iter);
+		if (BSON_ITER_HOLDS_DOCUMENT(iter) || BSON_ITER_HOLDS_ARRAY(iter))
+		{
+			bson_iter_t child_iter;
+			if (bson_iter_recurse(iter, &child_iter))
+			{
+				ReadExplainStats(&child_iter, OutSlowQuery);
+			}
+		}
+		else if (strcmp(key, "totalDocsExamined") == 0 && BSON_ITER_HOLDS_NUMBER(iter))
+		{
+			OutSlowQuery.NumExamined += bson_iter_as_int64(iter);
+		}
+		else if (strcmp(key, "stage") == 0 && BSON_ITER_HOLDS_UTF8(iter))
+		{
+			const char* stage = bson_iter_utf8(iter, NULL);
+			if (strcmp(stage, "IXSCAN") == 0)
+			{
+				OutSlowQuery.bIndexScan = true;
+			}
+			else if (strcmp(stage, "COLLSCAN") == 0)
+			{
+				OutSlowQuery.bCollectionScan = true;
+			}
+		}
+	}
+}
+#endif // SL_WITH_LIBMONGO_C
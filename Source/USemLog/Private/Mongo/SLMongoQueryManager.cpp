@@ -2,18 +2,24 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #include "Mongo/SLMongoQueryManager.h"
+#include "Individuals/SLIndividualManager.h"
+#include "Individuals/Type/SLSkeletalIndividual.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "EngineUtils.h"
 
 // Ctor
 ASLMongoQueryManager::ASLMongoQueryManager()
 {
-	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = false;
+	// Ticks only while disconnected handlers are waiting for their background fetches
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	PrimaryActorTick.TickInterval = 0.5f;
 
 	// Default values
 	bConnected = false;
 	bTaskSet = false;
 	bEpisodeSet = false;
+	DBHandler = MakeShared<FSLMongoQueryDBHandler, ESPMode::ThreadSafe>();
 
 #if WITH_EDITORONLY_DATA
 	// Make manager sprite smaller (used to easily find the actor in the world)
@@ -136,7 +142,7 @@ bool ASLMongoQueryManager::Connect(const FString& ServerIp, uint16 ServerPort)
 			*FString(__FUNCTION__), __LINE__);
 		return true;
 	}
-	if (DBHandler.Connect(ServerIp, ServerPort))
+	if (DBHandler->Connect(ServerIp, ServerPort))
 	{
 		bConnected = true;
 	}
@@ -147,12 +153,29 @@ bool ASLMongoQueryManager::Connect(const FString& ServerIp, uint16 ServerPort)
 	return bConnected;
 }
 
+// Called every update interval while disconnected handlers wait for their background fetches
+void ASLMongoQueryManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	ReleaseRetiredDBHandlers();
+}
+
 // Disconnect from server
 void ASLMongoQueryManager::Disconnect()
 {
 	if (bConnected)
 	{
-		DBHandler.Disconnect();
+		if (DBHandler.IsUnique())
+		{
+			DBHandler->Disconnect();
+		}
+		else
+		{
+			// Background fetches still hold the handler, it is kept until they are done and released on the game thread
+			RetiredDBHandlers.Add(DBHandler);
+			DBHandler = MakeShared<FSLMongoQueryDBHandler, ESPMode::ThreadSafe>();
+			SetActorTickEnabled(true);
+		}
 		TaskId = "";
 		EpisodeId = "";
 		
@@ -174,7 +197,7 @@ bool ASLMongoQueryManager::SetTask(const FString& InTaskId)
 	{
 		return true;
 	}
-	if (DBHandler.SetDatabase(InTaskId))
+	if (DBHandler->SetDatabase(InTaskId))
 	{
 		TaskId = InTaskId;
 		bTaskSet = true;	
@@ -205,7 +228,7 @@ bool ASLMongoQueryManager::SetEpisode(const FString& InEpisodeId)
 	{
 		return true;
 	}
-	if (DBHandler.SetCollection(InEpisodeId))
+	if (DBHandler->SetCollection(InEpisodeId))
 	{
 		EpisodeId = InEpisodeId;
 		bEpisodeSet = true;
@@ -218,6 +241,18 @@ bool ASLMongoQueryManager::SetEpisode(const FString& InEpisodeId)
 	return bEpisodeSet;
 }
 
+// Enable/disable query profiling
+void ASLMongoQueryManager::SetQueryProfiling(bool bEnable, float SlowQueryThreshold, bool bCaptureExplain)
+{
+	DBHandler->SetProfiling(bEnable, SlowQueryThreshold, bCaptureExplain);
+}
+
+// Log and write the current query profiling summary to file
+FString ASLMongoQueryManager::DumpQueryProfile() const
+{
+	return DBHandler->DumpProfilingSummary();
+}
+
 /* Queries */
 // Get the individual pose with task and episode init
 FTransform ASLMongoQueryManager::GetIndividualPoseAt(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts)
@@ -250,7 +285,7 @@ FTransform ASLMongoQueryManager::GetIndividualPoseAt(const FString& InEpisodeId,
 // Get the individual pose
 FTransform ASLMongoQueryManager::GetIndividualPoseAt(const FString& IndividualId, float Ts) const
 {
-	return DBHandler.GetIndividualPoseAt(IndividualId, Ts);
+	return DBHandler->GetIndividualPoseAt(IndividualId, Ts);
 }
 
 // Get the individual trajectory with task and episode init
@@ -284,16 +319,16 @@ TArray<FTransform> ASLMongoQueryManager::GetIndividualTrajectory(const FString&
 // Get the individual trajectory 
 TArray<FTransform> ASLMongoQueryManager::GetIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT) const
 {
-	return DBHandler.GetIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT);
+	return DBHandler->GetIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT);
 }
 
 
 // Get skeletal individual pose with task and episode init
-TPair<FTransform, TMap<int32, FTransform>> ASLMongoQueryManager::GetSkeletalIndividualPoseAt(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts)
+TPair<FTransform, TMap<int32, FTransform>> ASLMongoQueryManager::GetSkeletalIndividualPoseAt(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts, const TArray<int32>& BoneIndexes)
 {
 	if (SetTask(InTaskId))
 	{
-		return GetSkeletalIndividualPoseAt(InEpisodeId, IndividualId, Ts);
+		return GetSkeletalIndividualPoseAt(InEpisodeId, IndividualId, Ts, BoneIndexes);
 	}
 	else
 	{
@@ -303,11 +338,11 @@ TPair<FTransform, TMap<int32, FTransform>> ASLMongoQueryManager::GetSkeletalIndi
 }
 
 // Get skeletal individual pose with episode init
-TPair<FTransform, TMap<int32, FTransform>> ASLMongoQueryManager::GetSkeletalIndividualPoseAt(const FString& InEpisodeId, const FString& IndividualId, float Ts)
+TPair<FTransform, TMap<int32, FTransform>> ASLMongoQueryManager::GetSkeletalIndividualPoseAt(const FString& InEpisodeId, const FString& IndividualId, float Ts, const TArray<int32>& BoneIndexes)
 {
 	if (SetEpisode(InEpisodeId))
 	{
-		return GetSkeletalIndividualPoseAt(IndividualId, Ts);
+		return GetSkeletalIndividualPoseAt(IndividualId, Ts, BoneIndexes);
 	}
 	else
 	{
@@ -317,17 +352,57 @@ TPair<FTransform, TMap<int32, FTransform>> ASLMongoQueryManager::GetSkeletalIndi
 }
 
 // Get skeletal individual pose
-TPair<FTransform, TMap<int32, FTransform>> ASLMongoQueryManager::GetSkeletalIndividualPoseAt(const FString& IndividualId, float Ts) const
+TPair<FTransform, TMap<int32, FTransform>> ASLMongoQueryManager::GetSkeletalIndividualPoseAt(const FString& IndividualId, float Ts, const TArray<int32>& BoneIndexes) const
+{
+	return DBHandler->GetSkeletalIndividualPoseAt(IndividualId, Ts, BoneIndexes);	
+}
+
+// Get skeletal individual pose of the given bone names with task and episode init
+TPair<FTransform, TMap<int32, FTransform>> ASLMongoQueryManager::GetSkeletalIndividualPoseAt(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts, const TArray<FName>& BoneNames)
+{
+	if (SetTask(InTaskId))
+	{
+		return GetSkeletalIndividualPoseAt(InEpisodeId, IndividualId, Ts, BoneNames);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set task: %s .."), *FString(__FUNCTION__), __LINE__, *InTaskId);
+		return TPair<FTransform, TMap<int32, FTransform>>();
+	}
+}
+
+// Get skeletal individual pose of the given bone names with episode init
+TPair<FTransform, TMap<int32, FTransform>> ASLMongoQueryManager::GetSkeletalIndividualPoseAt(const FString& InEpisodeId, const FString& IndividualId, float Ts, const TArray<FName>& BoneNames)
+{
+	if (SetEpisode(InEpisodeId))
+	{
+		return GetSkeletalIndividualPoseAt(IndividualId, Ts, BoneNames);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set episode: %s .."), *FString(__FUNCTION__), __LINE__, *InEpisodeId);
+		return TPair<FTransform, TMap<int32, FTransform>>();
+	}
+}
+
+// Get skeletal individual pose of the given bone names
+TPair<FTransform, TMap<int32, FTransform>> ASLMongoQueryManager::GetSkeletalIndividualPoseAt(const FString& IndividualId, float Ts, const TArray<FName>& BoneNames) const
 {
-	return DBHandler.GetSkeletalIndividualPoseAt(IndividualId, Ts);	
+	const TArray<int32> BoneIndexes = GetBoneIndexes(IndividualId, BoneNames);
+	if (BoneIndexes.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d None of the bone names could be resolved for %s .."), *FString(__FUNCTION__), __LINE__, *IndividualId);
+		return TPair<FTransform, TMap<int32, FTransform>>();
+	}
+	return DBHandler->GetSkeletalIndividualPoseAt(IndividualId, Ts, BoneIndexes);
 }
 
 // Get skeletal individual trajectory with task and episode init
-TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT)
+TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT, const TArray<int32>& BoneIndexes)
 {
 	if (SetTask(InTaskId))
 	{
-		return GetSkeletalIndividualTrajectory(InEpisodeId, IndividualId, StartTs, EndTs, DeltaT);
+		return GetSkeletalIndividualTrajectory(InEpisodeId, IndividualId, StartTs, EndTs, DeltaT, BoneIndexes);
 	}
 	else
 	{
@@ -338,11 +413,11 @@ TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkel
 }
 
 // Get skeletal individual trajectoru with episode init
-TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT)
+TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT, const TArray<int32>& BoneIndexes)
 {
 	if (SetEpisode(InEpisodeId))
 	{
-		return GetSkeletalIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT);
+		return GetSkeletalIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT, BoneIndexes);
 	}
 	else
 	{
@@ -352,43 +427,234 @@ TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkel
 }
 
 // Get skeletal individual trajectory
-TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT) const
+TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT, const TArray<int32>& BoneIndexes) const
 {
-	return DBHandler.GetSkeletalIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT);
+	return DBHandler->GetSkeletalIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT, BoneIndexes);
+}
+
+// Get skeletal individual trajectory of the given bone names with task and episode init
+TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT, const TArray<FName>& BoneNames)
+{
+	if (SetTask(InTaskId))
+	{
+		return GetSkeletalIndividualTrajectory(InEpisodeId, IndividualId, StartTs, EndTs, DeltaT, BoneNames);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set task: %s .."), *FString(__FUNCTION__), __LINE__, *InTaskId);
+		return TArray<TPair<FTransform, TMap<int32, FTransform>>>();
+	}
+}
+
+// Get skeletal individual trajectory of the given bone names with episode init
+TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT, const TArray<FName>& BoneNames)
+{
+	if (SetEpisode(InEpisodeId))
+	{
+		return GetSkeletalIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT, BoneNames);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set episode: %s .."), *FString(__FUNCTION__), __LINE__, *InEpisodeId);
+		return TArray<TPair<FTransform, TMap<int32, FTransform>>>();
+	}
+}
+
+// Get skeletal individual trajectory of the given bone names
+TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT, const TArray<FName>& BoneNames) const
+{
+	const TArray<int32> BoneIndexes = GetBoneIndexes(IndividualId, BoneNames);
+	if (BoneIndexes.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d None of the bone names could be resolved for %s .."), *FString(__FUNCTION__), __LINE__, *IndividualId);
+		return TArray<TPair<FTransform, TMap<int32, FTransform>>>();
+	}
+	return DBHandler->GetSkeletalIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT, BoneIndexes);
 }
 
 // Get the episode data with task and episode init
-TArray<TPair<float, TMap<FString, FTransform>>> ASLMongoQueryManager::GetEpisodeData(const FString& InTaskId, const FString& InEpisodeId)
+FSLMongoEpisodeData ASLMongoQueryManager::GetEpisodeData(const FString& InTaskId, const FString& InEpisodeId, int32 NumPartitions)
 {
 	if (SetTask(InTaskId))
 	{
-		return GetEpisodeData(InEpisodeId);
+		return GetEpisodeData(InEpisodeId, NumPartitions);
 	}
 	else
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set task: %s .."), *FString(__FUNCTION__), __LINE__, *InTaskId);
-		return TArray<TPair<float, TMap<FString, FTransform>>>();
+		return FSLMongoEpisodeData();
 	}
 }
 
 // Get the episode data with episode init
-TArray<TPair<float, TMap<FString, FTransform>>> ASLMongoQueryManager::GetEpisodeData(const FString& InEpisodeId)
+FSLMongoEpisodeData ASLMongoQueryManager::GetEpisodeData(const FString& InEpisodeId, int32 NumPartitions)
 {
 	if (SetEpisode(InEpisodeId))
 	{
-		return GetEpisodeData();
+		return GetEpisodeData(NumPartitions);
 	}
 	else
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set episode: %s .."), *FString(__FUNCTION__), __LINE__, *InEpisodeId);
-		return TArray<TPair<float, TMap<FString, FTransform>>>();
+		return FSLMongoEpisodeData();
 	}
 }
 
 // Get the episode data
-TArray<TPair<float, TMap<FString, FTransform>>> ASLMongoQueryManager::GetEpisodeData() const
+FSLMongoEpisodeData ASLMongoQueryManager::GetEpisodeData(int32 NumPartitions) const
+{
+	return DBHandler->GetEpisodeDataParallel(NumPartitions);
+}
+
+// Get the episode document count and time range without changing the active task and episode
+bool ASLMongoQueryManager::GetEpisodeMetadata(const FString& InTaskId, const FString& InEpisodeId, FSLMongoEpisodeMetadata& OutMetadata) const
 {
-	return DBHandler.GetEpisodeData();
+	if (!bConnected)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Connect to server first.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+	return DBHandler->GetEpisodeMetadataPooled(InTaskId, InEpisodeId, OutMetadata);
+}
+
+// Get the database handler for the pooled queries of the background fetches (nullptr if not connected)
+TSharedPtr<const FSLMongoQueryDBHandler, ESPMode::ThreadSafe> ASLMongoQueryManager::GetSharedDBHandler() const
+{
+	if (!bConnected)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Connect to server first.."), *FString(__FUNCTION__), __LINE__);
+		return nullptr;
+	}
+	return DBHandler;
+}
+
+// Build the spatial index with task and episode init
+bool ASLMongoQueryManager::BuildSpatialIndex(const FString& InTaskId, const FString& InEpisodeId, float CellSize, float SegmentDuration)
+{
+	if (SetTask(InTaskId))
+	{
+		return BuildSpatialIndex(InEpisodeId, CellSize, SegmentDuration);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set task: %s .."), *FString(__FUNCTION__), __LINE__, *InTaskId);
+		return false;
+	}
+}
+
+// Build the spatial index with episode init
+bool ASLMongoQueryManager::BuildSpatialIndex(const FString& InEpisodeId, float CellSize, float SegmentDuration)
+{
+	if (SetEpisode(InEpisodeId))
+	{
+		return BuildSpatialIndex(CellSize, SegmentDuration);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set episode: %s .."), *FString(__FUNCTION__), __LINE__, *InEpisodeId);
+		return false;
+	}
+}
+
+// Build the spatial index of the active episode
+bool ASLMongoQueryManager::BuildSpatialIndex(float CellSize, float SegmentDuration)
+{
+	if (!bEpisodeSet)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Set task and episode first.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	const FString Key = TaskId + TEXT(".") + EpisodeId;
+	SpatialIndexes.Remove(Key);
+	TSharedPtr<FSLMongoSpatialIndex> SpatialIndex = MakeShared<FSLMongoSpatialIndex>();
+
+	// The locations are downloaded once per episode (rotations are projected out server side), the exact
+	// co-temporal queries need the recorded location runs, a server side cell aggregation would only give
+	// cell granular results and lose the individuals which hold their location across segments
+	if (!SpatialIndex->Build(DBHandler->GetEpisodeDataParallel(0, true), CellSize, SegmentDuration))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not build the spatial index of %s .."), *FString(__FUNCTION__), __LINE__, *Key);
+		return false;
+	}
+	SpatialIndexes.Add(Key, SpatialIndex);
+	return true;
+}
+
+// Get the individuals in the region with task and episode init
+TArray<FString> ASLMongoQueryManager::GetIndividualsInRegion(const FString& InTaskId, const FString& InEpisodeId, const FBox& Region, float StartTs, float EndTs)
+{
+	if (SetTask(InTaskId))
+	{
+		return GetIndividualsInRegion(InEpisodeId, Region, StartTs, EndTs);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set task: %s .."), *FString(__FUNCTION__), __LINE__, *InTaskId);
+		return TArray<FString>();
+	}
+}
+
+// Get the individuals in the region with episode init
+TArray<FString> ASLMongoQueryManager::GetIndividualsInRegion(const FString& InEpisodeId, const FBox& Region, float StartTs, float EndTs)
+{
+	if (SetEpisode(InEpisodeId))
+	{
+		return GetIndividualsInRegion(Region, StartTs, EndTs);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set episode: %s .."), *FString(__FUNCTION__), __LINE__, *InEpisodeId);
+		return TArray<FString>();
+	}
+}
+
+// Get the individuals in the region
+TArray<FString> ASLMongoQueryManager::GetIndividualsInRegion(const FBox& Region, float StartTs, float EndTs)
+{
+	if (FSLMongoSpatialIndex* SpatialIndex = GetSpatialIndex())
+	{
+		return SpatialIndex->GetIndividualsInRegion(Region, StartTs, EndTs);
+	}
+	return TArray<FString>();
+}
+
+// Get the individuals near the individual with task and episode init
+TMap<FString, float> ASLMongoQueryManager::GetIndividualsNear(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Radius, float StartTs, float EndTs)
+{
+	if (SetTask(InTaskId))
+	{
+		return GetIndividualsNear(InEpisodeId, IndividualId, Radius, StartTs, EndTs);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set task: %s .."), *FString(__FUNCTION__), __LINE__, *InTaskId);
+		return TMap<FString, float>();
+	}
+}
+
+// Get the individuals near the individual with episode init
+TMap<FString, float> ASLMongoQueryManager::GetIndividualsNear(const FString& InEpisodeId, const FString& IndividualId, float Radius, float StartTs, float EndTs)
+{
+	if (SetEpisode(InEpisodeId))
+	{
+		return GetIndividualsNear(IndividualId, Radius, StartTs, EndTs);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set episode: %s .."), *FString(__FUNCTION__), __LINE__, *InEpisodeId);
+		return TMap<FString, float>();
+	}
+}
+
+// Get the individuals near the individual
+TMap<FString, float> ASLMongoQueryManager::GetIndividualsNear(const FString& IndividualId, float Radius, float StartTs, float EndTs)
+{
+	if (FSLMongoSpatialIndex* SpatialIndex = GetSpatialIndex())
+	{
+		return SpatialIndex->GetIndividualsNear(IndividualId, Radius, StartTs, EndTs);
+	}
+	return TMap<FString, float>();
 }
 
 // Spawn or get manager from the world
@@ -412,3 +678,69 @@ ASLMongoQueryManager* ASLMongoQueryManager::GetExistingOrSpawnNew(UWorld* World)
 #endif // WITH_EDITOR
 	return Manager;
 }
+
+// Get the bone indexes of the skeletal individual from the bone names (uses the individual manager from the world)
+TArray<int32> ASLMongoQueryManager::GetBoneIndexes(const FString& IndividualId, const TArray<FName>& BoneNames) const
+{
+	TArray<int32> BoneIndexes;
+	for (TActorIterator<ASLIndividualManager> Iter(GetWorld()); Iter; ++Iter)
+	{
+		if ((*Iter)->IsValidLowLevel() && !(*Iter)->IsPendingKillOrUnreachable() && (*Iter)->IsLoaded())
+		{
+			if (auto SkI = Cast<USLSkeletalIndividual>((*Iter)->GetIndividual(IndividualId)))
+			{
+				if (USkeletalMeshComponent* SkMC = SkI->GetSkeletalMeshComponent())
+				{
+					for (const auto& BoneName : BoneNames)
+					{
+						const int32 BoneIndex = SkMC->GetBoneIndex(BoneName);
+						if (BoneIndex != INDEX_NONE)
+						{
+							BoneIndexes.Add(BoneIndex);
+						}
+						else
+						{
+							UE_LOG(LogTemp, Warning, TEXT("%s::%d Bone %s not found in %s .."),
+								*FString(__FUNCTION__), __LINE__, *BoneName.ToString(), *IndividualId);
+						}
+					}
+				}
+			}
+			break;
+		}
+	}
+	return BoneIndexes;
+}
+
+// Destroy the disconnected handlers which are no longer used by any background fetch (game thread)
+void ASLMongoQueryManager::ReleaseRetiredDBHandlers()
+{
+	// A retired handler is not handed out anymore, once unique no fetch can take it back
+	RetiredDBHandlers.RemoveAll([](const TSharedPtr<FSLMongoQueryDBHandler, ESPMode::ThreadSafe>& Handler)
+	{
+		return Handler.IsUnique();
+	});
+	if (RetiredDBHandlers.Num() == 0)
+	{
+		SetActorTickEnabled(false);
+	}
+}
+
+// Get the spatial index of the active episode, build it if missing (nullptr on failure)
+FSLMongoSpatialIndex* ASLMongoQueryManager::GetSpatialIndex()
+{
+	if (!bEpisodeSet)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Set task and episode first.."), *FString(__FUNCTION__), __LINE__);
+		return nullptr;
+	}
+	if (TSharedPtr<FSLMongoSpatialIndex>* SpatialIndexPtr = SpatialIndexes.Find(TaskId + TEXT(".") + EpisodeId))
+	{
+		return SpatialIndexPtr->Get();
+	}
+	if (BuildSpatialIndex())
+	{
+		return SpatialIndexes.FindChecked(TaskId + TEXT(".") + EpisodeId).Get();
+	}
+	return nullptr;
+}
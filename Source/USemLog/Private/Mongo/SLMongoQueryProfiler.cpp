@@ -0,0 +1,213 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Mongo/SLMongoQueryProfiler.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+// Upper bounds (in milliseconds) of the latency histogram buckets
+const float FSLMongoQueryStats::BucketBoundsMs[FSLMongoQueryStats::NumBuckets - 1] =
+	{ 1.f, 2.f, 5.f, 10.f, 25.f, 50.f, 100.f, 250.f, 500.f, 1000.f, 5000.f };
+
+// Add the duration to the histogram and the latency values
+void FSLMongoQueryStats::AddDuration(double Duration)
+{
+	Count++;
+	TotalDuration += Duration;
+	MinDuration = FMath::Min(MinDuration, Duration);
+	MaxDuration = FMath::Max(MaxDuration, Duration);
+
+	const float DurationMs = Duration * 1000.f;
+	int32 BucketIdx = 0;
+	while (BucketIdx < NumBuckets - 1 && DurationMs >= BucketBoundsMs[BucketIdx])
+	{
+		BucketIdx++;
+	}
+	Histogram[BucketIdx]++;
+}
+
+// Ctor
+FSLMongoQueryProfiler::FSLMongoQueryProfiler()
+{
+	bEnabled = false;
+	bCaptureExplain = false;
+	SlowQueryThreshold = 0.5f;
+	MaxNumSlowQueries = 32;
+	SessionName = TEXT("Default");
+	SessionStart = FDateTime::Now();
+}
+
+// Enable/disable profiling
+void FSLMongoQueryProfiler::SetEnabled(bool bEnable, float InSlowQueryThreshold, bool bInCaptureExplain)
+{
+	FScopeLock Lock(&CriticalSection);
+	bEnabled = bEnable;
+	SlowQueryThreshold = InSlowQueryThreshold;
+	bCaptureExplain = bInCaptureExplain;
+}
+
+// Check if profiling is enabled
+bool FSLMongoQueryProfiler::IsEnabled() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return bEnabled;
+}
+
+// Check if the query duration qualifies it for an explain capture
+bool FSLMongoQueryProfiler::ShouldExplain(double Duration) const
+{
+	FScopeLock Lock(&CriticalSection);
+	return bEnabled && bCaptureExplain && Duration > SlowQueryThreshold;
+}
+
+// Record a query
+void FSLMongoQueryProfiler::Record(const FString& Type, double Duration, int32 NumReturned)
+{
+	FScopeLock Lock(&CriticalSection);
+	if (!bEnabled)
+	{
+		return;
+	}
+	FSLMongoQueryStats& TypeStats = Stats.FindOrAdd(Type);
+	TypeStats.AddDuration(Duration);
+	TypeStats.NumReturned += NumReturned;
+}
+
+// Record the explain output of a slow query
+void FSLMongoQueryProfiler::RecordExplain(const FSLMongoSlowQuery& SlowQuery)
+{
+	FScopeLock Lock(&CriticalSection);
+	if (!bEnabled)
+	{
+		return;
+	}
+	FSLMongoQueryStats& TypeStats = Stats.FindOrAdd(SlowQuery.Type);
+	TypeStats.NumExplained++;
+	if (SlowQuery.bExecutionStats)
+	{
+		// Examined and returned are counted on the same queries
+		TypeStats.NumExplainedWithStats++;
+		TypeStats.NumExamined += SlowQuery.NumExamined;
+		TypeStats.NumExaminedReturned += SlowQuery.NumReturned;
+	}
+	if (SlowQuery.bIndexScan)
+	{
+		TypeStats.NumIndexScans++;
+	}
+	if (SlowQuery.bCollectionScan)
+	{
+		TypeStats.NumCollectionScans++;
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s query (%f seconds) used a collection scan, check the collection indexes.."),
+			*FString(__FUNCTION__), __LINE__, *SlowQuery.Type, SlowQuery.Duration);
+	}
+
+	// Keep only the slowest queries
+	if (SlowQueries.Num() < MaxNumSlowQueries)
+	{
+		SlowQueries.Add(SlowQuery);
+	}
+	else
+	{
+		int32 FastestIdx = 0;
+		for (int32 Idx = 1; Idx < SlowQueries.Num(); ++Idx)
+		{
+			if (SlowQueries[Idx].Duration < SlowQueries[FastestIdx].Duration)
+			{
+				FastestIdx = Idx;
+			}
+		}
+		if (SlowQueries[FastestIdx].Duration < SlowQuery.Duration)
+		{
+			SlowQueries[FastestIdx] = SlowQuery;
+		}
+	}
+}
+
+// Start a new session (clears all the data)
+void FSLMongoQueryProfiler::StartSession(const FString& InSessionName)
+{
+	FScopeLock Lock(&CriticalSection);
+	SessionName = InSessionName;
+	SessionStart = FDateTime::Now();
+	Stats.Empty();
+	SlowQueries.Empty();
+}
+
+// Get the session summary as json
+FString FSLMongoQueryProfiler::GetSummaryAsJson() const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FString Json = FString::Printf(TEXT("{\n\t\"session\": \"%s\",\n\t\"start\": \"%s\",\n\t\"duration\": %f,\n\t\"queries\": {\n"),
+		*SessionName, *SessionStart.ToIso8601(), (FDateTime::Now() - SessionStart).GetTotalSeconds());
+
+	// Histogram bounds are shared by all query types
+	FString BoundsStr;
+	for (int32 Idx = 0; Idx < FSLMongoQueryStats::NumBuckets - 1; ++Idx)
+	{
+		BoundsStr.Append(FString::Printf(TEXT("%s%g"), Idx > 0 ? TEXT(", ") : TEXT(""), FSLMongoQueryStats::BucketBoundsMs[Idx]));
+	}
+
+	int32 TypeIdx = 0;
+	for (const auto& TypeStatsPair : Stats)
+	{
+		const FSLMongoQueryStats& TypeStats = TypeStatsPair.Value;
+		FString HistogramStr;
+		for (int32 Idx = 0; Idx < FSLMongoQueryStats::NumBuckets; ++Idx)
+		{
+			HistogramStr.Append(FString::Printf(TEXT("%s%d"), Idx > 0 ? TEXT(", ") : TEXT(""), TypeStats.Histogram[Idx]));
+		}
+
+		Json.Append(FString::Printf(TEXT("\t\t\"%s\": {\n"), *TypeStatsPair.Key));
+		Json.Append(FString::Printf(TEXT("\t\t\t\"count\": %d,\n\t\t\t\"total\": %f,\n\t\t\t\"avg\": %f,\n\t\t\t\"min\": %f,\n\t\t\t\"max\": %f,\n"),
+			TypeStats.Count, TypeStats.TotalDuration, TypeStats.GetAvgDuration(),
+			TypeStats.Count > 0 ? TypeStats.MinDuration : 0.0, TypeStats.MaxDuration));
+		Json.Append(FString::Printf(TEXT("\t\t\t\"returned\": %lld,\n\t\t\t\"examined\": %lld,\n\t\t\t\"examined_returned\": %lld,\n\t\t\t\"explained\": %d,\n\t\t\t\"explained_with_stats\": %d,\n\t\t\t\"index_scans\": %d,\n\t\t\t\"collection_scans\": %d,\n"),
+			TypeStats.NumReturned, TypeStats.NumExamined, TypeStats.NumExaminedReturned, TypeStats.NumExplained,
+			TypeStats.NumExplainedWithStats, TypeStats.NumIndexScans, TypeStats.NumCollectionScans));
+		Json.Append(FString::Printf(TEXT("\t\t\t\"histogram_bounds_ms\": [%s],\n\t\t\t\"histogram\": [%s]\n"), *BoundsStr, *HistogramStr));
+		Json.Append(FString::Printf(TEXT("\t\t}%s\n"), ++TypeIdx < Stats.Num() ? TEXT(",") : TEXT("")));
+	}
+	Json.Append(TEXT("\t},\n\t\"slow_queries\": [\n"));
+
+	for (int32 Idx = 0; Idx < SlowQueries.Num(); ++Idx)
+	{
+		const FSLMongoSlowQuery& SQ = SlowQueries[Idx];
+		Json.Append(FString::Printf(TEXT("\t\t{\n\t\t\t\"type\": \"%s\",\n\t\t\t\"duration\": %f,\n\t\t\t\"examined\": %lld,\n\t\t\t\"returned\": %lld,\n\t\t\t\"execution_stats\": %s,\n\t\t\t\"index_scan\": %s,\n\t\t\t\"collection_scan\": %s,\n\t\t\t\"explain\": %s\n\t\t}%s\n"),
+			*SQ.Type, SQ.Duration, SQ.NumExamined, SQ.NumReturned, SQ.bExecutionStats ? TEXT("true") : TEXT("false"),
+			SQ.bIndexScan ? TEXT("true") : TEXT("false"), SQ.bCollectionScan ? TEXT("true") : TEXT("false"),
+			SQ.Explain.IsEmpty() ? TEXT("null") : *SQ.Explain,
+			Idx < SlowQueries.Num() - 1 ? TEXT(",") : TEXT("")));
+	}
+	Json.Append(TEXT("\t]\n}\n"));
+	return Json;
+}
+
+// Log the session summary
+void FSLMongoQueryProfiler::LogSummary() const
+{
+	FScopeLock Lock(&CriticalSection);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Query profile of session %s:"), *FString(__FUNCTION__), __LINE__, *SessionName);
+	for (const auto& TypeStatsPair : Stats)
+	{
+		const FSLMongoQueryStats& TypeStats = TypeStatsPair.Value;
+		UE_LOG(LogTemp, Log, TEXT("\t %s: count=%d; total=%f; avg=%f; max=%f; returned=%lld; examined/returned=%lld/%lld(explained=%d/%d); ixscan=%d; collscan=%d;"),
+			*TypeStatsPair.Key, TypeStats.Count, TypeStats.TotalDuration, TypeStats.GetAvgDuration(), TypeStats.MaxDuration,
+			TypeStats.NumReturned, TypeStats.NumExamined, TypeStats.NumExaminedReturned, TypeStats.NumExplainedWithStats,
+			TypeStats.NumExplained, TypeStats.NumIndexScans, TypeStats.NumCollectionScans);
+	}
+}
+
+// Write the session summary to file (returns the path, or empty on error)
+FString FSLMongoQueryProfiler::WriteSummaryToFile(const FString& DirPath) const
+{
+	const FString FullPath = FPaths::Combine(DirPath,
+		SessionName + TEXT("_") + SessionStart.ToString(TEXT("%Y%m%d_%H%M%S")) + TEXT(".json"));
+	if (FFileHelper::SaveStringToFile(GetSummaryAsJson(), *FullPath))
+	{
+		return FullPath;
+	}
+	UE_LOG(LogTemp, Error, TEXT("%s::%d Could not write the query profile to %s.."), *FString(__FUNCTION__), __LINE__, *FullPath);
+	return FString();
+}
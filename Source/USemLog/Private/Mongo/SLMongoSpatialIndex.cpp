@@ -0,0 +1,389 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Mongo/SLMongoSpatialIndex.h"
+#include "Mongo/SLMongoEpisodeData.h"
+#include "Algo/BinarySearch.h"
+
+// Ctor
+FSLMongoSpatialIndex::FSLMongoSpatialIndex()
+{
+	bIsBuilt = false;
+	CellSize = 50.f;
+	SegmentDuration = 10.f;
+}
+
+// Build the index from the episode data (CellSize in cm, SegmentDuration in seconds)
+bool FSLMongoSpatialIndex::Build(const FSLMongoEpisodeData& InEpisodeData, float InCellSize, float InSegmentDuration)
+{
+	Clear();
+
+	if (InEpisodeData.IsEmpty())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Episode data is empty, cannot build the spatial index.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	if (InCellSize <= 0.f || InSegmentDuration <= 0.f)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Invalid cell size (%f) or segment duration (%f).."),
+			*FString(__FUNCTION__), __LINE__, InCellSize, InSegmentDuration);
+		return false;
+	}
+
+	const double BuildStartTime = FPlatformTime::Seconds();
+	CellSize = InCellSize;
+	SegmentDuration = InSegmentDuration;
+	IndividualIds = InEpisodeData.IndividualIds;
+	IdToIndex = InEpisodeData.IdToIndex;
+	Timestamps = InEpisodeData.Timestamps;
+
+	// Split the frames into time segments
+	const int32 NumFrames = Timestamps.Num();
+	int32 SegmentFirstFrame = 0;
+	for (int32 FrameIdx = 1; FrameIdx <= NumFrames; ++FrameIdx)
+	{
+		if (FrameIdx == NumFrames || Timestamps[FrameIdx] - Timestamps[SegmentFirstFrame] >= SegmentDuration)
+		{
+			FSLMongoSpatialSegment& Segment = Segments.AddDefaulted_GetRef();
+			Segment.FirstFrame = SegmentFirstFrame;
+			Segment.LastFrame = FrameIdx - 1;
+			SegmentFirstFrame = FrameIdx;
+		}
+	}
+
+	// Every recorded location holds until the next recorded one, split it at the segment borders,
+	// this way the individuals which did not move in a segment are still indexed in it
+	for (int32 IndIdx = 0; IndIdx < InEpisodeData.NumIndividuals(); ++IndIdx)
+	{
+		const TArray<int32>& Frames = InEpisodeData.FrameIndexes[IndIdx];
+		const TArray<FTransform>& Poses = InEpisodeData.Poses[IndIdx];
+		if (Frames.Num() == 0)
+		{
+			continue;
+		}
+		int32 CurrFirstFrame = Frames[0];
+		FVector CurrLocation = Poses[0].GetLocation();
+
+		int32 SegmentIdx = 0;
+		while (Segments[SegmentIdx].LastFrame < CurrFirstFrame)
+		{
+			SegmentIdx++;
+		}
+
+		// Only the recorded samples are visited, the location holds until the next different one (or the end of the data)
+		for (int32 SampleIdx = 1; SampleIdx <= Frames.Num(); ++SampleIdx)
+		{
+			const bool bEndOfData = SampleIdx == Frames.Num();
+			if (!bEndOfData && Poses[SampleIdx].GetLocation().Equals(CurrLocation, KINDA_SMALL_NUMBER))
+			{
+				continue;
+			}
+			const int32 NextFrame = bEndOfData ? NumFrames : Frames[SampleIdx];
+
+			// Close the segments which end before the next location
+			while (Segments[SegmentIdx].LastFrame < NextFrame - 1)
+			{
+				AddSample(Segments[SegmentIdx], FSLMongoSpatialSample(IndIdx, CurrFirstFrame, Segments[SegmentIdx].LastFrame, CurrLocation));
+				CurrFirstFrame = Segments[SegmentIdx].LastFrame + 1;
+				SegmentIdx++;
+			}
+			AddSample(Segments[SegmentIdx], FSLMongoSpatialSample(IndIdx, CurrFirstFrame, NextFrame - 1, CurrLocation));
+			CurrFirstFrame = NextFrame;
+
+			if (!bEndOfData)
+			{
+				CurrLocation = Poses[SampleIdx].GetLocation();
+				if (Segments[SegmentIdx].LastFrame < NextFrame)
+				{
+					SegmentIdx++;
+				}
+			}
+		}
+	}
+
+	bIsBuilt = true;
+
+	int32 NumSamples = 0;
+	for (const auto& Segment : Segments)
+	{
+		NumSamples += Segment.Samples.Num();
+	}
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Built spatial index with %d segments, %d samples of %d individuals (%.2f MB) in [%f] seconds.."),
+		*FString(__FUNCTION__), __LINE__, Segments.Num(), NumSamples, IndividualIds.Num(),
+		GetAllocatedSize() / (1024.f * 1024.f), FPlatformTime::Seconds() - BuildStartTime);
+	return true;
+}
+
+// Clear the index
+void FSLMongoSpatialIndex::Clear()
+{
+	bIsBuilt = false;
+	IndividualIds.Empty();
+	IdToIndex.Empty();
+	Timestamps.Empty();
+	Segments.Empty();
+}
+
+// Get the individuals which were inside the region between the given timestamps
+TArray<FString> FSLMongoSpatialIndex::GetIndividualsInRegion(const FBox& Region, float StartTs, float EndTs) const
+{
+	TArray<FString> Ids;
+	int32 FirstFrame;
+	int32 LastFrame;
+	if (!bIsBuilt || !GetFrameRange(StartTs, EndTs, FirstFrame, LastFrame))
+	{
+		return Ids;
+	}
+
+	const FIntVector MinCell = GetCell(Region.Min);
+	const FIntVector MaxCell = GetCell(Region.Max);
+	TSet<int32> Found;
+	for (const auto& Segment : Segments)
+	{
+		if (Segment.LastFrame < FirstFrame || Segment.FirstFrame > LastFrame)
+		{
+			continue;
+		}
+		ForEachCellInBox(Segment, MinCell, MaxCell, [&](const TArray<int32>& SampleIndexes)
+		{
+			for (const int32 SampleIdx : SampleIndexes)
+			{
+				const FSLMongoSpatialSample& Sample = Segment.Samples[SampleIdx];
+				if (!Found.Contains(Sample.IndividualIndex)
+					&& Sample.OverlapsFrames(FirstFrame, LastFrame)
+					&& Region.IsInsideOrOn(Sample.Location))
+				{
+					Found.Add(Sample.IndividualIndex);
+				}
+			}
+		});
+	}
+
+	for (const int32 IndIdx : Found)
+	{
+		Ids.Add(IndividualIds[IndIdx]);
+	}
+	return Ids;
+}
+
+// Get the individuals which were within the radius of the given individual between the timestamps (with their min distance)
+TMap<FString, float> FSLMongoSpatialIndex::GetIndividualsNear(const FString& Id, float Radius, float StartTs, float EndTs) const
+{
+	TMap<FString, float> Results;
+	int32 FirstFrame;
+	int32 LastFrame;
+	if (!bIsBuilt || !GetFrameRange(StartTs, EndTs, FirstFrame, LastFrame))
+	{
+		return Results;
+	}
+
+	const int32* IndexPtr = IdToIndex.Find(Id);
+	if (!IndexPtr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Individual %s is not in the spatial index.."), *FString(__FUNCTION__), __LINE__, *Id);
+		return Results;
+	}
+
+	// The individuals have to be near at the same time, so every location of the
+	// reference individual is only compared against the samples holding in the same frames
+	TMap<int32, float> MinDistances;
+	for (const auto& Segment : Segments)
+	{
+		if (Segment.LastFrame < FirstFrame || Segment.FirstFrame > LastFrame)
+		{
+			continue;
+		}
+		if (const TArray<int32>* RefSampleIndexes = Segment.IndividualSamples.Find(*IndexPtr))
+		{
+			for (const int32 RefSampleIdx : *RefSampleIndexes)
+			{
+				const FSLMongoSpatialSample& RefSample = Segment.Samples[RefSampleIdx];
+				if (RefSample.OverlapsFrames(FirstFrame, LastFrame))
+				{
+					CollectNear(Segment, RefSample.Location, Radius,
+						FMath::Max(FirstFrame, RefSample.FirstFrame), FMath::Min(LastFrame, RefSample.LastFrame), MinDistances);
+				}
+			}
+		}
+	}
+
+	MinDistances.Remove(*IndexPtr);
+	for (const auto& Pair : MinDistances)
+	{
+		Results.Add(IndividualIds[Pair.Key], Pair.Value);
+	}
+	return Results;
+}
+
+// Get the individuals which were within the radius of the given location between the timestamps (with their min distance)
+TMap<FString, float> FSLMongoSpatialIndex::GetIndividualsNear(const FVector& Location, float Radius, float StartTs, float EndTs) const
+{
+	TMap<FString, float> Results;
+	int32 FirstFrame;
+	int32 LastFrame;
+	if (!bIsBuilt || !GetFrameRange(StartTs, EndTs, FirstFrame, LastFrame))
+	{
+		return Results;
+	}
+
+	TMap<int32, float> MinDistances;
+	for (const auto& Segment : Segments)
+	{
+		if (Segment.LastFrame >= FirstFrame && Segment.FirstFrame <= LastFrame)
+		{
+			CollectNear(Segment, Location, Radius, FirstFrame, LastFrame, MinDistances);
+		}
+	}
+
+	for (const auto& Pair : MinDistances)
+	{
+		Results.Add(IndividualIds[Pair.Key], Pair.Value);
+	}
+	return Results;
+}
+
+// Approximate memory footprint in bytes
+SIZE_T FSLMongoSpatialIndex::GetAllocatedSize() const
+{
+	SIZE_T Size = IndividualIds.GetAllocatedSize() + IdToIndex.GetAllocatedSize()
+		+ Timestamps.GetAllocatedSize() + Segments.GetAllocatedSize();
+	for (const auto& Id : IndividualIds)
+	{
+		Size += Id.GetAllocatedSize();
+	}
+	for (const auto& Segment : Segments)
+	{
+		Size += Segment.Samples.GetAllocatedSize() + Segment.Cells.GetAllocatedSize() + Segment.IndividualSamples.GetAllocatedSize();
+		for (const auto& Pair : Segment.Cells)
+		{
+			Size += Pair.Value.GetAllocatedSize();
+		}
+		for (const auto& Pair : Segment.IndividualSamples)
+		{
+			Size += Pair.Value.GetAllocatedSize();
+		}
+	}
+	return Size;
+}
+
+// Add the sample to the segment
+void FSLMongoSpatialIndex::AddSample(FSLMongoSpatialSegment& Segment, const FSLMongoSpatialSample& Sample) const
+{
+	const int32 SampleIdx = Segment.Samples.Add(Sample);
+	const FIntVector Cell = GetCell(Sample.Location);
+	Segment.Cells.FindOrAdd(Cell).Add(SampleIdx);
+	Segment.MinCell = FIntVector(FMath::Min(Segment.MinCell.X, Cell.X), FMath::Min(Segment.MinCell.Y, Cell.Y), FMath::Min(Segment.MinCell.Z, Cell.Z));
+	Segment.MaxCell = FIntVector(FMath::Max(Segment.MaxCell.X, Cell.X), FMath::Max(Segment.MaxCell.Y, Cell.Y), FMath::Max(Segment.MaxCell.Z, Cell.Z));
+	Segment.IndividualSamples.FindOrAdd(Sample.IndividualIndex).Add(SampleIdx);
+}
+
+// Get the grid cell of the location
+FIntVector FSLMongoSpatialIndex::GetCell(const FVector& Location) const
+{
+	// Far beyond any recorded location, keeps the cell box sizes within int64
+	constexpr float MaxCellCoord = 1.e9f;
+	return FIntVector(
+		FMath::FloorToInt(FMath::Clamp(Location.X / CellSize, -MaxCellCoord, MaxCellCoord)),
+		FMath::FloorToInt(FMath::Clamp(Location.Y / CellSize, -MaxCellCoord, MaxCellCoord)),
+		FMath::FloorToInt(FMath::Clamp(Location.Z / CellSize, -MaxCellCoord, MaxCellCoord)));
+}
+
+// Get the frame range from the timestamps (returns false if the range is outside the episode)
+bool FSLMongoSpatialIndex::GetFrameRange(float StartTs, float EndTs, int32& OutFirstFrame, int32& OutLastFrame) const
+{
+	if (Timestamps.Num() == 0 || StartTs > EndTs || EndTs < Timestamps[0] || StartTs > Timestamps.Last())
+	{
+		return false;
+	}
+
+	// The frame active at the start timestamp (last frame not newer than it)
+	OutFirstFrame = FMath::Max(Algo::UpperBound(Timestamps, StartTs) - 1, 0);
+
+	// The last frame not newer than the end timestamp
+	OutLastFrame = Algo::UpperBound(Timestamps, EndTs) - 1;
+	return OutLastFrame >= OutFirstFrame;
+}
+
+// Collect the samples within the radius of the location in the given frame range (keeps the min distance per individual)
+void FSLMongoSpatialIndex::CollectNear(const FSLMongoSpatialSegment& Segment, const FVector& Location, float Radius,
+	int32 FirstFrame, int32 LastFrame, TMap<int32, float>& OutMinDistances) const
+{
+	const FIntVector MinCell = GetCell(Location - FVector(Radius));
+	const FIntVector MaxCell = GetCell(Location + FVector(Radius));
+	const float RadiusSquared = Radius * Radius;
+	ForEachCellInBox(Segment, MinCell, MaxCell, [&](const TArray<int32>& SampleIndexes)
+	{
+		for (const int32 SampleIdx : SampleIndexes)
+		{
+			const FSLMongoSpatialSample& Sample = Segment.Samples[SampleIdx];
+			if (!Sample.OverlapsFrames(FirstFrame, LastFrame))
+			{
+				continue;
+			}
+			const float DistSquared = FVector::DistSquared(Location, Sample.Location);
+			if (DistSquared <= RadiusSquared)
+			{
+				const float Dist = FMath::Sqrt(DistSquared);
+				float* MinDistPtr = OutMinDistances.Find(Sample.IndividualIndex);
+				if (!MinDistPtr)
+				{
+					OutMinDistances.Add(Sample.IndividualIndex, Dist);
+				}
+				else if (Dist < *MinDistPtr)
+				{
+					*MinDistPtr = Dist;
+				}
+			}
+		}
+	});
+}
+
+// Call the function with the sample indexes of the occupied cells in the cell box (clamped to the occupied bounds,
+// the occupied cells are iterated directly if the box has more cells)
+void FSLMongoSpatialIndex::ForEachCellInBox(const FSLMongoSpatialSegment& Segment, const FIntVector& InMinCell, const FIntVector& InMaxCell,
+	TFunctionRef<void(const TArray<int32>&)> Func) const
+{
+	const FIntVector MinCell(
+		FMath::Max(InMinCell.X, Segment.MinCell.X),
+		FMath::Max(InMinCell.Y, Segment.MinCell.Y),
+		FMath::Max(InMinCell.Z, Segment.MinCell.Z));
+	const FIntVector MaxCell(
+		FMath::Min(InMaxCell.X, Segment.MaxCell.X),
+		FMath::Min(InMaxCell.Y, Segment.MaxCell.Y),
+		FMath::Min(InMaxCell.Z, Segment.MaxCell.Z));
+	if (MinCell.X > MaxCell.X || MinCell.Y > MaxCell.Y || MinCell.Z > MaxCell.Z)
+	{
+		return;
+	}
+
+	const int64 NumBoxCells = (int64(MaxCell.X) - MinCell.X + 1) * (int64(MaxCell.Y) - MinCell.Y + 1) * (int64(MaxCell.Z) - MinCell.Z + 1);
+	if (NumBoxCells > Segment.Cells.Num())
+	{
+		for (const auto& CellPair : Segment.Cells)
+		{
+			const FIntVector& Cell = CellPair.Key;
+			if (Cell.X >= MinCell.X && Cell.X <= MaxCell.X
+				&& Cell.Y >= MinCell.Y && Cell.Y <= MaxCell.Y
+				&& Cell.Z >= MinCell.Z && Cell.Z <= MaxCell.Z)
+			{
+				Func(CellPair.Value);
+			}
+		}
+		return;
+	}
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+			{
+				if (const TArray<int32>* SampleIndexes = Segment.Cells.Find(FIntVector(X, Y, Z)))
+				{
+					Func(*SampleIndexes);
+				}
+			}
+		}
+	}
+}
@@ -562,9 +562,6 @@ bool FSLWorldStateDBHandler::Connect(const FString& DBName, const FString& CollN
 		uint16 ServerPort, bool bOverwrite)
 {
 #if SL_WITH_LIBMONGO_C
-	// Required to initialize libmongoc's internals	
-	mongoc_init();
-
 	// Stores any error that might appear during the connection
 	bson_error_t error;
 
@@ -774,7 +771,6 @@ void FSLWorldStateDBHandler::Disconnect() const
 	{
 		mongoc_collection_destroy(collection);
 	}
-	mongoc_cleanup();
 #endif //SL_WITH_LIBMONGO_C
 }
 
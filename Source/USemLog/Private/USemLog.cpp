@@ -3,6 +3,18 @@
 
 #include "USemLog.h"
 
+#if SL_WITH_LIBMONGO_C
+THIRD_PARTY_INCLUDES_START
+#if PLATFORM_WINDOWS
+	#include "Windows/AllowWindowsPlatformTypes.h"
+	#include <mongoc/mongoc.h>
+	#include "Windows/HideWindowsPlatformTypes.h"
+#else
+	#include <mongoc/mongoc.h>
+#endif // #if PLATFORM_WINDOWS
+THIRD_PARTY_INCLUDES_END
+#endif //SL_WITH_LIBMONGO_C
+
 // Define logging types
 DEFINE_LOG_CATEGORY(LogSL);
 
@@ -11,12 +23,20 @@ DEFINE_LOG_CATEGORY(LogSL);
 void FUSemLog::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+#if SL_WITH_LIBMONGO_C
+	// The libmongoc internals are process wide, they are initialized once for all the db handlers
+	mongoc_init();
+#endif //SL_WITH_LIBMONGO_C
 }
 
 void FUSemLog::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+#if SL_WITH_LIBMONGO_C
+	// Called after the db handlers released their clients
+	mongoc_cleanup();
+#endif //SL_WITH_LIBMONGO_C
 }
 
 #undef LOCTEXT_NAMESPACE
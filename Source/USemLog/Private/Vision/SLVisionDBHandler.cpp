@@ -19,9 +19,6 @@ bool FSLVisionDBHandler::Connect(const FString& DBName, const FString& CollName,
 	const FString VisCollName = CollName + ".vis";
 
 #if SL_WITH_LIBMONGO_C
-	// Required to initialize libmongoc's internals	
-	mongoc_init();
-
 	// Stores any error that might appear during the connection
 	bson_error_t error;
 
@@ -149,7 +146,6 @@ void FSLVisionDBHandler::Disconnect() const
 	{
 		mongoc_collection_destroy(vis_collection);
 	}
-	mongoc_cleanup();
 #endif //SL_WITH_LIBMONGO_C
 }
 
@@ -2,86 +2,219 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #include "Viz/Markers/SLVizSkeletalBoneMeshMarker.h"
-#include "Viz/SLVizAssets.h"
-#include "Components/PoseableMeshComponent.h"
-#include "Components/SkeletalMeshComponent.h"
-#include "Materials/MaterialInstanceDynamic.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/StaticMesh.h"
+#include "Rendering/SkeletalMeshRenderData.h"
+#include "Rendering/SkeletalMeshLODRenderData.h"
+#include "Rendering/SkinWeightVertexBuffer.h"
+#include "MeshDescription.h"
+#include "MeshDescriptionBuilder.h"
+#include "StaticMeshAttributes.h"
 
 // Constructor
 USLVizSkeletalBoneMeshMarker::USLVizSkeletalBoneMeshMarker()
 {
 	PrimaryComponentTick.bCanEverTick = true;
 	PrimaryComponentTick.bStartWithTickEnabled = false;
-
-	PMCRef = nullptr;
 }
 
-// Set the visual properties of the skeletal mesh, visualize only selected material index (use original materials)
-void USLVizSkeletalBoneMeshMarker::SetVisual(USkeletalMesh* SkelMesh, int32 MaterialIndex)
+// Extract the reference pose geometry of the material sections (the triangles mostly skinned to the bone) into a transient static mesh
+// in the bone space, the instances are then placed with the bone world poses (requires CPU access to the mesh data in cooked builds)
+UStaticMesh* USLVizSkeletalBoneMeshMarker::CreateBoneStaticMesh(UObject* Outer, USkeletalMesh* SkelMesh, int32 BoneIndex,
+	const TArray<int32>& MaterialIndexes)
 {
-	// Create the poseable mesh reference and the dynamic material
-	SetPoseableMeshComponentVisual(SkelMesh);
+	if (!SkelMesh || MaterialIndexes.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d No skeletal mesh or material indexes given.."), *FString(__FUNCTION__), __LINE__);
+		return nullptr;
+	}
 
-	// Hide unwanted material slots
-	for (int32 MatIdx = 0; MatIdx < PMCRef->GetNumMaterials(); ++MatIdx)
+#if ENGINE_MINOR_VERSION > 26 || ENGINE_MAJOR_VERSION > 4
+	const FReferenceSkeleton& RefSkeleton = SkelMesh->GetRefSkeleton();
+	const TArray<FSkeletalMaterial>& SkelMaterials = SkelMesh->GetMaterials();
+#else
+	const FReferenceSkeleton& RefSkeleton = SkelMesh->RefSkeleton;
+	const TArray<FSkeletalMaterial>& SkelMaterials = SkelMesh->Materials;
+#endif
+	if (BoneIndex < 0 || BoneIndex >= RefSkeleton.GetNum())
 	{
-		if (MatIdx != MaterialIndex)
-		{
-			PMCRef->SetMaterial(MatIdx, VizAssetsContainer->MaterialInvisible);
-		}
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s invalid bone index %d.."), *FString(__FUNCTION__), __LINE__, *SkelMesh->GetName(), BoneIndex);
+		return nullptr;
 	}
-}
 
-// Set the visual properties of the skeletal mesh, visualize only selected material index
-void USLVizSkeletalBoneMeshMarker::SetVisual(USkeletalMesh* SkelMesh, int32 MaterialIndex,
-	const FLinearColor& InColor, ESLVizMaterialType InMaterialType)
-{
-	// Create the poseable mesh reference and the dynamic material
-	SetPoseableMeshComponentVisual(SkelMesh);
+	FSkeletalMeshRenderData* RenderData = SkelMesh->GetResourceForRendering();
+	if (!RenderData || RenderData->LODRenderData.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s has no render data.."), *FString(__FUNCTION__), __LINE__, *SkelMesh->GetName());
+		return nullptr;
+	}
+	const FSkeletalMeshLODRenderData& LODData = RenderData->LODRenderData[0];
+	const FRawStaticIndexBuffer16or32Interface* IndexBuffer = LODData.MultiSizeIndexContainer.GetIndexBuffer();
+	const FPositionVertexBuffer& PositionBuffer = LODData.StaticVertexBuffers.PositionVertexBuffer;
+	const FStaticMeshVertexBuffer& VertexBuffer = LODData.StaticVertexBuffers.StaticMeshVertexBuffer;
+	if (!IndexBuffer || IndexBuffer->Num() == 0 || PositionBuffer.GetNumVertices() == 0 || VertexBuffer.GetNumVertices() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s mesh data is not accessible on the CPU (allow CPU access in the LOD settings).."),
+			*FString(__FUNCTION__), __LINE__, *SkelMesh->GetName());
+		return nullptr;
+	}
 
-	// Set the dynamic material
-	SetDynamicMaterial(InMaterialType);
-	SetDynamicMaterialColor(InColor);
+	// Reference pose of the bone in component space (the space of the vertex buffers)
+	FTransform BoneRefPose = FTransform::Identity;
+	for (int32 Idx = BoneIndex; Idx != INDEX_NONE; Idx = RefSkeleton.GetParentIndex(Idx))
+	{
+		BoneRefPose = BoneRefPose * RefSkeleton.GetRefBonePose()[Idx];
+	}
 
-	// Apply dynamic material value
-	for (int32 MatIdx = 0; MatIdx < PMCRef->GetNumMaterials(); ++MatIdx)
+	// Triangles (first index) of every material index, only the ones mostly skinned to the bone are kept,
+	// sections shared by several bones would otherwise add the geometry of the other bones as well
+	const FSkinWeightVertexBuffer* SkinWeights = LODData.GetSkinWeightVertexBuffer();
+	const bool bHasSkinWeights = SkinWeights && SkinWeights->GetNumVertices() > 0;
+	if (!bHasSkinWeights)
 	{
-		MatIdx != MaterialIndex ? PMCRef->SetMaterial(MatIdx, VizAssetsContainer->MaterialInvisible)
-			: PMCRef->SetMaterial(MatIdx, DynamicMaterial);
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s skin weights are not accessible on the CPU, whole material sections are used for bone %d.."),
+			*FString(__FUNCTION__), __LINE__, *SkelMesh->GetName(), BoneIndex);
 	}
-}
+	auto GetDominantBone = [SkinWeights](const FSkelMeshRenderSection& Section, uint32 VertIdx)
+	{
+		uint32 MaxWeight = 0;
+		int32 LocalBoneIdx = INDEX_NONE;
+		for (uint32 InfluenceIdx = 0; InfluenceIdx < SkinWeights->GetMaxBoneInfluences(); ++InfluenceIdx)
+		{
+			const uint32 Weight = SkinWeights->GetBoneWeight(VertIdx, InfluenceIdx);
+			if (Weight > MaxWeight)
+			{
+				MaxWeight = Weight;
+				LocalBoneIdx = SkinWeights->GetBoneIndex(VertIdx, InfluenceIdx);
+			}
+		}
+		return Section.BoneMap.IsValidIndex(LocalBoneIdx) ? int32(Section.BoneMap[LocalBoneIdx]) : INDEX_NONE;
+	};
 
-// Visualize only selected material indexes (use original materials)
-void USLVizSkeletalBoneMeshMarker::SetVisual(USkeletalMesh* SkelMesh, const TArray<int32>& MaterialIndexes)
-{
-	// Create the poseable mesh reference and the dynamic material
-	SetPoseableMeshComponentVisual(SkelMesh);
+	TArray<TArray<uint32>> GroupTriangles;
+	GroupTriangles.SetNum(MaterialIndexes.Num());
+	int32 NumSkinnedTriangles = 0;
+	int32 NumOtherBoneTriangles = 0;
+	for (int32 GroupIdx = 0; GroupIdx < MaterialIndexes.Num(); ++GroupIdx)
+	{
+		for (const FSkelMeshRenderSection& Section : LODData.RenderSections)
+		{
+			if (Section.MaterialIndex != MaterialIndexes[GroupIdx])
+			{
+				continue;
+			}
+			for (uint32 TriIdx = 0; TriIdx < Section.NumTriangles; ++TriIdx)
+			{
+				const uint32 FirstIdx = Section.BaseIndex + TriIdx * 3;
+				int32 NumBoneCorners = 0;
+				for (uint32 CornerIdx = 0; bHasSkinWeights && CornerIdx < 3; ++CornerIdx)
+				{
+					NumBoneCorners += GetDominantBone(Section, IndexBuffer->Get(FirstIdx + CornerIdx)) == BoneIndex ? 1 : 0;
+				}
+				if (bHasSkinWeights && NumBoneCorners < 2)
+				{
+					NumOtherBoneTriangles++;
+					continue;
+				}
+				GroupTriangles[GroupIdx].Add(FirstIdx);
+				NumSkinnedTriangles++;
+			}
+		}
+	}
 
-	// Hide unwanted material slots
-	for (int32 MatIdx = 0; MatIdx < PMCRef->GetNumMaterials(); ++MatIdx)
+	if (NumOtherBoneTriangles > 0)
 	{
-		if (!MaterialIndexes.Contains(MatIdx))
+		if (NumSkinnedTriangles > 0)
 		{
-			PMCRef->SetMaterial(MatIdx, VizAssetsContainer->MaterialInvisible);
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s skipped %d triangles of the material sections of bone %d, they are skinned to other bones.."),
+				*FString(__FUNCTION__), __LINE__, *SkelMesh->GetName(), NumOtherBoneTriangles, BoneIndex);
+		}
+		else
+		{
+			// The material is bound to the bone but the bone does not dominate its vertices (e.g. weighted to the parent)
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s none of the %d triangles of the material sections is mostly skinned to bone %d, using the whole sections.."),
+				*FString(__FUNCTION__), __LINE__, *SkelMesh->GetName(), NumOtherBoneTriangles, BoneIndex);
+			for (int32 GroupIdx = 0; GroupIdx < MaterialIndexes.Num(); ++GroupIdx)
+			{
+				for (const FSkelMeshRenderSection& Section : LODData.RenderSections)
+				{
+					if (Section.MaterialIndex == MaterialIndexes[GroupIdx])
+					{
+						for (uint32 TriIdx = 0; TriIdx < Section.NumTriangles; ++TriIdx)
+						{
+							GroupTriangles[GroupIdx].Add(Section.BaseIndex + TriIdx * 3);
+						}
+					}
+				}
+			}
 		}
 	}
-}
 
-// Visualize only selected material indexes
-void USLVizSkeletalBoneMeshMarker::SetVisual(USkeletalMesh* SkelMesh, const TArray<int32>& MaterialIndexes,
-	const FLinearColor& InColor, ESLVizMaterialType InMaterialType)
-{
-	// Create the poseable mesh reference and the dynamic material
-	SetPoseableMeshComponentVisual(SkelMesh);
+	FMeshDescription MeshDescription;
+	FStaticMeshAttributes Attributes(MeshDescription);
+	Attributes.Register();
+	TPolygonGroupAttributesRef<FName> SlotNames = Attributes.GetPolygonGroupMaterialSlotNames();
+
+	FMeshDescriptionBuilder Builder;
+	Builder.SetMeshDescription(&MeshDescription);
+	Builder.EnablePolyGroups();
+	Builder.SetNumUVLayers(1);
 
-	// Set the dynamic material
-	SetDynamicMaterial(InMaterialType);
-	SetDynamicMaterialColor(InColor);
+	UStaticMesh* StaticMesh = NewObject<UStaticMesh>(Outer, NAME_None, RF_Transient);
+#if ENGINE_MINOR_VERSION > 26 || ENGINE_MAJOR_VERSION > 4
+	TArray<FStaticMaterial>& StaticMaterials = StaticMesh->GetStaticMaterials();
+#else
+	TArray<FStaticMaterial>& StaticMaterials = StaticMesh->StaticMaterials;
+#endif
 
-	// Apply dynamic material value
-	for (int32 MatIdx = 0; MatIdx < PMCRef->GetNumMaterials(); ++MatIdx)
+	// Every material index is a polygon group, the vertices shared by its triangles are added once
+	int32 NumTriangles = 0;
+	TMap<uint32, FVertexID> VertexIds;
+	for (int32 GroupIdx = 0; GroupIdx < MaterialIndexes.Num(); ++GroupIdx)
 	{
-		 !MaterialIndexes.Contains(MatIdx) ? PMCRef->SetMaterial(MatIdx, VizAssetsContainer->MaterialInvisible)
-			: PMCRef->SetMaterial(MatIdx, DynamicMaterial);
+		const int32 MaterialIndex = MaterialIndexes[GroupIdx];
+		const FName SlotName = *FString::Printf(TEXT("Bone%d_Mat%d"), BoneIndex, MaterialIndex);
+		const FPolygonGroupID GroupId = Builder.AppendPolygonGroup();
+		SlotNames[GroupId] = SlotName;
+		StaticMaterials.Add(FStaticMaterial(SkelMaterials.IsValidIndex(MaterialIndex)
+			? SkelMaterials[MaterialIndex].MaterialInterface : nullptr, SlotName));
+
+		for (const uint32 FirstIdx : GroupTriangles[GroupIdx])
+		{
+			FVertexInstanceID Corners[3];
+			for (int32 CornerIdx = 0; CornerIdx < 3; ++CornerIdx)
+			{
+				const uint32 VertIdx = IndexBuffer->Get(FirstIdx + CornerIdx);
+				FVertexID* VertexId = VertexIds.Find(VertIdx);
+				if (!VertexId)
+				{
+					VertexId = &VertexIds.Add(VertIdx, Builder.AppendVertex(
+						BoneRefPose.InverseTransformPosition(FVector(PositionBuffer.VertexPosition(VertIdx)))));
+				}
+
+				const FVector4 TangentZ = VertexBuffer.VertexTangentZ(VertIdx);
+				Corners[CornerIdx] = Builder.AppendInstance(*VertexId);
+				Builder.SetInstanceTangentSpace(Corners[CornerIdx],
+					BoneRefPose.InverseTransformVectorNoScale(FVector(TangentZ)),
+					BoneRefPose.InverseTransformVectorNoScale(FVector(VertexBuffer.VertexTangentX(VertIdx))),
+					TangentZ.W < 0.f ? -1.f : 1.f);
+				Builder.SetInstanceUV(Corners[CornerIdx], FVector2D(VertexBuffer.GetVertexUV(VertIdx, 0)), 0);
+			}
+			Builder.AppendTriangle(Corners[0], Corners[1], Corners[2], GroupId);
+			NumTriangles++;
+		}
 	}
+
+	if (NumTriangles == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s has no triangles for bone %d with the given material indexes.."),
+			*FString(__FUNCTION__), __LINE__, *SkelMesh->GetName(), BoneIndex);
+		StaticMesh->MarkPendingKill();
+		return nullptr;
+	}
+
+	StaticMesh->BuildFromMeshDescriptions(TArray<const FMeshDescription*>{ &MeshDescription });
+	UE_LOG(LogTemp, Log, TEXT("%s::%d %s extracted bone %d with %d vertices and %d triangles.."),
+		*FString(__FUNCTION__), __LINE__, *SkelMesh->GetName(), BoneIndex, VertexIds.Num(), NumTriangles);
+	return StaticMesh;
 }
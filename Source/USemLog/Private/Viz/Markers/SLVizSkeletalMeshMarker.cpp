@@ -14,6 +14,8 @@ USLVizSkeletalMeshMarker::USLVizSkeletalMeshMarker()
 	PrimaryComponentTick.bStartWithTickEnabled = false;
 
 	PMCRef = nullptr;
+	MaxNumInstances = 128;
+	RecycleIndex = 0;
 }
 
 // Called every frame, used for timeline visualizations, activated and deactivated on request
@@ -107,19 +109,7 @@ void USLVizSkeletalMeshMarker::AddInstance(const TPair<FTransform, TMap<int32, F
 		return;
 	}
 
-	UPoseableMeshComponent* PMC = CreateNewPoseableMeshInstance();
-	PMC->SetWorldTransform(SkeletalPose.Key);
-
-	for (int32 Idx = 0; Idx < 5; ++Idx)
-	{
-		for (const auto& BonePosePair : SkeletalPose.Value)
-		{
-			const FName BoneName = PMC->GetBoneName(BonePosePair.Key);
-			PMC->SetBoneTransformByName(BoneName, BonePosePair.Value, EBoneSpaces::WorldSpace);
-		}
-	}
-
-	PMCInstances.Add(PMC);
+	SetInstancePose(AcquireInstance(), SkeletalPose);
 }
 
 //// Add instances with the poses
@@ -163,21 +153,24 @@ void USLVizSkeletalMeshMarker::AddInstances(const TArray<TPair<FTransform, TMap<
 		return;
 	}
 
-	for (const auto& SkelPosePair : SkeletalPoses)
+	const int32 NumPoses = SkeletalPoses.Num();
+	const int32 Limit = GetInstancesLimit();
+	if (NumPoses <= Limit)
 	{
-		UPoseableMeshComponent* PMC = CreateNewPoseableMeshInstance();
-		PMC->SetWorldTransform(SkelPosePair.Key);
-
-		for (int32 Idx = 0; Idx < 5; ++Idx)
+		for (const auto& SkeletalPose : SkeletalPoses)
 		{
-			for (const auto& BonePosePair : SkelPosePair.Value)
-			{
-				const FName BoneName = PMC->GetBoneName(BonePosePair.Key);
-				PMC->SetBoneTransformByName(BoneName, BonePosePair.Value, EBoneSpaces::WorldSpace);
-			}
+			SetInstancePose(AcquireInstance(), SkeletalPose);
 		}
+		return;
+	}
 
-		PMCInstances.Add(PMC);
+	// Poses above the limit would recycle each other within the same call, sample them evenly (first and last included)
+	UE_LOG(LogTemp, Warning, TEXT("%s::%d %s drawing %d of the %d poses (instance limit), %d poses are skipped.."),
+		*FString(__FUNCTION__), __LINE__, *GetName(), Limit, NumPoses, NumPoses - Limit);
+	for (int32 SampleIdx = 0; SampleIdx < Limit; ++SampleIdx)
+	{
+		const int32 PoseIdx = Limit > 1 ? int32((int64(SampleIdx) * (NumPoses - 1)) / (Limit - 1)) : NumPoses - 1;
+		SetInstancePose(AcquireInstance(), SkeletalPoses[PoseIdx]);
 	}
 }
 
@@ -209,6 +202,7 @@ void USLVizSkeletalMeshMarker::AddInstances(const TArray<TPair<FTransform, TMap<
 	TimelineMaxNumInstances = TimelineParams.MaxNumInstances;
 	bLoopTimeline = TimelineParams.bLoop;
 	TimelineIndex = 0;
+	ReleaseInstances();
 
 	// Start timeline
 	if (TimelineParams.UpdateRate > 0.f)
@@ -218,16 +212,22 @@ void USLVizSkeletalMeshMarker::AddInstances(const TArray<TPair<FTransform, TMap<
 	SetComponentTickEnabled(true);
 }
 
-// Unregister the component, remove it from its outer Actor's Components array and mark for pending kill
-void USLVizSkeletalMeshMarker::DestroyComponent(bool bPromoteChildren)
+// Set the max number of poseable mesh instances, the oldest instances are recycled when it is reached
+void USLVizSkeletalMeshMarker::SetMaxNumInstances(int32 Value)
 {
-	for (const auto& PMCInst : PMCInstances)
+	MaxNumInstances = FMath::Max(Value, 1);
+
+	// Apply the new limit to the current instances
+	if (PMCInstances.Num() > MaxNumInstances || FreePMCInstances.Num() > MaxNumInstances)
 	{
-		if (PMCInst && PMCInst->IsValidLowLevel() && !PMCInst->IsPendingKillOrUnreachable())
-		{
-			PMCInst->DestroyComponent();
-		}
+		ReleaseInstances();
 	}
+}
+
+// Unregister the component, remove it from its outer Actor's Components array and mark for pending kill
+void USLVizSkeletalMeshMarker::DestroyComponent(bool bPromoteChildren)
+{
+	EmptyPool();
 
 	if (PMCRef && PMCRef->IsValidLowLevel() && !PMCRef->IsPendingKillOrUnreachable())
 	{
@@ -243,6 +243,7 @@ void USLVizSkeletalMeshMarker::Reset()
 {
 	ResetVisuals();
 	ResetPoses();
+	ClearAndStopTimeline();
 }
 
 // Reset visual related data
@@ -260,14 +261,8 @@ void USLVizSkeletalMeshMarker::ResetVisuals()
 // Reset instances (poses of the visuals)
 void USLVizSkeletalMeshMarker::ResetPoses()
 {
-	for (const auto& PMC : PMCInstances)
-	{
-		if (!PMC->IsPendingKillOrUnreachable())
-		{
-			PMC->DestroyComponent();
-		}
-	}
-	PMCInstances.Empty();
+	// The instances are kept in the pool for the next poses
+	ReleaseInstances();
 }
 
 //// Update intial timeline iteration (create the instances)
@@ -369,108 +364,114 @@ void USLVizSkeletalMeshMarker::HideInstances()
 	}
 }
 
-// Clear the timeline and the related members
-void USLVizSkeletalMeshMarker::ClearAndStopTimeline()
+// Get a visible instance from the pool (creates one, or recycles the oldest one if the limit is reached)
+UPoseableMeshComponent* USLVizSkeletalMeshMarker::AcquireInstance()
 {
-	if (IsComponentTickEnabled())
+	// Recycle the oldest active instance
+	if (PMCInstances.Num() >= GetInstancesLimit())
 	{
-		SetComponentTickEnabled(false);
-		SetComponentTickInterval(-1.f); // Tick every frame by default (If less than or equal to 0 then it will tick every frame)
+		RecycleIndex = RecycleIndex % PMCInstances.Num();
+		return PMCInstances[RecycleIndex++];
 	}
-	TimelineMaxNumInstances = INDEX_NONE;
-	TimelineIndex = INDEX_NONE;
-	TimelinePoses.Empty();
+
+	UPoseableMeshComponent* PMC = FreePMCInstances.Num() > 0 ? FreePMCInstances.Pop(false) : CreateNewPoseableMeshInstance();
+	PMC->SetVisibility(true);
+	PMCInstances.Add(PMC);
+	return PMC;
 }
 
-// Update timeline with the given number of new instances
-void USLVizSkeletalMeshMarker::UpdateTimeline(int32 NumNewInstances)
+// Set the pose and the bone poses of the instance
+void USLVizSkeletalMeshMarker::SetInstancePose(UPoseableMeshComponent* PMC, const TPair<FTransform, TMap<int32, FTransform>>& SkeletalPose) const
 {
-	// Check if the instances have already been created (number of timeline poses equals the number of intances)
-	bool bInstancesAlreadyCreated = TimelinePoses.Num() == PMCInstances.Num();
+	PMC->SetWorldTransform(SkeletalPose.Key);
+
+	// Pooled instances keep the bones of their previous pose, start from the reference visual (the bones missing from the pose)
+	PMC->BoneSpaceTransforms = PMCRef->BoneSpaceTransforms;
+	PMC->MarkRefreshTransformDirty();
 
-	// Check if it is safe to draw all new instances
-	if (TimelineIndex + NumNewInstances < TimelinePoses.Num())
+	// Parent bones have lower indexes, setting them first keeps the world poses of their children in a single pass
+	TArray<int32> BoneIndexes;
+	SkeletalPose.Value.GenerateKeyArray(BoneIndexes);
+	BoneIndexes.Sort();
+	for (const int32 BoneIndex : BoneIndexes)
 	{
-		// Safe to draw all instances
-		while (NumNewInstances > 0)
-		{
-			bInstancesAlreadyCreated ? PMCInstances[TimelineIndex]->SetVisibility(true) : AddInstance(TimelinePoses[TimelineIndex]);
-			TimelineIndex++;
-			NumNewInstances--;
-		}
+		PMC->SetBoneTransformByName(PMC->GetBoneName(BoneIndex), SkeletalPose.Value[BoneIndex], EBoneSpaces::WorldSpace);
 	}
-	else
+}
+
+// Hide the active instances and move them to the free pool
+void USLVizSkeletalMeshMarker::ReleaseInstances()
+{
+	for (const auto& PMC : PMCInstances)
 	{
-		// Reached end of the poses array, add only remaining values
-		while (TimelinePoses.IsValidIndex(TimelineIndex))
+		if (PMC && PMC->IsValidLowLevel() && !PMC->IsPendingKillOrUnreachable())
 		{
-			bInstancesAlreadyCreated ? PMCInstances[TimelineIndex]->SetVisibility(true) : AddInstance(TimelinePoses[TimelineIndex]);
-			TimelineIndex++;
+			PMC->SetVisibility(false);
+			FreePMCInstances.Add(PMC);
 		}
+	}
+	PMCInstances.Empty();
+	RecycleIndex = 0;
 
-		// Hide existing instances if timeline should be looped
-		if (bLoopTimeline)
-		{
-			// Avoid destroying the instances
-			HideInstances();
-			// TimelinePoses.Empty(); commented out since it is used to detect if the instances were created, or create explicit flag
-			TimelineIndex = 0;
-		}
-		else
+	// Keep the pool within the limit
+	while (FreePMCInstances.Num() > MaxNumInstances)
+	{
+		FreePMCInstances.Pop(false)->DestroyComponent();
+	}
+}
+
+// Destroy the active and the pooled instances
+void USLVizSkeletalMeshMarker::EmptyPool()
+{
+	ReleaseInstances();
+	for (const auto& PMC : FreePMCInstances)
+	{
+		if (PMC && PMC->IsValidLowLevel() && !PMC->IsPendingKillOrUnreachable())
 		{
-			ClearAndStopTimeline();
+			PMC->DestroyComponent();
 		}
 	}
+	FreePMCInstances.Empty();
 }
 
-// Update timeline with max number of instances
-void USLVizSkeletalMeshMarker::UpdateTimelineWithMaxNumInstances(int32 NumNewInstances)
+// Max number of active instances (the timeline limit or the pool limit)
+int32 USLVizSkeletalMeshMarker::GetInstancesLimit() const
 {
-	// Check if the instances have already been created (number of timeline poses equals the number of intances)
-	bool bInstancesAlreadyCreated = TimelinePoses.Num() == PMCInstances.Num();
+	return TimelineMaxNumInstances > 0 ? FMath::Min(TimelineMaxNumInstances, MaxNumInstances) : MaxNumInstances;
+}
 
-	// Check if it is safe to draw all new instances
-	if (TimelineIndex + NumNewInstances < TimelinePoses.Num())
+// Clear the timeline and the related members
+void USLVizSkeletalMeshMarker::ClearAndStopTimeline()
+{
+	if (IsComponentTickEnabled())
 	{
-		// Safe to draw all instances
-		while (NumNewInstances > 0)
-		{
-			if (TimelineIndex < TimelineMaxNumInstances)
-			{
-				bInstancesAlreadyCreated ? PMCInstances[TimelineIndex]->SetVisibility(true) : AddInstance(TimelinePoses[TimelineIndex]);
-			}
-			else
-			{
-				PMCInstances[TimelineIndex-TimelineMaxNumInstances]->SetVisibility(false);
-				bInstancesAlreadyCreated ? PMCInstances[TimelineIndex]->SetVisibility(true) : AddInstance(TimelinePoses[TimelineIndex]);
-			}
-			TimelineIndex++;
-			NumNewInstances--;
-		}
+		SetComponentTickEnabled(false);
+		SetComponentTickInterval(-1.f); // Tick every frame by default (If less than or equal to 0 then it will tick every frame)
 	}
-	else
+	TimelineMaxNumInstances = INDEX_NONE;
+	TimelineIndex = INDEX_NONE;
+	TimelinePoses.Empty();
+}
+
+// Update timeline with the given number of new instances
+void USLVizSkeletalMeshMarker::UpdateTimeline(int32 NumNewInstances)
+{
+	// Instances are drawn from the pool, the oldest ones are recycled once the limit is reached
+	const int32 EndIndex = FMath::Min(TimelineIndex + NumNewInstances, TimelinePoses.Num());
+	for (int32 PoseIdx = FMath::Max(TimelineIndex, EndIndex - GetInstancesLimit()); PoseIdx < EndIndex; ++PoseIdx)
 	{
-		// Reached end of the poses array, add only remaining values
-		while (TimelinePoses.IsValidIndex(TimelineIndex))
-		{
-			if (TimelineIndex < TimelineMaxNumInstances)
-			{
-				bInstancesAlreadyCreated ? PMCInstances[TimelineIndex]->SetVisibility(true) : AddInstance(TimelinePoses[TimelineIndex]);				bInstancesAlreadyCreated ? PMCInstances[TimelineIndex]->SetVisibility(true) : AddInstance(TimelinePoses[TimelineIndex]);
-			}
-			else
-			{
-				PMCInstances[TimelineIndex - TimelineMaxNumInstances]->SetVisibility(false);
-				bInstancesAlreadyCreated ? PMCInstances[TimelineIndex]->SetVisibility(true) : AddInstance(TimelinePoses[TimelineIndex]);
-			}
-			TimelineIndex++;
-		}
+		SetInstancePose(AcquireInstance(), TimelinePoses[PoseIdx]);
+	}
+	TimelineIndex = EndIndex;
 
+	// Check if the end of the poses array is reached
+	if (TimelineIndex >= TimelinePoses.Num())
+	{
 		// Hide existing instances if timeline should be looped
 		if (bLoopTimeline)
 		{
 			// Avoid destroying the instances
-			HideInstances();
-			// TimelinePoses.Empty(); commented out since it is used to detect if the instances were created, or create explicit flag
+			ReleaseInstances();
 			TimelineIndex = 0;
 		}
 		else
@@ -480,6 +481,13 @@ void USLVizSkeletalMeshMarker::UpdateTimelineWithMaxNumInstances(int32 NumNewIns
 	}
 }
 
+// Update timeline with max number of instances
+void USLVizSkeletalMeshMarker::UpdateTimelineWithMaxNumInstances(int32 NumNewInstances)
+{
+	// The timeline limit is applied by the pool (see GetInstancesLimit)
+	UpdateTimeline(NumNewInstances);
+}
+
 //   Set visual without the materials (avoid boilerplate code)
 void USLVizSkeletalMeshMarker::SetPoseableMeshComponentVisual(USkeletalMesh* SkelMesh)
 {
@@ -498,6 +506,9 @@ void USLVizSkeletalMeshMarker::SetPoseableMeshComponentVisual(USkeletalMesh* Ske
 		PMCRef->RegisterComponent();
 	}
 
+	// The pooled instances are duplicates of the previous visual
+	EmptyPool();
+
 	// Set the reference visual
 	PMCRef->SetSkeletalMesh(SkelMesh);
 }
@@ -15,6 +15,7 @@ USLVizStaticMeshMarker::USLVizStaticMeshMarker()
 	PrimaryComponentTick.bStartWithTickEnabled = false;
 
 	ISMC = nullptr;
+	TimelineFirstInstance = 0;
 }
 
 // Called every frame, used for timeline visualizations, activated and deactivated on request
@@ -168,6 +169,17 @@ void USLVizStaticMeshMarker::AddInstances(const TArray<FTransform>& Poses,
 	bLoopTimeline = TimelineParams.bLoop;
 
 	TimelineIndex = 0;
+
+	// Reserve the instances up front, the ring buffer pool is created as hidden instances
+	TimelineFirstInstance = ISMC->GetInstanceCount();
+	if (TimelineMaxNumInstances > 0)
+	{
+		PreallocateTimelinePool();
+	}
+	else
+	{
+		ISMC->PreAllocateInstancesMemory(TimelinePoses.Num());
+	}
 	
 	// Start timeline
 	if (TimelineParams.UpdateRate > 0.f)
@@ -177,6 +189,46 @@ void USLVizStaticMeshMarker::AddInstances(const TArray<FTransform>& Poses,
 	SetComponentTickEnabled(true);
 }
 
+// Replace the current instances with the poses
+void USLVizStaticMeshMarker::SetInstances(const TArray<FTransform>& Poses)
+{
+	if (!ISMC || !ISMC->IsValidLowLevel() || ISMC->IsPendingKillOrUnreachable())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Visual is not set.."), *FString(__FUNCTION__), __LINE__);
+		return;
+	}
+
+	// Update the existing instances in a single batch, add or remove only the difference
+	const int32 NumInstances = ISMC->GetInstanceCount();
+	TArray<FTransform> Transforms;
+	Transforms.Reserve(Poses.Num());
+	for (const auto& P : Poses)
+	{
+		Transforms.Add(GetInstanceTransform(P));
+	}
+
+	if (NumInstances > Transforms.Num())
+	{
+		TArray<int32> RemoveIndexes;
+		for (int32 Idx = Transforms.Num(); Idx < NumInstances; ++Idx)
+		{
+			RemoveIndexes.Add(Idx);
+		}
+		ISMC->RemoveInstances(RemoveIndexes);
+	}
+
+	const int32 NumUpdates = FMath::Min(NumInstances, Transforms.Num());
+	if (NumUpdates > 0)
+	{
+		ISMC->BatchUpdateInstancesTransforms(0, TArray<FTransform>(Transforms.GetData(), NumUpdates), true, true, true);
+	}
+
+	if (Transforms.Num() > NumInstances)
+	{
+		ISMC->AddInstances(TArray<FTransform>(Transforms.GetData() + NumInstances, Transforms.Num() - NumInstances), false);
+	}
+}
+
 /* Begin VizMarker interface */
 // Reset visuals and poses
 void USLVizStaticMeshMarker::Reset()
@@ -224,22 +276,26 @@ void USLVizStaticMeshMarker::ResetPoses()
 // Virtual add instance function
 void USLVizStaticMeshMarker::AddInstanceChecked(const FTransform& Pose)
 {
-	ISMC->AddInstance(Pose);
+	ISMC->AddInstance(GetInstanceTransform(Pose));
 }
 
 // Virtual update instance transform
 bool USLVizStaticMeshMarker::UpdateInstanceTransform(int32 Index, const FTransform& Pose)
 {
-	return ISMC->UpdateInstanceTransform(Index, Pose, true, true, true);
+	return ISMC->UpdateInstanceTransform(Index, GetInstanceTransform(Pose), true, true, true);
 }
 
 // Virtual add instances function
 void USLVizStaticMeshMarker::AddInstancesChecked(const TArray<FTransform>& Poses)
 {
+	// Single batch, the render state is updated only once
+	TArray<FTransform> Transforms;
+	Transforms.Reserve(Poses.Num());
 	for (const auto& P : Poses)
 	{
-		ISMC->AddInstance(P);
+		Transforms.Add(GetInstanceTransform(P));
 	}
+	ISMC->AddInstances(Transforms, false);
 }
 
 // Reset the timeline related members
@@ -252,36 +308,28 @@ void USLVizStaticMeshMarker::ClearAndStopTimeline()
 	}
 	TimelineMaxNumInstances = INDEX_NONE;
 	TimelineIndex = INDEX_NONE;
+	TimelineFirstInstance = 0;
 	TimelinePoses.Empty();
+	TimelineBatch.Empty();
 }
 
 // Update timeline with the given number of new instances
 void USLVizStaticMeshMarker::UpdateTimeline(int32 NumNewInstances)
 {
-	// Check if it is safe to draw all new instances
-	if (TimelineIndex + NumNewInstances < TimelinePoses.Num())
-	{
-		// Safe to draw all new instances
-		while (NumNewInstances > 0)
-		{
-			AddInstanceChecked(TimelinePoses[TimelineIndex]);
-			TimelineIndex++;
-			NumNewInstances--;
-		}
-	}
-	else
-	{
-		// Reached end of the poses array, add only remaining values
-		while (TimelinePoses.IsValidIndex(TimelineIndex))
-		{
-			AddInstanceChecked(TimelinePoses[TimelineIndex]);
-			TimelineIndex++;
-		}
+	// Draw the new instances in a single batch (clamped to the remaining poses)
+	const int32 EndIndex = FMath::Min(TimelineIndex + NumNewInstances, TimelinePoses.Num());
+	AddTimelineInstances(TimelineIndex, EndIndex);
+	TimelineIndex = EndIndex;
 
+	// Check if the end of the poses array is reached
+	if (TimelineIndex >= TimelinePoses.Num())
+	{
 		// Check if the timeline should be repeated or stopped
 		if (bLoopTimeline)
 		{
 			ISMC->ClearInstances();
+			ISMC->PreAllocateInstancesMemory(TimelinePoses.Num());
+			TimelineFirstInstance = 0;
 			TimelineIndex = 0;
 		}
 		else
@@ -294,46 +342,34 @@ void USLVizStaticMeshMarker::UpdateTimeline(int32 NumNewInstances)
 // Update timeline with max number of instances
 void USLVizStaticMeshMarker::UpdateTimelineWithMaxNumInstances(int32 NumNewInstances)
 {
-	// Check if it is safe to draw all new instances
-	if (TimelineIndex + NumNewInstances < TimelinePoses.Num())
+	const int32 EndIndex = FMath::Min(TimelineIndex + NumNewInstances, TimelinePoses.Num());
+
+	// Poses overwritten within the same batch would never be visible, only the last max number of them are set
+	int32 PoseIndex = FMath::Max(TimelineIndex, EndIndex - TimelineMaxNumInstances);
+	while (PoseIndex < EndIndex)
 	{
-		// Safe to draw all new instances
-		while (NumNewInstances > 0)
+		// Update the contiguous pool instances until the end of the batch or the wrap around of the ring buffer
+		const int32 PoolIndex = PoseIndex % TimelineMaxNumInstances;
+		const int32 SegmentEndIndex = FMath::Min(EndIndex, PoseIndex + TimelineMaxNumInstances - PoolIndex);
+		TimelineBatch.Reset();
+		for (; PoseIndex < SegmentEndIndex; ++PoseIndex)
 		{
-			if (TimelineIndex < TimelineMaxNumInstances)
-			{
-				AddInstanceChecked(TimelinePoses[TimelineIndex]);
-			}
-			else
-			{
-				int32 UpdateIndex = TimelineIndex % TimelineMaxNumInstances;
-				UpdateInstanceTransform(UpdateIndex, TimelinePoses[TimelineIndex]);
-			}
-			TimelineIndex++;
-			NumNewInstances--;
+			TimelineBatch.Add(GetInstanceTransform(TimelinePoses[PoseIndex]));
 		}
+		ISMC->BatchUpdateInstancesTransforms(TimelineFirstInstance + PoolIndex, TimelineBatch, true, false, true);
 	}
-	else
-	{
-		// Reached end of the poses array, add only remaining values
-		while (TimelinePoses.IsValidIndex(TimelineIndex))
-		{
-			if (TimelineIndex < TimelineMaxNumInstances)
-			{
-				AddInstanceChecked(TimelinePoses[TimelineIndex]);
-			}
-			else
-			{
-				int32 UpdateIndex = TimelineIndex % TimelineMaxNumInstances;
-				UpdateInstanceTransform(UpdateIndex, TimelinePoses[TimelineIndex]);
-			}
-			TimelineIndex++;
-		}
+	TimelineIndex = EndIndex;
 
-		// Check if the timeline should be repeated or stopped
+	// Single render state update for the whole tick
+	ISMC->MarkRenderStateDirty();
+
+	// Check if the end of the poses array is reached
+	if (TimelineIndex >= TimelinePoses.Num())
+	{
+		// Check if the timeline should be repeated or stopped, the pool is kept when repeating
 		if (bLoopTimeline)
 		{
-			ISMC->ClearInstances();
+			HideTimelinePool();
 			TimelineIndex = 0;
 		}
 		else
@@ -342,3 +378,36 @@ void USLVizStaticMeshMarker::UpdateTimelineWithMaxNumInstances(int32 NumNewInsta
 		}
 	}
 }
+
+// Add the timeline poses in the given range as instances in a single batch
+void USLVizStaticMeshMarker::AddTimelineInstances(int32 FromIndex, int32 ToIndex)
+{
+	if (FromIndex >= ToIndex)
+	{
+		return;
+	}
+
+	TimelineBatch.Reset();
+	for (int32 PoseIdx = FromIndex; PoseIdx < ToIndex; ++PoseIdx)
+	{
+		TimelineBatch.Add(GetInstanceTransform(TimelinePoses[PoseIdx]));
+	}
+	ISMC->AddInstances(TimelineBatch, false);
+}
+
+// Create the timeline ring buffer instances as hidden instances
+void USLVizStaticMeshMarker::PreallocateTimelinePool()
+{
+	// Zero scaled instances are not visible
+	TimelineBatch.Init(FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector),
+		FMath::Min(TimelineMaxNumInstances, TimelinePoses.Num()));
+	ISMC->AddInstances(TimelineBatch, false);
+}
+
+// Hide the timeline ring buffer instances in a single batch
+void USLVizStaticMeshMarker::HideTimelinePool()
+{
+	TimelineBatch.Init(FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector),
+		FMath::Min(TimelineMaxNumInstances, TimelinePoses.Num()));
+	ISMC->BatchUpdateInstancesTransforms(TimelineFirstInstance, TimelineBatch, true, true, true);
+}
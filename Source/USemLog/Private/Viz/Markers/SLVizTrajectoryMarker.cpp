@@ -0,0 +1,495 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Viz/Markers/SLVizTrajectoryMarker.h"
+#include "Viz/SLVizAssets.h"
+#include "ProceduralMeshComponent.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Async/Async.h"
+
+// Constructor
+USLVizTrajectoryMarker::USLVizTrajectoryMarker()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	ProcMeshComp = nullptr;
+	TimelineNumPoses = 0;
+	TimelinePosesPerSection = PosesPerSection;
+	BuildId = 0;
+}
+
+// Called every frame, used for timeline visualizations, activated and deactivated on request
+void USLVizTrajectoryMarker::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// Increase the passed time
+	TimelineDeltaTime += DeltaTime;
+
+	// Calculate the number of poses to draw depending on the passed time
+	int32 NumPosesToDraw = (TimelineDeltaTime * TimelineNumPoses) / TimelineDuration;
+
+	// Wait if not enough time has passed
+	if (NumPosesToDraw == 0)
+	{
+		return;
+	}
+
+	UpdateTimeline(NumPosesToDraw);
+
+	// Reset the elapsed time
+	TimelineDeltaTime = 0;
+}
+
+// Set the visual properties of the trajectory
+void USLVizTrajectoryMarker::SetVisual(const FSLVizTrajectoryParams& InParams, ESLVizMaterialType InMaterialType)
+{
+	// Clear any previous data
+	Reset();
+
+	if (!ProcMeshComp || !ProcMeshComp->IsValidLowLevel() || ProcMeshComp->IsPendingKillOrUnreachable())
+	{
+		ProcMeshComp = NewObject<UProceduralMeshComponent>(this);
+		ProcMeshComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		ProcMeshComp->bUseAsyncCooking = true;
+		ProcMeshComp->bSelectable = false;
+		ProcMeshComp->SetCastShadow(false);
+		ProcMeshComp->RegisterComponent();
+	}
+
+	Params = InParams;
+	Params.Width = FMath::Max(Params.Width, KINDA_SMALL_NUMBER);
+	Params.TickInterval = FMath::Max(Params.TickInterval, 1);
+
+	// Set the dynamic material
+	SetDynamicMaterial(InMaterialType);
+	SetDynamicMaterialColor(Params.Color);
+}
+
+// Set the trajectory poses (the mesh is built on a background thread)
+void USLVizTrajectoryMarker::SetPoses(const TArray<FTransform>& Poses)
+{
+	if (!ProcMeshComp || !ProcMeshComp->IsValidLowLevel() || ProcMeshComp->IsPendingKillOrUnreachable())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Visual is not set.."), *FString(__FUNCTION__), __LINE__);
+		return;
+	}
+	BuildSectionsAsync(Poses, false);
+}
+
+// Set the trajectory poses with timeline update (the max number of instances is not used)
+void USLVizTrajectoryMarker::SetPoses(const TArray<FTransform>& Poses, const FSLVizTimelineParams& TimelineParams)
+{
+	if (!ProcMeshComp || !ProcMeshComp->IsValidLowLevel() || ProcMeshComp->IsPendingKillOrUnreachable())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Visual is not set.."), *FString(__FUNCTION__), __LINE__);
+		return;
+	}
+
+	if (TimelineParams.Duration <= 0.008f || Poses.Num() == 0)
+	{
+		BuildSectionsAsync(Poses, false);
+		return;
+	}
+
+	if (IsComponentTickEnabled())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d A timeline is already active, reset first.."), *FString(__FUNCTION__), __LINE__);
+		return;
+	}
+
+	// Discard any pending background build
+	ResetPoses();
+
+	// Set the timeline data
+	TimelineNumPoses = Poses.Num();
+	TimelineDuration = TimelineParams.Duration;
+	bLoopTimeline = TimelineParams.bLoop;
+	TimelineIndex = 0;
+	if (TimelineParams.UpdateRate > 0.f)
+	{
+		SetComponentTickInterval(TimelineParams.UpdateRate);
+	}
+
+	// The timeline starts once its sections are built
+	BuildSectionsAsync(Poses, true);
+}
+
+// Unregister the component, remove it from its outer Actor's Components array and mark for pending kill
+void USLVizTrajectoryMarker::DestroyComponent(bool bPromoteChildren)
+{
+	// Invalidate any pending background build
+	BuildId++;
+	if (ProcMeshComp && ProcMeshComp->IsValidLowLevel() && !ProcMeshComp->IsPendingKillOrUnreachable())
+	{
+		ProcMeshComp->DestroyComponent();
+	}
+	Super::DestroyComponent(bPromoteChildren);
+}
+
+/* Begin VizMarker interface */
+// Reset visuals and poses
+void USLVizTrajectoryMarker::Reset()
+{
+	ResetVisuals();
+	ResetPoses();
+	ClearAndStopTimeline();
+}
+
+// Reset visual related data
+void USLVizTrajectoryMarker::ResetVisuals()
+{
+	// The section materials are created from the current dynamic material
+	SectionMaterials.Empty();
+
+	if (!ProcMeshComp || !ProcMeshComp->IsValidLowLevel() || ProcMeshComp->IsPendingKillOrUnreachable())
+	{
+		return;
+	}
+
+	ProcMeshComp->EmptyOverrideMaterials();
+}
+
+// Reset instances (poses of the visuals)
+void USLVizTrajectoryMarker::ResetPoses()
+{
+	// Invalidate any pending background build
+	BuildId++;
+	if (!ProcMeshComp || !ProcMeshComp->IsValidLowLevel() || ProcMeshComp->IsPendingKillOrUnreachable())
+	{
+		return;
+	}
+
+	TimelineSections.Empty();
+	TimelineSectionVertices.Empty();
+	TimelineSectionNumVisiblePoses.Empty();
+	ProcMeshComp->ClearAllMeshSections();
+}
+/* End VizMarker interface */
+
+// Clear the timeline and the related members
+void USLVizTrajectoryMarker::ClearAndStopTimeline()
+{
+	if (IsComponentTickEnabled())
+	{
+		SetComponentTickEnabled(false);
+		SetComponentTickInterval(-1.f); // Tick every frame by default (If less than or equal to 0 then it will tick every frame)
+	}
+	TimelineIndex = INDEX_NONE;
+	TimelineNumPoses = 0;
+	TimelineSections.Empty();
+	TimelineSectionVertices.Empty();
+	TimelineSectionNumVisiblePoses.Empty();
+}
+
+// Update timeline with the given number of new poses (only the sections of the new poses are updated)
+void USLVizTrajectoryMarker::UpdateTimeline(int32 NumNewPoses)
+{
+	const int32 NumVisiblePoses = FMath::Min(TimelineIndex + NumNewPoses, TimelineNumPoses);
+
+	// Sections ending before the previous last visible pose are already complete, the last pose of
+	// the trajectory is owned by the last section
+	const int32 LastSectionIdx = TimelineSections.Num() - 1;
+	const int32 FirstSection = FMath::Min(FMath::Max(TimelineIndex - 1, 0) / TimelinePosesPerSection, LastSectionIdx);
+	const int32 LastSection = FMath::Min(FMath::Max(NumVisiblePoses - 1, 0) / TimelinePosesPerSection, LastSectionIdx);
+	for (int32 SectionIdx = FirstSection; SectionIdx <= LastSection; ++SectionIdx)
+	{
+		ApplyTimelineSection(SectionIdx, NumVisiblePoses - SectionIdx * TimelinePosesPerSection);
+	}
+	TimelineIndex = NumVisiblePoses;
+
+	// Check if the end of the poses array is reached
+	if (TimelineIndex >= TimelineNumPoses)
+	{
+		// Check if the timeline should be repeated or stopped
+		if (bLoopTimeline)
+		{
+			// Hide the poses, the sections are kept for the next iteration
+			for (int32 SectionIdx = 0; SectionIdx < TimelineSections.Num(); ++SectionIdx)
+			{
+				ApplyTimelineSection(SectionIdx, 0);
+			}
+			TimelineIndex = 0;
+		}
+		else
+		{
+			ClearAndStopTimeline();
+		}
+	}
+}
+
+// Create the hidden timeline sections from the background build and start the timeline
+void USLVizTrajectoryMarker::StartTimeline(TArray<FSLVizTrajectoryMeshData>&& Sections)
+{
+	TimelineSections = MoveTemp(Sections);
+	const int32 NumSections = TimelineSections.Num();
+	TimelineSectionVertices.SetNum(NumSections);
+	TimelineSectionNumVisiblePoses.SetNum(NumSections);
+
+	ProcMeshComp->ClearAllMeshSections();
+	for (int32 SectionIdx = 0; SectionIdx < NumSections; ++SectionIdx)
+	{
+		// Start from the complete geometry with all the poses hidden
+		const FSLVizTrajectoryMeshData& MeshData = TimelineSections[SectionIdx];
+		TimelineSectionVertices[SectionIdx] = MeshData.Vertices;
+		TimelineSectionNumVisiblePoses[SectionIdx] = MeshData.PoseFirstVertices.Num();
+		UpdateTimelineVertices(SectionIdx, 0);
+		ApplySection(SectionIdx, MeshData, TimelineSectionVertices[SectionIdx]);
+	}
+
+	TimelineIndex = 0;
+	TimelineDeltaTime = 0.f;
+	SetComponentTickEnabled(true);
+}
+
+// Show the first poses of the timeline section, skipped if the section visible range did not change
+void USLVizTrajectoryMarker::ApplyTimelineSection(int32 SectionIndex, int32 NumVisibleSectionPoses)
+{
+	if (UpdateTimelineVertices(SectionIndex, NumVisibleSectionPoses))
+	{
+		// Only the positions change, the arrays left empty keep their section values
+		ProcMeshComp->UpdateMeshSection_LinearColor(SectionIndex, TimelineSectionVertices[SectionIndex], TArray<FVector>(),
+			TArray<FVector2D>(), TArray<FLinearColor>(), TArray<FProcMeshTangent>());
+	}
+}
+
+// Patch the uploaded vertices of the timeline section, the newly visible poses are restored and the hidden ones
+// collapsed onto the last visible cross section (the topology stays the same), false if nothing changed
+bool USLVizTrajectoryMarker::UpdateTimelineVertices(int32 SectionIndex, int32 NumVisibleSectionPoses)
+{
+	const FSLVizTrajectoryMeshData& MeshData = TimelineSections[SectionIndex];
+	const int32 NumSectionPoses = MeshData.PoseFirstVertices.Num();
+	const int32 NumVisible = FMath::Clamp(NumVisibleSectionPoses, 0, NumSectionPoses);
+	int32& NumPrevVisible = TimelineSectionNumVisiblePoses[SectionIndex];
+	if (NumVisible == NumPrevVisible)
+	{
+		return false;
+	}
+
+	TArray<FVector>& Vertices = TimelineSectionVertices[SectionIndex];
+	auto GetPoseEndVertex = [&MeshData, NumSectionPoses](int32 PoseIdx)
+	{
+		return PoseIdx + 1 < NumSectionPoses ? MeshData.PoseFirstVertices[PoseIdx + 1] : MeshData.Vertices.Num();
+	};
+
+	// Copy back the geometry of the newly visible poses (contiguous vertex range)
+	if (NumVisible > NumPrevVisible)
+	{
+		const int32 FirstVertex = MeshData.PoseFirstVertices[NumPrevVisible];
+		const int32 EndVertex = GetPoseEndVertex(NumVisible - 1);
+		FMemory::Memcpy(Vertices.GetData() + FirstVertex, MeshData.Vertices.GetData() + FirstVertex,
+			(EndVertex - FirstVertex) * sizeof(FVector));
+	}
+
+	// The strips towards the hidden poses become degenerate triangles, the ticks of the hidden poses collapse to a point
+	const int32 NumCrossVertices = Params.Type == ESLVizTrajectoryType::Line ? 4 : 2;
+	const int32 AnchorVertex = NumVisible > 0 ? MeshData.PoseFirstVertices[NumVisible - 1] : 0;
+	for (int32 PoseIdx = NumVisible; PoseIdx < NumSectionPoses; ++PoseIdx)
+	{
+		const int32 FirstVertex = MeshData.PoseFirstVertices[PoseIdx];
+		const int32 EndVertex = GetPoseEndVertex(PoseIdx);
+		for (int32 VertIdx = FirstVertex; VertIdx < EndVertex; ++VertIdx)
+		{
+			const int32 CrossIdx = VertIdx - FirstVertex;
+			Vertices[VertIdx] = MeshData.Vertices[AnchorVertex + (CrossIdx < NumCrossVertices ? CrossIdx : 0)];
+		}
+	}
+
+	NumPrevVisible = NumVisible;
+	return true;
+}
+
+// Build all the sections on a background thread and apply them (or start the timeline with them) on the game thread
+void USLVizTrajectoryMarker::BuildSectionsAsync(const TArray<FTransform>& Poses, bool bTimeline)
+{
+	const int32 CurrBuildId = ++BuildId;
+	const int32 NumPosesPerSection = GetNumPosesPerSection(Poses.Num());
+	if (bTimeline)
+	{
+		TimelinePosesPerSection = NumPosesPerSection;
+	}
+
+	TWeakObjectPtr<USLVizTrajectoryMarker> WeakThis(this);
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask,
+		[WeakThis, Poses, BuildParams = Params, NumPosesPerSection, bTimeline, CurrBuildId]()
+	{
+		TArray<FSLVizTrajectoryMeshData> Sections;
+		BuildSections(Poses, NumPosesPerSection, BuildParams, Sections);
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Sections = MoveTemp(Sections), bTimeline, CurrBuildId]() mutable
+		{
+			// Skip if the marker was destroyed or reset in the meantime
+			if (!WeakThis.IsValid() || WeakThis->BuildId != CurrBuildId
+				|| !WeakThis->ProcMeshComp || WeakThis->ProcMeshComp->IsPendingKillOrUnreachable())
+			{
+				return;
+			}
+
+			if (bTimeline)
+			{
+				WeakThis->StartTimeline(MoveTemp(Sections));
+				return;
+			}
+
+			WeakThis->ProcMeshComp->ClearAllMeshSections();
+			for (int32 SectionIdx = 0; SectionIdx < Sections.Num(); ++SectionIdx)
+			{
+				WeakThis->ApplySection(SectionIdx, Sections[SectionIdx], Sections[SectionIdx].Vertices);
+			}
+		});
+	});
+}
+
+// Create the mesh section with the trajectory material
+void USLVizTrajectoryMarker::ApplySection(int32 SectionIndex, const FSLVizTrajectoryMeshData& MeshData, const TArray<FVector>& Vertices)
+{
+	ProcMeshComp->CreateMeshSection_LinearColor(SectionIndex, Vertices, MeshData.Triangles, MeshData.Normals,
+		TArray<FVector2D>(), MeshData.Colors, TArray<FProcMeshTangent>(), false);
+	ProcMeshComp->SetMaterial(SectionIndex, GetSectionMaterial(SectionIndex, MeshData));
+}
+
+// Material of the trajectory section (vertex colors, or a section colored dynamic material if the asset is missing)
+UMaterialInterface* USLVizTrajectoryMarker::GetSectionMaterial(int32 SectionIndex, const FSLVizTrajectoryMeshData& MeshData)
+{
+	if (!Params.bTimeColoring || !DynamicMaterial)
+	{
+		return DynamicMaterial;
+	}
+
+	if (VizAssetsContainer && VizAssetsContainer->MaterialVertexColor)
+	{
+		return VizAssetsContainer->MaterialVertexColor;
+	}
+
+	// Every section is a color band, using the interpolated color of its middle vertex
+	while (SectionMaterials.Num() <= SectionIndex)
+	{
+		SectionMaterials.Add(UMaterialInstanceDynamic::Create(DynamicMaterial->Parent, this));
+	}
+	UMaterialInstanceDynamic* SectionMaterial = SectionMaterials[SectionIndex];
+	if (MeshData.Colors.Num() > 0)
+	{
+		SectionMaterial->SetVectorParameterValue(FName("Color"), MeshData.Colors[MeshData.Colors.Num() / 2]);
+	}
+	return SectionMaterial;
+}
+
+// Number of poses per section, time coloring without vertex colors uses smaller sections as color bands
+int32 USLVizTrajectoryMarker::GetNumPosesPerSection(int32 NumPoses) const
+{
+	if (Params.bTimeColoring && !(VizAssetsContainer && VizAssetsContainer->MaterialVertexColor))
+	{
+		return FMath::Clamp(FMath::DivideAndRoundUp(NumPoses, NumTimeColorBands), 1, PosesPerSection);
+	}
+	return PosesPerSection;
+}
+
+// Build the geometry of all the sections, every section shares its last pose with the next one, no UObject access
+void USLVizTrajectoryMarker::BuildSections(const TArray<FTransform>& Poses, int32 InNumPosesPerSection,
+	const FSLVizTrajectoryParams& InParams, TArray<FSLVizTrajectoryMeshData>& OutSections)
+{
+	const int32 NumPoses = Poses.Num();
+	const int32 NumSections = NumPoses > 0 ? FMath::Max(1, FMath::DivideAndRoundUp(NumPoses - 1, InNumPosesPerSection)) : 0;
+	OutSections.SetNum(NumSections);
+	for (int32 SectionIdx = 0; SectionIdx < NumSections; ++SectionIdx)
+	{
+		const int32 FirstPoseIdx = SectionIdx * InNumPosesPerSection;
+		const int32 NumSectionPoses = FMath::Min(InNumPosesPerSection + 1, NumPoses - FirstPoseIdx);
+		const int32 NumOwnedPoses = SectionIdx == NumSections - 1 ? NumPoses - FirstPoseIdx : InNumPosesPerSection;
+		BuildSection(Poses.GetData() + FirstPoseIdx, NumSectionPoses, FirstPoseIdx,
+			NumOwnedPoses, NumPoses, InParams, OutSections[SectionIdx]);
+	}
+}
+
+// Build the geometry of the section poses (the last one connects to the next section), no UObject access
+void USLVizTrajectoryMarker::BuildSection(const FTransform* SectionPoses, int32 NumSectionPoses, int32 FirstPoseIndex,
+	int32 NumOwnedPoses, int32 NumTotalPoses, const FSLVizTrajectoryParams& InParams, FSLVizTrajectoryMeshData& OutMeshData)
+{
+	// Lines are two crossed strips (Y and Z), ribbons a single strip (Y)
+	const bool bIsLine = InParams.Type == ESLVizTrajectoryType::Line;
+	const int32 NumCrossVertices = bIsLine ? 4 : 2;
+	const float HalfWidth = InParams.Width * 0.5f;
+	const float InvLastIndex = NumTotalPoses > 1 ? 1.f / (NumTotalPoses - 1) : 0.f;
+
+	OutMeshData.Vertices.Reserve(NumSectionPoses * NumCrossVertices);
+	OutMeshData.Normals.Reserve(NumSectionPoses * NumCrossVertices);
+	OutMeshData.Colors.Reserve(NumSectionPoses * NumCrossVertices);
+	OutMeshData.Triangles.Reserve(NumSectionPoses * NumCrossVertices * 6);
+	OutMeshData.PoseFirstVertices.Reserve(NumSectionPoses);
+
+	// First vertex of the previous cross section (the ticks are appended in between)
+	int32 PrevFirstVertex = INDEX_NONE;
+	for (int32 LocalIdx = 0; LocalIdx < NumSectionPoses; ++LocalIdx)
+	{
+		const FTransform& Pose = SectionPoses[LocalIdx];
+		const FVector Location = Pose.GetLocation();
+		const FVector AxisX = Pose.GetUnitAxis(EAxis::X);
+		const FVector AxisY = Pose.GetUnitAxis(EAxis::Y);
+		const FVector AxisZ = Pose.GetUnitAxis(EAxis::Z);
+		const FLinearColor Color = InParams.bTimeColoring
+			? FMath::Lerp(InParams.Color, InParams.EndColor, (FirstPoseIndex + LocalIdx) * InvLastIndex)
+			: InParams.Color;
+
+		// Cross section vertices
+		const int32 FirstVertex = OutMeshData.Vertices.Num();
+		OutMeshData.PoseFirstVertices.Add(FirstVertex);
+		OutMeshData.Vertices.Add(Location + AxisY * HalfWidth);
+		OutMeshData.Vertices.Add(Location - AxisY * HalfWidth);
+		OutMeshData.Normals.Add(AxisZ);
+		OutMeshData.Normals.Add(AxisZ);
+		if (bIsLine)
+		{
+			OutMeshData.Vertices.Add(Location + AxisZ * HalfWidth);
+			OutMeshData.Vertices.Add(Location - AxisZ * HalfWidth);
+			OutMeshData.Normals.Add(AxisY);
+			OutMeshData.Normals.Add(AxisY);
+		}
+		for (int32 Idx = 0; Idx < NumCrossVertices; ++Idx)
+		{
+			OutMeshData.Colors.Add(Color);
+		}
+
+		// Connect to the previous cross section
+		if (PrevFirstVertex != INDEX_NONE)
+		{
+			for (int32 StripIdx = 0; StripIdx < NumCrossVertices; StripIdx += 2)
+			{
+				AddQuad(OutMeshData, PrevFirstVertex + StripIdx, PrevFirstVertex + StripIdx + 1,
+					FirstVertex + StripIdx, FirstVertex + StripIdx + 1);
+			}
+		}
+		PrevFirstVertex = FirstVertex;
+
+		// Orientation tick along the X axis (crossed strips of half the trajectory width)
+		const int32 PoseIdx = FirstPoseIndex + LocalIdx;
+		if (InParams.TickLength > 0.f && LocalIdx < NumOwnedPoses && PoseIdx % InParams.TickInterval == 0)
+		{
+			const FVector TickEnd = Location + AxisX * InParams.TickLength;
+			const float TickHalfWidth = HalfWidth * 0.5f;
+			const int32 TickFirstVertex = OutMeshData.Vertices.Num();
+			OutMeshData.Vertices.Add(Location + AxisY * TickHalfWidth);
+			OutMeshData.Vertices.Add(Location - AxisY * TickHalfWidth);
+			OutMeshData.Vertices.Add(TickEnd + AxisY * TickHalfWidth);
+			OutMeshData.Vertices.Add(TickEnd - AxisY * TickHalfWidth);
+			OutMeshData.Vertices.Add(Location + AxisZ * TickHalfWidth);
+			OutMeshData.Vertices.Add(Location - AxisZ * TickHalfWidth);
+			OutMeshData.Vertices.Add(TickEnd + AxisZ * TickHalfWidth);
+			OutMeshData.Vertices.Add(TickEnd - AxisZ * TickHalfWidth);
+			for (int32 Idx = 0; Idx < 8; ++Idx)
+			{
+				OutMeshData.Normals.Add(Idx < 4 ? AxisZ : AxisY);
+				OutMeshData.Colors.Add(Color);
+			}
+			AddQuad(OutMeshData, TickFirstVertex, TickFirstVertex + 1, TickFirstVertex + 2, TickFirstVertex + 3);
+			AddQuad(OutMeshData, TickFirstVertex + 4, TickFirstVertex + 5, TickFirstVertex + 6, TickFirstVertex + 7);
+		}
+	}
+}
+
+// Append a strip quad with both windings
+void USLVizTrajectoryMarker::AddQuad(FSLVizTrajectoryMeshData& OutMeshData, int32 V0, int32 V1, int32 V2, int32 V3)
+{
+	OutMeshData.Triangles.Append({ V0, V2, V1, V1, V2, V3 });
+	OutMeshData.Triangles.Append({ V0, V1, V2, V1, V3, V2 });
+}
@@ -2,6 +2,7 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #include "Viz/SLVizCameraDirector.h"
+#include "Viz/SLVizEpisodeManager.h"
 #include "GameFramework/PlayerController.h"
 #include "GameFramework/Pawn.h"
 
@@ -22,6 +23,7 @@ ASLVizCameraDirector::ASLVizCameraDirector()
 	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	bIsInit = false;
+	bCameraPathActive = false;
 }
 
 // Called when the game starts or when sActivePawned
@@ -35,7 +37,14 @@ void ASLVizCameraDirector::BeginPlay()
 void ASLVizCameraDirector::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);	
-	UpdateBlendMovement(DeltaTime);
+	if (bCameraPathActive)
+	{
+		UpdateCameraPath();
+	}
+	else
+	{
+		UpdateBlendMovement(DeltaTime);
+	}
 }
 
 // Init director references
@@ -63,6 +72,9 @@ void ASLVizCameraDirector::Init()
 // Move the camera position to the given pose (smooth movement if blend time is > 0)
 void ASLVizCameraDirector::MoveCameraTo(const FTransform& Pose, float BlendTime)
 {
+	// Manual movements override the camera path
+	ClearCameraPath();
+
 	// Remove any previous attachments
 	DetachCamera();
 
@@ -89,6 +101,9 @@ void ASLVizCameraDirector::MoveCameraTo(const FTransform& Pose, float BlendTime)
 // Move and attach the camera to
 void ASLVizCameraDirector::AttachCameraTo(AActor* Actor, FName SocketName, float BlendTime)
 {
+	// Manual movements override the camera path
+	ClearCameraPath();
+
 	// Remove any previous attachments
 	DetachCamera();
 
@@ -112,6 +127,62 @@ void ASLVizCameraDirector::DetachCamera()
 	ActivePawn->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
 }
 
+// Drive the camera along the precomputed path with the episode time of the manager (replaces any active movement)
+void ASLVizCameraDirector::SetCameraPath(const FSLVizCameraPath& Path, ASLVizEpisodeManager* EpisodeManager)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return;
+	}
+
+	if (!Path.IsValid() || !EpisodeManager)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s invalid path or episode manager, the path is not set.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return;
+	}
+
+	ClearCameraPath();
+	DetachCamera();
+	StopBlendMovement();
+
+	CameraPath = Path;
+	CameraPathTimeSource = EpisodeManager;
+	bCameraPathActive = true;
+
+	// The episode time is advanced before the camera evaluates it, this way the camera never lags a frame behind
+	AddTickPrerequisiteActor(EpisodeManager);
+	SetActorTickEnabled(true);
+	UpdateCameraPath();
+}
+
+// Stop following the camera path (the camera keeps its current pose)
+void ASLVizCameraDirector::ClearCameraPath()
+{
+	if (!bCameraPathActive)
+	{
+		return;
+	}
+
+	if (ASLVizEpisodeManager* EpisodeManager = CameraPathTimeSource.Get())
+	{
+		RemoveTickPrerequisiteActor(EpisodeManager);
+	}
+	if (CameraPath.EvalFieldOfView(0.f) > 0.f)
+	{
+		APlayerController* PC = GetWorld()->GetFirstPlayerController();
+		if (PC && PC->PlayerCameraManager)
+		{
+			PC->PlayerCameraManager->UnlockFOV();
+		}
+	}
+
+	bCameraPathActive = false;
+	CameraPath.Reset();
+	CameraPathTimeSource.Reset();
+	SetActorTickEnabled(false);
+}
+
 
 // Start blend movement (set target and enable tick)
 void ASLVizCameraDirector::StartBlendMovement(const FTransform& Target, float BlendTime)
@@ -136,3 +207,29 @@ void ASLVizCameraDirector::UpdateBlendMovement(float DeltaTime)
 	StopBlendMovement();
 }
 
+// Set the camera to the path pose of the current episode time
+void ASLVizCameraDirector::UpdateCameraPath()
+{
+	ASLVizEpisodeManager* EpisodeManager = CameraPathTimeSource.Get();
+	if (!EpisodeManager)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s episode manager is not valid anymore, clearing the camera path.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		ClearCameraPath();
+		return;
+	}
+
+	// The pose only depends on the episode time, pauses, seeks and speed changes need no extra handling
+	const float Time = EpisodeManager->GetReplayTime();
+	ActivePawn->SetActorTransform(CameraPath.Eval(Time));
+
+	const float FieldOfView = CameraPath.EvalFieldOfView(Time);
+	if (FieldOfView > 0.f)
+	{
+		APlayerController* PC = GetWorld()->GetFirstPlayerController();
+		if (PC && PC->PlayerCameraManager)
+		{
+			PC->PlayerCameraManager->SetFOV(FieldOfView);
+		}
+	}
+}
+
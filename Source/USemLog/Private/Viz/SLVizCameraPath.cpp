@@ -0,0 +1,144 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Viz/SLVizCameraPath.h"
+
+// Build the curves from the keyframes (sorted by time, returns false if there are no keyframes)
+bool FSLVizCameraPath::Build(const TArray<FSLVizCameraKeyframe>& InKeyframes)
+{
+	Reset();
+	if (InKeyframes.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d No keyframes given, the camera path is empty.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	Keyframes = InKeyframes;
+	Keyframes.StableSort([](const FSLVizCameraKeyframe& A, const FSLVizCameraKeyframe& B) { return A.Time < B.Time; });
+
+	// The field of view is only animated if every keyframe sets it
+	const bool bHasFieldOfView = !Keyframes.ContainsByPredicate(
+		[](const FSLVizCameraKeyframe& K) { return K.FieldOfView <= 0.f; });
+
+	FQuat PrevQuat = Keyframes[0].Pose.GetRotation();
+	for (const auto& Keyframe : Keyframes)
+	{
+		// Keep the rotations in the same hemisphere, otherwise the spline takes the long way around
+		FQuat Quat = Keyframe.Pose.GetRotation().GetNormalized();
+		if ((PrevQuat | Quat) < 0.f)
+		{
+			Quat = Quat * -1.f;
+		}
+		PrevQuat = Quat;
+
+		int32 PointIdx = LocationCurve.AddPoint(Keyframe.Time, Keyframe.Pose.GetLocation());
+		LocationCurve.Points[PointIdx].InterpMode = CIM_CurveAutoClamped;
+
+		PointIdx = RotationCurve.AddPoint(Keyframe.Time, Quat);
+		RotationCurve.Points[PointIdx].InterpMode = CIM_CurveAutoClamped;
+
+		if (bHasFieldOfView)
+		{
+			PointIdx = FieldOfViewCurve.AddPoint(Keyframe.Time, Keyframe.FieldOfView);
+			FieldOfViewCurve.Points[PointIdx].InterpMode = CIM_CurveAutoClamped;
+		}
+	}
+	LocationCurve.AutoSetTangents();
+	RotationCurve.AutoSetTangents();
+	FieldOfViewCurve.AutoSetTangents();
+
+	StartTime = Keyframes[0].Time;
+	EndTime = Keyframes.Last().Time;
+	return true;
+}
+
+// Build the path framing the targets, the locations are given for every sample time (returns false on invalid input)
+bool FSLVizCameraPath::BuildFraming(const TArray<float>& SampleTimes, const TArray<TArray<FVector>>& TargetLocations,
+	const FSLVizCameraFramingParams& Params)
+{
+	const int32 NumSamples = SampleTimes.Num();
+	if (NumSamples == 0 || TargetLocations.Num() != NumSamples)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Invalid samples (times=%d, locations=%d), the camera path is empty.."),
+			*FString(__FUNCTION__), __LINE__, NumSamples, TargetLocations.Num());
+		Reset();
+		return false;
+	}
+
+	// Bounding sphere of the targets in every sample
+	TArray<FVector> Centers;
+	TArray<float> Radii;
+	Centers.Reserve(NumSamples);
+	Radii.Reserve(NumSamples);
+	for (const auto& Locations : TargetLocations)
+	{
+		const FBox Box(Locations);
+		Centers.Add(Box.IsValid ? Box.GetCenter() : (Centers.Num() > 0 ? Centers.Last() : FVector::ZeroVector));
+		Radii.Add(Box.IsValid ? Box.GetExtent().Size() : (Radii.Num() > 0 ? Radii.Last() : 0.f));
+	}
+
+	// Moving average over the window removes the jitter of the recorded motion
+	const int32 HalfWindow = FMath::Max(Params.SmoothingWindow, 0);
+	const float HalfFov = FMath::DegreesToRadians(FMath::Clamp(Params.FieldOfView, 5.f, 170.f) * 0.5f);
+	const FVector ViewDir = Params.ViewRotation.Vector();
+	const FQuat ViewQuat = Params.ViewRotation.Quaternion();
+
+	TArray<FSLVizCameraKeyframe> FramingKeyframes;
+	FramingKeyframes.Reserve(NumSamples);
+	for (int32 SampleIdx = 0; SampleIdx < NumSamples; ++SampleIdx)
+	{
+		const int32 First = FMath::Max(SampleIdx - HalfWindow, 0);
+		const int32 Last = FMath::Min(SampleIdx + HalfWindow, NumSamples - 1);
+		FVector Center = FVector::ZeroVector;
+		float Radius = 0.f;
+		for (int32 Idx = First; Idx <= Last; ++Idx)
+		{
+			Center += Centers[Idx];
+			Radius += Radii[Idx];
+		}
+		const float InvNum = 1.f / (Last - First + 1);
+		Center *= InvNum;
+		Radius *= InvNum;
+
+		const float Distance = FMath::Max(Params.MinDistance, Radius * Params.DistanceScale / FMath::Tan(HalfFov));
+
+		FSLVizCameraKeyframe& Keyframe = FramingKeyframes.AddDefaulted_GetRef();
+		Keyframe.Time = SampleTimes[SampleIdx];
+		Keyframe.Pose = FTransform(ViewQuat, Center - ViewDir * Distance);
+		Keyframe.FieldOfView = Params.FieldOfView;
+	}
+	return Build(FramingKeyframes);
+}
+
+// Evaluate the camera pose at the given time (clamped to the path time range)
+FTransform FSLVizCameraPath::Eval(float Time) const
+{
+	if (!IsValid())
+	{
+		return FTransform::Identity;
+	}
+	const float ClampedTime = FMath::Clamp(Time, StartTime, EndTime);
+	return FTransform(RotationCurve.Eval(ClampedTime, FQuat::Identity).GetNormalized(),
+		LocationCurve.Eval(ClampedTime, FVector::ZeroVector));
+}
+
+// Evaluate the field of view at the given time (negative if the path does not change the field of view)
+float FSLVizCameraPath::EvalFieldOfView(float Time) const
+{
+	if (FieldOfViewCurve.Points.Num() == 0)
+	{
+		return -1.f;
+	}
+	return FieldOfViewCurve.Eval(FMath::Clamp(Time, StartTime, EndTime), -1.f);
+}
+
+// Clear the curves
+void FSLVizCameraPath::Reset()
+{
+	Keyframes.Empty();
+	LocationCurve.Reset();
+	RotationCurve.Reset();
+	FieldOfViewCurve.Reset();
+	StartTime = 0.f;
+	EndTime = 0.f;
+}
@@ -0,0 +1,192 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Viz/SLVizEpisodeCache.h"
+#include "Viz/SLVizEpisodeUtils.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+// Ctor
+FSLVizEpisodeCache::FSLVizEpisodeCache()
+{
+	MaxBytes = 0;
+	bSpillToDisk = false;
+	SpillDir = FPaths::ProjectDir() + TEXT("/SL/EpisodeCache/Spill/");
+	IndividualManager = nullptr;
+}
+
+// Set the memory budget in bytes (0 for unlimited), and if the evicted episodes are written to disk
+void FSLVizEpisodeCache::SetBudget(int64 InMaxBytes, bool bInSpillToDisk)
+{
+	MaxBytes = InMaxBytes;
+	bSpillToDisk = bInSpillToDisk;
+	EnforceBudget(FString());
+}
+
+// Add the episode, evicts the least recently used ones if the budget is exceeded
+void FSLVizEpisodeCache::Add(const FString& Id, FSLVizEpisodeData&& InEpisodeData)
+{
+	Remove(Id);
+	EpisodeBytes.Add(Id, InEpisodeData.GetAllocatedSize());
+	Episodes.Add(Id, MakeShared<FSLVizEpisodeData>(MoveTemp(InEpisodeData)));
+	UsageOrder.Add(Id);
+	UpdateMemoryStats();
+	EnforceBudget(Id);
+}
+
+// Get the episode (reloads it if it was spilled), marks it as the most recently used (nullptr if not available)
+const FSLVizEpisodeData* FSLVizEpisodeCache::Find(const FString& Id)
+{
+	return FindShared(Id).Get();
+}
+
+// Get the episode shared with the cache (reloads it if it was spilled), stays valid after an eviction (nullptr if not available)
+TSharedPtr<const FSLVizEpisodeData> FSLVizEpisodeCache::FindShared(const FString& Id)
+{
+	if (const TSharedPtr<const FSLVizEpisodeData>* EpisodeData = Episodes.Find(Id))
+	{
+		Stats.Hits++;
+		Touch(Id);
+		return *EpisodeData;
+	}
+
+	Stats.Misses++;
+	if (SpilledEpisodes.Contains(Id))
+	{
+		if (!IndividualManager)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d No individual manager set, cannot reload episode %s.."), *FString(__FUNCTION__), __LINE__, *Id);
+			return nullptr;
+		}
+
+		FSLVizEpisodeData EpisodeData;
+		const FString SpillPath = GetSpillPath(Id);
+		if (FSLVizEpisodeUtils::LoadEpisodeData(IndividualManager, SpillPath, EpisodeData))
+		{
+			Stats.Reloads++;
+			SpilledEpisodes.Remove(Id);
+			IFileManager::Get().Delete(*SpillPath);
+			Add(Id, MoveTemp(EpisodeData));
+			UE_LOG(LogTemp, Log, TEXT("%s::%d Reloaded episode %s from %s.."), *FString(__FUNCTION__), __LINE__, *Id, *SpillPath);
+			return Episodes.FindChecked(Id);
+		}
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not reload episode %s from %s.."), *FString(__FUNCTION__), __LINE__, *Id, *SpillPath);
+		SpilledEpisodes.Remove(Id);
+		UpdateMemoryStats();
+	}
+	return nullptr;
+}
+
+// Remove the episode from memory and disk
+void FSLVizEpisodeCache::Remove(const FString& Id)
+{
+	Episodes.Remove(Id);
+	EpisodeBytes.Remove(Id);
+	UsageOrder.Remove(Id);
+	if (SpilledEpisodes.Remove(Id) > 0)
+	{
+		IFileManager::Get().Delete(*GetSpillPath(Id));
+	}
+	UpdateMemoryStats();
+}
+
+// Remove all the episodes from memory and disk
+void FSLVizEpisodeCache::Empty()
+{
+	for (const auto& Id : SpilledEpisodes)
+	{
+		IFileManager::Get().Delete(*GetSpillPath(Id));
+	}
+	SpilledEpisodes.Empty();
+	Episodes.Empty();
+	EpisodeBytes.Empty();
+	UsageOrder.Empty();
+	UpdateMemoryStats();
+}
+
+// Log the cache statistics
+void FSLVizEpisodeCache::LogStats() const
+{
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Episode cache: in_memory=%d; spilled=%d; size=%.2fMB (peak=%.2fMB, budget=%.2fMB); hits=%d; misses=%d; evictions=%d; spills=%d; reloads=%d;"),
+		*FString(__FUNCTION__), __LINE__, Stats.NumInMemory, Stats.NumSpilled,
+		Stats.CurrentBytes / (1024.f * 1024.f), Stats.PeakBytes / (1024.f * 1024.f), MaxBytes / (1024.f * 1024.f),
+		Stats.Hits, Stats.Misses, Stats.Evictions, Stats.Spills, Stats.Reloads);
+}
+
+// Mark the episode as the most recently used
+void FSLVizEpisodeCache::Touch(const FString& Id)
+{
+	UsageOrder.Remove(Id);
+	UsageOrder.Add(Id);
+}
+
+// Evict the least recently used episodes until the budget is satisfied (the given episode is kept)
+void FSLVizEpisodeCache::EnforceBudget(const FString& KeepId)
+{
+	if (MaxBytes <= 0)
+	{
+		return;
+	}
+
+	int32 OrderIdx = 0;
+	while (Stats.CurrentBytes > MaxBytes && OrderIdx < UsageOrder.Num())
+	{
+		if (UsageOrder[OrderIdx].Equals(KeepId))
+		{
+			OrderIdx++;
+			continue;
+		}
+
+		// Evict removes the id from the usage order, the reference into the array would dangle
+		const FString EvictId = UsageOrder[OrderIdx];
+		Evict(EvictId);
+	}
+
+	if (Stats.CurrentBytes > MaxBytes)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Episode %s alone (%.2fMB) exceeds the cache budget (%.2fMB).."),
+			*FString(__FUNCTION__), __LINE__, *KeepId, Stats.CurrentBytes / (1024.f * 1024.f), MaxBytes / (1024.f * 1024.f));
+	}
+}
+
+// Evict the episode from memory (spill it to disk if enabled)
+void FSLVizEpisodeCache::Evict(const FString& Id)
+{
+	if (bSpillToDisk)
+	{
+		const FString SpillPath = GetSpillPath(Id);
+		if (FSLVizEpisodeUtils::SaveEpisodeData(*Episodes[Id], SpillPath))
+		{
+			SpilledEpisodes.Add(Id);
+			Stats.Spills++;
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Evicted episode %s (%.2fMB, spilled=%d).."), *FString(__FUNCTION__), __LINE__,
+		*Id, EpisodeBytes[Id] / (1024.f * 1024.f), SpilledEpisodes.Contains(Id));
+
+	Episodes.Remove(Id);
+	EpisodeBytes.Remove(Id);
+	UsageOrder.Remove(Id);
+	Stats.Evictions++;
+	UpdateMemoryStats();
+}
+
+// Get the spill file path of the episode
+FString FSLVizEpisodeCache::GetSpillPath(const FString& Id) const
+{
+	return SpillDir + FPaths::MakeValidFileName(Id) + TEXT(".slep");
+}
+
+// Update the memory statistics
+void FSLVizEpisodeCache::UpdateMemoryStats()
+{
+	Stats.CurrentBytes = 0;
+	for (const auto& Pair : EpisodeBytes)
+	{
+		Stats.CurrentBytes += Pair.Value;
+	}
+	Stats.PeakBytes = FMath::Max(Stats.PeakBytes, Stats.CurrentBytes);
+	Stats.NumInMemory = Episodes.Num();
+	Stats.NumSpilled = SpilledEpisodes.Num();
+}
@@ -0,0 +1,209 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Viz/SLVizEpisodeDiskCache.h"
+#include "Viz/SLVizEpisodeUtils.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/BufferReader.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+// Ctor
+FSLVizEpisodeDiskCache::FSLVizEpisodeDiskCache()
+{
+	bEnabled = true;
+	MaxBytes = 0;
+	CacheDir = FPaths::ProjectDir() + TEXT("/SL/EpisodeCache/Disk/");
+}
+
+// Read the cached episode if it matches the metadata, the actors and bones are not resolved (safe to call from worker threads)
+bool FSLVizEpisodeDiskCache::Read(const FString& TaskId, const FString& EpisodeId, const FSLMongoEpisodeMetadata& Metadata,
+	FSLVizEpisodeData& OutVizEpisodeData) const
+{
+	if (!bEnabled || !Metadata.IsValid())
+	{
+		return false;
+	}
+
+	const FString Path = GetPath(TaskId, EpisodeId);
+	if (!FPaths::FileExists(Path))
+	{
+		return false;
+	}
+
+	double ExecBegin = FPlatformTime::Seconds();
+	bool bSuccess = false;
+
+	// Read through a mapped view of the file, fall back to a regular read if mapping is not supported
+	TUniquePtr<IMappedFileHandle> MappedFile(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+	TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile ? MappedFile->MapRegion(0, MAX_int64, true) : nullptr);
+	if (MappedRegion)
+	{
+		FBufferReader Reader((void*)MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize(), false);
+		bSuccess = ReadFromArchive(Reader, TaskId, EpisodeId, Metadata, OutVizEpisodeData);
+	}
+	else
+	{
+		TArray<uint8> Bytes;
+		if (FFileHelper::LoadFileToArray(Bytes, *Path, FILEREAD_Silent))
+		{
+			FMemoryReader Reader(Bytes);
+			bSuccess = ReadFromArchive(Reader, TaskId, EpisodeId, Metadata, OutVizEpisodeData);
+		}
+	}
+	MappedRegion.Reset();
+	MappedFile.Reset();
+
+	if (bSuccess)
+	{
+		// The timestamp orders the files for the size limit eviction
+		IFileManager::Get().SetTimeStamp(*Path, FDateTime::UtcNow());
+		UE_LOG(LogTemp, Log, TEXT("%s::%d Read episode %s::%s from the disk cache in [%f] seconds.."),
+			*FString(__FUNCTION__), __LINE__, *TaskId, *EpisodeId, FPlatformTime::Seconds() - ExecBegin);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d Disk cache entry of episode %s::%s is stale or unreadable.."),
+			*FString(__FUNCTION__), __LINE__, *TaskId, *EpisodeId);
+	}
+	return bSuccess;
+}
+
+// Write the episode with its metadata (safe to call from worker threads)
+bool FSLVizEpisodeDiskCache::Write(const FString& TaskId, const FString& EpisodeId, const FSLMongoEpisodeMetadata& Metadata,
+	const FSLVizEpisodeData& InVizEpisodeData) const
+{
+	if (!bEnabled || !Metadata.IsValid())
+	{
+		return false;
+	}
+
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+
+	// The archive operators are non-const, the writer does not modify the data
+	uint32 Magic = FileMagic;
+	int32 Version = FSLVizEpisodeUtils::EpisodeDataFileVersion;
+	FString Task = TaskId;
+	FString Episode = EpisodeId;
+	FSLMongoEpisodeMetadata MetadataCopy = Metadata;
+	Writer << Magic;
+	Writer << Version;
+	Writer << Task;
+	Writer << Episode;
+	Writer << MetadataCopy;
+	FSLVizEpisodeUtils::SerializeEpisodeData(Writer, const_cast<FSLVizEpisodeData&>(InVizEpisodeData));
+
+	// Write to a uniquely named temporary file first, concurrent writers of the same episode never share it, and the
+	// move only replaces the entry once the file is complete (an interrupted write leaves no partial entry)
+	const FString Path = GetPath(TaskId, EpisodeId);
+	const FString TmpPath = FPaths::CreateTempFilename(*FPaths::GetPath(Path), *EpisodeId, TEXT(".tmp"));
+	if (!FFileHelper::SaveArrayToFile(Bytes, *TmpPath) || !IFileManager::Get().Move(*Path, *TmpPath, true, true))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not write episode %s::%s to %s.."),
+			*FString(__FUNCTION__), __LINE__, *TaskId, *EpisodeId, *Path);
+		IFileManager::Get().Delete(*TmpPath, false, true, true);
+		return false;
+	}
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Wrote episode %s::%s to the disk cache (%.2fMB).."),
+		*FString(__FUNCTION__), __LINE__, *TaskId, *EpisodeId, Bytes.Num() / (1024.f * 1024.f));
+	EnforceMaxBytes(Path);
+	return true;
+}
+
+// Remove the least recently used files until the cache fits its max size (the given file is kept)
+void FSLVizEpisodeDiskCache::EnforceMaxBytes(const FString& KeepPath) const
+{
+	if (MaxBytes <= 0)
+	{
+		return;
+	}
+
+	// Size and last read or write time of every cache file
+	TArray<TPair<FDateTime, FString>> Files;
+	int64 TotalBytes = 0;
+	FPlatformFileManager::Get().GetPlatformFile().IterateDirectoryStatRecursively(*CacheDir,
+		[&Files, &TotalBytes](const TCHAR* FilenameOrDirectory, const FFileStatData& StatData)
+	{
+		if (!StatData.bIsDirectory && FPaths::GetExtension(FilenameOrDirectory) == TEXT("slep"))
+		{
+			Files.Emplace(StatData.ModificationTime, FilenameOrDirectory);
+			TotalBytes += StatData.FileSize;
+		}
+		return true;
+	});
+	if (TotalBytes <= MaxBytes)
+	{
+		return;
+	}
+
+	// Oldest first, a file being read or written by another worker fails to delete and is skipped
+	Files.Sort([](const TPair<FDateTime, FString>& A, const TPair<FDateTime, FString>& B) { return A.Key < B.Key; });
+	int32 NumRemoved = 0;
+	for (const auto& File : Files)
+	{
+		if (TotalBytes <= MaxBytes)
+		{
+			break;
+		}
+		if (FPaths::IsSamePath(File.Value, KeepPath))
+		{
+			continue;
+		}
+		const int64 FileBytes = IFileManager::Get().FileSize(*File.Value);
+		if (IFileManager::Get().Delete(*File.Value, false, true, true))
+		{
+			TotalBytes -= FMath::Max<int64>(FileBytes, 0);
+			NumRemoved++;
+		}
+	}
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Removed %d episodes from the disk cache, %.2fMB of %.2fMB used.."),
+		*FString(__FUNCTION__), __LINE__, NumRemoved, TotalBytes / (1024.f * 1024.f), MaxBytes / (1024.f * 1024.f));
+}
+
+// Remove the cached episode
+void FSLVizEpisodeDiskCache::Remove(const FString& TaskId, const FString& EpisodeId) const
+{
+	IFileManager::Get().Delete(*GetPath(TaskId, EpisodeId), false, true, true);
+}
+
+// Get the cache file path of the episode
+FString FSLVizEpisodeDiskCache::GetPath(const FString& TaskId, const FString& EpisodeId) const
+{
+	return CacheDir + TaskId + TEXT("/") + EpisodeId + TEXT(".slep");
+}
+
+// Read the header and the episode data from the archive (returns false on mismatch)
+bool FSLVizEpisodeDiskCache::ReadFromArchive(FArchive& Ar, const FString& TaskId, const FString& EpisodeId,
+	const FSLMongoEpisodeMetadata& Metadata, FSLVizEpisodeData& OutVizEpisodeData) const
+{
+	uint32 Magic = 0;
+	int32 Version = INDEX_NONE;
+	FString Task;
+	FString Episode;
+	FSLMongoEpisodeMetadata CachedMetadata;
+	Ar << Magic;
+	Ar << Version;
+	if (Ar.IsError() || Magic != FileMagic || Version != FSLVizEpisodeUtils::EpisodeDataFileVersion)
+	{
+		return false;
+	}
+	if (FSLVizEpisodeUtils::IsArrayNumInBounds(Ar, sizeof(ANSICHAR)))
+	{
+		Ar << Task;
+	}
+	if (FSLVizEpisodeUtils::IsArrayNumInBounds(Ar, sizeof(ANSICHAR)))
+	{
+		Ar << Episode;
+	}
+	Ar << CachedMetadata;
+	if (Ar.IsError() || !Task.Equals(TaskId) || !Episode.Equals(EpisodeId) || !CachedMetadata.Matches(Metadata))
+	{
+		return false;
+	}
+	return FSLVizEpisodeUtils::SerializeEpisodeData(Ar, OutVizEpisodeData);
+}
@@ -16,6 +16,9 @@ ASLVizEpisodeManager::ASLVizEpisodeManager()
 	bEpisodeLoaded = false;
 	bLoopReplay = false;
 	bReplayRunning = false;
+	bClockReplay = false;
+	bInterpolateReplay = false;
+	FixedStepTickInterval = 0.f;
 
 	EpisodeDefaultUpdateRate = 0.f;
 	ActiveFrameIndex = INDEX_NONE;
@@ -34,6 +37,16 @@ void ASLVizEpisodeManager::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	// The clock handles the looping, the tick rate only affects the smoothness
+	if (bClockReplay)
+	{
+		if (!ApplyClockTime())
+		{
+			StopReplay();
+		}
+		return;
+	}
+
 	if (!ApplyNextFrameChanges())
 	{
 		if (bLoopReplay)
@@ -91,6 +104,15 @@ void ASLVizEpisodeManager::LoadEpisode(const FSLVizEpisodeData& InEpisodeData)
 	// Set the episode data
 	EpisodeData = InEpisodeData;
 
+	// Cache the actor mobilities and the bone mappings once per episode
+	MovableActors.Init(false, EpisodeData.Actors.Num());
+	for (int32 ActorIdx = 0; ActorIdx < EpisodeData.Actors.Num(); ++ActorIdx)
+	{
+		// todo, static components can be ignored (might make sense to remove them form the episode data)
+		MovableActors[ActorIdx] = EpisodeData.Actors[ActorIdx]->GetRootComponent()->Mobility != EComponentMobility::Static;
+	}
+	SkeletalPoseApplier.Init(EpisodeData.Bones);
+
 	// Calculate a default update rate  
 	CalcRealtimeAproxUpdateRateValue(256);
 
@@ -106,6 +128,12 @@ void ASLVizEpisodeManager::ClearEpisode()
 {
 	StopReplay();
 	EpisodeData.Clear();
+	ActorState.Empty();
+	BoneState.Empty();
+	MovableActors.Empty();
+	SkeletalPoseApplier.Reset();
+	InterpolatedActors.Empty();
+	InterpolatedMeshes.Empty();
 	ActiveFrameIndex = INDEX_NONE;
 	ReplayFirstFrameIndex = INDEX_NONE;
 	ReplayLastFrameIndex = INDEX_NONE;
@@ -129,14 +157,21 @@ bool ASLVizEpisodeManager::GotoFrame(int32 FrameIndex)
 		return false;
 	}
 
-	if(!EpisodeData.FullFrames.IsValidIndex(FrameIndex))
+	if(!EpisodeData.Timestamps.IsValidIndex(FrameIndex))
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d Frame index is not valid, this should not happen.."), *FString(__FUNCTION__), __LINE__);
 		return false;
 	}
 
+	// Seek the nearest keyframe and roll the changes forward (overwrites any interpolated poses)
 	ActiveFrameIndex = FrameIndex;
-	ApplyPoses(EpisodeData.FullFrames[FrameIndex]);
+	EpisodeData.GetStateAt(FrameIndex, ActorState, BoneState);
+	ApplyPoses();
+	InterpolatedActors.Reset();
+	InterpolatedMeshes.Init(false, SkeletalPoseApplier.NumMeshes());
+
+	// Keep the clock on the shown frame, paused or running replays continue from here
+	ReplayClock.SetTime(EpisodeData.Timestamps[FrameIndex]);
 
 	//UE_LOG(LogTemp, Log, TEXT("%s::%d Applied poses from frame %d.."), *FString(__FUNCTION__), __LINE__, ActiveFrameIndex);
 	return true;
@@ -145,7 +180,13 @@ bool ASLVizEpisodeManager::GotoFrame(int32 FrameIndex)
 // Set visual world as in the given timestamp (binary search for nearest index)
 bool ASLVizEpisodeManager::GotoFrame(float Timestamp)
 {
-	return GotoFrame(FSLVizEpisodeUtils::BinarySearchLessEqual(EpisodeData.Timestamps, Timestamp));
+	if (GotoFrame(FSLVizEpisodeUtils::BinarySearchLessEqual(EpisodeData.Timestamps, Timestamp)))
+	{
+		// The requested time can lie between two frames
+		ReplayClock.SetTime(FMath::Clamp(Timestamp, EpisodeData.Timestamps[0], EpisodeData.Timestamps.Last()));
+		return true;
+	}
+	return false;
 }
 
 // Play episode with the given parameters
@@ -178,13 +219,31 @@ bool ASLVizEpisodeManager::Play(const FSLVizEpisodePlayParams& PlayParams)
 	// Should the replay be looped
 	bLoopReplay = PlayParams.bLoop;
 
+	// Follow the wall time with the given speed, the tick rate only affects the smoothness
+	bClockReplay = !PlayParams.bFixedStep;
+	if (bClockReplay)
+	{
+		ReplayLastFrameIndex = FMath::Clamp(ReplayLastFrameIndex, ReplayFirstFrameIndex, EpisodeData.Timestamps.Num() - 1);
+		bInterpolateReplay = PlayParams.bInterpolate;
+		ReplayClock.Start(EpisodeData.Timestamps[ReplayFirstFrameIndex], EpisodeData.Timestamps[ReplayLastFrameIndex],
+			PlayParams.Speed, PlayParams.bLoop);
+		FixedStepTickInterval = GetActorTickInterval();
+		SetActorTickInterval(0.f);
+		GotoFrame(PlayParams.Speed < 0.f ? ReplayLastFrameIndex : ReplayFirstFrameIndex);
+		StartReplay();
+		return true;
+	}
+
+	// Step with the given update rate, or with the average one of the episode
+	SetActorTickInterval(PlayParams.UpdateRate > 0.f ? PlayParams.UpdateRate : EpisodeDefaultUpdateRate);
+
 	// Goto first frame
 	GotoFrame(ReplayFirstFrameIndex);
 
 	// Start playing the frames
 	StartReplay();
 
-	return false;
+	return true;
 }
 
 // Play whole episode
@@ -203,6 +262,7 @@ bool ASLVizEpisodeManager::PlayEpisode()
 	}
 
 	// Set replay flags
+	bClockReplay = false;
 	ReplayFirstFrameIndex = 0;
 	ReplayLastFrameIndex = EpisodeData.Timestamps.Num();
 
@@ -225,6 +285,7 @@ bool ASLVizEpisodeManager::PlayFrames(int32 FirstFrame, int32 LastFrame)
 		return false;
 	}
 	// Set replay flags
+	bClockReplay = false;
 	ReplayFirstFrameIndex = FirstFrame;
 	ReplayLastFrameIndex = LastFrame;
 
@@ -265,6 +326,12 @@ void ASLVizEpisodeManager::SetPauseReplay(bool bPause)
 	{
 		SetActorTickEnabled(!bPause);
 		bReplayRunning = !bPause;
+
+		// Do not count the paused time
+		if (!bPause)
+		{
+			ReplayClock.Resume();
+		}
 	}
 }
 
@@ -275,12 +342,93 @@ void ASLVizEpisodeManager::StopReplay()
 	{
 		SetActorTickEnabled(false);
 		bReplayRunning = false;
+		if (bClockReplay)
+		{
+			// Clock replays tick every frame, the fixed step replays use the previous update rate
+			SetActorTickInterval(FixedStepTickInterval);
+			bClockReplay = false;
+		}
 		GotoFrame(0);
 		ReplayFirstFrameIndex = INDEX_NONE;
 		ReplayLastFrameIndex = INDEX_NONE;
 	}
 }
 
+// Get the current episode time (replay clock time, or the timestamp of the active frame)
+float ASLVizEpisodeManager::GetReplayTime() const
+{
+	// The clock follows the seeks as well, paused replays report the time they were moved to
+	if (bClockReplay)
+	{
+		return ReplayClock.GetTime();
+	}
+	return EpisodeData.Timestamps.IsValidIndex(ActiveFrameIndex) ? EpisodeData.Timestamps[ActiveFrameIndex] : 0.f;
+}
+
+// Sample the locations of the episode actors every interval of episode time (returns false if none of the actors is in the episode)
+bool ASLVizEpisodeManager::SampleActorLocations(const TArray<AActor*>& InActors, float SampleInterval,
+	TArray<float>& OutTimes, TArray<TArray<FVector>>& OutLocations) const
+{
+	OutTimes.Reset();
+	OutLocations.Reset();
+	if (!bEpisodeLoaded || !EpisodeData.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d No valid episode is loaded.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	// Column indexes of the sampled actors
+	TArray<int32> Columns;
+	for (AActor* Actor : InActors)
+	{
+		const int32 ActorIdx = EpisodeData.Actors.IndexOfByKey(Actor);
+		if (ActorIdx != INDEX_NONE)
+		{
+			Columns.Add(ActorIdx);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not part of the episode, skipping.."),
+				*FString(__FUNCTION__), __LINE__, Actor ? *Actor->GetName() : TEXT("NONE"));
+		}
+	}
+	if (Columns.Num() == 0)
+	{
+		return false;
+	}
+
+	// Roll the actor changes forward once through the whole episode (the bone changes are not needed)
+	const TArray<float>& Timestamps = EpisodeData.Timestamps;
+	const float Interval = FMath::Max(SampleInterval, KINDA_SMALL_NUMBER);
+	TArray<FTransform> Poses = EpisodeData.ActorKeyframes[0];
+	float NextSampleTime = Timestamps[0];
+	for (int32 FrameIdx = 0; FrameIdx < Timestamps.Num(); ++FrameIdx)
+	{
+		if (FrameIdx > 0)
+		{
+			const FSLVizEpisodeChangeList& ActorChanges = EpisodeData.ActorChanges;
+			for (int32 ChangeIdx = ActorChanges.Begin(FrameIdx); ChangeIdx < ActorChanges.End(FrameIdx); ++ChangeIdx)
+			{
+				Poses[ActorChanges.Indexes[ChangeIdx]] = ActorChanges.Poses[ChangeIdx];
+			}
+		}
+
+		// The last frame is always sampled so the path covers the whole episode
+		if (Timestamps[FrameIdx] >= NextSampleTime || FrameIdx == Timestamps.Num() - 1)
+		{
+			OutTimes.Add(Timestamps[FrameIdx]);
+			TArray<FVector>& Locations = OutLocations.AddDefaulted_GetRef();
+			Locations.Reserve(Columns.Num());
+			for (const int32 ActorIdx : Columns)
+			{
+				Locations.Add(Poses[ActorIdx].GetLocation());
+			}
+			NextSampleTime = Timestamps[FrameIdx] + Interval;
+		}
+	}
+	return true;
+}
+
 //// Goto the next nth frame
 //void ASLVizEpisodeManager::Next(int32 StepSize, bool bLoop)
 //{	
@@ -477,25 +625,123 @@ bool ASLVizEpisodeManager::ApplyNextFrameChanges()
 	if (ActiveFrameIndex < ReplayLastFrameIndex)
 	{
 		ActiveFrameIndex++;
-		//if (EpisodeData.CompactFrames.IsValidIndex(ActiveFrameIndex))
-		if (EpisodeData.FullFrames.IsValidIndex(ActiveFrameIndex))
+		if (EpisodeData.Timestamps.IsValidIndex(ActiveFrameIndex))
 		{
-			//ApplyPoses(EpisodeData.CompactFrames[ActiveFrameIndex]);
-			ApplyPoses(EpisodeData.FullFrames[ActiveFrameIndex]);
+			// The previous frame is fully applied, only the changes need to be set
+			ApplyFrameChanges(ActiveFrameIndex);
 			return true;
 		}
 		else
 		{
-			//UE_LOG(LogTemp, Warning, TEXT("%s::%d ActiveFrameIndex=%d (Num=%d) is not valid, this should not happen.."),
-			//	*FString(__FUNCTION__), __LINE__, ActiveFrameIndex, EpisodeData.CompactFrames.Num());
 			UE_LOG(LogTemp, Warning, TEXT("%s::%d ActiveFrameIndex=%d (Num=%d) is not valid, this should not happen.."),
-				*FString(__FUNCTION__), __LINE__, ActiveFrameIndex, EpisodeData.FullFrames.Num());
+				*FString(__FUNCTION__), __LINE__, ActiveFrameIndex, EpisodeData.Timestamps.Num());
 			ActiveFrameIndex--;
 		}
 	}
 	return false;	
 }
 
+// Apply the state of the replay clock time (return false if the replay reached its end)
+bool ASLVizEpisodeManager::ApplyClockTime()
+{
+	const bool bClockRunning = ReplayClock.Advance();
+	const float Time = ReplayClock.GetTime();
+	const TArray<float>& Timestamps = EpisodeData.Timestamps;
+	const int32 TargetFrame = FMath::Clamp(FSLVizEpisodeUtils::BinarySearchLessEqual(Timestamps, Time),
+		ReplayFirstFrameIndex, ReplayLastFrameIndex);
+
+	// The poses interpolated in the last update have to be reset as well
+	TBitArray<> DirtyActors(false, EpisodeData.Actors.Num());
+	TBitArray<> DirtyMeshes = InterpolatedMeshes.Num() == SkeletalPoseApplier.NumMeshes()
+		? InterpolatedMeshes : TBitArray<>(false, SkeletalPoseApplier.NumMeshes());
+	for (const int32 ActorIdx : InterpolatedActors)
+	{
+		DirtyActors[ActorIdx] = true;
+	}
+	InterpolatedActors.Reset();
+	InterpolatedMeshes.Init(false, SkeletalPoseApplier.NumMeshes());
+
+	// Late updates jump straight to the target frame, the skipped frames are never applied to the world
+	SeekFrame(TargetFrame, DirtyActors, DirtyMeshes);
+
+	// Blend towards the columns which change in the next recorded frame, the exact poses are restored after applying
+	TArray<TPair<int32, FTransform>> ExactActorPoses;
+	TArray<TPair<int32, FTransform>> ExactBonePoses;
+	const int32 NextFrame = TargetFrame + 1;
+	if (bInterpolateReplay && NextFrame <= ReplayLastFrameIndex && Timestamps[NextFrame] > Timestamps[TargetFrame])
+	{
+		const float Alpha = FMath::Clamp((Time - Timestamps[TargetFrame]) / (Timestamps[NextFrame] - Timestamps[TargetFrame]), 0.f, 1.f);
+		if (Alpha > 0.f)
+		{
+			const FSLVizEpisodeChangeList& ActorChanges = EpisodeData.ActorChanges;
+			for (int32 ChangeIdx = ActorChanges.Begin(NextFrame); ChangeIdx < ActorChanges.End(NextFrame); ++ChangeIdx)
+			{
+				const int32 ActorIdx = ActorChanges.Indexes[ChangeIdx];
+				if (MovableActors[ActorIdx])
+				{
+					ExactActorPoses.Emplace(ActorIdx, ActorState[ActorIdx]);
+					ActorState[ActorIdx].Blend(ExactActorPoses.Last().Value, ActorChanges.Poses[ChangeIdx], Alpha);
+					DirtyActors[ActorIdx] = true;
+					InterpolatedActors.Add(ActorIdx);
+				}
+			}
+
+			const FSLVizEpisodeChangeList& BoneChanges = EpisodeData.BoneChanges;
+			for (int32 ChangeIdx = BoneChanges.Begin(NextFrame); ChangeIdx < BoneChanges.End(NextFrame); ++ChangeIdx)
+			{
+				const int32 BoneIdx = BoneChanges.Indexes[ChangeIdx];
+				const int32 MeshIdx = SkeletalPoseApplier.GetMeshIndex(BoneIdx);
+				ExactBonePoses.Emplace(BoneIdx, BoneState[BoneIdx]);
+				BoneState[BoneIdx].Blend(ExactBonePoses.Last().Value, BoneChanges.Poses[ChangeIdx], Alpha);
+				DirtyMeshes[MeshIdx] = true;
+				InterpolatedMeshes[MeshIdx] = true;
+			}
+		}
+	}
+
+	// Every dirty actor and mesh is moved once per update, the attachments are updated when the batch ends
+	{
+		FSLVizScopedMovementBatch MovementBatch(ActorState.Num());
+		for (TConstSetBitIterator<> ActorItr(DirtyActors); ActorItr; ++ActorItr)
+		{
+			if (MovableActors[ActorItr.GetIndex()])
+			{
+				MoveActor(ActorItr.GetIndex(), MovementBatch);
+			}
+		}
+	}
+	SkeletalPoseApplier.Apply(BoneState, DirtyMeshes);
+
+	// Restore the exact state of the active frame
+	for (const auto& Pair : ExactActorPoses)
+	{
+		ActorState[Pair.Key] = Pair.Value;
+	}
+	for (const auto& Pair : ExactBonePoses)
+	{
+		BoneState[Pair.Key] = Pair.Value;
+	}
+	return bClockRunning;
+}
+
+// Move the active state to the given frame, marks the actors and meshes which need to be re-applied
+void ASLVizEpisodeManager::SeekFrame(int32 FrameIndex, TBitArray<>& OutDirtyActors, TBitArray<>& OutDirtyMeshes)
+{
+	if (FrameIndex == ActiveFrameIndex)
+	{
+		return;
+	}
+
+	// Only the columns which changed in between the two frames differ
+	TBitArray<> ChangedBones(false, BoneState.Num());
+	EpisodeData.SeekState(ActiveFrameIndex, FrameIndex, ActorState, BoneState, OutDirtyActors, ChangedBones);
+	for (TConstSetBitIterator<> BoneItr(ChangedBones); BoneItr; ++BoneItr)
+	{
+		OutDirtyMeshes[SkeletalPoseApplier.GetMeshIndex(BoneItr.GetIndex())] = true;
+	}
+	ActiveFrameIndex = FrameIndex;
+}
+
 // Start replay
 void ASLVizEpisodeManager::StartReplay()
 {
@@ -503,31 +749,58 @@ void ASLVizEpisodeManager::StartReplay()
 	SetActorTickEnabled(true);
 	bReplayRunning = true;}
 
-// Apply frame poses
-void ASLVizEpisodeManager::ApplyPoses(const FSLVizEpisodeFrameData& Frame)
+// Apply the full state of the active frame
+void ASLVizEpisodeManager::ApplyPoses()
 {
-	for (const auto& ActorPosePair : Frame.ActorPoses)
 	{
-		// todo, static components can be ignored (might make sense to remove them form the episode data)
-		if (ActorPosePair.Key->GetRootComponent()->Mobility != EComponentMobility::Static)
+		FSLVizScopedMovementBatch MovementBatch(ActorState.Num());
+		for (TConstSetBitIterator<> ActorItr(MovableActors); ActorItr; ++ActorItr)
 		{
-			ActorPosePair.Key->SetActorTransform(ActorPosePair.Value);
+			MoveActor(ActorItr.GetIndex(), MovementBatch);
 		}
 	}
 
-	// todo, without this multiple iteration the bones are weirdly offseted
-	for (int32 Idx = 0; Idx < 5; Idx++)
+	// The actors are moved first, the bone poses are converted relative to the mesh transforms
+	SkeletalPoseApplier.Apply(BoneState);
+}
+
+// Apply the changes of the given frame on top of the active state
+void ASLVizEpisodeManager::ApplyFrameChanges(int32 FrameIndex)
+{
+	const FSLVizEpisodeChangeList& ActorChanges = EpisodeData.ActorChanges;
 	{
-		for (const auto& PMCBonePosesPair : Frame.BonePoses)
+		FSLVizScopedMovementBatch MovementBatch(ActorChanges.End(FrameIndex) - ActorChanges.Begin(FrameIndex));
+		for (int32 ChangeIdx = ActorChanges.Begin(FrameIndex); ChangeIdx < ActorChanges.End(FrameIndex); ++ChangeIdx)
 		{
-			UPoseableMeshComponent* PMC = PMCBonePosesPair.Key;
-			for (const auto& BoneIndexPosePair : PMCBonePosesPair.Value)
+			const int32 ActorIdx = ActorChanges.Indexes[ChangeIdx];
+			ActorState[ActorIdx] = ActorChanges.Poses[ChangeIdx];
+			if (MovableActors[ActorIdx])
 			{
-				const FName BoneName = PMC->GetBoneName(BoneIndexPosePair.Key);
-				PMC->SetBoneTransformByName(BoneName, BoneIndexPosePair.Value, EBoneSpaces::WorldSpace);
+				MoveActor(ActorIdx, MovementBatch);
 			}
 		}
 	}
+
+	// The bones are set in world space, the children depend on the parents, so the whole mesh is re-applied if any of its bones changed
+	const FSLVizEpisodeChangeList& BoneChanges = EpisodeData.BoneChanges;
+	if (BoneChanges.Begin(FrameIndex) == BoneChanges.End(FrameIndex))
+	{
+		return;
+	}
+	TBitArray<> ChangedMeshes(false, SkeletalPoseApplier.NumMeshes());
+	for (int32 ChangeIdx = BoneChanges.Begin(FrameIndex); ChangeIdx < BoneChanges.End(FrameIndex); ++ChangeIdx)
+	{
+		const int32 BoneIdx = BoneChanges.Indexes[ChangeIdx];
+		BoneState[BoneIdx] = BoneChanges.Poses[ChangeIdx];
+		ChangedMeshes[SkeletalPoseApplier.GetMeshIndex(BoneIdx)] = true;
+	}
+	SkeletalPoseApplier.Apply(BoneState, ChangedMeshes);
+}
+
+// Move the actor to its active state pose, the attached components are updated when the batch ends
+void ASLVizEpisodeManager::MoveActor(int32 ActorIdx, FSLVizScopedMovementBatch& MovementBatch)
+{
+	MovementBatch.Move(EpisodeData.Actors[ActorIdx]->GetRootComponent(), ActorState[ActorIdx]);
 }
 
 // Calculate an approximation of the update rate value to coincide with realtime
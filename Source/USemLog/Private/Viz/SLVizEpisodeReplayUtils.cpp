@@ -3,6 +3,7 @@
 
 #include "Viz/SLVizEpisodeUtils.h"
 #include "Viz/SLVizEpisodeManager.h"
+#include "Mongo/SLMongoEpisodeData.h"
 
 #include "Individuals/SLIndividualManager.h"
 #include "Individuals/SLIndividualComponent.h"
@@ -11,7 +12,12 @@
 #include "Animation/SkeletalMeshActor.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Components/PoseableMeshComponent.h"
+#include "Components/SceneComponent.h"
 #include "EngineUtils.h"
+#include "Async/ParallelFor.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
 
 // IsA's
 //#include "Components/LightComponentBase.h"
@@ -35,6 +41,14 @@ void FSLVizEpisodeUtils::SetActorsAsVisualsOnly(UWorld* World)
 		// Make sure all actors have no physics, have no collisions and are movable
 		ActItr->DisableComponentsSimulatePhysics();
 		ActItr->SetActorEnableCollision(ECollisionEnabled::NoCollision);
+
+		// Replayed actors are teleported every frame, avoid any overlap updates
+		TInlineComponentArray<UPrimitiveComponent*> PrimitiveComponents;
+		ActItr->GetComponents(PrimitiveComponents);
+		for (auto PC : PrimitiveComponents)
+		{
+			PC->SetGenerateOverlapEvents(false);
+		}
 		if (ActItr->GetRootComponent())
 		{
 			// Ignore static actors to avoid breaking the static lighning
@@ -76,126 +90,202 @@ void FSLVizEpisodeUtils::AddPoseablMeshComponentsToSkeletalActors(UWorld* World)
 	}
 }
 
-// Build the full replay episode data from the mongo compact form
+// Build the replay episode data from the mongo columnar form (returns true if no errors occured)
 bool FSLVizEpisodeUtils::BuildEpisodeData(ASLIndividualManager* IndividualManager,
-	const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData,
+	const FSLMongoEpisodeData& InMongoEpisodeData,
 	FSLVizEpisodeData& OutVizEpisodeData)
 {
 	double ExecBegin = FPlatformTime::Seconds();
-	/* First frame (FullFrame -  contains all the data) */
-	// Process first frame (contains all individuals -- the rest of the frames contain only individuals that have moved)
-	FSLVizEpisodeFrameData FullFrameData;
 
-	// Iterate individuals with their poses
-	for (const auto& IndividualPosePair : InMongoEpisodeData[0].Value)
+	TArray<int32> ActorSources;
+	TArray<int32> BoneSources;
+	if (!BindEpisodeData(IndividualManager, InMongoEpisodeData, OutVizEpisodeData, ActorSources, BoneSources))
 	{
-		const FString IndividualId = IndividualPosePair.Key;
-		const FTransform IndividualPose = IndividualPosePair.Value;
+		return false;
+	}
+	FillEpisodeData(InMongoEpisodeData, ActorSources, BoneSources, OutVizEpisodeData);
 
-		if (auto Individual = IndividualManager->GetIndividual(IndividualId))
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: frames=%d, actors=%d, bones=%d, keyframes=%d, changes=%d, size=%.2fMB, total=[%f] seconds..;"),
+		*FString(__func__), __LINE__, OutVizEpisodeData.NumFrames(), OutVizEpisodeData.Actors.Num(), OutVizEpisodeData.Bones.Num(),
+		OutVizEpisodeData.ActorKeyframes.Num(), OutVizEpisodeData.ActorChanges.Num() + OutVizEpisodeData.BoneChanges.Num(),
+		OutVizEpisodeData.GetAllocatedSize() / (1024.f * 1024.f), FPlatformTime::Seconds() - ExecBegin);
+	return true;
+}
+
+// Resolve the individuals of the episode to their actors and bones (game thread), outputs the mongo column index of every actor and bone
+bool FSLVizEpisodeUtils::BindEpisodeData(ASLIndividualManager* IndividualManager,
+	const FSLMongoEpisodeData& InMongoEpisodeData,
+	FSLVizEpisodeData& OutVizEpisodeData,
+	TArray<int32>& OutActorSources, TArray<int32>& OutBoneSources)
+{
+	// Resolve every individual once, and store the mongo column index of the actors and bones
+	for (int32 IndividualIdx = 0; IndividualIdx < InMongoEpisodeData.NumIndividuals(); ++IndividualIdx)
+	{
+		const FString& IndividualId = InMongoEpisodeData.IndividualIds[IndividualIdx];
+		auto Individual = IndividualManager->GetIndividual(IndividualId);
+		if (!Individual)
 		{
-			if (Individual->IsA(USLRigidIndividual::StaticClass())
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find individual with id=%s, this should not happen, aborting.."),
+				*FString(__FUNCTION__), __LINE__, *IndividualId);
+			return false;
+		}
+
+		if (Individual->IsA(USLRigidIndividual::StaticClass())
 			|| Individual->IsA(USLSkeletalIndividual::StaticClass())
 			|| Individual->IsA(USLVirtualViewIndividual::StaticClass()))
-			{
-				FullFrameData.ActorPoses.Emplace(Individual->GetParentActor(), IndividualPose);
-			}
-			else if (auto BI = Cast<USLBoneIndividual>(Individual))
-			{
-				FullFrameData.BonePoses.FindOrAdd(BI->GetPoseableMeshComponent()).Add(BI->GetBoneIndex(), IndividualPose);
-			}
-			else if (auto VBI = Cast<USLVirtualBoneIndividual>(Individual))
-			{
-				FullFrameData.BonePoses.FindOrAdd(VBI->GetPoseableMeshComponent()).Add(VBI->GetBoneIndex(), IndividualPose);
-			}
+		{
+			OutVizEpisodeData.Actors.Add(Individual->GetParentActor());
+			OutVizEpisodeData.ActorIds.Add(IndividualId);
+			OutActorSources.Add(IndividualIdx);
 		}
-		else
+		else if (auto BI = Cast<USLBoneIndividual>(Individual))
 		{
-			UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find individual with id=%s, this should not happen, aborting.."),
-				*FString(__FUNCTION__), __LINE__, *IndividualPosePair.Key);
-			return false;
+			OutVizEpisodeData.Bones.Emplace(BI->GetPoseableMeshComponent(), BI->GetBoneIndex());
+			OutVizEpisodeData.BoneIds.Add(IndividualId);
+			OutBoneSources.Add(IndividualIdx);
+		}
+		else if (auto VBI = Cast<USLVirtualBoneIndividual>(Individual))
+		{
+			OutVizEpisodeData.Bones.Emplace(VBI->GetPoseableMeshComponent(), VBI->GetBoneIndex());
+			OutVizEpisodeData.BoneIds.Add(IndividualId);
+			OutBoneSources.Add(IndividualIdx);
 		}
 	}
-	// Add the timestamp
-	//OutVizEpisodeData.Timestamps[0] = InMongoEpisodeData[0].Key;
-	OutVizEpisodeData.Timestamps.Emplace(InMongoEpisodeData[0].Key);
+	return true;
+}
 
-	double FirstFrameDuration = FPlatformTime::Seconds() - ExecBegin;
+// Fill the timestamps, keyframes and change lists of the bound episode (no UObject access, safe to call from worker threads)
+void FSLVizEpisodeUtils::FillEpisodeData(const FSLMongoEpisodeData& InMongoEpisodeData,
+	const TArray<int32>& ActorSources, const TArray<int32>& BoneSources,
+	FSLVizEpisodeData& OutVizEpisodeData)
+{
+	OutVizEpisodeData.Timestamps = InMongoEpisodeData.Timestamps;
 
-	// Add the individuals poses
-	//OutVizEpisodeData.Frames[0] = FullFrameData;
-	OutVizEpisodeData.FullFrames.Emplace(FullFrameData);
-	OutVizEpisodeData.CompactFrames.Emplace(FullFrameData);
+	// Convert the columns to keyframes and change lists (in parallel, the columns are pre-sized)
+	FillKeyframesAndChanges(InMongoEpisodeData, ActorSources, OutVizEpisodeData.KeyframeInterval,
+		OutVizEpisodeData.ActorKeyframes, OutVizEpisodeData.ActorChanges);
+	FillKeyframesAndChanges(InMongoEpisodeData, BoneSources, OutVizEpisodeData.KeyframeInterval,
+		OutVizEpisodeData.BoneKeyframes, OutVizEpisodeData.BoneChanges);
+}
+
+// Write the episode data to a binary file (the actors and bones are stored as individual ids)
+bool FSLVizEpisodeUtils::SaveEpisodeData(const FSLVizEpisodeData& InVizEpisodeData, const FString& Path)
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
 
-	/* Process the following frames */
-	// Update full frame with the new transform values
-	// Create compact frame holding only the changes fromt he previous frame
-	for (int32 FrameIndex = 1; FrameIndex < InMongoEpisodeData.Num(); ++FrameIndex)
+	// The archive operators are non-const, the writer does not modify the data
+	SerializeEpisodeData(Writer, const_cast<FSLVizEpisodeData&>(InVizEpisodeData));
+	if (!FFileHelper::SaveArrayToFile(Bytes, *Path))
 	{
-		if (FrameIndex % 250 == 0) { UE_LOG(LogTemp, Log, TEXT(" processing frame %d / %d .."),  FrameIndex, InMongoEpisodeData.Num()); }
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not write episode %s to %s.."),
+			*FString(__FUNCTION__), __LINE__, *InVizEpisodeData.Id, *Path);
+		return false;
+	}
+	return true;
+}
 
-		// TODO will emplace make a copy, or one needs to make one here ?
-		//FSLVizEpisodeFrameData PrevFrameCopy = FullFrameData;
-		FSLVizEpisodeFrameData CompactFrameData;
+// Read the episode data from a binary file and re-resolve its actors and bones (returns false on errors or version mismatch)
+bool FSLVizEpisodeUtils::LoadEpisodeData(ASLIndividualManager* IndividualManager, const FString& Path,
+	FSLVizEpisodeData& OutVizEpisodeData)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Path, FILEREAD_Silent))
+	{
+		return false;
+	}
 
-		// Iterate individuals with their poses
-		for (const auto& IndividualPosePair : InMongoEpisodeData[FrameIndex].Value)
-		{
-			const FString IndividualId = IndividualPosePair.Key;
-			const FTransform IndividualPose = IndividualPosePair.Value;
-			if (auto Individual = IndividualManager->GetIndividual(IndividualId))
-			{
-				if (Individual->IsA(USLRigidIndividual::StaticClass())
-					|| Individual->IsA(USLSkeletalIndividual::StaticClass())
-					|| Individual->IsA(USLVirtualViewIndividual::StaticClass()))
-				{
-					// Update the full frame with the new value
-					//if (auto FoundActorPose = FullFrameData.ActorPoses.Find(RI->GetParentActor())){(*FoundActorPose) = IndividualPose;}
-					FullFrameData.ActorPoses.FindChecked(Individual->GetParentActor()) = IndividualPose;
-					// Add as new data to the compact frame
-					CompactFrameData.ActorPoses.Emplace(Individual->GetParentActor(), IndividualPose);
-
-					if (IndividualId.Equals("6HI1inL7OUKmqNXGXI81YA"))
-					{
-						UE_LOG(LogTemp, Log, TEXT("%s::%d Pose=%s;"), *FString(__FUNCTION__), __LINE__, *IndividualPose.ToString());
-					}
-				}
-				else if (auto BI = Cast<USLBoneIndividual>(Individual))
-				{
-					FullFrameData.BonePoses.FindOrAdd(BI->GetPoseableMeshComponent()).Add(BI->GetBoneIndex(), IndividualPose);
-					CompactFrameData.BonePoses.FindOrAdd(BI->GetPoseableMeshComponent()).Add(BI->GetBoneIndex(), IndividualPose);
-				}
-				else if (auto VBI = Cast<USLVirtualBoneIndividual>(Individual))
-				{
-					FullFrameData.BonePoses.FindOrAdd(VBI->GetPoseableMeshComponent()).Add(VBI->GetBoneIndex(), IndividualPose);
-					CompactFrameData.BonePoses.FindOrAdd(VBI->GetPoseableMeshComponent()).Add(VBI->GetBoneIndex(), IndividualPose);
-				}
-			}
-			else
-			{
-				UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find individual with id=%s, this should not happen, aborting.."),
-					*FString(__FUNCTION__), __LINE__, *IndividualId);
-				return false;
-			}
-		}
+	FMemoryReader Reader(Bytes);
+	if (!SerializeEpisodeData(Reader, OutVizEpisodeData))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s could not be read.."), *FString(__FUNCTION__), __LINE__, *Path);
+		return false;
+	}
+	return ResolveEpisodeData(IndividualManager, OutVizEpisodeData);
+}
 
-		// Add the timestamp
-		//OutVizEpisodeData.Timestamps[FrameIndex] = InMongoEpisodeData[FrameIndex].Key;
-		OutVizEpisodeData.Timestamps.Emplace(InMongoEpisodeData[FrameIndex].Key);
+// Serialize the episode data with its file version (the actors and bones are stored as individual ids, returns false on errors or version mismatch)
+bool FSLVizEpisodeUtils::SerializeEpisodeData(FArchive& Ar, FSLVizEpisodeData& VizEpisodeData)
+{
+	int32 Version = EpisodeDataFileVersion;
+	Ar << Version;
+	if (Version != EpisodeDataFileVersion)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Episode data has version %d (expected %d), ignoring it.."),
+			*FString(__FUNCTION__), __LINE__, Version, EpisodeDataFileVersion);
+		return false;
+	}
 
-		// Add the individuals poses
-		//OutFullEpisodeData.Frames[FrameIndex] = FullFrameData;
-		OutVizEpisodeData.FullFrames.Emplace(FullFrameData);
-		OutVizEpisodeData.CompactFrames.Emplace(CompactFrameData);
+	if (Ar.IsLoading())
+	{
+		VizEpisodeData.Clear();
 	}
-	
-	double FollowingFramesDuration = FPlatformTime::Seconds() - ExecBegin - FirstFrameDuration;
-	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: first frame=[%f], following frames(num=%d)=[%f], total=[%f] seconds..;"),
-		*FString(__func__), __LINE__, FirstFrameDuration, OutVizEpisodeData.Timestamps.Num(),
-		FollowingFramesDuration, FPlatformTime::Seconds() - ExecBegin);
-	return true;
+
+	// The array counts of a corrupt file fail the read instead of being allocated
+	if (IsArrayNumInBounds(Ar, sizeof(ANSICHAR)))
+	{
+		Ar << VizEpisodeData.Id;
+	}
+	if (IsArrayNumInBounds(Ar, sizeof(float)))
+	{
+		Ar << VizEpisodeData.Timestamps;
+	}
+	Ar << VizEpisodeData.KeyframeInterval;
+	SerializeIds(Ar, VizEpisodeData.ActorIds);
+	SerializeKeyframes(Ar, VizEpisodeData.ActorKeyframes);
+	SerializeChangeList(Ar, VizEpisodeData.ActorChanges);
+	SerializeIds(Ar, VizEpisodeData.BoneIds);
+	SerializeKeyframes(Ar, VizEpisodeData.BoneKeyframes);
+	SerializeChangeList(Ar, VizEpisodeData.BoneChanges);
+
+	if (Ar.IsLoading() && (Ar.IsError() || !VizEpisodeData.IsValid()))
+	{
+		VizEpisodeData.Clear();
+		return false;
+	}
+	return !Ar.IsError();
 }
 
+// Resolve the actors and bones of the deserialized episode data from their individual ids (game thread)
+bool FSLVizEpisodeUtils::ResolveEpisodeData(ASLIndividualManager* IndividualManager, FSLVizEpisodeData& VizEpisodeData)
+{
+	VizEpisodeData.Actors.Empty(VizEpisodeData.ActorIds.Num());
+	VizEpisodeData.Bones.Empty(VizEpisodeData.BoneIds.Num());
+	for (const auto& ActorId : VizEpisodeData.ActorIds)
+	{
+		AActor* Actor = nullptr;
+		if (auto Individual = IndividualManager->GetIndividual(ActorId))
+		{
+			Actor = Individual->GetParentActor();
+		}
+		if (!Actor)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find individual with id=%s, aborting.."), *FString(__FUNCTION__), __LINE__, *ActorId);
+			VizEpisodeData.Clear();
+			return false;
+		}
+		VizEpisodeData.Actors.Add(Actor);
+	}
+	for (const auto& BoneId : VizEpisodeData.BoneIds)
+	{
+		auto Individual = IndividualManager->GetIndividual(BoneId);
+		if (auto BI = Cast<USLBoneIndividual>(Individual))
+		{
+			VizEpisodeData.Bones.Emplace(BI->GetPoseableMeshComponent(), BI->GetBoneIndex());
+		}
+		else if (auto VBI = Cast<USLVirtualBoneIndividual>(Individual))
+		{
+			VizEpisodeData.Bones.Emplace(VBI->GetPoseableMeshComponent(), VBI->GetBoneIndex());
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find bone individual with id=%s, aborting.."), *FString(__FUNCTION__), __LINE__, *BoneId);
+			VizEpisodeData.Clear();
+			return false;
+		}
+	}
+	return true;
+}
 
 // Executes a binary search for element Item in array Array using the <= operator (from ProfilerCommon::FBinaryFindIndex)
 int32 FSLVizEpisodeUtils::BinarySearchLessEqual(const TArray<float>& Array, float Value)
@@ -275,6 +365,180 @@ void FSLVizEpisodeUtils::RemoveUnnecessaryComponents(AActor* Actor)
 	}
 }
 
+// Serialize the change list
+void FSLVizEpisodeUtils::SerializeChangeList(FArchive& Ar, FSLVizEpisodeChangeList& ChangeList)
+{
+	if (IsArrayNumInBounds(Ar, sizeof(int32)))
+	{
+		Ar << ChangeList.Offsets;
+	}
+	if (IsArrayNumInBounds(Ar, sizeof(int32)))
+	{
+		Ar << ChangeList.Indexes;
+	}
+	if (IsArrayNumInBounds(Ar, MinTransformBytes))
+	{
+		Ar << ChangeList.Poses;
+	}
+}
+
+// Serialize the individual ids, every string count is checked when loading
+void FSLVizEpisodeUtils::SerializeIds(FArchive& Ar, TArray<FString>& Ids)
+{
+	if (!Ar.IsLoading())
+	{
+		Ar << Ids;
+		return;
+	}
+
+	// Same layout as the array operator (count followed by the strings)
+	if (!IsArrayNumInBounds(Ar, sizeof(int32)))
+	{
+		return;
+	}
+	int32 Num = 0;
+	Ar << Num;
+	Ids.SetNum(Num);
+	for (auto& Id : Ids)
+	{
+		if (!IsArrayNumInBounds(Ar, sizeof(ANSICHAR)))
+		{
+			return;
+		}
+		Ar << Id;
+	}
+}
+
+// Serialize the keyframes, every pose array count is checked when loading
+void FSLVizEpisodeUtils::SerializeKeyframes(FArchive& Ar, TArray<TArray<FTransform>>& Keyframes)
+{
+	if (!Ar.IsLoading())
+	{
+		Ar << Keyframes;
+		return;
+	}
+
+	// Same layout as the array operator (count followed by the pose arrays)
+	if (!IsArrayNumInBounds(Ar, sizeof(int32)))
+	{
+		return;
+	}
+	int32 Num = 0;
+	Ar << Num;
+	Keyframes.SetNum(Num);
+	for (auto& Keyframe : Keyframes)
+	{
+		if (!IsArrayNumInBounds(Ar, MinTransformBytes))
+		{
+			return;
+		}
+		Ar << Keyframe;
+	}
+}
+
+// Check the array count at the archive position against the remaining bytes before the array is allocated
+// (always true when saving, sets the archive error if the count does not fit)
+bool FSLVizEpisodeUtils::IsArrayNumInBounds(FArchive& Ar, int32 MinElementBytes)
+{
+	if (!Ar.IsLoading())
+	{
+		return true;
+	}
+	if (Ar.IsError())
+	{
+		return false;
+	}
+
+	// Peek the count
+	const int64 Pos = Ar.Tell();
+	int32 Num = 0;
+	Ar << Num;
+	Ar.Seek(Pos);
+
+	// Negative string counts mark two byte characters
+	const int64 NumElements = FMath::Abs(static_cast<int64>(Num));
+	const int64 RemainingBytes = Ar.TotalSize() - Pos - static_cast<int64>(sizeof(int32));
+	if (Ar.IsError() || NumElements * MinElementBytes > RemainingBytes)
+	{
+		Ar.SetError();
+		return false;
+	}
+	return true;
+}
+
+// Fill the keyframes and the per frame change lists of the given mongo columns (the poses are carried forward between the recorded frames)
+void FSLVizEpisodeUtils::FillKeyframesAndChanges(const FSLMongoEpisodeData& InMongoEpisodeData, const TArray<int32>& SourceIndexes,
+	int32 KeyframeInterval, TArray<TArray<FTransform>>& OutKeyframes, FSLVizEpisodeChangeList& OutChanges)
+{
+	const int32 NumFrames = InMongoEpisodeData.NumFrames();
+	if (NumFrames == 0)
+	{
+		return;
+	}
+	const int32 NumColumns = SourceIndexes.Num();
+	const int32 NumKeyframes = (NumFrames - 1) / KeyframeInterval + 1;
+
+	// Pre-size the keyframes, every column is then carried forward independently
+	OutKeyframes.SetNum(NumKeyframes);
+	for (auto& Keyframe : OutKeyframes)
+	{
+		Keyframe.SetNumUninitialized(NumColumns);
+	}
+	ParallelFor(NumColumns, [&](int32 ColumnIdx)
+	{
+		const int32 SourceIdx = SourceIndexes[ColumnIdx];
+		const TArray<int32>& Frames = InMongoEpisodeData.FrameIndexes[SourceIdx];
+		const TArray<FTransform>& Poses = InMongoEpisodeData.Poses[SourceIdx];
+
+		// The poses before the first recorded one take its value (the individual was not moved until then)
+		FTransform CurrPose = Poses.Num() > 0 ? Poses[0] : FTransform::Identity;
+
+		// The keyframes hold the state after the changes of their frame
+		int32 SampleIdx = 0;
+		for (int32 KeyframeIdx = 0; KeyframeIdx < NumKeyframes; ++KeyframeIdx)
+		{
+			const int32 KeyFrameIdx = KeyframeIdx * KeyframeInterval;
+			for (; SampleIdx < Frames.Num() && Frames[SampleIdx] <= KeyFrameIdx; ++SampleIdx)
+			{
+				CurrPose = Poses[SampleIdx];
+			}
+			OutKeyframes[KeyframeIdx][ColumnIdx] = CurrPose;
+		}
+	});
+
+	// Count the changes of every frame (stored in the next offset entry), only the recorded samples are visited
+	OutChanges.Offsets.SetNumZeroed(NumFrames + 1);
+	for (const int32 SourceIdx : SourceIndexes)
+	{
+		for (const int32 FrameIdx : InMongoEpisodeData.FrameIndexes[SourceIdx])
+		{
+			OutChanges.Offsets[FrameIdx + 1]++;
+		}
+	}
+
+	// Convert the counts to offsets
+	for (int32 FrameIdx = 0; FrameIdx < NumFrames; ++FrameIdx)
+	{
+		OutChanges.Offsets[FrameIdx + 1] += OutChanges.Offsets[FrameIdx];
+	}
+
+	// Fill the pre-sized change arrays, the columns are visited in order so every frame keeps its changes sorted by column
+	OutChanges.Indexes.SetNumUninitialized(OutChanges.Offsets[NumFrames]);
+	OutChanges.Poses.SetNumUninitialized(OutChanges.Offsets[NumFrames]);
+	TArray<int32> NextChangeIdx(OutChanges.Offsets.GetData(), NumFrames);
+	for (int32 ColumnIdx = 0; ColumnIdx < NumColumns; ++ColumnIdx)
+	{
+		const int32 SourceIdx = SourceIndexes[ColumnIdx];
+		const TArray<int32>& Frames = InMongoEpisodeData.FrameIndexes[SourceIdx];
+		const TArray<FTransform>& Poses = InMongoEpisodeData.Poses[SourceIdx];
+		for (int32 SampleIdx = 0; SampleIdx < Frames.Num(); ++SampleIdx)
+		{
+			const int32 ChangeIdx = NextChangeIdx[Frames[SampleIdx]]++;
+			OutChanges.Indexes[ChangeIdx] = ColumnIdx;
+			OutChanges.Poses[ChangeIdx] = Poses[SampleIdx];
+		}
+	}
+}
 
 //// Make sure the mesh of the pawn or spectator is not visible in the world
 //void FSLVizEpisodeUtils::HidePawnOrSpectator(UWorld* World)
@@ -368,4 +632,30 @@ void FSLVizEpisodeUtils::RemoveUnnecessaryComponents(AActor* Actor)
 ////{
 ////	C->ConditionalBeginDestroy();
 ////}
-//};
\ No newline at end of file
+//};
+
+
+// Reserve the scopes for the expected number of moved roots
+FSLVizScopedMovementBatch::FSLVizScopedMovementBatch(int32 ExpectedNum)
+{
+	Scopes.Reserve(ExpectedNum);
+}
+
+// Close the scopes in reverse order
+FSLVizScopedMovementBatch::~FSLVizScopedMovementBatch()
+{
+	for (int32 Idx = Scopes.Num() - 1; Idx >= 0; --Idx)
+	{
+		Scopes[Idx].Reset();
+	}
+}
+
+// Teleport the root component without sweeping, its deferred scope is opened on the first move
+void FSLVizScopedMovementBatch::Move(USceneComponent* RootComponent, const FTransform& Pose)
+{
+	if (!RootComponent->IsDeferringMovementUpdates())
+	{
+		Scopes.Emplace(MakeUnique<FScopedMovementUpdate>(RootComponent, EScopedUpdate::DeferredUpdates));
+	}
+	RootComponent->SetWorldTransform(Pose, false, nullptr, ETeleportType::TeleportPhysics);
+}
@@ -0,0 +1,494 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Viz/SLVizGhostReplayManager.h"
+#include "Viz/SLVizEpisodeUtils.h"
+#include "Viz/SLVizAssets.h"
+#include "UObject/ConstructorHelpers.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/PoseableMeshComponent.h"
+#include "Engine/StaticMeshActor.h"
+
+// Sets default values for this actor's properties
+ASLVizGhostReplayManager::ASLVizGhostReplayManager()
+{
+	// Allow ticking, disable it by default (used for episode replay)
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	bReplayRunning = false;
+	VizAssetsContainer = nullptr;
+
+	LoadAssetsContainer();
+
+#if WITH_EDITORONLY_DATA
+	// Make manager sprite smaller (used to easily find the actor in the world)
+	SpriteScale = 0.35;
+#endif // WITH_EDITORONLY_DATA
+}
+
+// Called every frame
+void ASLVizGhostReplayManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const bool bClockRunning = ReplayClock.Advance();
+	ApplyTime(ReplayClock.GetTime());
+	if (!bClockRunning)
+	{
+		SetActorTickEnabled(false);
+		bReplayRunning = false;
+	}
+}
+
+// Called when actor removed from game or game ended
+void ASLVizGhostReplayManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ClearEpisodes();
+	EmptyPool();
+	Super::EndPlay(EndPlayReason);
+}
+
+// Add an episode replayed on ghost clones with the given time offset and tint (returns the episode index, INDEX_NONE on error)
+int32 ASLVizGhostReplayManager::AddEpisode(TSharedPtr<const FSLVizEpisodeData> InEpisodeData, float TimeOffset, const FSLVizVisualParams& VisualParams)
+{
+	if (!InEpisodeData.IsValid() || !InEpisodeData->IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Episode data is not valid to load.."), *FString(__FUNCTION__), __LINE__);
+		return INDEX_NONE;
+	}
+
+	const int32 EpisodeIndex = Episodes.AddDefaulted();
+	FSLVizGhostEpisode& Episode = Episodes[EpisodeIndex];
+	Episode.EpisodeData = MoveTemp(InEpisodeData);
+	Episode.TimeOffset = TimeOffset;
+
+	// One tint material is shared by all the clones of the episode
+	if (VisualParams.MaterialType != ESLVizMaterialType::NONE && VizAssetsContainer)
+	{
+		UMaterialInterface* ParentMaterial = VisualParams.MaterialType == ESLVizMaterialType::Additive ? VizAssetsContainer->MaterialHighlightAdditive
+			: VisualParams.MaterialType == ESLVizMaterialType::Lit ? VizAssetsContainer->MaterialLit
+			: VisualParams.MaterialType == ESLVizMaterialType::Unlit ? VizAssetsContainer->MaterialUnlit
+			: VizAssetsContainer->MaterialHighlightTranslucent;
+		Episode.Material = UMaterialInstanceDynamic::Create(ParentMaterial, this);
+		Episode.Material->SetVectorParameterValue(FName("Color"), VisualParams.Color);
+		EpisodeMaterials.Add(Episode.Material);
+	}
+
+	// Clone the actors, the skeletal actors which only drive bones are cloned as well
+	Episode.Ghosts.Reserve(Episode.EpisodeData->Actors.Num());
+	for (AActor* SourceActor : Episode.EpisodeData->Actors)
+	{
+		AActor* Ghost = AcquireGhost(SourceActor);
+		if (Ghost)
+		{
+			SetGhostMaterials(Ghost, GetSourceMeshComponent(SourceActor), Episode.Material);
+			Episode.SourceToGhost.Add(SourceActor, Ghost);
+		}
+		Episode.Ghosts.Add(Ghost);
+	}
+
+	TArray<FSLVizEpisodeBoneTarget> GhostBones;
+	GhostBones.Reserve(Episode.EpisodeData->Bones.Num());
+	for (const auto& Bone : Episode.EpisodeData->Bones)
+	{
+		AActor* SourceActor = Bone.PoseableMeshComponent->GetOwner();
+		AActor* Ghost = Episode.SourceToGhost.FindRef(SourceActor);
+		if (!Ghost)
+		{
+			Ghost = AcquireGhost(SourceActor);
+			if (Ghost)
+			{
+				SetGhostMaterials(Ghost, GetSourceMeshComponent(SourceActor), Episode.Material);
+				Episode.SourceToGhost.Add(SourceActor, Ghost);
+			}
+		}
+		UPoseableMeshComponent* GhostPMC = Ghost ? Cast<UPoseableMeshComponent>(Ghost->GetRootComponent()) : nullptr;
+		if (!GhostPMC)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not clone the poseable mesh of %s, ghost episode aborted.."),
+				*FString(__FUNCTION__), __LINE__, *SourceActor->GetName());
+			for (const auto& Pair : Episode.SourceToGhost)
+			{
+				ReleaseGhost(Pair.Value);
+			}
+			if (Episode.Material)
+			{
+				EpisodeMaterials.RemoveSingleSwap(Episode.Material);
+			}
+			Episodes.RemoveAt(EpisodeIndex);
+			return INDEX_NONE;
+		}
+		GhostBones.Emplace(GhostPMC, Bone.BoneIndex);
+	}
+	Episode.SkeletalPoseApplier.Init(GhostBones);
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Added ghost episode %s with %d clones (offset=%f, pooled=%d).."),
+		*FString(__FUNCTION__), __LINE__, *Episode.EpisodeData->Id, Episode.SourceToGhost.Num(), TimeOffset, PooledGhosts.Num());
+
+	// Show the first frame of the episode
+	ApplyEpisodeTime(Episode, Episode.EpisodeData->Timestamps[0]);
+	return EpisodeIndex;
+}
+
+// Change the time offset of the episode
+void ASLVizGhostReplayManager::SetEpisodeTimeOffset(int32 EpisodeIndex, float TimeOffset)
+{
+	if (Episodes.IsValidIndex(EpisodeIndex))
+	{
+		Episodes[EpisodeIndex].TimeOffset = TimeOffset;
+	}
+}
+
+// Release all the episode clones back to the pool
+void ASLVizGhostReplayManager::ClearEpisodes()
+{
+	StopReplay();
+	for (auto& Episode : Episodes)
+	{
+		for (const auto& Pair : Episode.SourceToGhost)
+		{
+			ReleaseGhost(Pair.Value);
+		}
+	}
+	Episodes.Empty();
+	EpisodeMaterials.Empty();
+}
+
+// Spawn the clones of the given episode ahead of time (NumSets clones for every actor)
+void ASLVizGhostReplayManager::PrewarmPool(const FSLVizEpisodeData& InEpisodeData, int32 NumSets)
+{
+	// Count the clones required by one set for every mesh asset
+	TMap<UObject*, int32> NumRequired;
+	TMap<UObject*, UMeshComponent*> SourceMeshes;
+	TSet<AActor*> SourceActors(InEpisodeData.Actors);
+	for (const auto& Bone : InEpisodeData.Bones)
+	{
+		SourceActors.Add(Bone.PoseableMeshComponent->GetOwner());
+	}
+	for (AActor* SourceActor : SourceActors)
+	{
+		if (UMeshComponent* SourceMC = GetSourceMeshComponent(SourceActor))
+		{
+			if (UObject* MeshAsset = GetMeshAsset(SourceMC))
+			{
+				NumRequired.FindOrAdd(MeshAsset)++;
+				SourceMeshes.Add(MeshAsset, SourceMC);
+			}
+		}
+	}
+
+	int32 NumSpawned = 0;
+	for (const auto& Pair : NumRequired)
+	{
+		TArray<AActor*>& Free = FreeGhosts.FindOrAdd(Pair.Key);
+		while (Free.Num() < Pair.Value * NumSets)
+		{
+			AActor* Ghost = SpawnGhost(SourceMeshes[Pair.Key]);
+			if (!Ghost)
+			{
+				break;
+			}
+			Free.Add(Ghost);
+			NumSpawned++;
+		}
+	}
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Prewarmed %d ghost clones for episode %s (pooled=%d).."),
+		*FString(__FUNCTION__), __LINE__, NumSpawned, *InEpisodeData.Id, PooledGhosts.Num());
+}
+
+// Destroy all the pooled clones
+void ASLVizGhostReplayManager::EmptyPool()
+{
+	ClearEpisodes();
+	for (AActor* Ghost : PooledGhosts)
+	{
+		if (Ghost && Ghost->IsValidLowLevel() && !Ghost->IsPendingKillOrUnreachable())
+		{
+			Ghost->Destroy();
+		}
+	}
+	PooledGhosts.Empty();
+	FreeGhosts.Empty();
+}
+
+// Play all the episodes from a single clock (the time range covers all the offset episodes)
+bool ASLVizGhostReplayManager::Play(const FSLVizEpisodePlayParams& PlayParams)
+{
+	if (Episodes.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d No ghost episodes are loaded.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	float StartTime = 0.f;
+	float EndTime = 0.f;
+	GetTimeRange(StartTime, EndTime);
+	if (PlayParams.StartTime >= 0.f)
+	{
+		StartTime = FMath::Max(StartTime, PlayParams.StartTime);
+	}
+	if (PlayParams.EndTime >= 0.f && PlayParams.EndTime > StartTime)
+	{
+		EndTime = FMath::Min(EndTime, PlayParams.EndTime);
+	}
+
+	ReplayClock.Start(StartTime, EndTime, PlayParams.Speed, PlayParams.bLoop);
+	ApplyTime(ReplayClock.GetTime());
+	SetActorTickInterval(0.f);
+	SetActorTickEnabled(true);
+	bReplayRunning = true;
+	return true;
+}
+
+// Set all the episodes as in the given time of the shared clock
+void ASLVizGhostReplayManager::GotoTime(float Time)
+{
+	ApplyTime(Time);
+}
+
+// Set replay to pause or play
+void ASLVizGhostReplayManager::SetPauseReplay(bool bPause)
+{
+	if (bReplayRunning == bPause)
+	{
+		SetActorTickEnabled(!bPause);
+		bReplayRunning = !bPause;
+
+		// Do not count the paused time
+		if (!bPause)
+		{
+			ReplayClock.Resume();
+		}
+	}
+}
+
+// Stop the replay
+void ASLVizGhostReplayManager::StopReplay()
+{
+	SetActorTickEnabled(false);
+	bReplayRunning = false;
+}
+
+// Load container with the vizual assets
+bool ASLVizGhostReplayManager::LoadAssetsContainer()
+{
+	static ConstructorHelpers::FObjectFinder<USLVizAssets>VizAssetsContainerAsset(AssetsContainerPath);
+	if (VizAssetsContainerAsset.Succeeded())
+	{
+		VizAssetsContainer = VizAssetsContainerAsset.Object;
+		if (VizAssetsContainer->MaterialHighlightTranslucent == nullptr)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Assets container MaterialHighlightTranslucent is NULL.."), *FString(__FUNCTION__), __LINE__);
+			return false;
+		}
+		return true;
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not find the assets container at Path=%s.."),
+			*FString(__FUNCTION__), __LINE__, AssetsContainerPath);
+		return false;
+	}
+}
+
+// Get a ghost clone of the actor from the pool (spawns a new one if the pool is empty)
+AActor* ASLVizGhostReplayManager::AcquireGhost(AActor* SourceActor)
+{
+	UMeshComponent* SourceMC = GetSourceMeshComponent(SourceActor);
+	UObject* MeshAsset = SourceMC ? GetMeshAsset(SourceMC) : nullptr;
+	if (!MeshAsset)
+	{
+		return nullptr;
+	}
+
+	AActor* Ghost = nullptr;
+	TArray<AActor*>& Free = FreeGhosts.FindOrAdd(MeshAsset);
+	if (Free.Num() > 0)
+	{
+		Ghost = Free.Pop(false);
+	}
+	else
+	{
+		Ghost = SpawnGhost(SourceMC);
+	}
+
+	if (Ghost)
+	{
+		Ghost->SetActorTransform(SourceActor->GetActorTransform(), false, nullptr, ETeleportType::TeleportPhysics);
+		Ghost->SetActorHiddenInGame(false);
+#if WITH_EDITOR
+		Ghost->SetIsTemporarilyHiddenInEditor(false);
+#endif // WITH_EDITOR
+	}
+	return Ghost;
+}
+
+// Hide the ghost and return it to the pool
+void ASLVizGhostReplayManager::ReleaseGhost(AActor* Ghost)
+{
+	if (!Ghost || !Ghost->IsValidLowLevel() || Ghost->IsPendingKillOrUnreachable())
+	{
+		return;
+	}
+	Ghost->SetActorHiddenInGame(true);
+#if WITH_EDITOR
+	Ghost->SetIsTemporarilyHiddenInEditor(true);
+#endif // WITH_EDITOR
+	if (UMeshComponent* MC = Cast<UMeshComponent>(Ghost->GetRootComponent()))
+	{
+		if (UObject* MeshAsset = GetMeshAsset(MC))
+		{
+			FreeGhosts.FindOrAdd(MeshAsset).Add(Ghost);
+		}
+	}
+}
+
+// Spawn a new ghost clone of the source mesh component (not added to the pool)
+AActor* ASLVizGhostReplayManager::SpawnGhost(UMeshComponent* SourceMC)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	AActor* Ghost = nullptr;
+	if (UStaticMeshComponent* SourceSMC = Cast<UStaticMeshComponent>(SourceMC))
+	{
+		AStaticMeshActor* SMA = GetWorld()->SpawnActor<AStaticMeshActor>(SpawnParams);
+		SMA->SetMobility(EComponentMobility::Movable);
+		SMA->GetStaticMeshComponent()->SetStaticMesh(SourceSMC->GetStaticMesh());
+		Ghost = SMA;
+	}
+	else if (USkinnedMeshComponent* SourceSkMC = Cast<USkinnedMeshComponent>(SourceMC))
+	{
+		// The bones are driven directly, a poseable mesh is used as root
+		Ghost = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+		UPoseableMeshComponent* PMC = NewObject<UPoseableMeshComponent>(Ghost);
+		PMC->SetMobility(EComponentMobility::Movable);
+		PMC->SetSkeletalMesh(SourceSkMC->SkeletalMesh);
+		PMC->bHasMotionBlurVelocityMeshes = false;
+		PMC->bPerBoneMotionBlur = false;
+		Ghost->SetRootComponent(PMC);
+		PMC->RegisterComponent();
+		Ghost->AddInstanceComponent(PMC);
+	}
+	if (!Ghost)
+	{
+		return nullptr;
+	}
+
+	// Clones are visual only
+	if (UPrimitiveComponent* PC = Cast<UPrimitiveComponent>(Ghost->GetRootComponent()))
+	{
+		PC->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		PC->SetGenerateOverlapEvents(false);
+		PC->SetCastShadow(false);
+	}
+#if WITH_EDITOR
+	Ghost->SetActorLabel(TEXT("SL_Ghost_") + SourceMC->GetOwner()->GetName());
+#endif // WITH_EDITOR
+	PooledGhosts.Add(Ghost);
+	return Ghost;
+}
+
+// Get the mesh component which is cloned from the source actor (poseable, skeletal or static)
+UMeshComponent* ASLVizGhostReplayManager::GetSourceMeshComponent(AActor* SourceActor) const
+{
+	if (UPoseableMeshComponent* PMC = SourceActor->FindComponentByClass<UPoseableMeshComponent>())
+	{
+		return PMC;
+	}
+	if (USkeletalMeshComponent* SkMC = SourceActor->FindComponentByClass<USkeletalMeshComponent>())
+	{
+		return SkMC;
+	}
+	return SourceActor->FindComponentByClass<UStaticMeshComponent>();
+}
+
+// Get the mesh asset of the component (used as the pool key)
+UObject* ASLVizGhostReplayManager::GetMeshAsset(UMeshComponent* MC) const
+{
+	if (UStaticMeshComponent* SMC = Cast<UStaticMeshComponent>(MC))
+	{
+		return SMC->GetStaticMesh();
+	}
+	if (USkinnedMeshComponent* SkMC = Cast<USkinnedMeshComponent>(MC))
+	{
+		return SkMC->SkeletalMesh;
+	}
+	return nullptr;
+}
+
+// Set the tint material on the ghost, or the materials of the source mesh if no tint is given
+void ASLVizGhostReplayManager::SetGhostMaterials(AActor* Ghost, UMeshComponent* SourceMC, UMaterialInstanceDynamic* Material) const
+{
+	UMeshComponent* GhostMC = Cast<UMeshComponent>(Ghost->GetRootComponent());
+	if (!GhostMC)
+	{
+		return;
+	}
+	for (int32 MatIdx = 0; MatIdx < GhostMC->GetNumMaterials(); ++MatIdx)
+	{
+		GhostMC->SetMaterial(MatIdx, Material ? Material : SourceMC->GetMaterial(MatIdx));
+	}
+}
+
+// Get the time range of the shared clock
+void ASLVizGhostReplayManager::GetTimeRange(float& OutStartTime, float& OutEndTime) const
+{
+	OutStartTime = TNumericLimits<float>::Max();
+	OutEndTime = TNumericLimits<float>::Lowest();
+	for (const auto& Episode : Episodes)
+	{
+		OutStartTime = FMath::Min(OutStartTime, Episode.EpisodeData->Timestamps[0] + Episode.TimeOffset);
+		OutEndTime = FMath::Max(OutEndTime, Episode.EpisodeData->Timestamps.Last() + Episode.TimeOffset);
+	}
+}
+
+// Apply the state of every episode at the given clock time
+void ASLVizGhostReplayManager::ApplyTime(float Time)
+{
+	for (auto& Episode : Episodes)
+	{
+		ApplyEpisodeTime(Episode, Time - Episode.TimeOffset);
+	}
+}
+
+// Apply the state of the episode at its local time
+void ASLVizGhostReplayManager::ApplyEpisodeTime(FSLVizGhostEpisode& Episode, float LocalTime)
+{
+	const FSLVizEpisodeData& EpisodeData = *Episode.EpisodeData;
+	const int32 FrameIndex = FMath::Clamp(FSLVizEpisodeUtils::BinarySearchLessEqual(EpisodeData.Timestamps, LocalTime),
+		0, EpisodeData.NumFrames() - 1);
+	if (FrameIndex == Episode.ActiveFrameIndex)
+	{
+		return;
+	}
+
+	// Only the clones of the changed columns are moved
+	TBitArray<> ChangedActors(false, EpisodeData.Actors.Num());
+	TBitArray<> ChangedBones(false, EpisodeData.Bones.Num());
+	EpisodeData.SeekState(Episode.ActiveFrameIndex, FrameIndex, Episode.ActorState, Episode.BoneState, ChangedActors, ChangedBones);
+	Episode.ActiveFrameIndex = FrameIndex;
+
+	// The deferred scopes of all the moved clones stay open until the whole frame is set
+	{
+		FSLVizScopedMovementBatch MovementBatch(Episode.Ghosts.Num());
+		for (TConstSetBitIterator<> ActorItr(ChangedActors); ActorItr; ++ActorItr)
+		{
+			if (AActor* Ghost = Episode.Ghosts[ActorItr.GetIndex()])
+			{
+				MovementBatch.Move(Ghost->GetRootComponent(), Episode.ActorState[ActorItr.GetIndex()]);
+			}
+		}
+	}
+
+	TBitArray<> ChangedMeshes(false, Episode.SkeletalPoseApplier.NumMeshes());
+	for (TConstSetBitIterator<> BoneItr(ChangedBones); BoneItr; ++BoneItr)
+	{
+		ChangedMeshes[Episode.SkeletalPoseApplier.GetMeshIndex(BoneItr.GetIndex())] = true;
+	}
+	Episode.SkeletalPoseApplier.Apply(Episode.BoneState, ChangedMeshes);
+}
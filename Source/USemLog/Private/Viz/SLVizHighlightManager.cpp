@@ -98,90 +98,147 @@ void ASLVizHighlightManager::RestoreOriginalMaterials()
 }
 
 
-// Highlight a static mesh
+// Highlight the given slots of the mesh component (all slots if the params slots are empty)
 void ASLVizHighlightManager::Highlight(UMeshComponent* MC, const FSLVizVisualParams& VisualParams)
 {
-	// Cache the original materials
-	HighlightedStaticMeshes.Add(MC, FSLVizHighlightData(MC->GetMaterials(), VisualParams.MaterialSlots));
-
-	UMaterialInstanceDynamic* DynMat = CreateTransientMID(VisualParams.MaterialType);
-	DynMat->SetVectorParameterValue(FName("Color"), VisualParams.Color);
-	
-	if (VisualParams.MaterialSlots.Num() > 0)
+	// Already highlighted slots only change their material (the cached originals are kept)
+	const FSLVizHighlightMaterialKey Key(VisualParams);
+	TArray<int32> ChangedSlots;
+	TArray<FSLVizHighlightMaterialKey> ReleasedKeys;
+	AssignSlotKeys(MC, VisualParams.MaterialSlots, Key, false, ChangedSlots, ReleasedKeys);
+	if (ChangedSlots.Num() == 0)
 	{
-		for (int32 MatIdx : VisualParams.MaterialSlots)
-		{
-			MC->SetMaterial(MatIdx, DynMat);
-		}
+		return;
 	}
-	else
+
+	// Acquire first, the material stays pooled if the key is shared
+	UMaterialInstanceDynamic* DynMat = AcquireMaterial(Key, ChangedSlots.Num());
+	for (const auto& ReleasedKey : ReleasedKeys)
 	{
-		for (int32 MatIdx = 0; MatIdx < MC->GetNumMaterials(); ++MatIdx)
-		{
-			MC->SetMaterial(MatIdx, DynMat);
-		}
+		ReleaseMaterial(ReleasedKey);
 	}
+	ApplyMaterial(MC, ChangedSlots, DynMat);
 }
 
-// Update the visual of the given mesh component
+// Update the visual of the already highlighted slots of the mesh component (all its highlighted slots if the params slots are empty)
 void ASLVizHighlightManager::UpdateHighlight(UMeshComponent* MC, const FSLVizVisualParams& VisualParams)
 {
-	if (auto HighlightData = HighlightedStaticMeshes.Find(MC))
+	const FSLVizHighlightMaterialKey Key(VisualParams);
+	TArray<int32> ChangedSlots;
+	TArray<FSLVizHighlightMaterialKey> ReleasedKeys;
+	AssignSlotKeys(MC, VisualParams.MaterialSlots, Key, true, ChangedSlots, ReleasedKeys);
+	if (ChangedSlots.Num() == 0)
 	{
-		UMaterialInstanceDynamic* DynMat = CreateTransientMID(VisualParams.MaterialType);
-		DynMat->SetVectorParameterValue(FName("Color"), VisualParams.Color);
+		return;
+	}
 
-		if (HighlightData->MaterialSlots.Num() > 0)
-		{
-			for (int32 MatIdx : HighlightData->MaterialSlots)
-			{
-				MC->SetMaterial(MatIdx, DynMat);
-			}
-		}
-		else
+	UMaterialInstanceDynamic* DynMat = AcquireMaterial(Key, ChangedSlots.Num());
+	for (const auto& ReleasedKey : ReleasedKeys)
+	{
+		ReleaseMaterial(ReleasedKey);
+	}
+	ApplyMaterial(MC, ChangedSlots, DynMat);
+}
+
+// Clear the highlight of the given slots of the mesh component (all slots if empty), the other slots keep their highlight
+void ASLVizHighlightManager::ClearHighlight(UMeshComponent* MC, const TArray<int32>& MaterialSlots)
+{
+	TArray<FSLVizHighlightMaterialKey> ReleasedKeys;
+	ClearSlotKeys(MC, MaterialSlots, ReleasedKeys);
+	for (const auto& ReleasedKey : ReleasedKeys)
+	{
+		ReleaseMaterial(ReleasedKey);
+	}
+}
+
+// Clear all highlights
+void ASLVizHighlightManager::ClearAllHighlights()
+{
+	for (const auto& MCToDataPair : HighlightedStaticMeshes)
+	{
+		for (const auto& SlotToKeyPair : MCToDataPair.Value.SlotKeys)
 		{
-			for (int32 MatIdx = 0; MatIdx < MC->GetNumMaterials(); ++MatIdx)
-			{
-				MC->SetMaterial(MatIdx, DynMat);
-			}
+			MCToDataPair.Key->SetMaterial(SlotToKeyPair.Key, MCToDataPair.Value.OriginalMaterials[SlotToKeyPair.Key]);
 		}
 	}
+	HighlightedStaticMeshes.Empty();
+
+	// No material is used anymore
+	for (auto& KeyToMaterialPair : MaterialPool)
+	{
+		KeyToMaterialPair.Value.NumUsers = 0;
+	}
+	TrimMaterialPool();
 }
 
-// Clear highlight of a static mesh
-void ASLVizHighlightManager::ClearHighlight(UMeshComponent* MC)
+// Highlight (or update) the given mesh components in one pass sharing a single material (target slots overwrite the params slots)
+void ASLVizHighlightManager::HighlightBatch(const TArray<FSLVizIndividualHighlightData>& Targets, const FSLVizVisualParams& VisualParams)
 {
-	FSLVizHighlightData HighlightData;
-	if (HighlightedStaticMeshes.RemoveAndCopyValue(MC, HighlightData))
+	const FSLVizHighlightMaterialKey Key(VisualParams);
+	HighlightedStaticMeshes.Reserve(HighlightedStaticMeshes.Num() + Targets.Num());
+
+	// The users of the shared material are counted in one go
+	int32 NumNewUsers = 0;
+	TArray<TArray<int32>> ChangedSlots;
+	ChangedSlots.SetNum(Targets.Num());
+	TArray<FSLVizHighlightMaterialKey> ReleasedKeys;
+	for (int32 TargetIdx = 0; TargetIdx < Targets.Num(); ++TargetIdx)
 	{
-		if (HighlightData.MaterialSlots.Num() > 0)
+		if (UMeshComponent* MC = Targets[TargetIdx].MeshComponent)
 		{
-			for (int32 MatIdx : HighlightData.MaterialSlots)
-			{
-				MC->SetMaterial(MatIdx, HighlightData.OriginalMaterials[MatIdx]);
-			}
+			AssignSlotKeys(MC, Targets[TargetIdx].MaterialSlots, Key, false, ChangedSlots[TargetIdx], ReleasedKeys);
+			NumNewUsers += ChangedSlots[TargetIdx].Num();
 		}
-		else
+	}
+
+	if (NumNewUsers == 0)
+	{
+		return;
+	}
+
+	UMaterialInstanceDynamic* DynMat = AcquireMaterial(Key, NumNewUsers);
+	for (const auto& ReleasedKey : ReleasedKeys)
+	{
+		ReleaseMaterial(ReleasedKey);
+	}
+
+	for (int32 TargetIdx = 0; TargetIdx < Targets.Num(); ++TargetIdx)
+	{
+		if (ChangedSlots[TargetIdx].Num() > 0)
 		{
-			for (int32 MatIdx = 0; MatIdx < HighlightData.OriginalMaterials.Num(); ++MatIdx)
-			{
-				MC->SetMaterial(MatIdx, HighlightData.OriginalMaterials[MatIdx]);
-			}
+			ApplyMaterial(Targets[TargetIdx].MeshComponent, ChangedSlots[TargetIdx], DynMat);
 		}
 	}
 }
 
-// Clear all highlights
-void ASLVizHighlightManager::ClearAllHighlights()
+// Clear the highlights of the given mesh component slots in one pass
+void ASLVizHighlightManager::ClearHighlightBatch(const TArray<FSLVizIndividualHighlightData>& Targets)
 {
-	for (const auto& SMToMatsPair : HighlightedStaticMeshes)
+	TArray<FSLVizHighlightMaterialKey> ReleasedKeys;
+	for (const auto& Target : Targets)
 	{
-		for (int32 MatIdx = 0; MatIdx < SMToMatsPair.Value.OriginalMaterials.Num(); ++MatIdx)
+		if (Target.MeshComponent)
 		{
-			SMToMatsPair.Key->SetMaterial(MatIdx, SMToMatsPair.Value.OriginalMaterials[MatIdx]);
+			ClearSlotKeys(Target.MeshComponent, Target.MaterialSlots, ReleasedKeys);
 		}
 	}
-	HighlightedStaticMeshes.Empty();
+
+	// Trim once after all the users are released
+	for (const auto& ReleasedKey : ReleasedKeys)
+	{
+		if (FSLVizHighlightPooledMaterial* PooledMaterial = MaterialPool.Find(ReleasedKey))
+		{
+			PooledMaterial->NumUsers--;
+		}
+	}
+	TrimMaterialPool();
+}
+
+// Set the max number of unused materials kept in the pool
+void ASLVizHighlightManager::SetMaxNumPooledMaterials(int32 Value)
+{
+	MaxNumPooledMaterials = FMath::Max(Value, 0);
+	TrimMaterialPool();
 }
 
 // Bind delegates
@@ -226,4 +283,153 @@ UMaterialInstanceDynamic* ASLVizHighlightManager::CreateTransientMID(ESLVizMater
 		return UMaterialInstanceDynamic::Create(VizAssetsContainer->MaterialHighlightAdditive, nullptr);
 	}
 	return nullptr;
-}
\ No newline at end of file
+}
+
+// Get the shared material of the visual values from the pool (created if missing), increases its users count
+UMaterialInstanceDynamic* ASLVizHighlightManager::AcquireMaterial(const FSLVizHighlightMaterialKey& Key, int32 NumNewUsers)
+{
+	FSLVizHighlightPooledMaterial& PooledMaterial = MaterialPool.FindOrAdd(Key);
+	if (!PooledMaterial.Material || PooledMaterial.Material->IsPendingKillOrUnreachable())
+	{
+		PooledMaterial.Material = CreateTransientMID(Key.MaterialType);
+		PooledMaterial.Material->SetVectorParameterValue(FName("Color"), Key.Color);
+	}
+	PooledMaterial.NumUsers += NumNewUsers;
+	return PooledMaterial.Material;
+}
+
+// Decrease the users count of the pooled material, unused materials above the pool limit are removed
+void ASLVizHighlightManager::ReleaseMaterial(const FSLVizHighlightMaterialKey& Key)
+{
+	if (FSLVizHighlightPooledMaterial* PooledMaterial = MaterialPool.Find(Key))
+	{
+		PooledMaterial->NumUsers--;
+		if (PooledMaterial->NumUsers <= 0 && MaterialPool.Num() > MaxNumPooledMaterials)
+		{
+			MaterialPool.Remove(Key);
+		}
+	}
+}
+
+// Remove the unused materials if the pool is above its limit
+void ASLVizHighlightManager::TrimMaterialPool()
+{
+	for (auto It = MaterialPool.CreateIterator(); It && MaterialPool.Num() > MaxNumPooledMaterials; ++It)
+	{
+		if (It->Value.NumUsers <= 0)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+// Set the material key of the slots (all slots if empty), outputs the slots which changed and the keys they used before
+void ASLVizHighlightManager::AssignSlotKeys(UMeshComponent* MC, const TArray<int32>& MaterialSlots, const FSLVizHighlightMaterialKey& Key,
+	bool bOnlyHighlighted, TArray<int32>& OutChangedSlots, TArray<FSLVizHighlightMaterialKey>& OutReleasedKeys)
+{
+	FSLVizHighlightData* HighlightData = HighlightedStaticMeshes.Find(MC);
+	if (!HighlightData)
+	{
+		if (bOnlyHighlighted)
+		{
+			return;
+		}
+		HighlightData = &HighlightedStaticMeshes.Add(MC, FSLVizHighlightData(MC->GetMaterials()));
+	}
+
+	auto AssignSlot = [&](int32 Slot)
+	{
+		if (!HighlightData->OriginalMaterials.IsValidIndex(Slot))
+		{
+			return;
+		}
+		if (FSLVizHighlightMaterialKey* SlotKey = HighlightData->SlotKeys.Find(Slot))
+		{
+			if (*SlotKey == Key)
+			{
+				return;
+			}
+			OutReleasedKeys.Add(*SlotKey);
+			*SlotKey = Key;
+		}
+		else if (bOnlyHighlighted)
+		{
+			return;
+		}
+		else
+		{
+			HighlightData->SlotKeys.Add(Slot, Key);
+		}
+		OutChangedSlots.Add(Slot);
+	};
+
+	if (MaterialSlots.Num() > 0)
+	{
+		for (int32 Slot : MaterialSlots)
+		{
+			AssignSlot(Slot);
+		}
+	}
+	else if (bOnlyHighlighted)
+	{
+		TArray<int32> HighlightedSlots;
+		HighlightData->SlotKeys.GetKeys(HighlightedSlots);
+		for (int32 Slot : HighlightedSlots)
+		{
+			AssignSlot(Slot);
+		}
+	}
+	else
+	{
+		for (int32 Slot = 0; Slot < HighlightData->OriginalMaterials.Num(); ++Slot)
+		{
+			AssignSlot(Slot);
+		}
+	}
+
+	// Invalid slots on a new entry
+	if (HighlightData->SlotKeys.Num() == 0)
+	{
+		HighlightedStaticMeshes.Remove(MC);
+	}
+}
+
+// Restore the original materials of the slots (all highlighted slots if empty), outputs the keys they used
+void ASLVizHighlightManager::ClearSlotKeys(UMeshComponent* MC, const TArray<int32>& MaterialSlots, TArray<FSLVizHighlightMaterialKey>& OutReleasedKeys)
+{
+	FSLVizHighlightData* HighlightData = HighlightedStaticMeshes.Find(MC);
+	if (!HighlightData)
+	{
+		return;
+	}
+
+	TArray<int32> ClearedSlots = MaterialSlots;
+	if (ClearedSlots.Num() == 0)
+	{
+		HighlightData->SlotKeys.GetKeys(ClearedSlots);
+	}
+	for (int32 Slot : ClearedSlots)
+	{
+		FSLVizHighlightMaterialKey SlotKey;
+		if (HighlightData->SlotKeys.RemoveAndCopyValue(Slot, SlotKey))
+		{
+			MC->SetMaterial(Slot, HighlightData->OriginalMaterials[Slot]);
+			OutReleasedKeys.Add(SlotKey);
+		}
+	}
+
+	// The mesh is only forgotten once none of its slots is highlighted
+	if (HighlightData->SlotKeys.Num() == 0)
+	{
+		HighlightedStaticMeshes.Remove(MC);
+	}
+}
+
+// Apply the material to the given slots
+void ASLVizHighlightManager::ApplyMaterial(UMeshComponent* MC, const TArray<int32>& MaterialSlots, UMaterialInterface* Material)
+{
+	for (int32 MatIdx : MaterialSlots)
+	{
+		MC->SetMaterial(MatIdx, Material);
+	}
+}
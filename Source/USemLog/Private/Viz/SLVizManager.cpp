@@ -8,6 +8,7 @@
 //#include "Viz/SLVizEpisodeManager.h"
 #include "Viz/SLVizEpisodeUtils.h"
 #include "Viz/SLVizCameraDirector.h"
+#include "Viz/SLVizGhostReplayManager.h"
 #include "Individuals/SLIndividualManager.h"
 
 #include "Individuals/Type/SLRigidIndividual.h"
@@ -18,6 +19,7 @@
 #include "Components/SkeletalMeshComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "EngineUtils.h"
+#include "Async/Async.h"
 
 
 #if WITH_EDITOR
@@ -36,6 +38,7 @@ ASLVizManager::ASLVizManager()
 	HighlightManager = nullptr;
 	MarkerManager = nullptr;
 	EpisodeManager = nullptr;
+	GhostReplayManager = nullptr;
 
 #if WITH_EDITORONLY_DATA
 	// Make manager sprite smaller (used to easily find the actor in the world)
@@ -109,6 +112,18 @@ void ASLVizManager::Init()
 			*FString(__FUNCTION__), __LINE__, *GetName());
 		return;
 	}
+
+	if (!SetGhostReplayManager())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d %s could not set the viz ghost replay manager.."),
+			*FString(__FUNCTION__), __LINE__, *GetName());
+		return;
+	}
+
+	EpisodeCache.SetIndividualManager(IndividualManager);
+	EpisodeCache.SetBudget(int64(EpisodeCacheBudgetMB) * 1024 * 1024, bSpillEvictedEpisodes);
+	EpisodeDiskCache.SetEnabled(bUseEpisodeDiskCache);
+	EpisodeDiskCache.SetMaxBytes(int64(EpisodeDiskCacheBudgetMB) * 1024 * 1024);
 	bIsInit = true;	
 }
 
@@ -120,8 +135,20 @@ void ASLVizManager::Reset()
 	HighlightManager = nullptr;
 	MarkerManager = nullptr;
 	EpisodeManager = nullptr;
+	if (GhostReplayManager)
+	{
+		GhostReplayManager->ClearEpisodes();
+	}
+	GhostReplayManager = nullptr;
 	bIsInit = false;
-	CachedEpisodeData.Empty();
+	QueuedCacheRequests.Empty();
+	for (const auto& IdToRequestPair : ActiveCacheRequests)
+	{
+		IdToRequestPair.Value->bCancelled = true;
+	}
+	ActiveCacheRequests.Empty();
+	EpisodeCache.LogStats();
+	EpisodeCache.Empty();
 }
 
 
@@ -145,51 +172,12 @@ bool ASLVizManager::HighlightIndividual(const FString& Id, const FLinearColor& C
 		//return false;
 	}
 
-	if (auto Individual = IndividualManager->GetIndividual(Id))
-	{
-		if (auto VI = Cast<USLVisibleIndividual>(Individual))
-		{
-			if (auto RI = Cast<USLRigidIndividual>(VI))
-			{
-				UMeshComponent* MC = RI->GetStaticMeshComponent();
-				HighlightManager->Highlight(MC, FSLVizVisualParams(Color, MaterialType));
-				HighlightedIndividuals.Add(Id, FSLVizIndividualHighlightData(MC));
-				return true;
-			}
-			else if (auto SkI = Cast<USLSkeletalIndividual>(VI))
-			{				
-				UMeshComponent* MC = SkI->GetVisibleMeshComponent();
-				HighlightManager->Highlight(MC, FSLVizVisualParams(Color, MaterialType));
-				HighlightedIndividuals.Add(Id, FSLVizIndividualHighlightData(MC));
-				return true;
-			}
-			else if (auto BI = Cast<USLBoneIndividual>(VI))
-			{
-				UMeshComponent* MC = BI->GetVisibleMeshComponent();
-				int32 MaterialIndex = BI->GetMaterialIndex();
-				HighlightManager->Highlight(MC, FSLVizVisualParams(Color, MaterialType, MaterialIndex));
-				HighlightedIndividuals.Add(Id, FSLVizIndividualHighlightData(MC, MaterialIndex));
-				return true;
-			}
-			else
-			{
-				UE_LOG(LogTemp, Warning, TEXT("%s::%d %s individual (Id=%s) is of unssuported visual type.."),
-					*FString(__FUNCTION__), __LINE__, *GetName(), *Id);
-				return false;
-			}
-		}
-		else
-		{
-			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s individual (Id=%s) is not of visible type, cannot highlight.."),
-				*FString(__FUNCTION__), __LINE__, *GetName(), *Id);
-			return false;
-		}
-	}
-	else
+	FSLVizIndividualHighlightData Target;
+	if (GetIndividualHighlightTarget(Id, Target))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s cannot find individual (Id=%s).."),
-			*FString(__FUNCTION__), __LINE__, *GetName(), *Id);
-		return false;
+		HighlightManager->Highlight(Target.MeshComponent, FSLVizVisualParams(Color, MaterialType, Target.MaterialSlots));
+		HighlightedIndividuals.Add(Id, Target);
+		return true;
 	}
 	return false;
 }
@@ -227,7 +215,7 @@ bool ASLVizManager::RemoveIndividualHighlight(const FString& Id)
 	FSLVizIndividualHighlightData HighlightData;
 	if (HighlightedIndividuals.RemoveAndCopyValue(Id, HighlightData))
 	{
-		HighlightManager->ClearHighlight(HighlightData.MeshComponent);
+		HighlightManager->ClearHighlight(HighlightData.MeshComponent, HighlightData.MaterialSlots);
 		return true;
 	}
 	else
@@ -249,11 +237,72 @@ void ASLVizManager::RemoveAllIndividualHighlights()
 
 	for (const auto& HighlightDataPair : HighlightedIndividuals)
 	{
-		HighlightManager->ClearHighlight(HighlightDataPair.Value.MeshComponent);
+		HighlightManager->ClearHighlight(HighlightDataPair.Value.MeshComponent, HighlightDataPair.Value.MaterialSlots);
 	}
 	HighlightedIndividuals.Empty();
 }
 
+// Highlight (or update) the individuals in one pass sharing a single material (returns the number of highlighted individuals)
+int32 ASLVizManager::HighlightIndividuals(const TArray<FString>& Ids, const FLinearColor& Color, ESLVizMaterialType MaterialType)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return 0;
+	}
+
+	TArray<FSLVizIndividualHighlightData> Targets;
+	Targets.Reserve(Ids.Num());
+	for (const auto& Id : Ids)
+	{
+		if (auto HD = HighlightedIndividuals.Find(Id))
+		{
+			Targets.Add(*HD);
+		}
+		else
+		{
+			FSLVizIndividualHighlightData Target;
+			if (GetIndividualHighlightTarget(Id, Target))
+			{
+				HighlightedIndividuals.Add(Id, Target);
+				Targets.Add(Target);
+			}
+		}
+	}
+
+	HighlightManager->HighlightBatch(Targets, FSLVizVisualParams(Color, MaterialType));
+	return Targets.Num();
+}
+
+// Remove the highlights of the individuals in one pass (returns the number of removed highlights)
+int32 ASLVizManager::RemoveIndividualHighlights(const TArray<FString>& Ids)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return 0;
+	}
+
+	TArray<FSLVizIndividualHighlightData> Targets;
+	Targets.Reserve(Ids.Num());
+	for (const auto& Id : Ids)
+	{
+		FSLVizIndividualHighlightData HighlightData;
+		if (HighlightedIndividuals.RemoveAndCopyValue(Id, HighlightData))
+		{
+			Targets.Add(HighlightData);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s could not find individual (Id=%s) as highlighted.."),
+				*FString(__FUNCTION__), __LINE__, *GetName(), *Id);
+		}
+	}
+
+	HighlightManager->ClearHighlightBatch(Targets);
+	return Targets.Num();
+}
+
 // Spawn or get manager from the world
 ASLVizManager* ASLVizManager::GetExistingOrSpawnNew(UWorld* World)
 {
@@ -492,7 +541,140 @@ bool ASLVizManager::CreateStaticMeshMarkerTimeline(const FString& MarkerId, cons
 }
 
 
+/* Trajectory level of detail */
+// Create a primitive marker at the trajectory poses simplified with the camera distance
+bool ASLVizManager::CreatePrimitiveMarkerLOD(const FString& MarkerId, const TArray<FTransform>& Poses,
+	ESLVizPrimitiveMarkerType PrimitiveType, float Size,
+	const FLinearColor& Color, ESLVizMaterialType MaterialType,
+	const FSLVizTrajectoryLODParams& LODParams)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+
+	if (Markers.Contains(MarkerId))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s marker (Id=%s) already exists.."),
+			*FString(__FUNCTION__), __LINE__, *GetName(), *MarkerId);
+		return false;
+	}
+
+	if (auto Marker = MarkerManager->CreatePrimitiveMarkerLOD(Poses, PrimitiveType, Size,
+		Color, MaterialType, LODParams))
+	{
+		Markers.Add(MarkerId, Marker);
+		return true;
+	}
+	return false;
+}
+
+// Create a marker by cloning the visual of the given individual at the trajectory poses simplified with the camera distance
+bool ASLVizManager::CreateStaticMeshMarkerLOD(const FString& MarkerId, const TArray<FTransform>& Poses,
+	const FString& IndividualId, const FLinearColor& Color, ESLVizMaterialType MaterialType,
+	const FSLVizTrajectoryLODParams& LODParams)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+
+	if (Markers.Contains(MarkerId))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s marker (Id=%s) already exists.."),
+			*FString(__FUNCTION__), __LINE__, *GetName(), *MarkerId);
+		return false;
+	}
+
+	if (auto Individual = IndividualManager->GetIndividual(IndividualId))
+	{
+		if (auto RI = Cast<USLRigidIndividual>(Individual))
+		{
+			UStaticMesh* SM = RI->GetStaticMeshComponent()->GetStaticMesh();
+			if (auto Marker = MarkerManager->CreateStaticMeshMarkerLOD(Poses, SM, Color, MaterialType, LODParams))
+			{
+				Markers.Add(MarkerId, Marker);
+				return true;
+			};
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s individual (Id=%s) is not of rigid visible type, cannot create a clone marker.."),
+				*FString(__FUNCTION__), __LINE__, *GetName(), *IndividualId);
+			return false;
+		}
+	}
+	return false;
+}
+
+
+/* Trajectory (single mesh) */
+// Create a line or ribbon trajectory marker
+bool ASLVizManager::CreateTrajectoryMarker(const FString& MarkerId, const TArray<FTransform>& Poses,
+	const FSLVizTrajectoryParams& TrajectoryParams, ESLVizMaterialType MaterialType)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+
+	if (Markers.Contains(MarkerId))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s marker (Id=%s) already exists.."),
+			*FString(__FUNCTION__), __LINE__, *GetName(), *MarkerId);
+		return false;
+	}
+
+	if (auto Marker = MarkerManager->CreateTrajectoryMarker(Poses, TrajectoryParams, MaterialType))
+	{
+		Markers.Add(MarkerId, Marker);
+		return true;
+	}
+	return false;
+}
+
+// Create a line or ribbon trajectory marker timeline
+bool ASLVizManager::CreateTrajectoryMarkerTimeline(const FString& MarkerId, const TArray<FTransform>& Poses,
+	const FSLVizTrajectoryParams& TrajectoryParams, ESLVizMaterialType MaterialType,
+	const FSLVizTimelineParams& TimelineParams)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+
+	if (Markers.Contains(MarkerId))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s marker (Id=%s) already exists.."),
+			*FString(__FUNCTION__), __LINE__, *GetName(), *MarkerId);
+		return false;
+	}
+
+	if (auto Marker = MarkerManager->CreateTrajectoryMarkerTimeline(Poses, TrajectoryParams, MaterialType, TimelineParams))
+	{
+		Markers.Add(MarkerId, Marker);
+		return true;
+	}
+	return false;
+}
+
+
 /* Skeletal mesh */
+// Set the max number of poseable mesh instances of the next skeletal markers (more poses are evenly subsampled)
+void ASLVizManager::SetSkeletalMarkerMaxNumInstances(int32 Value)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return;
+	}
+	MarkerManager->SetSkeletalMarkerMaxNumInstances(Value);
+}
+
 // Create a marker by cloning the visual of the given skeletal individual (use original materials)
 bool ASLVizManager::CreateSkeletalMeshMarker(const FString& MarkerId,
 	const TArray<TPair<FTransform, TMap<int32, FTransform>>>& SkeletalPoses,
@@ -670,27 +852,18 @@ bool ASLVizManager::CreateBoneMeshMarker(const FString& MarkerId, const TArray<F
 	{
 		if (auto BI = Cast<USLBoneIndividual>(Individual))
 		{
-			//USkeletalMesh* SkelM = BI->GetSkeletalMeshComponent()->SkeletalMesh;
-			//int32 BoneIndex = BI->GetBoneIndex();
-			//int32 MaterialIndex = BI->GetMaterialIndex();
-			//TArray<TMap<int32, FTransform>> BonePosesArray;
-			//for (const auto& T : Poses)
-			//{
-			//	TMap< int32, FTransform> Map;
-			//	Map.Emplace(BoneIndex, T);
-			//	BonePosesArray.Emplace(Map);
-			//}
-
-			//if (auto Marker = MarkerManager->CreateSkeletalMarker(Poses, SkelM,
-			//	BonePosesArray, TArray<int32>{MaterialIndex}))
-			//{
-			//	Markers.Add(MarkerId, Marker);
-			//	return true;
-			//};
+			// The bone geometry is extracted once and shared by all the bone markers
+			USkeletalMesh* SkelM = BI->GetSkeletalMeshComponent()->SkeletalMesh;
+			if (auto Marker = MarkerManager->CreateSkeletalBoneMarker(Poses, SkelM,
+				BI->GetBoneIndex(), BI->GetMaterialIndex()))
+			{
+				Markers.Add(MarkerId, Marker);
+				return true;
+			};
 		}
 		else
 		{
-			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s individual (Id=%s) is not of skeletal visible type, cannot create a clone marker.."),
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s individual (Id=%s) is not of bone type, cannot create a bone marker.."),
 				*FString(__FUNCTION__), __LINE__, *GetName(), *IndividualId);
 			return false;
 		}
@@ -701,9 +874,6 @@ bool ASLVizManager::CreateBoneMeshMarker(const FString& MarkerId, const TArray<F
 // Create a marker by cloning the visual of the given individual
 bool ASLVizManager::CreateBoneMeshMarker(const FString& MarkerId, const TArray<FTransform>& Poses, const FString& IndividualId, const FLinearColor& Color, ESLVizMaterialType MaterialType)
 {
-	// TODO
-	UE_LOG(LogTemp, Error, TEXT("%s::%d TODO "), *FString(__FUNCTION__), __LINE__);
-
 	if (!bIsInit)
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
@@ -721,27 +891,17 @@ bool ASLVizManager::CreateBoneMeshMarker(const FString& MarkerId, const TArray<F
 	{
 		if (auto BI = Cast<USLBoneIndividual>(Individual))
 		{
-			//USkeletalMesh* SkelM = BI->GetSkeletalMeshComponent()->SkeletalMesh;
-			//int32 BoneIndex = BI->GetBoneIndex();
-			//int32 MaterialIndex = BI->GetMaterialIndex();
-			//TArray<TMap<int32, FTransform>> BonePosesArray;
-			//for (const auto& T : Poses)
-			//{
-			//	TMap< int32, FTransform> Map;
-			//	Map.Emplace(BoneIndex, T);
-			//	BonePosesArray.Emplace(Map);
-			//}
-			//
-			//if (auto Marker = MarkerManager->CreateSkeletalMarker(Poses, SkelM, Color, MaterialType,
-			//	BonePosesArray, TArray<int32>{MaterialIndex}))
-			//{
-			//	Markers.Add(MarkerId, Marker);
-			//	return true;
-			//};
+			USkeletalMesh* SkelM = BI->GetSkeletalMeshComponent()->SkeletalMesh;
+			if (auto Marker = MarkerManager->CreateSkeletalBoneMarker(Poses, SkelM,
+				BI->GetBoneIndex(), BI->GetMaterialIndex(), Color, MaterialType))
+			{
+				Markers.Add(MarkerId, Marker);
+				return true;
+			};
 		}
 		else
 		{
-			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s individual (Id=%s) is not of skeletal visible type, cannot create a clone marker.."),
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s individual (Id=%s) is not of bone type, cannot create a bone marker.."),
 				*FString(__FUNCTION__), __LINE__, *GetName(), *IndividualId);
 			return false;
 		}
@@ -751,23 +911,6 @@ bool ASLVizManager::CreateBoneMeshMarker(const FString& MarkerId, const TArray<F
 
 // Create a timeline marker by cloning the visual of the given individual
 bool ASLVizManager::CreateBoneMeshMarkerTimeline(const FString& MarkerId, const TArray<FTransform>& Poses, const FString& IndividualId, const FSLVizTimelineParams& TimelineParams)
-{
-	// TODO
-	UE_LOG(LogTemp, Error, TEXT("%s::%d TODO "), *FString(__FUNCTION__), __LINE__);
-	return false;
-}
-
-// Create a timeline marker by cloning the visual of the given individual
-bool ASLVizManager::CreateBoneMeshMarkerTimeline(const FString& MarkerId, const TArray<FTransform>& Poses, const FString& IndividualId, const FLinearColor& Color, ESLVizMaterialType MaterialType, const FSLVizTimelineParams& TimelineParams)
-{
-	// TODO
-	UE_LOG(LogTemp, Error, TEXT("%s::%d TODO "), *FString(__FUNCTION__), __LINE__);
-	return false;
-}
-
-
-// Remove marker with the given id
-bool ASLVizManager::RemoveMarker(const FString& Id)
 {
 	if (!bIsInit)
 	{
@@ -775,35 +918,112 @@ bool ASLVizManager::RemoveMarker(const FString& Id)
 		return false;
 	}
 
-	USLVizBaseMarker* RemovedMarker = nullptr;
-	if (Markers.RemoveAndCopyValue(Id, RemovedMarker))
-	{
-		MarkerManager->ClearMarker(RemovedMarker);
-		return true;
-	}
-	return false;
-}
-
-// Remove all markers
-void ASLVizManager::RemoveAllMarkers()
-{
-	if (!bIsInit)
+	if (Markers.Contains(MarkerId))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
-		return;
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s marker (Id=%s) already exists.."),
+			*FString(__FUNCTION__), __LINE__, *GetName(), *MarkerId);
+		return false;
 	}
 
-	for (const auto& IdMarkerPair : Markers)
+	if (auto Individual = IndividualManager->GetIndividual(IndividualId))
 	{
-		MarkerManager->ClearMarker(IdMarkerPair.Value);
+		if (auto BI = Cast<USLBoneIndividual>(Individual))
+		{
+			USkeletalMesh* SkelM = BI->GetSkeletalMeshComponent()->SkeletalMesh;
+			if (auto Marker = MarkerManager->CreateSkeletalBoneMarkerTimeline(Poses, SkelM,
+				BI->GetBoneIndex(), BI->GetMaterialIndex(), TimelineParams))
+			{
+				Markers.Add(MarkerId, Marker);
+				return true;
+			};
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s individual (Id=%s) is not of bone type, cannot create a bone marker.."),
+				*FString(__FUNCTION__), __LINE__, *GetName(), *IndividualId);
+			return false;
+		}
 	}
-	Markers.Empty();
+	return false;
 }
 
-
-/* Episode replay */
-// Setup the world for episode replay (remove physics, pause simulation, change skeletal meshes to poseable meshes)
-bool ASLVizManager::ConvertWorldToVisualizationMode()
+// Create a timeline marker by cloning the visual of the given individual
+bool ASLVizManager::CreateBoneMeshMarkerTimeline(const FString& MarkerId, const TArray<FTransform>& Poses, const FString& IndividualId, const FLinearColor& Color, ESLVizMaterialType MaterialType, const FSLVizTimelineParams& TimelineParams)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+
+	if (Markers.Contains(MarkerId))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s marker (Id=%s) already exists.."),
+			*FString(__FUNCTION__), __LINE__, *GetName(), *MarkerId);
+		return false;
+	}
+
+	if (auto Individual = IndividualManager->GetIndividual(IndividualId))
+	{
+		if (auto BI = Cast<USLBoneIndividual>(Individual))
+		{
+			USkeletalMesh* SkelM = BI->GetSkeletalMeshComponent()->SkeletalMesh;
+			if (auto Marker = MarkerManager->CreateSkeletalBoneMarkerTimeline(Poses, SkelM,
+				BI->GetBoneIndex(), BI->GetMaterialIndex(), Color, MaterialType, TimelineParams))
+			{
+				Markers.Add(MarkerId, Marker);
+				return true;
+			};
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s individual (Id=%s) is not of bone type, cannot create a bone marker.."),
+				*FString(__FUNCTION__), __LINE__, *GetName(), *IndividualId);
+			return false;
+		}
+	}
+	return false;
+}
+
+
+// Remove marker with the given id
+bool ASLVizManager::RemoveMarker(const FString& Id)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+
+	USLVizBaseMarker* RemovedMarker = nullptr;
+	if (Markers.RemoveAndCopyValue(Id, RemovedMarker))
+	{
+		MarkerManager->ClearMarker(RemovedMarker);
+		return true;
+	}
+	return false;
+}
+
+// Remove all markers
+void ASLVizManager::RemoveAllMarkers()
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return;
+	}
+
+	for (const auto& IdMarkerPair : Markers)
+	{
+		MarkerManager->ClearMarker(IdMarkerPair.Value);
+	}
+	Markers.Empty();
+}
+
+
+/* Episode replay */
+// Setup the world for episode replay (remove physics, pause simulation, change skeletal meshes to poseable meshes)
+bool ASLVizManager::ConvertWorldToVisualizationMode()
 {
 	if (!bIsInit)
 	{
@@ -861,15 +1081,31 @@ bool ASLVizManager::IsWorldConvertedToVisualizationMode() const
 	return EpisodeManager->IsWorldConverted();
 }
 
+// Set the episode cache memory budget in MB (0 for unlimited)
+void ASLVizManager::SetEpisodeCacheBudget(int32 MaxMB, bool bSpillToDisk)
+{
+	EpisodeCacheBudgetMB = MaxMB;
+	bSpillEvictedEpisodes = bSpillToDisk;
+	EpisodeCache.SetBudget(int64(EpisodeCacheBudgetMB) * 1024 * 1024, bSpillEvictedEpisodes);
+}
+
+// Set the persistent disk cache size budget in MB (0 for unlimited)
+void ASLVizManager::SetEpisodeDiskCacheBudget(int32 MaxMB)
+{
+	EpisodeDiskCacheBudgetMB = FMath::Max(MaxMB, 0);
+	EpisodeDiskCache.SetMaxBytes(int64(EpisodeDiskCacheBudgetMB) * 1024 * 1024);
+	EpisodeDiskCache.EnforceMaxBytes();
+}
+
 // Cache the episode data
-bool ASLVizManager::CacheEpisodeData(const FString& Id, const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData)
+bool ASLVizManager::CacheEpisodeData(const FString& Id, const FSLMongoEpisodeData& InMongoEpisodeData)
 {
 	if (!bIsInit)
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
 		return false;
 	}
-	if (InMongoEpisodeData.Num() == 0)
+	if (InMongoEpisodeData.IsEmpty())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s the episode data is empty.."), *FString(__FUNCTION__), __LINE__, *GetName());
 		return false;
@@ -881,11 +1117,11 @@ bool ASLVizManager::CacheEpisodeData(const FString& Id, const TArray<TPair<float
 	}
 
 	// Create and reserve episode data with the array size
-	FSLVizEpisodeData VizEpisodeData(InMongoEpisodeData.Num());
+	FSLVizEpisodeData VizEpisodeData(InMongoEpisodeData.NumFrames());
 	VizEpisodeData.Id = Id;
 	if (FSLVizEpisodeUtils::BuildEpisodeData(IndividualManager, InMongoEpisodeData, VizEpisodeData))
 	{
-		CachedEpisodeData.Add(Id, VizEpisodeData);
+		EpisodeCache.Add(Id, MoveTemp(VizEpisodeData));
 		return true;
 	}
 	else
@@ -895,6 +1131,84 @@ bool ASLVizManager::CacheEpisodeData(const FString& Id, const TArray<TPair<float
 	}
 }
 
+// Cache the episode in the background, the data is fetched on a worker thread, only the actor binding runs on the game thread
+bool ASLVizManager::CacheEpisodeDataAsync(const FString& Id, TFunction<FSLMongoEpisodeData()> FetchFunc,
+	TFunction<void(const FString&, bool)> OnCached,
+	const FString& TaskId, TFunction<bool(FSLMongoEpisodeMetadata&)> MetadataFunc)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+	if (IsEpisodeCached(Id) || IsEpisodeBeingCached(Id))
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d %s the episode (%s) is already cached or being cached.."), *FString(__FUNCTION__), __LINE__, *GetName(), *Id);
+		return true;
+	}
+
+	TSharedPtr<FSLVizEpisodeCacheRequest> Request = MakeShared<FSLVizEpisodeCacheRequest>();
+	Request->Id = Id;
+	Request->FetchFunc = MoveTemp(FetchFunc);
+	Request->OnCached = MoveTemp(OnCached);
+	Request->TaskId = TaskId;
+	Request->MetadataFunc = MoveTemp(MetadataFunc);
+	QueuedCacheRequests.Add(Request);
+	StartQueuedCacheRequests();
+	return true;
+}
+
+// Cache the episode from the disk cache if it matches the metadata (returns false if not available or stale)
+bool ASLVizManager::CacheEpisodeDataFromDisk(const FString& TaskId, const FString& Id, const FSLMongoEpisodeMetadata& Metadata)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+	if (IsEpisodeCached(Id))
+	{
+		return true;
+	}
+
+	FSLVizEpisodeData VizEpisodeData;
+	if (EpisodeDiskCache.Read(TaskId, Id, Metadata, VizEpisodeData)
+		&& FSLVizEpisodeUtils::ResolveEpisodeData(IndividualManager, VizEpisodeData))
+	{
+		VizEpisodeData.Id = Id;
+		EpisodeCache.Add(Id, MoveTemp(VizEpisodeData));
+		return true;
+	}
+	return false;
+}
+
+// Write the cached episode with its metadata to the disk cache
+bool ASLVizManager::WriteEpisodeDataToDisk(const FString& TaskId, const FString& Id, const FSLMongoEpisodeMetadata& Metadata)
+{
+	if (const FSLVizEpisodeData* EpisodeData = EpisodeCache.Find(Id))
+	{
+		return EpisodeDiskCache.Write(TaskId, Id, Metadata, *EpisodeData);
+	}
+	return false;
+}
+
+// Check if the episode is queued or being cached in the background
+bool ASLVizManager::IsEpisodeBeingCached(const FString& Id) const
+{
+	if (ActiveCacheRequests.Contains(Id))
+	{
+		return true;
+	}
+	for (const auto& Request : QueuedCacheRequests)
+	{
+		if (Request->Id.Equals(Id))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 // Load cached episode data
 bool ASLVizManager::LoadCachedEpisodeData(const FString& Id)
 {
@@ -908,13 +1222,14 @@ bool ASLVizManager::LoadCachedEpisodeData(const FString& Id)
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s cannot load episode data because the world is not set as visual only.."), *FString(__FUNCTION__), __LINE__, *GetName());
 		return false;
 	}
-	if (!IsEpisodeCached(Id))
+	const FSLVizEpisodeData* EpisodeData = EpisodeCache.Find(Id);
+	if (!EpisodeData)
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s the episode (%s) data is not cached.."), *FString(__FUNCTION__), __LINE__, *GetName(), *Id);
 		return false;
 	}
 	
-	EpisodeManager->LoadEpisode(CachedEpisodeData[Id]);
+	EpisodeManager->LoadEpisode(*EpisodeData);
 	return true;
 }
 
@@ -926,14 +1241,15 @@ bool ASLVizManager::ReplayCachedEpisode(const FString& Id, const FSLVizEpisodePl
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
 		return false;
 	}
-	if (!IsEpisodeCached(Id))
-	{
-		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s episode (%s) is not cached.."), *FString(__FUNCTION__), __LINE__, *GetName(), *Id);
-		return false;
-	}
 	if (!EpisodeManager->GetEpisodeId().Equals(Id))
 	{
-		EpisodeManager->LoadEpisode(CachedEpisodeData[Id]);
+		const FSLVizEpisodeData* EpisodeData = EpisodeCache.Find(Id);
+		if (!EpisodeData)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s episode (%s) is not cached.."), *FString(__FUNCTION__), __LINE__, *GetName(), *Id);
+			return false;
+		}
+		EpisodeManager->LoadEpisode(*EpisodeData);
 	}
 
 	return EpisodeManager->Play(Params);
@@ -947,21 +1263,22 @@ bool ASLVizManager::GotoCachedEpisodeFrame(const FString& Id, float Ts)
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
 		return false;
 	}
-	if (!IsEpisodeCached(Id))
-	{
-		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s episode (%s) is not cached.."), *FString(__FUNCTION__), __LINE__, *GetName(), *Id);
-		return false;
-	}
 	if (!EpisodeManager->GetEpisodeId().Equals(Id))
 	{
-		EpisodeManager->LoadEpisode(CachedEpisodeData[Id]);
+		const FSLVizEpisodeData* EpisodeData = EpisodeCache.Find(Id);
+		if (!EpisodeData)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s episode (%s) is not cached.."), *FString(__FUNCTION__), __LINE__, *GetName(), *Id);
+			return false;
+		}
+		EpisodeManager->LoadEpisode(*EpisodeData);
 	}
 
 	return EpisodeManager->GotoFrame(Ts);
 }
 
 // Change the data into an episode format and load it to the episode replay manager
-void ASLVizManager::LoadEpisodeData(const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData)
+void ASLVizManager::LoadEpisodeData(const FSLMongoEpisodeData& InMongoEpisodeData)
 {
 	if (!bIsInit)
 	{
@@ -973,7 +1290,7 @@ void ASLVizManager::LoadEpisodeData(const TArray<TPair<float, TMap<FString, FTra
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s cannot load episode data because the world is not set as visual only.."), *FString(__FUNCTION__), __LINE__, *GetName());
 		return;
 	}
-	if (InMongoEpisodeData.Num() == 0)
+	if (InMongoEpisodeData.IsEmpty())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s the episode data is empty.."), *FString(__FUNCTION__), __LINE__, *GetName());
 		return;
@@ -981,7 +1298,7 @@ void ASLVizManager::LoadEpisodeData(const TArray<TPair<float, TMap<FString, FTra
 
 
 	// Create and reserve episode data with the array size
-	FSLVizEpisodeData VizEpisodeData(InMongoEpisodeData.Num());
+	FSLVizEpisodeData VizEpisodeData(InMongoEpisodeData.NumFrames());
 	if (FSLVizEpisodeUtils::BuildEpisodeData(IndividualManager, InMongoEpisodeData, VizEpisodeData))
 	{
 		EpisodeManager->LoadEpisode(VizEpisodeData);
@@ -1063,6 +1380,95 @@ void ASLVizManager::StopReplay()
 	EpisodeManager->StopReplay();
 }
 
+// Set the replay speed factor (negative values replay in reverse)
+void ASLVizManager::SetReplaySpeed(float Speed)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return;
+	}
+	EpisodeManager->SetReplaySpeed(Speed);
+	GhostReplayManager->SetReplaySpeed(Speed);
+}
+
+/* Ghost replay */
+// Add the cached episode to the multi episode ghost replay (replayed on pooled clones with the given tint and time offset)
+bool ASLVizManager::AddGhostEpisode(const FString& Id, float TimeOffset, const FSLVizVisualParams& VisualParams)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+	// The ghost episode shares the cached data, it stays valid if the cache evicts the episode
+	TSharedPtr<const FSLVizEpisodeData> EpisodeData = EpisodeCache.FindShared(Id);
+	if (!EpisodeData.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s could not find episode %s in the cache.."), *FString(__FUNCTION__), __LINE__, *GetName(), *Id);
+		return false;
+	}
+	return GhostReplayManager->AddEpisode(EpisodeData, TimeOffset, VisualParams) != INDEX_NONE;
+}
+
+// Remove all the ghost episodes (the clones are kept in the pool for the next session)
+void ASLVizManager::ClearGhostEpisodes()
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return;
+	}
+	GhostReplayManager->ClearEpisodes();
+}
+
+// Spawn the ghost clones of the cached episode ahead of time
+void ASLVizManager::PrewarmGhostPool(const FString& Id, int32 NumSets)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return;
+	}
+	if (const FSLVizEpisodeData* EpisodeData = EpisodeCache.Find(Id))
+	{
+		GhostReplayManager->PrewarmPool(*EpisodeData, NumSets);
+	}
+}
+
+// Replay all the ghost episodes from a single clock
+bool ASLVizManager::PlayGhostEpisodes(const FSLVizEpisodePlayParams& Params)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+	return GhostReplayManager->Play(Params);
+}
+
+// Set the ghost episodes as in the given time
+void ASLVizManager::GotoGhostEpisodesTime(float Ts)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return;
+	}
+	GhostReplayManager->GotoTime(Ts);
+}
+
+// Pause/unpause the ghost replay
+void ASLVizManager::PauseGhostReplay(bool bPause)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return;
+	}
+	GhostReplayManager->SetPauseReplay(bPause);
+}
+
 // Move the view to a given position
 void ASLVizManager::SetCameraView(const FTransform& Pose)
 {
@@ -1115,8 +1521,214 @@ void ASLVizManager::DetachCameraView()
 	CameraDirector->DetachCamera();
 }
 
+// Move the camera view along a spline through the keyframes, driven by the episode replay time
+bool ASLVizManager::SetCameraViewPath(const TArray<FSLVizCameraKeyframe>& Keyframes)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+
+	FSLVizCameraPath Path;
+	if (!Path.Build(Keyframes))
+	{
+		return false;
+	}
+	CameraDirector->SetCameraPath(Path, EpisodeManager);
+	return CameraDirector->HasCameraPath();
+}
+
+// Move the camera view along a precomputed path framing the individuals over the loaded episode
+bool ASLVizManager::SetCameraViewFramingPath(const TArray<FString>& Ids, const FSLVizCameraFramingParams& Params)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
 
+	TArray<AActor*> Actors;
+	for (const auto& Id : Ids)
+	{
+		if (auto Individual = IndividualManager->GetIndividual(Id))
+		{
+			Actors.Add(Individual->GetParentActor());
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s could not find individual %s, skipping.."), *FString(__FUNCTION__), __LINE__, *GetName(), *Id);
+		}
+	}
 
+	// The whole path is computed upfront, the replay only evaluates the curves
+	TArray<float> SampleTimes;
+	TArray<TArray<FVector>> TargetLocations;
+	if (!EpisodeManager->SampleActorLocations(Actors, Params.SampleInterval, SampleTimes, TargetLocations))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s could not sample the individuals from the episode.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+
+	FSLVizCameraPath Path;
+	if (!Path.BuildFraming(SampleTimes, TargetLocations, Params))
+	{
+		return false;
+	}
+	UE_LOG(LogTemp, Log, TEXT("%s::%d %s built framing path of %d individuals with %d samples.."),
+		*FString(__FUNCTION__), __LINE__, *GetName(), Actors.Num(), SampleTimes.Num());
+	CameraDirector->SetCameraPath(Path, EpisodeManager);
+	return CameraDirector->HasCameraPath();
+}
+
+// Stop following the camera view path
+void ASLVizManager::ClearCameraViewPath()
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return;
+	}
+	CameraDirector->ClearCameraPath();
+}
+
+
+
+
+/* Background caching */
+// Start the queued caching requests up to the concurrency limit
+void ASLVizManager::StartQueuedCacheRequests()
+{
+	while (QueuedCacheRequests.Num() > 0 && ActiveCacheRequests.Num() < MaxConcurrentEpisodeCaching)
+	{
+		TSharedPtr<FSLVizEpisodeCacheRequest> Request = QueuedCacheRequests[0];
+		QueuedCacheRequests.RemoveAt(0);
+		ActiveCacheRequests.Add(Request->Id, Request);
+		UE_LOG(LogTemp, Log, TEXT("%s::%d %s fetching episode %s in the background (active=%d, queued=%d).."),
+			*FString(__FUNCTION__), __LINE__, *GetName(), *Request->Id, ActiveCacheRequests.Num(), QueuedCacheRequests.Num());
+
+		DispatchCacheRequestRead(Request, true);
+	}
+}
+
+// Read the request data on a worker thread (from the disk cache if allowed and up to date, otherwise from the database)
+void ASLVizManager::DispatchCacheRequestRead(TSharedPtr<FSLVizEpisodeCacheRequest> Request, bool bAllowDiskCache)
+{
+	// The disk cache only holds its settings, a copy is used on the worker thread
+	const bool bUseDiskCache = EpisodeDiskCache.IsEnabled() && !Request->TaskId.IsEmpty() && Request->MetadataFunc;
+	const FSLVizEpisodeDiskCache DiskCache = EpisodeDiskCache;
+
+	// Read the data on a worker thread, continue on the game thread for the actor binding
+	TWeakObjectPtr<ASLVizManager> WeakThis(this);
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, Request, bUseDiskCache, bAllowDiskCache, DiskCache]()
+	{
+		if (Request->bCancelled)
+		{
+			return;
+		}
+		if (bUseDiskCache && !Request->Metadata.IsValid())
+		{
+			Request->MetadataFunc(Request->Metadata);
+		}
+		Request->bReadFromDisk = bUseDiskCache && bAllowDiskCache
+			&& DiskCache.Read(Request->TaskId, Request->Id, Request->Metadata, Request->VizEpisodeData);
+		if (!Request->bReadFromDisk && !Request->bCancelled)
+		{
+			Request->MongoEpisodeData = Request->FetchFunc();
+		}
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Request]()
+		{
+			if (WeakThis.IsValid())
+			{
+				WeakThis->OnCacheRequestFetched(Request);
+			}
+		});
+	});
+}
+
+// Bind the fetched episode on the game thread and fill it in the background
+void ASLVizManager::OnCacheRequestFetched(TSharedPtr<FSLVizEpisodeCacheRequest> Request)
+{
+	// Skip requests from before a reset
+	if (!bIsInit || ActiveCacheRequests.FindRef(Request->Id) != Request)
+	{
+		return;
+	}
+
+	// Data read from the disk cache only needs its actors and bones resolved, re-read from the database if that fails
+	if (Request->bReadFromDisk)
+	{
+		Request->VizEpisodeData.Id = Request->Id;
+		if (FSLVizEpisodeUtils::ResolveEpisodeData(IndividualManager, Request->VizEpisodeData))
+		{
+			FinishCacheRequest(Request, true);
+		}
+		else
+		{
+			DispatchCacheRequestRead(Request, false);
+		}
+		return;
+	}
+
+	if (Request->MongoEpisodeData.IsEmpty())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s the episode (%s) data is empty.."), *FString(__FUNCTION__), __LINE__, *GetName(), *Request->Id);
+		FinishCacheRequest(Request, false);
+		return;
+	}
+
+	Request->VizEpisodeData.Id = Request->Id;
+	if (!FSLVizEpisodeUtils::BindEpisodeData(IndividualManager, Request->MongoEpisodeData,
+		Request->VizEpisodeData, Request->ActorSources, Request->BoneSources))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s could not bind episode %s.."), *FString(__FUNCTION__), __LINE__, *GetName(), *Request->Id);
+		FinishCacheRequest(Request, false);
+		return;
+	}
+
+	// Fill the keyframes and change lists on a worker thread, and store the result in the disk cache
+	const bool bUseDiskCache = EpisodeDiskCache.IsEnabled() && !Request->TaskId.IsEmpty();
+	const FSLVizEpisodeDiskCache DiskCache = EpisodeDiskCache;
+	TWeakObjectPtr<ASLVizManager> WeakThis(this);
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, Request, bUseDiskCache, DiskCache]()
+	{
+		if (Request->bCancelled)
+		{
+			return;
+		}
+		FSLVizEpisodeUtils::FillEpisodeData(Request->MongoEpisodeData, Request->ActorSources, Request->BoneSources, Request->VizEpisodeData);
+		Request->MongoEpisodeData.Clear();
+		if (bUseDiskCache)
+		{
+			DiskCache.Write(Request->TaskId, Request->Id, Request->Metadata, Request->VizEpisodeData);
+		}
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Request]()
+		{
+			if (WeakThis.IsValid() && WeakThis->bIsInit && WeakThis->ActiveCacheRequests.FindRef(Request->Id) == Request)
+			{
+				WeakThis->FinishCacheRequest(Request, true);
+			}
+		});
+	});
+}
+
+// Add the filled episode to the cache and notify the listeners
+void ASLVizManager::FinishCacheRequest(TSharedPtr<FSLVizEpisodeCacheRequest> Request, bool bSuccess)
+{
+	ActiveCacheRequests.Remove(Request->Id);
+	if (bSuccess)
+	{
+		EpisodeCache.Add(Request->Id, MoveTemp(Request->VizEpisodeData));
+		UE_LOG(LogTemp, Log, TEXT("%s::%d %s cached episode %s in the background.."), *FString(__FUNCTION__), __LINE__, *GetName(), *Request->Id);
+	}
+
+	if (Request->OnCached)
+	{
+		Request->OnCached(Request->Id, bSuccess);
+	}
+	OnEpisodeCached.Broadcast(Request->Id, bSuccess);
+	StartQueuedCacheRequests();
+}
 
 /* Managers */
 // Get the individual manager from the world (or spawn a new one)
@@ -1173,6 +1785,52 @@ bool ASLVizManager::SetVizHighlightManager()
 	return true;
 }
 
+// Get the mesh component and the material slots to highlight of the individual (returns false if not of a supported visual type)
+bool ASLVizManager::GetIndividualHighlightTarget(const FString& Id, FSLVizIndividualHighlightData& OutTarget) const
+{
+	if (auto Individual = IndividualManager->GetIndividual(Id))
+	{
+		if (auto VI = Cast<USLVisibleIndividual>(Individual))
+		{
+			if (auto RI = Cast<USLRigidIndividual>(VI))
+			{
+				OutTarget = FSLVizIndividualHighlightData(RI->GetStaticMeshComponent());
+				return true;
+			}
+			else if (auto SkI = Cast<USLSkeletalIndividual>(VI))
+			{				
+				OutTarget = FSLVizIndividualHighlightData(SkI->GetVisibleMeshComponent());
+				return true;
+			}
+			else if (auto BI = Cast<USLBoneIndividual>(VI))
+			{
+				OutTarget = FSLVizIndividualHighlightData(BI->GetVisibleMeshComponent(), BI->GetMaterialIndex());
+				return true;
+			}
+			else
+			{
+				UE_LOG(LogTemp, Warning, TEXT("%s::%d %s individual (Id=%s) is of unssuported visual type.."),
+					*FString(__FUNCTION__), __LINE__, *GetName(), *Id);
+				return false;
+			}
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s individual (Id=%s) is not of visible type, cannot highlight.."),
+				*FString(__FUNCTION__), __LINE__, *GetName(), *Id);
+			return false;
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s cannot find individual (Id=%s).."),
+			*FString(__FUNCTION__), __LINE__, *GetName(), *Id);
+		return false;
+	}
+	return false;
+}
+
+
 // Get the vizualization marker manager from the world (or spawn a new one)
 bool ASLVizManager::SetVizMarkerManager()
 {
@@ -1253,3 +1911,30 @@ bool ASLVizManager::SetCameraDirector()
 #endif // WITH_EDITOR
 	return true;
 }
+
+// Get the ghost replay manager from the world (or spawn a new one)
+bool ASLVizManager::SetGhostReplayManager()
+{
+	if (GhostReplayManager && GhostReplayManager->IsValidLowLevel() && !GhostReplayManager->IsPendingKillOrUnreachable())
+	{
+		return true;
+	}
+
+	for (TActorIterator<ASLVizGhostReplayManager>Iter(GetWorld()); Iter; ++Iter)
+	{
+		if ((*Iter)->IsValidLowLevel() && !(*Iter)->IsPendingKillOrUnreachable())
+		{
+			GhostReplayManager = *Iter;
+			return true;
+		}
+	}
+
+	// Spawning a new manager
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Name = TEXT("SL_GhostReplayManager");
+	GhostReplayManager = GetWorld()->SpawnActor<ASLVizGhostReplayManager>(SpawnParams);
+#if WITH_EDITOR
+	GhostReplayManager->SetActorLabel(TEXT("SL_GhostReplayManager"));
+#endif // WITH_EDITOR
+	return true;
+}
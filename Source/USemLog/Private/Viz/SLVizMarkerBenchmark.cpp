@@ -0,0 +1,376 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Viz/SLVizMarkerBenchmark.h"
+#include "Viz/SLVizMarkerManager.h"
+#include "Viz/SLVizHighlightManager.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/SkeletalMesh.h"
+#include "Components/StaticMeshComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformMemory.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectArray.h"
+
+// Console command to run the benchmark
+static FAutoConsoleCommand SLVizMarkerBenchmarkCmd(
+	TEXT("SL.Viz.MarkerBenchmark"),
+	TEXT("Marker and highlight stress benchmark, args: Markers= Poses= Skeletal= SkeletalPoses= Highlights= Updates= StaticMesh= SkeletalMesh= Seed="),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&FSLVizMarkerBenchmark::RunFromArgs));
+
+// Take a snapshot of the current counters
+FSLVizBenchmarkCounters FSLVizBenchmarkCounters::Capture()
+{
+	FSLVizBenchmarkCounters Counters;
+	Counters.NumObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+#if !UE_BUILD_SHIPPING
+	Counters.MallocCalls = FMalloc::TotalMallocCalls;
+	Counters.FreeCalls = FMalloc::TotalFreeCalls;
+	Counters.ReallocCalls = FMalloc::TotalReallocCalls;
+#endif // !UE_BUILD_SHIPPING
+	Counters.UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	Counters.Time = FPlatformTime::Seconds();
+	return Counters;
+}
+
+// Run the benchmark, outputs the results as json (returns false on errors)
+bool FSLVizMarkerBenchmark::Run(const FSLVizMarkerBenchmarkParams& Params, FString& OutJson)
+{
+	if (!GEngine || Params.NumPoses < 1 || Params.NumSkeletalPoses < 1)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Invalid benchmark parameters or no engine available.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	UStaticMesh* StaticMesh = LoadObject<UStaticMesh>(nullptr, *Params.StaticMeshPath);
+	if (!StaticMesh)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not load the static mesh %s.."), *FString(__FUNCTION__), __LINE__, *Params.StaticMeshPath);
+		return false;
+	}
+
+	// Skeletal markers require a mesh
+	USkeletalMesh* SkeletalMesh = nullptr;
+	int32 NumBones = 0;
+	if (Params.NumSkeletal > 0)
+	{
+		SkeletalMesh = LoadObject<USkeletalMesh>(nullptr, *Params.SkeletalMeshPath);
+		if (!SkeletalMesh)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not load the skeletal mesh %s.."), *FString(__FUNCTION__), __LINE__, *Params.SkeletalMeshPath);
+			return false;
+		}
+#if ENGINE_MINOR_VERSION > 26 || ENGINE_MAJOR_VERSION > 4
+		NumBones = SkeletalMesh->GetRefSkeleton().GetNum();
+#else
+		NumBones = SkeletalMesh->RefSkeleton.GetNum();
+#endif
+	}
+
+	// Transient world, the level of the caller is left untouched (rooted to survive the measured garbage collections)
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("SLVizMarkerBenchmark"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->AddToRoot();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	ASLVizMarkerManager* MarkerManager = World->SpawnActor<ASLVizMarkerManager>(SpawnParams);
+	ASLVizHighlightManager* HighlightManager = World->SpawnActor<ASLVizHighlightManager>(SpawnParams);
+
+	// Random poses and colors (generated upfront, not part of the measurements)
+	FRandomStream RandomStream(Params.Seed);
+	auto GeneratePoses = [&RandomStream](int32 Num)
+	{
+		TArray<FTransform> Poses;
+		Poses.Reserve(Num);
+		FVector Loc = RandomStream.GetUnitVector() * RandomStream.FRandRange(0.f, 1000.f);
+		for (int32 PoseIdx = 0; PoseIdx < Num; ++PoseIdx)
+		{
+			Loc += RandomStream.GetUnitVector() * 5.f;
+			Poses.Emplace(FQuat(RandomStream.GetUnitVector(), RandomStream.FRandRange(0.f, PI)), Loc);
+		}
+		return Poses;
+	};
+	auto GenerateColor = [&RandomStream]()
+	{
+		return FLinearColor(RandomStream.FRand(), RandomStream.FRand(), RandomStream.FRand());
+	};
+
+	TArray<TArray<FTransform>> MarkerPoses;
+	TArray<TArray<FTransform>> UpdatePoses;
+	for (int32 MarkerIdx = 0; MarkerIdx < Params.NumMarkers; ++MarkerIdx)
+	{
+		MarkerPoses.Add(GeneratePoses(Params.NumPoses));
+		UpdatePoses.Add(GeneratePoses(Params.NumPoses));
+	}
+
+	TArray<TArray<TPair<FTransform, TMap<int32, FTransform>>>> SkeletalPoses;
+	for (int32 SkelIdx = 0; SkelIdx < Params.NumSkeletal; ++SkelIdx)
+	{
+		TArray<TPair<FTransform, TMap<int32, FTransform>>>& MarkerSkeletalPoses = SkeletalPoses.AddDefaulted_GetRef();
+		for (const FTransform& Pose : GeneratePoses(Params.NumSkeletalPoses))
+		{
+			TPair<FTransform, TMap<int32, FTransform>> SkeletalPose;
+			SkeletalPose.Key = Pose;
+			for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+			{
+				SkeletalPose.Value.Add(BoneIdx, FTransform(FQuat(RandomStream.GetUnitVector(), RandomStream.FRandRange(0.f, 0.5f)),
+					Pose.GetLocation() + RandomStream.GetUnitVector() * 20.f));
+			}
+			MarkerSkeletalPoses.Add(MoveTemp(SkeletalPose));
+		}
+	}
+
+	TArray<FSLVizIndividualHighlightData> HighlightTargets;
+	for (int32 HighlightIdx = 0; HighlightIdx < Params.NumHighlights; ++HighlightIdx)
+	{
+		AStaticMeshActor* SMA = World->SpawnActor<AStaticMeshActor>(SpawnParams);
+		SMA->GetStaticMeshComponent()->SetStaticMesh(StaticMesh);
+		HighlightTargets.Emplace(SMA->GetStaticMeshComponent());
+	}
+
+	TArray<FString> Operations;
+	MeasureGC(TEXT("gc_baseline"), Operations);
+
+	/* Primitive markers */
+	TArray<USLVizPrimitiveMarker*> PrimitiveMarkers;
+	Measure(TEXT("primitive_create"), Params.NumMarkers, [&]()
+	{
+		for (int32 MarkerIdx = 0; MarkerIdx < Params.NumMarkers; ++MarkerIdx)
+		{
+			PrimitiveMarkers.Add(MarkerManager->CreatePrimitiveMarker(MarkerPoses[MarkerIdx],
+				ESLVizPrimitiveMarkerType::Box, 0.05f, FLinearColor::Green, ESLVizMaterialType::Unlit));
+		}
+	}, Operations);
+	for (int32 UpdateIdx = 0; UpdateIdx < Params.NumUpdates; ++UpdateIdx)
+	{
+		const FLinearColor Color = GenerateColor();
+		Measure(TEXT("primitive_update"), Params.NumMarkers, [&]()
+		{
+			for (int32 MarkerIdx = 0; MarkerIdx < PrimitiveMarkers.Num(); ++MarkerIdx)
+			{
+				PrimitiveMarkers[MarkerIdx]->SetInstances(UpdateIdx % 2 == 0 ? UpdatePoses[MarkerIdx] : MarkerPoses[MarkerIdx]);
+				PrimitiveMarkers[MarkerIdx]->UpdateMaterialColor(Color);
+			}
+		}, Operations);
+	}
+	Measure(TEXT("primitive_destroy"), Params.NumMarkers, [&]()
+	{
+		for (USLVizPrimitiveMarker* Marker : PrimitiveMarkers)
+		{
+			MarkerManager->ClearMarker(Marker);
+		}
+		PrimitiveMarkers.Empty();
+	}, Operations);
+	MeasureGC(TEXT("gc_primitive"), Operations);
+
+	/* Static mesh markers */
+	TArray<USLVizStaticMeshMarker*> StaticMeshMarkers;
+	Measure(TEXT("static_create"), Params.NumMarkers, [&]()
+	{
+		for (int32 MarkerIdx = 0; MarkerIdx < Params.NumMarkers; ++MarkerIdx)
+		{
+			StaticMeshMarkers.Add(MarkerManager->CreateStaticMeshMarker(MarkerPoses[MarkerIdx], StaticMesh,
+				FLinearColor::Green, ESLVizMaterialType::Unlit));
+		}
+	}, Operations);
+	for (int32 UpdateIdx = 0; UpdateIdx < Params.NumUpdates; ++UpdateIdx)
+	{
+		const FLinearColor Color = GenerateColor();
+		Measure(TEXT("static_update"), Params.NumMarkers, [&]()
+		{
+			for (int32 MarkerIdx = 0; MarkerIdx < StaticMeshMarkers.Num(); ++MarkerIdx)
+			{
+				StaticMeshMarkers[MarkerIdx]->SetInstances(UpdateIdx % 2 == 0 ? UpdatePoses[MarkerIdx] : MarkerPoses[MarkerIdx]);
+				StaticMeshMarkers[MarkerIdx]->UpdateMaterialColor(Color);
+			}
+		}, Operations);
+	}
+	Measure(TEXT("static_destroy"), Params.NumMarkers, [&]()
+	{
+		for (USLVizStaticMeshMarker* Marker : StaticMeshMarkers)
+		{
+			MarkerManager->ClearMarker(Marker);
+		}
+		StaticMeshMarkers.Empty();
+	}, Operations);
+	MeasureGC(TEXT("gc_static"), Operations);
+
+	/* Skeletal markers */
+	if (SkeletalMesh)
+	{
+		TArray<USLVizSkeletalMeshMarker*> SkeletalMarkers;
+		Measure(TEXT("skeletal_create"), Params.NumSkeletal, [&]()
+		{
+			for (int32 SkelIdx = 0; SkelIdx < Params.NumSkeletal; ++SkelIdx)
+			{
+				SkeletalMarkers.Add(MarkerManager->CreateSkeletalMarker(SkeletalPoses[SkelIdx], SkeletalMesh,
+					FLinearColor::Green, ESLVizMaterialType::Unlit));
+			}
+		}, Operations);
+		for (int32 UpdateIdx = 0; UpdateIdx < Params.NumUpdates; ++UpdateIdx)
+		{
+			const FLinearColor Color = GenerateColor();
+			Measure(TEXT("skeletal_update"), Params.NumSkeletal, [&]()
+			{
+				for (USLVizSkeletalMeshMarker* Marker : SkeletalMarkers)
+				{
+					Marker->UpdateMaterialColor(Color);
+				}
+			}, Operations);
+		}
+		Measure(TEXT("skeletal_destroy"), Params.NumSkeletal, [&]()
+		{
+			for (USLVizSkeletalMeshMarker* Marker : SkeletalMarkers)
+			{
+				MarkerManager->ClearMarker(Marker);
+			}
+			SkeletalMarkers.Empty();
+		}, Operations);
+		MeasureGC(TEXT("gc_skeletal"), Operations);
+	}
+
+	/* Highlights */
+	if (HighlightTargets.Num() > 0)
+	{
+		TArray<UMeshComponent*> HighlightMCs;
+		for (const auto& Target : HighlightTargets)
+		{
+			HighlightMCs.Add(Target.MeshComponent);
+		}
+
+		// One call per mesh
+		FSLVizVisualParams VisualParams;
+		Measure(TEXT("highlight_single_create"), HighlightMCs.Num(), [&]()
+		{
+			for (UMeshComponent* MC : HighlightMCs)
+			{
+				HighlightManager->Highlight(MC, VisualParams);
+			}
+		}, Operations);
+		for (int32 UpdateIdx = 0; UpdateIdx < Params.NumUpdates; ++UpdateIdx)
+		{
+			VisualParams.Color = GenerateColor();
+			Measure(TEXT("highlight_single_update"), HighlightMCs.Num(), [&]()
+			{
+				for (UMeshComponent* MC : HighlightMCs)
+				{
+					HighlightManager->UpdateHighlight(MC, VisualParams);
+				}
+			}, Operations);
+		}
+		Measure(TEXT("highlight_single_destroy"), HighlightMCs.Num(), [&]()
+		{
+			for (UMeshComponent* MC : HighlightMCs)
+			{
+				HighlightManager->ClearHighlight(MC);
+			}
+		}, Operations);
+		MeasureGC(TEXT("gc_highlight_single"), Operations);
+
+		// Batch calls
+		VisualParams = FSLVizVisualParams();
+		Measure(TEXT("highlight_batch_create"), HighlightMCs.Num(), [&]()
+		{
+			HighlightManager->HighlightBatch(HighlightTargets, VisualParams);
+		}, Operations);
+		for (int32 UpdateIdx = 0; UpdateIdx < Params.NumUpdates; ++UpdateIdx)
+		{
+			VisualParams.Color = GenerateColor();
+			Measure(TEXT("highlight_batch_update"), HighlightMCs.Num(), [&]()
+			{
+				HighlightManager->HighlightBatch(HighlightTargets, VisualParams);
+			}, Operations);
+		}
+		Measure(TEXT("highlight_batch_destroy"), HighlightMCs.Num(), [&]()
+		{
+			HighlightManager->ClearHighlightBatch(HighlightTargets);
+		}, Operations);
+		MeasureGC(TEXT("gc_highlight_batch"), Operations);
+	}
+
+	OutJson = FString::Printf(TEXT("{\n\t\"params\": {\n\t\t\"markers\": %d,\n\t\t\"poses\": %d,\n\t\t\"skeletal\": %d,\n\t\t\"skeletal_poses\": %d,\n\t\t\"bones\": %d,\n\t\t\"highlights\": %d,\n\t\t\"updates\": %d,\n\t\t\"static_mesh\": \"%s\",\n\t\t\"seed\": %d,\n\t\t\"allocations_tracked\": %s\n\t},\n"),
+		Params.NumMarkers, Params.NumPoses, Params.NumSkeletal, Params.NumSkeletalPoses, NumBones, Params.NumHighlights,
+		Params.NumUpdates, *Params.StaticMeshPath, Params.Seed, UE_BUILD_SHIPPING ? TEXT("false") : TEXT("true"));
+	OutJson.Append(TEXT("\t\"operations\": [\n"));
+	OutJson.Append(FString::Join(Operations, TEXT(",\n")));
+	OutJson.Append(TEXT("\n\t]\n}\n"));
+
+	// Cleanup
+	MarkerManager->ClearAllMarkers();
+	HighlightManager->ClearAllHighlights();
+	World->RemoveFromRoot();
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return true;
+}
+
+// Run the benchmark from the console command arguments and write the results to file
+void FSLVizMarkerBenchmark::RunFromArgs(const TArray<FString>& Args)
+{
+	const FString Cmd = FString::Join(Args, TEXT(" "));
+	FSLVizMarkerBenchmarkParams Params;
+	FParse::Value(*Cmd, TEXT("Markers="), Params.NumMarkers);
+	FParse::Value(*Cmd, TEXT("Poses="), Params.NumPoses);
+	FParse::Value(*Cmd, TEXT("Skeletal="), Params.NumSkeletal);
+	FParse::Value(*Cmd, TEXT("SkeletalPoses="), Params.NumSkeletalPoses);
+	FParse::Value(*Cmd, TEXT("Highlights="), Params.NumHighlights);
+	FParse::Value(*Cmd, TEXT("Updates="), Params.NumUpdates);
+	FParse::Value(*Cmd, TEXT("StaticMesh="), Params.StaticMeshPath);
+	FParse::Value(*Cmd, TEXT("SkeletalMesh="), Params.SkeletalMeshPath);
+	FParse::Value(*Cmd, TEXT("Seed="), Params.Seed);
+
+	FString Json;
+	if (!Run(Params, Json))
+	{
+		return;
+	}
+
+	const FString Path = FPaths::ProjectDir() + TEXT("/SL/Benchmarks/MarkerBenchmark_")
+		+ FDateTime::Now().ToString(TEXT("%Y%m%d_%H%M%S")) + TEXT(".json");
+	if (FFileHelper::SaveStringToFile(Json, *Path))
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d Marker benchmark results written to %s:\n%s"), *FString(__FUNCTION__), __LINE__, *Path, *Json);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not write the marker benchmark results to %s.."), *FString(__FUNCTION__), __LINE__, *Path);
+	}
+}
+
+// Run the operation and append its measurements to the json operations array
+void FSLVizMarkerBenchmark::Measure(const FString& Name, int32 NumItems, TFunctionRef<void()> Operation, TArray<FString>& OutOperations)
+{
+	const FSLVizBenchmarkCounters Before = FSLVizBenchmarkCounters::Capture();
+	Operation();
+	const FSLVizBenchmarkCounters After = FSLVizBenchmarkCounters::Capture();
+
+	const double Duration = After.Time - Before.Time;
+	const bool bTracked = Before.MallocCalls >= 0;
+	OutOperations.Add(FString::Printf(TEXT("\t\t{ \"name\": \"%s\", \"items\": %d, \"game_thread\": %f, \"per_item_us\": %f, \"objects_delta\": %d, \"malloc_calls\": %lld, \"free_calls\": %lld, \"realloc_calls\": %lld, \"used_memory_delta\": %lld }"),
+		*Name, NumItems, Duration, NumItems > 0 ? Duration * 1e6 / NumItems : 0.0,
+		After.NumObjects - Before.NumObjects,
+		bTracked ? After.MallocCalls - Before.MallocCalls : -1,
+		bTracked ? After.FreeCalls - Before.FreeCalls : -1,
+		bTracked ? After.ReallocCalls - Before.ReallocCalls : -1,
+		int64(After.UsedPhysical) - int64(Before.UsedPhysical)));
+}
+
+// Run a full garbage collection and append its measurements (objects purged, duration)
+void FSLVizMarkerBenchmark::MeasureGC(const FString& Name, TArray<FString>& OutOperations)
+{
+	const FSLVizBenchmarkCounters Before = FSLVizBenchmarkCounters::Capture();
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+	const FSLVizBenchmarkCounters After = FSLVizBenchmarkCounters::Capture();
+
+	OutOperations.Add(FString::Printf(TEXT("\t\t{ \"name\": \"%s\", \"items\": 0, \"game_thread\": %f, \"objects_purged\": %d, \"used_memory_delta\": %lld }"),
+		*Name, After.Time - Before.Time, Before.NumObjects - After.NumObjects,
+		int64(After.UsedPhysical) - int64(Before.UsedPhysical)));
+}
@@ -5,11 +5,18 @@
 #include "Viz/Markers/SLVizBaseMarker.h"
 #include "UObject/ConstructorHelpers.h"
 #include "Materials/MaterialInstanceDynamic.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/StaticMesh.h"
 
 // Sets default values for this component's properties
 ASLVizMarkerManager::ASLVizMarkerManager()
 {
-	PrimaryActorTick.bCanEverTick = false;
+	// Ticks only while camera distance based trajectory markers exist
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	PrimaryActorTick.TickInterval = TrajectoryLODUpdateInterval;
 	// Add a default root component to have the markers attached to something
 	// commented out since it is not being attached ATM
 	//RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("ManagerRootComponent"));
@@ -20,6 +27,29 @@ void ASLVizMarkerManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 	ClearAllMarkers();
+	BoneMeshCache.Empty();
+}
+
+// Called every update interval, sets the camera distance based trajectory levels
+void ASLVizMarkerManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	if (!PC || !PC->PlayerCameraManager)
+	{
+		return;
+	}
+
+	const FVector CameraLocation = PC->PlayerCameraManager->GetCameraLocation();
+	for (auto& MarkerLODPair : TrajectoryLODMarkers)
+	{
+		if (MarkerLODPair.Value.Params.bUseCameraDistance)
+		{
+			ApplyTrajectoryLOD(MarkerLODPair.Key, MarkerLODPair.Value,
+				GetCameraToleranceScale(MarkerLODPair.Value, CameraLocation));
+		}
+	}
 }
 
 // Clear marker
@@ -28,6 +58,10 @@ void ASLVizMarkerManager::ClearMarker(USLVizBaseMarker* Marker)
 	// Destroy only if managed by this manager
 	if (Markers.Remove(Marker) > 0)
 	{
+		if (TrajectoryLODMarkers.Remove(Cast<USLVizStaticMeshMarker>(Marker)) > 0)
+		{
+			UpdateTickEnabled();
+		}
 		if (Marker && Marker->IsValidLowLevel() && !Marker->IsPendingKillOrUnreachable())
 		{
 			Marker->DestroyComponent();
@@ -48,6 +82,8 @@ void ASLVizMarkerManager::ClearAllMarkers()
 		}
 	}
 	Markers.Empty();
+	TrajectoryLODMarkers.Empty();
+	UpdateTickEnabled();
 }
 
 // Create a static mesh visual marker at the given pose (use original material)
@@ -145,11 +181,79 @@ USLVizPrimitiveMarker* ASLVizMarkerManager::CreatePrimitiveMarkerTimeline(const
 	return Marker;
 }
 
+// Create a static mesh visual marker at the simplified poses
+USLVizStaticMeshMarker* ASLVizMarkerManager::CreateStaticMeshMarkerLOD(const TArray<FTransform>& Poses, UStaticMesh* SM,
+	const FLinearColor& InColor, ESLVizMaterialType MaterialType,
+	const FSLVizTrajectoryLODParams& LODParams)
+{
+	auto Marker = CreateAndAddNewMarker<USLVizStaticMeshMarker>(this);
+	Marker->SetVisual(SM, InColor, MaterialType);
+	AddTrajectoryLODMarker(Marker, Poses, LODParams);
+	return Marker;
+}
+
+// Create a primitive marker at the simplified poses
+USLVizPrimitiveMarker* ASLVizMarkerManager::CreatePrimitiveMarkerLOD(const TArray<FTransform>& Poses,
+	ESLVizPrimitiveMarkerType PrimitiveType, float Size,
+	const FLinearColor& InColor, ESLVizMaterialType MaterialType,
+	const FSLVizTrajectoryLODParams& LODParams)
+{
+	auto Marker = CreateAndAddNewMarker<USLVizPrimitiveMarker>(this);
+	Marker->SetVisual(PrimitiveType, Size, InColor, MaterialType);
+	AddTrajectoryLODMarker(Marker, Poses, LODParams);
+	return Marker;
+}
+
+// Update the level of detail parameters of a trajectory marker (the poses are kept)
+void ASLVizMarkerManager::SetMarkerLODParams(USLVizStaticMeshMarker* Marker, const FSLVizTrajectoryLODParams& LODParams)
+{
+	FSLVizTrajectoryLODMarker* LODMarker = TrajectoryLODMarkers.Find(Marker);
+	if (!LODMarker)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Marker is not a trajectory level of detail marker.."), *FString(__FUNCTION__), __LINE__);
+		return;
+	}
+
+	// The ranking depends on the tolerances ratio, rank again only if the tolerances changed
+	if (LODParams.PositionTolerance != LODMarker->Params.PositionTolerance
+		|| LODParams.AngleTolerance != LODMarker->Params.AngleTolerance)
+	{
+		const TArray<FTransform> Poses = LODMarker->LOD.GetOriginalPoses();
+		LODMarker->LOD.Init(Poses, LODParams.PositionTolerance, LODParams.AngleTolerance);
+	}
+	LODMarker->Params = LODParams;
+	LODMarker->ToleranceScale = -1.f;
+	ApplyTrajectoryLOD(Marker, *LODMarker, 1.f);
+	UpdateTickEnabled();
+}
+
+// Create a line or ribbon trajectory marker at the given poses
+USLVizTrajectoryMarker* ASLVizMarkerManager::CreateTrajectoryMarker(const TArray<FTransform>& Poses,
+	const FSLVizTrajectoryParams& TrajectoryParams, ESLVizMaterialType MaterialType)
+{
+	auto Marker = CreateAndAddNewMarker<USLVizTrajectoryMarker>(this);
+	Marker->SetVisual(TrajectoryParams, MaterialType);
+	Marker->SetPoses(Poses);
+	return Marker;
+}
+
+// Create a line or ribbon trajectory marker timeline at the given poses
+USLVizTrajectoryMarker* ASLVizMarkerManager::CreateTrajectoryMarkerTimeline(const TArray<FTransform>& Poses,
+	const FSLVizTrajectoryParams& TrajectoryParams, ESLVizMaterialType MaterialType,
+	const FSLVizTimelineParams& TimelineParams)
+{
+	auto Marker = CreateAndAddNewMarker<USLVizTrajectoryMarker>(this);
+	Marker->SetVisual(TrajectoryParams, MaterialType);
+	Marker->SetPoses(Poses, TimelineParams);
+	return Marker;
+}
+
 // Create a skeletal mesh based marker at the given pose (use original material)
 USLVizSkeletalMeshMarker* ASLVizMarkerManager::CreateSkeletalMarker(const TPair<FTransform, TMap<int32, FTransform>>& SkeletalPose,
 	USkeletalMesh* SkelMesh)
 {
 	auto Marker = CreateAndAddNewMarker<USLVizSkeletalMeshMarker>(this);
+	Marker->SetMaxNumInstances(SkeletalMarkerMaxNumInstances);
 	Marker->SetVisual(SkelMesh);
 	Marker->AddInstance(SkeletalPose);
 	return Marker;
@@ -160,6 +264,7 @@ USLVizSkeletalMeshMarker* ASLVizMarkerManager::CreateSkeletalMarker(const TPair<
 	USkeletalMesh* SkelMesh, const FLinearColor& InColor, ESLVizMaterialType MaterialType)
 {
 	auto Marker = CreateAndAddNewMarker<USLVizSkeletalMeshMarker>(this);
+	Marker->SetMaxNumInstances(SkeletalMarkerMaxNumInstances);
 	Marker->SetVisual(SkelMesh, InColor, MaterialType);
 	Marker->AddInstance(SkeletalPose);
 	return Marker;
@@ -170,6 +275,7 @@ USLVizSkeletalMeshMarker* ASLVizMarkerManager::CreateSkeletalMarker(const TArray
 	USkeletalMesh* SkelMesh)
 {
 	auto Marker = CreateAndAddNewMarker<USLVizSkeletalMeshMarker>(this);
+	Marker->SetMaxNumInstances(SkeletalMarkerMaxNumInstances);
 	Marker->SetVisual(SkelMesh);
 	Marker->AddInstances(SkeletalPoses);
 	return Marker;
@@ -180,7 +286,7 @@ USLVizSkeletalMeshMarker* ASLVizMarkerManager::CreateSkeletalMarker(const TArray
 	USkeletalMesh* SkelMesh, const FLinearColor& InColor,ESLVizMaterialType MaterialType)
 {
 	auto Marker = CreateAndAddNewMarker<USLVizSkeletalMeshMarker>(this);
-
+	Marker->SetMaxNumInstances(SkeletalMarkerMaxNumInstances);
 	Marker->SetVisual(SkelMesh, InColor, MaterialType);
 	Marker->AddInstances(SkeletalPoses);
 	return Marker;
@@ -190,6 +296,7 @@ USLVizSkeletalMeshMarker* ASLVizMarkerManager::CreateSkeletalMarker(const TArray
 USLVizSkeletalMeshMarker* ASLVizMarkerManager::CreateSkeletalMarkerTimeline(const TArray<TPair<FTransform, TMap<int32, FTransform>>>& SkeletalPoses, USkeletalMesh* SkelMesh, const FSLVizTimelineParams& TimelineParams)
 {
 	auto Marker = CreateAndAddNewMarker<USLVizSkeletalMeshMarker>(this);
+	Marker->SetMaxNumInstances(SkeletalMarkerMaxNumInstances);
 	Marker->SetVisual(SkelMesh);
 	Marker->AddInstances(SkeletalPoses, TimelineParams);
 	return Marker;
@@ -202,44 +309,188 @@ USLVizSkeletalMeshMarker* ASLVizMarkerManager::CreateSkeletalMarkerTimeline(cons
 	const FSLVizTimelineParams& TimelineParams)
 {
 	auto Marker = CreateAndAddNewMarker<USLVizSkeletalMeshMarker>(this);
+	Marker->SetMaxNumInstances(SkeletalMarkerMaxNumInstances);
 	Marker->SetVisual(SkelMesh, InColor, MaterialType);
 	Marker->AddInstances(SkeletalPoses, TimelineParams);
 	return Marker;
 }
 
 // Create a skeletal bone visual marker at the given pose (use original material)
-USLVizSkeletalMeshMarker* ASLVizMarkerManager::CreateSkeletalBoneMarker(const FTransform& Pose, USkeletalMesh* SkelMesh, int32 MaterialIndex)
+USLVizSkeletalBoneMeshMarker* ASLVizMarkerManager::CreateSkeletalBoneMarker(const FTransform& Pose, USkeletalMesh* SkelMesh, int32 BoneIndex,
+	int32 MaterialIndex)
 {
-	// TODO
-	UE_LOG(LogTemp, Error, TEXT("%s::%d TODO"), *FString(__FUNCTION__), __LINE__);
+	return CreateSkeletalBoneMarker(TArray<FTransform>{ Pose }, SkelMesh, BoneIndex, MaterialIndex);
+}
+
+// Create a skeletal bone visual marker at the given pose
+USLVizSkeletalBoneMeshMarker* ASLVizMarkerManager::CreateSkeletalBoneMarker(const FTransform& Pose, USkeletalMesh* SkelMesh, int32 BoneIndex,
+	int32 MaterialIndex,
+	const FLinearColor& InColor, ESLVizMaterialType MaterialType)
+{
+	return CreateSkeletalBoneMarker(TArray<FTransform>{ Pose }, SkelMesh, BoneIndex, MaterialIndex, InColor, MaterialType);
+}
+
+// Create a skeletal bone visual marker at the given poses (use original material)
+USLVizSkeletalBoneMeshMarker* ASLVizMarkerManager::CreateSkeletalBoneMarker(const TArray<FTransform>& Poses, USkeletalMesh* SkelMesh, int32 BoneIndex,
+	int32 MaterialIndex)
+{
+	UStaticMesh* BoneMesh = GetBoneStaticMesh(SkelMesh, BoneIndex, MaterialIndex);
+	if (!BoneMesh)
+	{
+		return nullptr;
+	}
 
 	auto Marker = CreateAndAddNewMarker<USLVizSkeletalBoneMeshMarker>(this);
-	Marker->SetVisual(SkelMesh, MaterialIndex);
-	//Marker->AddInstance(Pose);
+	Marker->SetVisual(BoneMesh);
+	Marker->AddInstances(Poses);
 	return Marker;
 }
 
-// Create a skeletal bone visual marker at the given pose
-USLVizSkeletalMeshMarker* ASLVizMarkerManager::CreateSkeletalBoneMarker(const FTransform& Pose, USkeletalMesh* SkelMesh, int32 MaterialIndex,
+// Create a skeletal bone visual marker at the given poses
+USLVizSkeletalBoneMeshMarker* ASLVizMarkerManager::CreateSkeletalBoneMarker(const TArray<FTransform>& Poses, USkeletalMesh* SkelMesh, int32 BoneIndex,
+	int32 MaterialIndex,
 	const FLinearColor& InColor, ESLVizMaterialType MaterialType)
 {
+	UStaticMesh* BoneMesh = GetBoneStaticMesh(SkelMesh, BoneIndex, MaterialIndex);
+	if (!BoneMesh)
+	{
+		return nullptr;
+	}
+
+	auto Marker = CreateAndAddNewMarker<USLVizSkeletalBoneMeshMarker>(this);
+	Marker->SetVisual(BoneMesh, InColor, MaterialType);
+	Marker->AddInstances(Poses);
+	return Marker;
+}
+
+// Create a skeletal bone timeline marker at the given poses (use original material)
+USLVizSkeletalBoneMeshMarker* ASLVizMarkerManager::CreateSkeletalBoneMarkerTimeline(const TArray<FTransform>& Poses, USkeletalMesh* SkelMesh, int32 BoneIndex,
+	int32 MaterialIndex,
+	const FSLVizTimelineParams& TimelineParams)
+{
+	UStaticMesh* BoneMesh = GetBoneStaticMesh(SkelMesh, BoneIndex, MaterialIndex);
+	if (!BoneMesh)
+	{
+		return nullptr;
+	}
+
 	auto Marker = CreateAndAddNewMarker<USLVizSkeletalBoneMeshMarker>(this);
-	Marker->SetVisual(SkelMesh, MaterialIndex, InColor, MaterialType);
-	//Marker->AddInstance(Pose);
+	Marker->SetVisual(BoneMesh);
+	Marker->AddInstances(Poses, TimelineParams);
 	return Marker;
 }
 
-// Create a skeletal bone visual marker at the given poses (use original material)
-USLVizSkeletalMeshMarker* ASLVizMarkerManager::CreateSkeletalBoneMarker(const TArray<FTransform>& Poses, USkeletalMesh* SkelMesh, int32 MaterialIndex)
+// Create a skeletal bone timeline marker at the given poses
+USLVizSkeletalBoneMeshMarker* ASLVizMarkerManager::CreateSkeletalBoneMarkerTimeline(const TArray<FTransform>& Poses, USkeletalMesh* SkelMesh, int32 BoneIndex,
+	int32 MaterialIndex,
+	const FLinearColor& InColor, ESLVizMaterialType MaterialType,
+	const FSLVizTimelineParams& TimelineParams)
 {
-	UE_LOG(LogTemp, Error, TEXT("%s::%d TODO"), *FString(__FUNCTION__), __LINE__);
-	return nullptr;
+	UStaticMesh* BoneMesh = GetBoneStaticMesh(SkelMesh, BoneIndex, MaterialIndex);
+	if (!BoneMesh)
+	{
+		return nullptr;
+	}
+
+	auto Marker = CreateAndAddNewMarker<USLVizSkeletalBoneMeshMarker>(this);
+	Marker->SetVisual(BoneMesh, InColor, MaterialType);
+	Marker->AddInstances(Poses, TimelineParams);
+	return Marker;
 }
 
-// Create a skeletal bone visual marker at the given poses
-USLVizSkeletalMeshMarker* ASLVizMarkerManager::CreateSkeletalBoneMarker(const TArray<FTransform>& Poses, USkeletalMesh* SkelMesh, int32 MaterialIndex, const FLinearColor& InColor, ESLVizMaterialType MaterialType)
+// Clear the cached bone meshes (the markers using them are cleared as well)
+void ASLVizMarkerManager::ClearBoneMeshCache()
+{
+	TArray<USLVizBaseMarker*> BoneMarkers;
+	for (auto Marker : Markers)
+	{
+		if (Marker && Marker->IsA(USLVizSkeletalBoneMeshMarker::StaticClass()))
+		{
+			BoneMarkers.Add(Marker);
+		}
+	}
+	for (auto Marker : BoneMarkers)
+	{
+		ClearMarker(Marker);
+	}
+	BoneMeshCache.Empty();
+}
+
+// Rank the trajectory poses of the marker and set its initial level
+void ASLVizMarkerManager::AddTrajectoryLODMarker(USLVizStaticMeshMarker* Marker, const TArray<FTransform>& Poses,
+	const FSLVizTrajectoryLODParams& LODParams)
+{
+	FSLVizTrajectoryLODMarker& LODMarker = TrajectoryLODMarkers.Add(Marker);
+	LODMarker.LOD.Init(Poses, LODParams.PositionTolerance, LODParams.AngleTolerance);
+	LODMarker.Params = LODParams;
+
+	// Start with the finest level, camera distance markers are updated with the next tick
+	ApplyTrajectoryLOD(Marker, LODMarker, 1.f);
+	UpdateTickEnabled();
+}
+
+// Set the marker instances to the level of the tolerance scale (skipped if the level is unchanged)
+void ASLVizMarkerManager::ApplyTrajectoryLOD(USLVizStaticMeshMarker* Marker, FSLVizTrajectoryLODMarker& LODMarker, float ToleranceScale)
+{
+	if (LODMarker.ToleranceScale == ToleranceScale)
+	{
+		return;
+	}
+	LODMarker.ToleranceScale = ToleranceScale;
+
+	TArray<FTransform> Poses;
+	LODMarker.LOD.GetPoses(ToleranceScale, LODMarker.Params.MaxNumInstances, Poses);
+	Marker->SetInstances(Poses);
+}
+
+// Get the (power of two) tolerance scale of the trajectory from the camera distance
+float ASLVizMarkerManager::GetCameraToleranceScale(const FSLVizTrajectoryLODMarker& LODMarker, const FVector& CameraLocation) const
 {
-	UE_LOG(LogTemp, Error, TEXT("%s::%d TODO"), *FString(__FUNCTION__), __LINE__);
-	return nullptr;
+	const float Distance = FMath::Sqrt(LODMarker.LOD.GetBounds().ComputeSquaredDistanceToPoint(CameraLocation));
+	const float Scale = Distance / FMath::Max(LODMarker.Params.ReferenceDistance, 1.f);
+
+	// Quantized to avoid updating the instances with every camera movement
+	return Scale <= 1.f ? 1.f : FMath::Pow(2.f, FMath::FloorToFloat(FMath::Log2(Scale)));
 }
 
+// Enable the tick only if there are camera distance based trajectory markers
+void ASLVizMarkerManager::UpdateTickEnabled()
+{
+	bool bHasCameraLODMarkers = false;
+	for (const auto& MarkerLODPair : TrajectoryLODMarkers)
+	{
+		if (MarkerLODPair.Value.Params.bUseCameraDistance)
+		{
+			bHasCameraLODMarkers = true;
+			break;
+		}
+	}
+	SetActorTickEnabled(bHasCameraLODMarkers);
+}
+
+// Get the cached static mesh of the bone geometry (extracted on the first request)
+UStaticMesh* ASLVizMarkerManager::GetBoneStaticMesh(USkeletalMesh* SkelMesh, int32 BoneIndex, int32 MaterialIndex)
+{
+	if (!SkelMesh)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d No skeletal mesh given.."), *FString(__FUNCTION__), __LINE__);
+		return nullptr;
+	}
+
+	const FString Key = FString::Printf(TEXT("%s_%d_%d"), *SkelMesh->GetPathName(), BoneIndex, MaterialIndex);
+	if (UStaticMesh** CachedMesh = BoneMeshCache.Find(Key))
+	{
+		if (*CachedMesh && (*CachedMesh)->IsValidLowLevel() && !(*CachedMesh)->IsPendingKillOrUnreachable())
+		{
+			return *CachedMesh;
+		}
+	}
+
+	// Failed extractions are not cached, the mesh data might become accessible later
+	UStaticMesh* BoneMesh = USLVizSkeletalBoneMeshMarker::CreateBoneStaticMesh(this, SkelMesh, BoneIndex, TArray<int32>{ MaterialIndex });
+	if (BoneMesh)
+	{
+		BoneMeshCache.Add(Key, BoneMesh);
+	}
+	return BoneMesh;
+}
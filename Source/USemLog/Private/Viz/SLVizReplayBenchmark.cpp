@@ -0,0 +1,222 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Viz/SLVizReplayBenchmark.h"
+#include "Viz/SLVizEpisodeManager.h"
+#include "Viz/SLVizEpisodeUtils.h"
+#include "Mongo/SLMongoEpisodeData.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/SkeletalMesh.h"
+#include "Animation/SkeletalMeshActor.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/PoseableMeshComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// Console command to run the benchmark
+static FAutoConsoleCommand SLVizReplayBenchmarkCmd(
+	TEXT("SL.Viz.ReplayBenchmark"),
+	TEXT("Replay throughput benchmark on a synthetic episode, args: Individuals= Skeletal= Frames= FrameRate= Moving= Gotos= Keyframe= SkeletalMesh= Seed="),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&FSLVizReplayBenchmark::RunFromArgs));
+
+// Run the benchmark, outputs the results as json (returns false on errors)
+bool FSLVizReplayBenchmark::Run(const FSLVizReplayBenchmarkParams& Params, FString& OutJson)
+{
+	if (!GEngine || Params.NumFrames < 3 || Params.NumIndividuals + Params.NumSkeletal < 1)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Invalid benchmark parameters or no engine available.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	// Skeletal individuals require a mesh
+	USkeletalMesh* SkeletalMesh = nullptr;
+	int32 NumBones = 0;
+	if (Params.NumSkeletal > 0)
+	{
+		SkeletalMesh = LoadObject<USkeletalMesh>(nullptr, *Params.SkeletalMeshPath);
+		if (!SkeletalMesh)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not load the skeletal mesh %s.."), *FString(__FUNCTION__), __LINE__, *Params.SkeletalMeshPath);
+			return false;
+		}
+#if ENGINE_MINOR_VERSION > 26 || ENGINE_MAJOR_VERSION > 4
+		NumBones = SkeletalMesh->GetRefSkeleton().GetNum();
+#else
+		NumBones = SkeletalMesh->RefSkeleton.GetNum();
+#endif
+	}
+
+	/* Generate */
+	double ExecBegin = FPlatformTime::Seconds();
+	FSLMongoEpisodeData MongoEpisodeData;
+	GenerateEpisodeData(Params, NumBones, MongoEpisodeData);
+	const double GenerateDuration = FPlatformTime::Seconds() - ExecBegin;
+
+	// Transient world, the level of the caller is left untouched
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("SLVizReplayBenchmark"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	FSLVizEpisodeData VizEpisodeData(Params.NumFrames);
+	VizEpisodeData.Id = TEXT("SLVizReplayBenchmark");
+	VizEpisodeData.KeyframeInterval = FMath::Max(Params.KeyframeInterval, 1);
+	TArray<int32> ActorSources;
+	TArray<int32> BoneSources;
+	for (int32 IndividualIdx = 0; IndividualIdx < Params.NumIndividuals; ++IndividualIdx)
+	{
+		AStaticMeshActor* SMA = World->SpawnActor<AStaticMeshActor>(SpawnParams);
+		SMA->SetMobility(EComponentMobility::Movable);
+		VizEpisodeData.Actors.Add(SMA);
+		VizEpisodeData.ActorIds.Add(MongoEpisodeData.IndividualIds[IndividualIdx]);
+		ActorSources.Add(IndividualIdx);
+	}
+	TArray<ASkeletalMeshActor*> SkeletalActors;
+	for (int32 SkelIdx = 0; SkelIdx < Params.NumSkeletal; ++SkelIdx)
+	{
+		ASkeletalMeshActor* SkMA = World->SpawnActor<ASkeletalMeshActor>(SpawnParams);
+		SkMA->GetSkeletalMeshComponent()->SetSkeletalMesh(SkeletalMesh);
+		SkMA->GetSkeletalMeshComponent()->SetMobility(EComponentMobility::Movable);
+		SkeletalActors.Add(SkMA);
+		const int32 ColumnIdx = Params.NumIndividuals + SkelIdx;
+		VizEpisodeData.Actors.Add(SkMA);
+		VizEpisodeData.ActorIds.Add(MongoEpisodeData.IndividualIds[ColumnIdx]);
+		ActorSources.Add(ColumnIdx);
+	}
+
+	// Convert the transient world (adds the poseable meshes of the skeletal actors)
+	ASLVizEpisodeManager* EpisodeManager = World->SpawnActor<ASLVizEpisodeManager>(SpawnParams);
+	EpisodeManager->ConvertWorld();
+	for (int32 SkelIdx = 0; SkelIdx < SkeletalActors.Num(); ++SkelIdx)
+	{
+		UPoseableMeshComponent* PMC = SkeletalActors[SkelIdx]->FindComponentByClass<UPoseableMeshComponent>();
+		for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+		{
+			const int32 ColumnIdx = Params.NumIndividuals + Params.NumSkeletal + SkelIdx * NumBones + BoneIdx;
+			VizEpisodeData.Bones.Emplace(PMC, BoneIdx);
+			VizEpisodeData.BoneIds.Add(MongoEpisodeData.IndividualIds[ColumnIdx]);
+			BoneSources.Add(ColumnIdx);
+		}
+	}
+
+	/* Build */
+	const uint64 UsedMemoryBefore = FPlatformMemory::GetStats().UsedPhysical;
+	ExecBegin = FPlatformTime::Seconds();
+	FSLVizEpisodeUtils::FillEpisodeData(MongoEpisodeData, ActorSources, BoneSources, VizEpisodeData);
+	const double BuildDuration = FPlatformTime::Seconds() - ExecBegin;
+	const int64 UsedMemoryDelta = int64(FPlatformMemory::GetStats().UsedPhysical) - int64(UsedMemoryBefore);
+
+	/* Load */
+	ExecBegin = FPlatformTime::Seconds();
+	EpisodeManager->LoadEpisode(VizEpisodeData);
+	const double LoadDuration = FPlatformTime::Seconds() - ExecBegin;
+
+	/* Sequential apply */
+	EpisodeManager->ReplayFirstFrameIndex = 0;
+	EpisodeManager->ReplayLastFrameIndex = VizEpisodeData.NumFrames() - 1;
+	EpisodeManager->GotoFrame(0);
+	int32 NumAppliedFrames = 0;
+	ExecBegin = FPlatformTime::Seconds();
+	while (EpisodeManager->ApplyNextFrameChanges())
+	{
+		NumAppliedFrames++;
+	}
+	const double ApplyDuration = FPlatformTime::Seconds() - ExecBegin;
+
+	/* Random gotos */
+	FRandomStream RandomStream(Params.Seed + 1);
+	ExecBegin = FPlatformTime::Seconds();
+	for (int32 GotoIdx = 0; GotoIdx < Params.NumGotos; ++GotoIdx)
+	{
+		EpisodeManager->GotoFrame(RandomStream.RandRange(0, VizEpisodeData.NumFrames() - 1));
+	}
+	const double GotoDuration = FPlatformTime::Seconds() - ExecBegin;
+
+	OutJson = FString::Printf(TEXT("{\n\t\"params\": {\n\t\t\"individuals\": %d,\n\t\t\"skeletal\": %d,\n\t\t\"bones\": %d,\n\t\t\"frames\": %d,\n\t\t\"frame_rate\": %f,\n\t\t\"moving_ratio\": %f,\n\t\t\"keyframe_interval\": %d,\n\t\t\"gotos\": %d,\n\t\t\"seed\": %d\n\t},\n"),
+		Params.NumIndividuals, Params.NumSkeletal, NumBones * Params.NumSkeletal, Params.NumFrames, Params.FrameRate,
+		Params.MovingRatio, VizEpisodeData.KeyframeInterval, Params.NumGotos, Params.Seed);
+	OutJson.Append(FString::Printf(TEXT("\t\"build\": {\n\t\t\"generate\": %f,\n\t\t\"duration\": %f,\n\t\t\"load\": %f,\n\t\t\"mongo_bytes\": %llu,\n\t\t\"viz_bytes\": %llu,\n\t\t\"used_memory_delta\": %lld,\n\t\t\"keyframes\": %d,\n\t\t\"changes\": %d\n\t},\n"),
+		GenerateDuration, BuildDuration, LoadDuration, (uint64)MongoEpisodeData.GetAllocatedSize(), (uint64)VizEpisodeData.GetAllocatedSize(),
+		UsedMemoryDelta, VizEpisodeData.ActorKeyframes.Num(), VizEpisodeData.ActorChanges.Num() + VizEpisodeData.BoneChanges.Num()));
+	OutJson.Append(FString::Printf(TEXT("\t\"apply\": {\n\t\t\"frames\": %d,\n\t\t\"duration\": %f,\n\t\t\"frames_per_second\": %f\n\t},\n"),
+		NumAppliedFrames, ApplyDuration, ApplyDuration > 0.0 ? NumAppliedFrames / ApplyDuration : 0.0));
+	OutJson.Append(FString::Printf(TEXT("\t\"goto\": {\n\t\t\"count\": %d,\n\t\t\"duration\": %f,\n\t\t\"gotos_per_second\": %f\n\t}\n}\n"),
+		Params.NumGotos, GotoDuration, GotoDuration > 0.0 ? Params.NumGotos / GotoDuration : 0.0));
+
+	// Cleanup
+	EpisodeManager->ClearEpisode();
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return true;
+}
+
+// Run the benchmark from the console command arguments and write the results to file
+void FSLVizReplayBenchmark::RunFromArgs(const TArray<FString>& Args)
+{
+	const FString Cmd = FString::Join(Args, TEXT(" "));
+	FSLVizReplayBenchmarkParams Params;
+	FParse::Value(*Cmd, TEXT("Individuals="), Params.NumIndividuals);
+	FParse::Value(*Cmd, TEXT("Skeletal="), Params.NumSkeletal);
+	FParse::Value(*Cmd, TEXT("Frames="), Params.NumFrames);
+	FParse::Value(*Cmd, TEXT("FrameRate="), Params.FrameRate);
+	FParse::Value(*Cmd, TEXT("Moving="), Params.MovingRatio);
+	FParse::Value(*Cmd, TEXT("Gotos="), Params.NumGotos);
+	FParse::Value(*Cmd, TEXT("Keyframe="), Params.KeyframeInterval);
+	FParse::Value(*Cmd, TEXT("SkeletalMesh="), Params.SkeletalMeshPath);
+	FParse::Value(*Cmd, TEXT("Seed="), Params.Seed);
+
+	FString Json;
+	if (!Run(Params, Json))
+	{
+		return;
+	}
+
+	const FString Path = FPaths::ProjectDir() + TEXT("/SL/Benchmarks/ReplayBenchmark_")
+		+ FDateTime::Now().ToString(TEXT("%Y%m%d_%H%M%S")) + TEXT(".json");
+	if (FFileHelper::SaveStringToFile(Json, *Path))
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d Replay benchmark results written to %s:\n%s"), *FString(__FUNCTION__), __LINE__, *Path, *Json);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not write the replay benchmark results to %s.."), *FString(__FUNCTION__), __LINE__, *Path);
+	}
+}
+
+// Generate the synthetic mongo episode data (rigid columns, skeletal root columns, then the bone columns)
+void FSLVizReplayBenchmark::GenerateEpisodeData(const FSLVizReplayBenchmarkParams& Params, int32 NumBones, FSLMongoEpisodeData& OutEpisodeData)
+{
+	const int32 NumColumns = Params.NumIndividuals + Params.NumSkeletal + Params.NumSkeletal * NumBones;
+	const int32 NumFrames = Params.NumFrames;
+	FRandomStream RandomStream(Params.Seed);
+
+	OutEpisodeData.Clear();
+	OutEpisodeData.Timestamps.SetNumUninitialized(NumFrames);
+	for (int32 FrameIdx = 0; FrameIdx < NumFrames; ++FrameIdx)
+	{
+		OutEpisodeData.Timestamps[FrameIdx] = FrameIdx / FMath::Max(Params.FrameRate, 1.f);
+	}
+
+	// Every column is recorded in the first frame, then only the moving ones (random walk)
+	OutEpisodeData.IndividualIds.Reserve(NumColumns);
+	for (int32 ColumnIdx = 0; ColumnIdx < NumColumns; ++ColumnIdx)
+	{
+		const int32 IndividualIdx = OutEpisodeData.FindOrAddIndividual(FString::Printf(TEXT("SLBench%d"), ColumnIdx));
+		FTransform Pose(FRotator::ZeroRotator, RandomStream.GetUnitVector() * RandomStream.FRandRange(0.f, 1000.f));
+		for (int32 FrameIdx = 0; FrameIdx < NumFrames; ++FrameIdx)
+		{
+			if (FrameIdx == 0 || RandomStream.FRand() < Params.MovingRatio)
+			{
+				Pose.AddToTranslation(RandomStream.GetUnitVector());
+				Pose.SetRotation(FQuat(RandomStream.GetUnitVector(), RandomStream.FRandRange(0.f, 0.05f)) * Pose.GetRotation());
+				OutEpisodeData.SetPose(IndividualIdx, FrameIdx, Pose);
+			}
+		}
+	}
+}
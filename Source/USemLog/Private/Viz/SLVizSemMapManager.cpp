@@ -20,6 +20,10 @@ ASLVizSemMapManager::ASLVizSemMapManager()
 
 	bIsInit = false;
 	bExecutingTask = false;
+	NumIndexedIndividuals = 0;
+	bVisibilityIndexDirty = true;
+	bHasBaseHidden = false;
+	bBaseHidden = false;
 
 #if WITH_EDITORONLY_DATA
 	// Make manager sprite smaller (used to easily find the actor in the world)
@@ -88,6 +92,8 @@ void ASLVizSemMapManager::Init()
 	}
 	//VizManager->ConvertWorldToVisualizationMode();
 
+	BuildVisibilityIndex();
+
 	bIsInit = true;
 	UE_LOG(LogTemp, Warning, TEXT("%s::%d %s succesfully initialized.."),
 		*FString(__FUNCTION__), __LINE__, *GetName());
@@ -118,18 +124,19 @@ void ASLVizSemMapManager::SetAllIndividualsHidden(bool bNewHidden)
 		return;
 	}
 
-	for (const auto Individual : IndividualManager->GetIndividuals())
+	UpdateVisibilityIndex();
+
+	// Every actor is visited once, even if shared by several individuals
+	for (int32 ActorIdx = 0; ActorIdx < IndexedActors.Num(); ++ActorIdx)
 	{
-		if (AActor* ParentActor = Individual->GetParentActor())
-		{
-			ParentActor->SetActorHiddenInGame(bNewHidden);
-		}
-		else
-		{
-			UE_LOG(LogTemp, Error, TEXT("%s::%d Individual %s has no valid parent actor.."), *FString(__FUNCTION__), __LINE__,
-				*Individual->GetFullName());
-		}
+		SetIndexedActorHidden(ActorIdx, bNewHidden);
 	}
+
+	// All the actors share the value now
+	bHasBaseHidden = true;
+	bBaseHidden = bNewHidden;
+	OffBaseActorIndexes.Empty();
+	OffBaseFlags.Init(false, IndexedActors.Num());
 }
 
 
@@ -154,9 +161,9 @@ void ASLVizSemMapManager::SetIndividualsHidden(const TArray<FString>& Ids, bool
 		GetWorld()->GetTimerManager().ClearTimer(IterateTimerHandle);
 		
 		// Finish up previous work
-		for (; IterateIdx < IterateIds.Num(); ++IterateIdx)
+		if (IterateIds.IsValidIndex(IterateIdx))
 		{
-			IndividualManager->GetIndividualActor(IterateIds[IterateIdx])->SetActorHiddenInGame(bIterateHiddenValue);
+			SetIndividualsHiddenBatch(TArray<FString>(IterateIds.GetData() + IterateIdx, IterateIds.Num() - IterateIdx), bIterateHiddenValue);
 		}
 		IterateIdx = INDEX_NONE;
 		IterateIds.Empty();
@@ -175,10 +182,7 @@ void ASLVizSemMapManager::SetIndividualsHidden(const TArray<FString>& Ids, bool
 	}
 	else
 	{
-		for (const auto& Id : Ids)
-		{
-			IndividualManager->GetIndividualActor(Id)->SetActorHiddenInGame(bNewHidden);
-		}
+		SetIndividualsHiddenBatch(Ids, bNewHidden);
 	}
 }
 
@@ -187,10 +191,14 @@ void ASLVizSemMapManager::SetIndividualsHiddenIterateCallback()
 {
 	if (IterateIds.IsValidIndex(IterateIdx))
 	{
+		UpdateVisibilityIndex();
 		UE_LOG(LogTemp, Log, TEXT("%s::%d::%.4f %s's iter timer trigger %d/%d.."),
 			*FString(__FUNCTION__), __LINE__, GetWorld()->GetTimeSeconds(), *GetName(),
 			IterateIdx, IterateIds.Num());
-		IndividualManager->GetIndividualActor(IterateIds[IterateIdx])->SetActorHiddenInGame(bIterateHiddenValue);
+		if (const int32* ActorIdx = IdToActorIndex.Find(IterateIds[IterateIdx]))
+		{
+			SetIndexedActorHidden(*ActorIdx, bIterateHiddenValue);
+		}
 		IterateIdx++;
 	}
 	else
@@ -204,6 +212,152 @@ void ASLVizSemMapManager::SetIndividualsHiddenIterateCallback()
 	}
 }
 
+// Hide/show the individuals in one indexed pass (only the actors changing their state are touched)
+void ASLVizSemMapManager::SetIndividualsHiddenBatch(const TArray<FString>& Ids, bool bNewHidden)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d %s is not initialized, init first.."),
+			*FString(__FUNCTION__), __LINE__, *GetName());
+		return;
+	}
+
+	UpdateVisibilityIndex();
+	for (const auto& Id : Ids)
+	{
+		if (const int32* ActorIdx = IdToActorIndex.Find(Id))
+		{
+			SetIndexedActorHidden(*ActorIdx, bNewHidden);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s could not find individual (Id=%s).."),
+				*FString(__FUNCTION__), __LINE__, *GetName(), *Id);
+		}
+	}
+}
+
+// Hide/show all the individuals of the given semantic classes
+void ASLVizSemMapManager::SetClassesHidden(const TArray<FString>& Classes, bool bNewHidden)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d %s is not initialized, init first.."),
+			*FString(__FUNCTION__), __LINE__, *GetName());
+		return;
+	}
+
+	UpdateVisibilityIndex();
+	SetGroupsHidden(ClassToActorIndexes, Classes, bNewHidden);
+}
+
+// Hide/show all the individuals of the given types (grouped by their individual type name, e.g. SkeletalIndividual)
+void ASLVizSemMapManager::SetTypesHidden(const TArray<FString>& Types, bool bNewHidden)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d %s is not initialized, init first.."),
+			*FString(__FUNCTION__), __LINE__, *GetName());
+		return;
+	}
+
+	UpdateVisibilityIndex();
+	SetGroupsHidden(TypeToActorIndexes, Types, bNewHidden);
+}
+
+// Hide/show all the individuals except the given ids, classes and types (which get the opposite value),
+// repeated queries with the same value only touch the previously and newly excepted actors
+void ASLVizSemMapManager::SetAllIndividualsHiddenExcept(const TArray<FString>& Ids, const TArray<FString>& Classes,
+	const TArray<FString>& Types, bool bNewHidden)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d %s is not initialized, init first.."),
+			*FString(__FUNCTION__), __LINE__, *GetName());
+		return;
+	}
+
+	UpdateVisibilityIndex();
+
+	// A full pass is only needed if the actors do not already share the value
+	if (!bHasBaseHidden || bBaseHidden != bNewHidden)
+	{
+		SetAllIndividualsHidden(bNewHidden);
+	}
+
+	TSet<int32> Excepted;
+	CollectIndexedActors(Ids, Classes, Types, Excepted);
+
+	// Restore the actors which are not excepted anymore
+	const TArray<int32> PrevOffBaseActorIndexes = MoveTemp(OffBaseActorIndexes);
+	OffBaseActorIndexes.Reset();
+	for (const int32 ActorIdx : PrevOffBaseActorIndexes)
+	{
+		OffBaseFlags[ActorIdx] = false;
+		if (!Excepted.Contains(ActorIdx))
+		{
+			SetIndexedActorHidden(ActorIdx, bNewHidden);
+		}
+	}
+
+	// The excepted actors are listed as off base again
+	for (const int32 ActorIdx : Excepted)
+	{
+		SetIndexedActorHidden(ActorIdx, !bNewHidden);
+	}
+}
+
+// Rebuild the id, class and type lookup of the individual actors
+void ASLVizSemMapManager::BuildVisibilityIndex()
+{
+	IndexedActors.Empty();
+	IdToActorIndex.Empty();
+	ClassToActorIndexes.Empty();
+	TypeToActorIndexes.Empty();
+
+	TMap<AActor*, int32> ActorToIndex;
+	for (const auto Individual : IndividualManager->GetIndividuals())
+	{
+		AActor* ParentActor = Individual->GetParentActor();
+		if (!ParentActor)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Individual %s has no valid parent actor.."), *FString(__FUNCTION__), __LINE__,
+				*Individual->GetFullName());
+			continue;
+		}
+
+		int32 ActorIdx = INDEX_NONE;
+		if (const int32* ExistingIdx = ActorToIndex.Find(ParentActor))
+		{
+			ActorIdx = *ExistingIdx;
+		}
+		else
+		{
+			ActorIdx = IndexedActors.Add(ParentActor);
+			ActorToIndex.Add(ParentActor, ActorIdx);
+		}
+
+		IdToActorIndex.Add(Individual->GetIdValue(), ActorIdx);
+		TArray<int32>& ClassActorIndexes = ClassToActorIndexes.FindOrAdd(Individual->GetClassValue());
+		if (ClassActorIndexes.Num() == 0 || ClassActorIndexes.Last() != ActorIdx)
+		{
+			ClassActorIndexes.Add(ActorIdx);
+		}
+		TArray<int32>& TypeActorIndexes = TypeToActorIndexes.FindOrAdd(Individual->GetTypeName());
+		if (TypeActorIndexes.Num() == 0 || TypeActorIndexes.Last() != ActorIdx)
+		{
+			TypeActorIndexes.Add(ActorIdx);
+		}
+	}
+	NumIndexedIndividuals = IndividualManager->GetIndividuals().Num();
+	bVisibilityIndexDirty = false;
+
+	// The actor indexes changed, the base value is unknown until the next hide/show all
+	bHasBaseHidden = false;
+	OffBaseActorIndexes.Empty();
+	OffBaseFlags.Init(false, IndexedActors.Num());
+}
+
 // Spawn or get manager from the world
 ASLVizSemMapManager* ASLVizSemMapManager::GetExistingOrSpawnNew(UWorld* World)
 {
@@ -280,3 +434,75 @@ bool ASLVizSemMapManager::SetVizManager()
 	return true;
 }
 
+// Rebuild the lookup if it was marked dirty or the number of individuals changed
+void ASLVizSemMapManager::UpdateVisibilityIndex()
+{
+	if (bVisibilityIndexDirty || NumIndexedIndividuals != IndividualManager->GetIndividuals().Num())
+	{
+		BuildVisibilityIndex();
+	}
+}
+
+// Set the hidden value of the indexed actor (skipped if unchanged)
+void ASLVizSemMapManager::SetIndexedActorHidden(int32 ActorIndex, bool bNewHidden)
+{
+	// Keep track of the actors differing from the hide/show all value
+	if (bHasBaseHidden && bNewHidden != bBaseHidden && !OffBaseFlags[ActorIndex])
+	{
+		OffBaseFlags[ActorIndex] = true;
+		OffBaseActorIndexes.Add(ActorIndex);
+	}
+
+	AActor* Actor = IndexedActors[ActorIndex];
+	if (Actor && !Actor->IsPendingKillOrUnreachable() && Actor->IsHidden() != bNewHidden)
+	{
+		Actor->SetActorHiddenInGame(bNewHidden);
+	}
+}
+
+// Set the hidden value of the indexed actors of the groups (classes or types)
+void ASLVizSemMapManager::SetGroupsHidden(const TMap<FString, TArray<int32>>& GroupToActorIndexes, const TArray<FString>& Groups, bool bNewHidden)
+{
+	for (const auto& Group : Groups)
+	{
+		if (const TArray<int32>* ActorIndexes = GroupToActorIndexes.Find(Group))
+		{
+			for (const int32 ActorIdx : *ActorIndexes)
+			{
+				SetIndexedActorHidden(ActorIdx, bNewHidden);
+			}
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s has no individuals of %s.."),
+				*FString(__FUNCTION__), __LINE__, *GetName(), *Group);
+		}
+	}
+}
+
+// Collect the indexed actors of the ids, classes and types
+void ASLVizSemMapManager::CollectIndexedActors(const TArray<FString>& Ids, const TArray<FString>& Classes,
+	const TArray<FString>& Types, TSet<int32>& OutActorIndexes) const
+{
+	for (const auto& Id : Ids)
+	{
+		if (const int32* ActorIdx = IdToActorIndex.Find(Id))
+		{
+			OutActorIndexes.Add(*ActorIdx);
+		}
+	}
+	for (const auto& Class : Classes)
+	{
+		if (const TArray<int32>* ActorIndexes = ClassToActorIndexes.Find(Class))
+		{
+			OutActorIndexes.Append(*ActorIndexes);
+		}
+	}
+	for (const auto& Type : Types)
+	{
+		if (const TArray<int32>* ActorIndexes = TypeToActorIndexes.Find(Type))
+		{
+			OutActorIndexes.Append(*ActorIndexes);
+		}
+	}
+}
@@ -0,0 +1,120 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Viz/SLVizSkeletalPoseApplier.h"
+#include "Viz/SLVizEpisodeManager.h"
+#include "Components/PoseableMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+
+// Precompute the mesh and bone mappings of the episode bone columns
+void FSLVizSkeletalPoseApplier::Init(const TArray<FSLVizEpisodeBoneTarget>& Bones)
+{
+	Reset();
+
+	TMap<UPoseableMeshComponent*, int32> MeshToIndex;
+	BoneColumnToMesh.Reserve(Bones.Num());
+	for (int32 ColumnIdx = 0; ColumnIdx < Bones.Num(); ++ColumnIdx)
+	{
+		UPoseableMeshComponent* PMC = Bones[ColumnIdx].PoseableMeshComponent;
+		int32 MeshIdx = INDEX_NONE;
+		if (const int32* MeshIdxPtr = MeshToIndex.Find(PMC))
+		{
+			MeshIdx = *MeshIdxPtr;
+		}
+		else
+		{
+			MeshIdx = Meshes.AddDefaulted();
+			MeshToIndex.Add(PMC, MeshIdx);
+
+			FSLVizSkeletalPoseMesh& Mesh = Meshes[MeshIdx];
+			Mesh.PoseableMeshComponent = PMC;
+#if ENGINE_MINOR_VERSION > 26 || ENGINE_MAJOR_VERSION > 4
+			const FReferenceSkeleton& RefSkeleton = PMC->SkeletalMesh->GetRefSkeleton();
+#else
+			const FReferenceSkeleton& RefSkeleton = PMC->SkeletalMesh->RefSkeleton;
+#endif
+			const int32 NumBones = RefSkeleton.GetNum();
+			Mesh.ParentIndexes.SetNumUninitialized(NumBones);
+			for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+			{
+				Mesh.ParentIndexes[BoneIdx] = RefSkeleton.GetParentIndex(BoneIdx);
+			}
+			Mesh.Columns.Init(INDEX_NONE, NumBones);
+			Mesh.ComponentSpaceTransforms.SetNumUninitialized(NumBones);
+		}
+
+		const int32 BoneIndex = Bones[ColumnIdx].BoneIndex;
+		if (Meshes[MeshIdx].Columns.IsValidIndex(BoneIndex))
+		{
+			Meshes[MeshIdx].Columns[BoneIndex] = ColumnIdx;
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Bone index %d is not valid in %s, it will be ignored.."),
+				*FString(__FUNCTION__), __LINE__, BoneIndex, *PMC->GetOwner()->GetName());
+		}
+		BoneColumnToMesh.Add(MeshIdx);
+	}
+}
+
+// Clear the mappings
+void FSLVizSkeletalPoseApplier::Reset()
+{
+	Meshes.Empty();
+	BoneColumnToMesh.Empty();
+}
+
+// Apply the bone poses of all the meshes
+void FSLVizSkeletalPoseApplier::Apply(const TArray<FTransform>& BoneState)
+{
+	for (auto& Mesh : Meshes)
+	{
+		ApplyMesh(Mesh, BoneState);
+	}
+}
+
+// Apply the bone poses of the meshes set in the mask
+void FSLVizSkeletalPoseApplier::Apply(const TArray<FTransform>& BoneState, const TBitArray<>& MeshMask)
+{
+	for (TConstSetBitIterator<> MeshItr(MeshMask); MeshItr; ++MeshItr)
+	{
+		ApplyMesh(Meshes[MeshItr.GetIndex()], BoneState);
+	}
+}
+
+// Pose the mesh in a single parent-first pass, and mark its transforms dirty once
+void FSLVizSkeletalPoseApplier::ApplyMesh(FSLVizSkeletalPoseMesh& Mesh, const TArray<FTransform>& BoneState)
+{
+	UPoseableMeshComponent* PMC = Mesh.PoseableMeshComponent;
+	TArray<FTransform>& BoneSpaceTransforms = PMC->BoneSpaceTransforms;
+	const int32 NumBones = Mesh.Columns.Num();
+	if (BoneSpaceTransforms.Num() != NumBones)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s bone transforms are not in sync with the skeleton (%d/%d).."),
+			*FString(__FUNCTION__), __LINE__, *PMC->GetOwner()->GetName(), BoneSpaceTransforms.Num(), NumBones);
+		return;
+	}
+
+	// The parents always have a lower index than their children, so their component space pose is already known
+	const FTransform& ComponentToWorld = PMC->GetComponentTransform();
+	TArray<FTransform>& ComponentSpaceTransforms = Mesh.ComponentSpaceTransforms;
+	for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+	{
+		const int32 ParentIdx = Mesh.ParentIndexes[BoneIdx];
+		const int32 ColumnIdx = Mesh.Columns[BoneIdx];
+		if (ColumnIdx != INDEX_NONE)
+		{
+			// Recorded bone, convert the world space pose to the parent bone space
+			ComponentSpaceTransforms[BoneIdx] = BoneState[ColumnIdx].GetRelativeTransform(ComponentToWorld);
+			BoneSpaceTransforms[BoneIdx] = ParentIdx == INDEX_NONE ? ComponentSpaceTransforms[BoneIdx]
+				: ComponentSpaceTransforms[BoneIdx].GetRelativeTransform(ComponentSpaceTransforms[ParentIdx]);
+		}
+		else
+		{
+			// Not recorded bone, keep its local pose
+			ComponentSpaceTransforms[BoneIdx] = ParentIdx == INDEX_NONE ? BoneSpaceTransforms[BoneIdx]
+				: BoneSpaceTransforms[BoneIdx] * ComponentSpaceTransforms[ParentIdx];
+		}
+	}
+	PMC->MarkRefreshTransformDirty();
+}
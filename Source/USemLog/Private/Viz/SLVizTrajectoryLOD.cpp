@@ -0,0 +1,133 @@
+// Copyright 2020, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Viz/SLVizTrajectoryLOD.h"
+
+// Rank the poses, the errors are normalized with the given tolerances (cm, degrees)
+void FSLVizTrajectoryLOD::Init(const TArray<FTransform>& InPoses, float PositionTolerance, float AngleTolerance)
+{
+	Poses = InPoses;
+	InvPositionTolerance = 1.f / FMath::Max(PositionTolerance, KINDA_SMALL_NUMBER);
+	InvAngleTolerance = 1.f / FMath::Max(FMath::DegreesToRadians(AngleTolerance), KINDA_SMALL_NUMBER);
+
+	const int32 NumPoses = Poses.Num();
+	Bounds = FBox(ForceInit);
+	for (const auto& Pose : Poses)
+	{
+		Bounds += Pose.GetLocation();
+	}
+
+	// The end poses are always kept
+	Errors.Init(0.f, NumPoses);
+	if (NumPoses > 0)
+	{
+		Errors[0] = MAX_flt;
+		Errors.Last() = MAX_flt;
+	}
+
+	// Douglas-Peucker splits, the error of a pose is clamped by its parent split error,
+	// this way the poses kept at any tolerance are exactly the ones with a larger error
+	struct FSegment
+	{
+		int32 First;
+		int32 Last;
+		float ParentError;
+	};
+	TArray<FSegment> Segments;
+	if (NumPoses > 2)
+	{
+		Segments.Add({ 0, NumPoses - 1, MAX_flt });
+	}
+	while (Segments.Num() > 0)
+	{
+		const FSegment Segment = Segments.Pop(false);
+		int32 SplitIdx = INDEX_NONE;
+		float SplitError = -1.f;
+		for (int32 Idx = Segment.First + 1; Idx < Segment.Last; ++Idx)
+		{
+			const float Error = GetPoseError(Segment.First, Segment.Last, Idx);
+			if (Error > SplitError)
+			{
+				SplitError = Error;
+				SplitIdx = Idx;
+			}
+		}
+
+		Errors[SplitIdx] = FMath::Min(SplitError, Segment.ParentError);
+		if (SplitIdx - Segment.First > 1)
+		{
+			Segments.Add({ Segment.First, SplitIdx, Errors[SplitIdx] });
+		}
+		if (Segment.Last - SplitIdx > 1)
+		{
+			Segments.Add({ SplitIdx, Segment.Last, Errors[SplitIdx] });
+		}
+	}
+
+	// Rank the poses by their errors (ties keep the trajectory order)
+	Ranking.SetNumUninitialized(NumPoses);
+	for (int32 Idx = 0; Idx < NumPoses; ++Idx)
+	{
+		Ranking[Idx] = Idx;
+	}
+	Ranking.Sort([this](int32 A, int32 B)
+		{
+			return Errors[A] > Errors[B] || (Errors[A] == Errors[B] && A < B);
+		});
+}
+
+// Get the simplified poses, skipped poses deviate less than the tolerances times the scale (budget ignored if negative)
+void FSLVizTrajectoryLOD::GetPoses(float ToleranceScale, int32 MaxNumPoses, TArray<FTransform>& OutPoses) const
+{
+	// Restore the trajectory order of the kept poses
+	TArray<int32> Kept(Ranking.GetData(), GetNumPoses(ToleranceScale, MaxNumPoses));
+	Kept.Sort();
+
+	OutPoses.Reset(Kept.Num());
+	for (const int32 Idx : Kept)
+	{
+		OutPoses.Add(Poses[Idx]);
+	}
+}
+
+// Get the number of poses kept at the given tolerance scale and budget
+int32 FSLVizTrajectoryLOD::GetNumPoses(float ToleranceScale, int32 MaxNumPoses) const
+{
+	// The errors are sorted, find the first pose within the tolerance
+	int32 Low = 0;
+	int32 High = Ranking.Num();
+	while (Low < High)
+	{
+		const int32 Mid = (Low + High) / 2;
+		if (Errors[Ranking[Mid]] > ToleranceScale)
+		{
+			Low = Mid + 1;
+		}
+		else
+		{
+			High = Mid;
+		}
+	}
+
+	// The end poses are kept regardless of the budget
+	return MaxNumPoses < 0 ? Low : FMath::Min(Low, FMath::Max(MaxNumPoses, FMath::Min(2, Ranking.Num())));
+}
+
+// Normalized error of the pose if it is skipped between the first and the last pose
+float FSLVizTrajectoryLOD::GetPoseError(int32 FirstIndex, int32 LastIndex, int32 Index) const
+{
+	const FTransform& First = Poses[FirstIndex];
+	const FTransform& Last = Poses[LastIndex];
+	const FVector Location = Poses[Index].GetLocation();
+
+	// Project the pose on the segment, fall back to the sample ratio for stationary segments
+	const FVector Segment = Last.GetLocation() - First.GetLocation();
+	const float SegmentSizeSquared = Segment.SizeSquared();
+	const float Alpha = SegmentSizeSquared > KINDA_SMALL_NUMBER
+		? FMath::Clamp(FVector::DotProduct(Location - First.GetLocation(), Segment) / SegmentSizeSquared, 0.f, 1.f)
+		: float(Index - FirstIndex) / float(LastIndex - FirstIndex);
+
+	const float PositionError = FVector::Dist(Location, First.GetLocation() + Segment * Alpha);
+	const float AngleError = FQuat::Slerp(First.GetRotation(), Last.GetRotation(), Alpha).AngularDistance(Poses[Index].GetRotation());
+	return FMath::Max(PositionError * InvPositionTolerance, AngleError * InvAngleTolerance);
+}
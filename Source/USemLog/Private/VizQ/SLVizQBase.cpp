@@ -18,7 +18,7 @@ void USLVizQBase::Execute(ASLKnowrobManager* KRManager)
 		return;
 	}
 
-	if (!KRManager || !KRManager->IsValidLowLevel() || KRManager->IsPendingKillOrUnreachable() || !KRManager->IsInit())
+	if (!IsKRManagerValid(KRManager))
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d %'s knowrob manager is not valid/init, aborting execution.."),
 			*FString(__FUNCTION__), __LINE__, *GetName());
@@ -37,6 +37,12 @@ void USLVizQBase::Execute(ASLKnowrobManager* KRManager)
 	}
 }
 
+// Check if the knowrob manager can be used for the execution
+bool USLVizQBase::IsKRManagerValid(ASLKnowrobManager* KRManager)
+{
+	return KRManager && KRManager->IsValidLowLevel() && !KRManager->IsPendingKillOrUnreachable() && KRManager->IsInit();
+}
+
 #if WITH_EDITOR
 // Execute function called from the editor, references need to be set manually
 void USLVizQBase::ManualExecute()
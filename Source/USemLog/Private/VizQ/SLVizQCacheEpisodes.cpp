@@ -13,10 +13,29 @@ void USLVizQCacheEpisodes::ExecuteImpl(ASLKnowrobManager* KRManager)
 	ASLVizManager* VizManager = KRManager->GetVizManager();
 	ASLMongoQueryManager* MongoQueryManager = KRManager->GetMongoQueryManager();
 
+	// Dispatch the fetches to background workers, only the actor binding runs on the game thread
+	if (bAsync)
+	{
+		VizManager->SetMaxConcurrentEpisodeCaching(MaxConcurrency);
+		for (const auto Episode : Episodes)
+		{
+			CacheEpisodeAsync(KRManager, Task, Episode);
+		}
+		return;
+	}
+
 	for (const auto Episode : Episodes)
 	{
 		if (!VizManager->IsEpisodeCached(Episode))
 		{
+			// Use the disk cache if it is up to date with the database
+			FSLMongoEpisodeMetadata Metadata;
+			MongoQueryManager->GetEpisodeMetadata(Task, Episode, Metadata);
+			if (VizManager->CacheEpisodeDataFromDisk(Task, Episode, Metadata))
+			{
+				continue;
+			}
+
 			UE_LOG(LogTemp, Log, TEXT("%s::%d Collecting episode %s::%s .."),
 				*FString(__FUNCTION__), __LINE__, *Task, *Episode);
 
@@ -26,6 +45,58 @@ void USLVizQCacheEpisodes::ExecuteImpl(ASLKnowrobManager* KRManager)
 				UE_LOG(LogTemp, Error, TEXT("%s::%d Could not cache episode %s::%s, execution aborted .."),
 					*FString(__FUNCTION__), __LINE__, *Task, *Episode);
 			}
+			else
+			{
+				VizManager->WriteEpisodeDataToDisk(Task, Episode, Metadata);
+			}
 		}
 	}
 }
+
+// The async caching only dispatches background work, it can start as soon as the query tree is scheduled
+bool USLVizQCacheEpisodes::PreDispatch(ASLKnowrobManager* KRManager)
+{
+	if (bAsync)
+	{
+		ExecuteImpl(KRManager);
+		return true;
+	}
+	return false;
+}
+
+// Queue the episode for background caching, returns false if it could not be queued
+bool USLVizQCacheEpisodes::CacheEpisodeAsync(ASLKnowrobManager* KRManager, const FString& Task, const FString& Episode)
+{
+	ASLVizManager* VizManager = KRManager->GetVizManager();
+
+	// The workers only use the shared handler, the manager can be destroyed or disconnected meanwhile
+	TSharedPtr<const FSLMongoQueryDBHandler, ESPMode::ThreadSafe> DBHandler = KRManager->GetMongoQueryManager()->GetSharedDBHandler();
+	if (!DBHandler.IsValid())
+	{
+		return false;
+	}
+	const FString TaskId = Task;
+	auto FetchFunc = [DBHandler, TaskId, Episode]()
+	{
+		return DBHandler->GetEpisodeDataPooled(TaskId, Episode);
+	};
+	auto MetadataFunc = [DBHandler, TaskId, Episode](FSLMongoEpisodeMetadata& OutMetadata)
+	{
+		return DBHandler->GetEpisodeMetadataPooled(TaskId, Episode, OutMetadata);
+	};
+	auto OnCached = [TaskId](const FString& Id, bool bSuccess)
+	{
+		if (!bSuccess)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not cache episode %s::%s .."),
+				*FString(__FUNCTION__), __LINE__, *TaskId, *Id);
+		}
+	};
+	if (!VizManager->CacheEpisodeDataAsync(Episode, FetchFunc, OnCached, TaskId, MetadataFunc))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not queue episode %s::%s for caching .."),
+			*FString(__FUNCTION__), __LINE__, *Task, *Episode);
+		return false;
+	}
+	return true;
+}
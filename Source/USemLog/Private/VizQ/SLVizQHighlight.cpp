@@ -86,17 +86,12 @@ void USLVizQHighlight::ExecuteImpl(ASLKnowrobManager* KRManager)
 	ASLVizManager* VizManager = KRManager->GetVizManager();
 	if (Action == ESLVizQHighlightAction::Highlight)
 	{
-		for (const auto& Id : Ids)
-		{
-			VizManager->HighlightIndividual(Id, Color, MaterialType);
-		}
+		// Single pass, all the individuals share one material
+		VizManager->HighlightIndividuals(Ids, Color, MaterialType);
 	}
 	else if (Action == ESLVizQHighlightAction::Remove)
 	{
-		for (const auto& Id : Ids)
-		{
-			VizManager->RemoveIndividualHighlight(Id);
-		}
+		VizManager->RemoveIndividualHighlights(Ids);
 	}
 	else if (Action == ESLVizQHighlightAction::RemoveAll)
 	{
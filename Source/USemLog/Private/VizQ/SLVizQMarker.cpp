@@ -112,38 +112,135 @@ void USLVizQMarker::PostEditChangeProperty(struct FPropertyChangedEvent& Propert
 // Virtual implementation of the execute function
 void USLVizQMarker::ExecuteImpl(ASLKnowrobManager* KRManager)
 {
-	ASLVizManager* VizManager = KRManager->GetVizManager();
 	ASLMongoQueryManager* MongoQueryManager = KRManager->GetMongoQueryManager();
-
-	/* Skeletal */
-	if (MeshType == ESLVizQMarkerMeshType::SkeletalMesh)
+	const bool bSkeletal = MeshType == ESLVizQMarkerMeshType::SkeletalMesh;
+	const bool bSinglePose = Type == ESLVizQMarkerType::Pose;
+	if (!bSinglePose && !(EndTime > 0 && EndTime > StartTime))
 	{
-		// Pose/trajectory data
-		TArray<TPair<FTransform, TMap<int32, FTransform>>> SkeletalPoses;
+		UE_LOG(LogTemp, Error, TEXT("%s::%d EndTime is not valid.."), *FString(__FUNCTION__), __LINE__);
+		return;
+	}
+
+	// Pose/trajectory data
+	FSLVizQMarkerData Data;
 
-		// Read data as pose or trajectory
-		if (Type == ESLVizQMarkerType::Pose)
+	// Read data as pose or trajectory
+	if (bSkeletal)
+	{
+		if (bSinglePose)
 		{
-			SkeletalPoses.Add(MongoQueryManager->GetSkeletalIndividualPoseAt(Task, Episode, Individual,
+			Data.SkeletalPoses.Add(MongoQueryManager->GetSkeletalIndividualPoseAt(Task, Episode, Individual,
 				StartTime));
 		}
-		else if (EndTime > 0 && EndTime > StartTime)
-		{			
-			SkeletalPoses = MongoQueryManager->GetSkeletalIndividualTrajectory(Task, Episode, Individual,
+		else
+		{
+			Data.SkeletalPoses = MongoQueryManager->GetSkeletalIndividualTrajectory(Task, Episode, Individual,
 				StartTime, EndTime, DeltaT);
 		}
+	}
+	else
+	{
+		if (bSinglePose)
+		{
+			Data.Poses.Add(MongoQueryManager->GetIndividualPoseAt(Task, Episode, Individual,
+				StartTime));
+		}
 		else
 		{
-			UE_LOG(LogTemp, Error, TEXT("%s::%d EndTime is not valid.."), *FString(__FUNCTION__), __LINE__);
-			return;
+			Data.Poses = MongoQueryManager->GetIndividualTrajectory(Task, Episode, Individual,
+				StartTime, EndTime, DeltaT);
 		}
+	}
+
+	DrawMarker(KRManager->GetVizManager(), Data);
+}
 
+// Returns the pose/trajectory fetch of the marker, the marker is drawn on the game thread
+FSLVizQFetchFunc USLVizQMarker::CreateFetchTask(ASLKnowrobManager* KRManager)
+{
+	const bool bSinglePose = Type == ESLVizQMarkerType::Pose;
+	if (!bSinglePose && !(EndTime > 0 && EndTime > StartTime))
+	{
+		// Let the direct execution report the error
+		return nullptr;
+	}
+
+	// The worker only touches the shared handler, the query objects are only accessed on the game thread
+	TSharedPtr<const FSLMongoQueryDBHandler, ESPMode::ThreadSafe> DBHandler = KRManager->GetMongoQueryManager()->GetSharedDBHandler();
+	if (!DBHandler.IsValid())
+	{
+		return nullptr;
+	}
+	TWeakObjectPtr<USLVizQMarker> WeakThis(this);
+	const bool bSkeletal = MeshType == ESLVizQMarkerMeshType::SkeletalMesh;
+	const FString TaskId = Task;
+	const FString EpisodeId = Episode;
+	const FString IndividualId = Individual;
+	const float Start = StartTime;
+	const float End = EndTime;
+	const float Delta = DeltaT;
+	return [DBHandler, WeakThis, bSkeletal, bSinglePose, TaskId, EpisodeId, IndividualId, Start, End, Delta]() -> FSLVizQApplyFunc
+	{
+		FSLVizQMarkerData Data;
+		FetchDataThreadSafe(*DBHandler, TaskId, EpisodeId, IndividualId, bSkeletal, bSinglePose, Start, End, Delta, Data);
+		return [WeakThis, Data](ASLKnowrobManager* KR)
+		{
+			if (USLVizQMarker* Marker = WeakThis.Get())
+			{
+				Marker->DrawMarker(KR->GetVizManager(), Data);
+			}
+		};
+	};
+}
+
+// Fetch the pose/trajectory data with pooled connections of the shared handler (safe to call from worker threads)
+void USLVizQMarker::FetchDataThreadSafe(const FSLMongoQueryDBHandler& DBHandler, const FString& InTask, const FString& InEpisode, const FString& InIndividual,
+	bool bSkeletal, bool bSinglePose, float InStartTime, float InEndTime, float InDeltaT, FSLVizQMarkerData& OutData)
+{
+	if (bSkeletal)
+	{
+		if (bSinglePose)
+		{
+			OutData.SkeletalPoses.Add(DBHandler.GetSkeletalIndividualPoseAtPooled(InTask, InEpisode, InIndividual,
+				InStartTime));
+		}
+		else
+		{
+			OutData.SkeletalPoses = DBHandler.GetSkeletalIndividualTrajectoryPooled(InTask, InEpisode, InIndividual,
+				InStartTime, InEndTime, InDeltaT);
+		}
+	}
+	else
+	{
+		if (bSinglePose)
+		{
+			OutData.Poses.Add(DBHandler.GetIndividualPoseAtPooled(InTask, InEpisode, InIndividual,
+				InStartTime));
+		}
+		else
+		{
+			OutData.Poses = DBHandler.GetIndividualTrajectoryPooled(InTask, InEpisode, InIndividual,
+				InStartTime, InEndTime, InDeltaT);
+		}
+	}
+}
+
+// Draw the marker from the fetched data
+void USLVizQMarker::DrawMarker(ASLVizManager* VizManager, const FSLVizQMarkerData& Data)
+{
+	/* Skeletal */
+	if (MeshType == ESLVizQMarkerMeshType::SkeletalMesh)
+	{
+		const TArray<TPair<FTransform, TMap<int32, FTransform>>>& SkeletalPoses = Data.SkeletalPoses;
 		if (SkeletalPoses.Num() == 0)
 		{
-			UE_LOG(LogTemp, Error, TEXT("%s::%d query resulted in 0 poses.. make sure %s is skeletal.."), *FString(__FUNCTION__), __LINE__);
+			UE_LOG(LogTemp, Error, TEXT("%s::%d query resulted in 0 poses.. make sure %s is skeletal.."), *FString(__FUNCTION__), __LINE__, *Individual);
 			return;
 		}
 
+		// More poses than instances are evenly subsampled
+		VizManager->SetSkeletalMarkerMaxNumInstances(MaxNumSkeletalInstances);
+
 		// Draw marker as static or timeline
 		if (Type != ESLVizQMarkerType::Timeline)
 		{
@@ -172,30 +269,10 @@ void USLVizQMarker::ExecuteImpl(ASLKnowrobManager* KRManager)
 			}
 		}		
 	}
-
 	/* Static mesh */
 	else
 	{
-		// Pose/trajectory data
-		TArray<FTransform> Poses;
-
-		// Read data as pose or trajectory
-		if (Type == ESLVizQMarkerType::Pose)
-		{
-			Poses.Add(MongoQueryManager->GetIndividualPoseAt(Task, Episode, Individual,
-				StartTime));
-		}
-		else if (EndTime > 0 && EndTime > StartTime)
-		{
-			Poses = MongoQueryManager->GetIndividualTrajectory(Task, Episode, Individual,
-				StartTime, EndTime, DeltaT);
-		}
-		else
-		{
-			UE_LOG(LogTemp, Error, TEXT("%s::%d EndTime is not valid.."), *FString(__FUNCTION__), __LINE__);
-			return;
-		}
-
+		const TArray<FTransform>& Poses = Data.Poses;
 		if (Poses.Num() == 0)
 		{
 			UE_LOG(LogTemp, Error, TEXT("%s::%d query resulted in 0 poses.."), *FString(__FUNCTION__), __LINE__);
@@ -205,7 +282,12 @@ void USLVizQMarker::ExecuteImpl(ASLKnowrobManager* KRManager)
 		// Draw marker as static or timeline
 		if (MeshType == ESLVizQMarkerMeshType::Primitive)
 		{
-			if (Type != ESLVizQMarkerType::Timeline)
+			if (Type == ESLVizQMarkerType::Trajectory && bUseLOD)
+			{
+				VizManager->CreatePrimitiveMarkerLOD(MarkerId, Poses, PrimitiveType, Size,
+					Color, MaterialType, LODParams);
+			}
+			else if (Type != ESLVizQMarkerType::Timeline)
 			{
 				VizManager->CreatePrimitiveMarker(MarkerId, Poses, PrimitiveType, Size,
 					Color, MaterialType);
@@ -225,6 +307,11 @@ void USLVizQMarker::ExecuteImpl(ASLKnowrobManager* KRManager)
 				{	
 					VizManager->CreateStaticMeshMarker(MarkerId, Poses, Individual);
 				}
+				else if (Type == ESLVizQMarkerType::Trajectory && bUseLOD)
+				{
+					VizManager->CreateStaticMeshMarkerLOD(MarkerId, Poses, Individual,
+						Color, MaterialType, LODParams);
+				}
 				else
 				{
 					VizManager->CreateStaticMeshMarker(MarkerId, Poses, Individual,
@@ -246,5 +333,17 @@ void USLVizQMarker::ExecuteImpl(ASLKnowrobManager* KRManager)
 				}
 			}
 		}
+		else if (MeshType == ESLVizQMarkerMeshType::TrajectoryMesh)
+		{
+			if (Type != ESLVizQMarkerType::Timeline)
+			{
+				VizManager->CreateTrajectoryMarker(MarkerId, Poses, TrajectoryParams, MaterialType);
+			}
+			else
+			{
+				VizManager->CreateTrajectoryMarkerTimeline(MarkerId, Poses, TrajectoryParams, MaterialType,
+					TimelineParams);
+			}
+		}
 	}
 }
@@ -6,6 +6,7 @@
 #include "Knowrob/SLKnowrobManager.h"
 #include "Mongo/SLMongoQueryManager.h"
 #include "Viz/SLVizManager.h"
+#include "Async/ParallelFor.h"
 
 #if WITH_EDITOR
 #include "Engine/Selection.h"
@@ -162,152 +163,246 @@ void USLVizQMarkerArray::PostEditChangeProperty(struct FPropertyChangedEvent& Pr
 // Virtual implementation of the execute function
 void USLVizQMarkerArray::ExecuteImpl(ASLKnowrobManager* KRManager)
 {
-	ASLVizManager* VizManager = KRManager->GetVizManager();
 	ASLMongoQueryManager* MongoQueryManager = KRManager->GetMongoQueryManager();
-
-	if (MarkerIds.Num() != Individuals.Num())
+	if (!IsValidQuery())
 	{
-		UE_LOG(LogTemp, Error, TEXT("%s::%d MarkerIds.Num() != Individuals.Num().."), *FString(__FUNCTION__), __LINE__);
 		return;
 	}
 
-	int32 ViewIdx = 0;
-	for (const auto& MarkerId : MarkerIds)
+	const bool bSkeletal = MeshType == ESLVizQMarkerArrayMeshType::SkeletalMesh;
+	const bool bSinglePose = Type == ESLVizQMarkerArrayType::Pose;
+	TArray<FSLVizQMarkerData> Data;
+	Data.SetNum(Individuals.Num());
+	for (int32 ViewIdx = 0; ViewIdx < Individuals.Num(); ++ViewIdx)
 	{
-		const FString Individual = Individuals[ViewIdx];
-		ViewIdx++;
+		const FString& Individual = Individuals[ViewIdx];
 
-		/* Skeletal */
-		if (MeshType == ESLVizQMarkerArrayMeshType::SkeletalMesh)
+		// Read data as pose or trajectory
+		if (bSkeletal)
 		{
-			// Pose/trajectory data
-			TArray<TPair<FTransform, TMap<int32, FTransform>>> SkeletalPoses;
-
-			// Read data as pose or trajectory
-			if (Type == ESLVizQMarkerArrayType::Pose)
+			if (bSinglePose)
 			{
-				SkeletalPoses.Add(MongoQueryManager->GetSkeletalIndividualPoseAt(Task, Episode, Individual,
+				Data[ViewIdx].SkeletalPoses.Add(MongoQueryManager->GetSkeletalIndividualPoseAt(Task, Episode, Individual,
 					StartTime));
 			}
-			else if (EndTime > 0 && EndTime > StartTime)
+			else
 			{
-				SkeletalPoses = MongoQueryManager->GetSkeletalIndividualTrajectory(Task, Episode, Individual,
+				Data[ViewIdx].SkeletalPoses = MongoQueryManager->GetSkeletalIndividualTrajectory(Task, Episode, Individual,
 					StartTime, EndTime, DeltaT);
 			}
+		}
+		else
+		{
+			if (bSinglePose)
+			{
+				Data[ViewIdx].Poses.Add(MongoQueryManager->GetIndividualPoseAt(Task, Episode, Individual,
+					StartTime));
+			}
 			else
 			{
-				UE_LOG(LogTemp, Error, TEXT("%s::%d EndTime is not valid.."), *FString(__FUNCTION__), __LINE__);
-				return;
+				Data[ViewIdx].Poses = MongoQueryManager->GetIndividualTrajectory(Task, Episode, Individual,
+					StartTime, EndTime, DeltaT);
 			}
+		}
+	}
 
-			if (SkeletalPoses.Num() == 0)
+	DrawMarkers(KRManager->GetVizManager(), Data);
+}
+
+// Returns the pose/trajectory fetch of all the markers (in parallel), the markers are drawn on the game thread
+FSLVizQFetchFunc USLVizQMarkerArray::CreateFetchTask(ASLKnowrobManager* KRManager)
+{
+	if (!IsValidQuery())
+	{
+		return nullptr;
+	}
+
+	TSharedPtr<const FSLMongoQueryDBHandler, ESPMode::ThreadSafe> DBHandler = KRManager->GetMongoQueryManager()->GetSharedDBHandler();
+	if (!DBHandler.IsValid())
+	{
+		return nullptr;
+	}
+	TWeakObjectPtr<USLVizQMarkerArray> WeakThis(this);
+	const bool bSkeletal = MeshType == ESLVizQMarkerArrayMeshType::SkeletalMesh;
+	const bool bSinglePose = Type == ESLVizQMarkerArrayType::Pose;
+	const FString TaskId = Task;
+	const FString EpisodeId = Episode;
+	const TArray<FString> IndividualIds = Individuals;
+	const float Start = StartTime;
+	const float End = EndTime;
+	const float Delta = DeltaT;
+	return [DBHandler, WeakThis, bSkeletal, bSinglePose, TaskId, EpisodeId, IndividualIds, Start, End, Delta]() -> FSLVizQApplyFunc
+	{
+		TArray<FSLVizQMarkerData> Data;
+		Data.SetNum(IndividualIds.Num());
+
+		// Every query uses its own pooled connection
+		ParallelFor(IndividualIds.Num(), [&](int32 ViewIdx)
+		{
+			USLVizQMarker::FetchDataThreadSafe(*DBHandler, TaskId, EpisodeId, IndividualIds[ViewIdx],
+				bSkeletal, bSinglePose, Start, End, Delta, Data[ViewIdx]);
+		});
+		return [WeakThis, Data](ASLKnowrobManager* KR)
+		{
+			if (USLVizQMarkerArray* MarkerArray = WeakThis.Get())
 			{
-				UE_LOG(LogTemp, Error, TEXT("%s::%d query resulted in 0 poses.. make sure %s is skeletal.."), *FString(__FUNCTION__), __LINE__);
-				return;
+				MarkerArray->DrawMarkers(KR->GetVizManager(), Data);
 			}
+		};
+	};
+}
 
-			// Draw marker as static or timeline
-			if (Type != ESLVizQMarkerArrayType::Timeline)
+// Check the marker ids and the time interval
+bool USLVizQMarkerArray::IsValidQuery() const
+{
+	if (MarkerIds.Num() != Individuals.Num())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d MarkerIds.Num() != Individuals.Num().."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	if (Type != ESLVizQMarkerArrayType::Pose && !(EndTime > 0 && EndTime > StartTime))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d EndTime is not valid.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+	return true;
+}
+
+// Draw the markers from the fetched data (one entry per individual)
+void USLVizQMarkerArray::DrawMarkers(ASLVizManager* VizManager, const TArray<FSLVizQMarkerData>& Data)
+{
+	if (Data.Num() != MarkerIds.Num() || Data.Num() != Individuals.Num())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Fetched data does not match the markers (changed during the fetch?).."), *FString(__FUNCTION__), __LINE__);
+		return;
+	}
+
+	for (int32 ViewIdx = 0; ViewIdx < MarkerIds.Num(); ++ViewIdx)
+	{
+		DrawMarker(VizManager, MarkerIds[ViewIdx], Individuals[ViewIdx], Data[ViewIdx]);
+	}
+}
+
+// Draw the marker of the individual
+void USLVizQMarkerArray::DrawMarker(ASLVizManager* VizManager, const FString& MarkerId, const FString& Individual, const FSLVizQMarkerData& Data)
+{
+	/* Skeletal */
+	if (MeshType == ESLVizQMarkerArrayMeshType::SkeletalMesh)
+	{
+		const TArray<TPair<FTransform, TMap<int32, FTransform>>>& SkeletalPoses = Data.SkeletalPoses;
+		if (SkeletalPoses.Num() == 0)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d query resulted in 0 poses.. make sure %s is skeletal.."), *FString(__FUNCTION__), __LINE__, *Individual);
+			return;
+		}
+
+		// More poses than instances are evenly subsampled
+		VizManager->SetSkeletalMarkerMaxNumInstances(MaxNumSkeletalInstances);
+
+		// Draw marker as static or timeline
+		if (Type != ESLVizQMarkerArrayType::Timeline)
+		{
+			if (bUseOriginalColor)
 			{
-				if (bUseOriginalColor)
-				{
-					VizManager->CreateSkeletalMeshMarker(MarkerId, SkeletalPoses, Individual);
-				}
-				else
-				{
-					VizManager->CreateSkeletalMeshMarker(MarkerId, SkeletalPoses, Individual,
-						Color, MaterialType);
-				}
+				VizManager->CreateSkeletalMeshMarker(MarkerId, SkeletalPoses, Individual);
 			}
 			else
 			{
-				if (bUseOriginalColor)
-				{
-					VizManager->CreateSkeletalMeshMarkerTimeline(MarkerId, SkeletalPoses, Individual,
-						TimelineParams);
-				}
-				else
-				{
-					VizManager->CreateSkeletalMeshMarkerTimeline(MarkerId, SkeletalPoses, Individual,
-						Color, MaterialType,
-						TimelineParams);
-				}
+				VizManager->CreateSkeletalMeshMarker(MarkerId, SkeletalPoses, Individual,
+					Color, MaterialType);
 			}
 		}
-
-		/* Static mesh */
 		else
 		{
-			// Pose/trajectory data
-			TArray<FTransform> Poses;
-
-			// Read data as pose or trajectory
-			if (Type == ESLVizQMarkerArrayType::Pose)
+			if (bUseOriginalColor)
 			{
-				Poses.Add(MongoQueryManager->GetIndividualPoseAt(Task, Episode, Individual,
-					StartTime));
-			}
-			else if (EndTime > 0 && EndTime > StartTime)
-			{
-				Poses = MongoQueryManager->GetIndividualTrajectory(Task, Episode, Individual,
-					StartTime, EndTime, DeltaT);
+				VizManager->CreateSkeletalMeshMarkerTimeline(MarkerId, SkeletalPoses, Individual,
+					TimelineParams);
 			}
 			else
 			{
-				UE_LOG(LogTemp, Error, TEXT("%s::%d EndTime is not valid.."), *FString(__FUNCTION__), __LINE__);
-				return;
+				VizManager->CreateSkeletalMeshMarkerTimeline(MarkerId, SkeletalPoses, Individual,
+					Color, MaterialType,
+					TimelineParams);
 			}
+		}
+	}
+	/* Static mesh */
+	else
+	{
+		const TArray<FTransform>& Poses = Data.Poses;
+		if (Poses.Num() == 0)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d query resulted in 0 poses.."), *FString(__FUNCTION__), __LINE__);
+			return;
+		}
 
-			if (Poses.Num() == 0)
+		// Draw marker as static or timeline
+		if (MeshType == ESLVizQMarkerArrayMeshType::Primitive)
+		{
+			if (Type == ESLVizQMarkerArrayType::Trajectory && bUseLOD)
 			{
-				UE_LOG(LogTemp, Error, TEXT("%s::%d query resulted in 0 poses.."), *FString(__FUNCTION__), __LINE__);
-				return;
+				VizManager->CreatePrimitiveMarkerLOD(MarkerId, Poses, PrimitiveType, Size,
+					Color, MaterialType, LODParams);
 			}
-
-			// Draw marker as static or timeline
-			if (MeshType == ESLVizQMarkerArrayMeshType::Primitive)
+			else if (Type != ESLVizQMarkerArrayType::Timeline)
 			{
-				if (Type != ESLVizQMarkerArrayType::Timeline)
+				VizManager->CreatePrimitiveMarker(MarkerId, Poses, PrimitiveType, Size,
+					Color, MaterialType);
+			}
+			else
+			{
+				VizManager->CreatePrimitiveMarkerTimeline(MarkerId, Poses, PrimitiveType,
+					Size, Color, MaterialType,
+					TimelineParams);
+			}
+		}
+		else if (MeshType == ESLVizQMarkerArrayMeshType::StaticMesh)
+		{
+			if (Type != ESLVizQMarkerArrayType::Timeline)
+			{
+				if (bUseOriginalColor)
 				{
-					VizManager->CreatePrimitiveMarker(MarkerId, Poses, PrimitiveType, Size,
-						Color, MaterialType);
+					VizManager->CreateStaticMeshMarker(MarkerId, Poses, Individual);
+				}
+				else if (Type == ESLVizQMarkerArrayType::Trajectory && bUseLOD)
+				{
+					VizManager->CreateStaticMeshMarkerLOD(MarkerId, Poses, Individual,
+						Color, MaterialType, LODParams);
 				}
 				else
 				{
-					VizManager->CreatePrimitiveMarkerTimeline(MarkerId, Poses, PrimitiveType,
-						Size, Color, MaterialType,
-						TimelineParams);
+					VizManager->CreateStaticMeshMarker(MarkerId, Poses, Individual,
+						Color, MaterialType);
 				}
 			}
-			else if (MeshType == ESLVizQMarkerArrayMeshType::StaticMesh)
+			else
 			{
-				if (Type != ESLVizQMarkerArrayType::Timeline)
+				if (bUseOriginalColor)
 				{
-					if (bUseOriginalColor)
-					{
-						VizManager->CreateStaticMeshMarker(MarkerId, Poses, Individual);
-					}
-					else
-					{
-						VizManager->CreateStaticMeshMarker(MarkerId, Poses, Individual,
-							Color, MaterialType);
-					}
+					VizManager->CreateStaticMeshMarkerTimeline(MarkerId, Poses, Individual,
+						TimelineParams);
 				}
 				else
 				{
-					if (bUseOriginalColor)
-					{
-						VizManager->CreateStaticMeshMarkerTimeline(MarkerId, Poses, Individual,
-							TimelineParams);
-					}
-					else
-					{
-						VizManager->CreateStaticMeshMarkerTimeline(MarkerId, Poses, Individual,
-							Color, MaterialType,
-							TimelineParams);
-					}
+					VizManager->CreateStaticMeshMarkerTimeline(MarkerId, Poses, Individual,
+						Color, MaterialType,
+						TimelineParams);
 				}
 			}
 		}
+		else if (MeshType == ESLVizQMarkerArrayMeshType::TrajectoryMesh)
+		{
+			if (Type != ESLVizQMarkerArrayType::Timeline)
+			{
+				VizManager->CreateTrajectoryMarker(MarkerId, Poses, TrajectoryParams, MaterialType);
+			}
+			else
+			{
+				VizManager->CreateTrajectoryMarkerTimeline(MarkerId, Poses, TrajectoryParams, MaterialType,
+					TimelineParams);
+			}
+		}
 	}
 }
@@ -5,6 +5,7 @@
 #include "Knowrob/SLKnowrobManager.h"
 #include "Mongo/SLMongoQueryManager.h"
 #include "Viz/SLVizManager.h"
+#include "VizQ/SLVizQCacheEpisodes.h"
 
 #if WITH_EDITOR
 // Called when a property is changed in the editor
@@ -31,6 +32,16 @@ void USLVizQReplay::PostEditChangeProperty(struct FPropertyChangedEvent& Propert
 			KnowrobManager->GetVizManager()->StopReplay();
 		}
 	}
+	else if (PropertyName == GET_MEMBER_NAME_CHECKED(USLVizQReplay, Speed))
+	{
+		if (bLiveUpdate && Type == ESLVizQReplayType::Replay)
+		{
+			if (IsReadyForManualExecution())
+			{
+				KnowrobManager->GetVizManager()->SetReplaySpeed(Speed);
+			}
+		}
+	}
 	else if (PropertyName == GET_MEMBER_NAME_CHECKED(USLVizQReplay, StartTime))
 	{
 		if (bLiveUpdate && Type == ESLVizQReplayType::Goto)
@@ -50,8 +61,36 @@ void USLVizQReplay::ExecuteImpl(ASLKnowrobManager* KRManager)
 	ASLVizManager* VizManager = KRManager->GetVizManager();
 	ASLMongoQueryManager* MongoQueryManager = KRManager->GetMongoQueryManager();
 
-	// Retrieve and cache episode
-	if (!VizManager->IsEpisodeCached(Episode))
+	// Episode is being cached in the background, execute once it is ready
+	if (VizManager->IsEpisodeBeingCached(Episode))
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d Waiting for episode %s::%s to be cached .."),
+			*FString(__FUNCTION__), __LINE__, *Task, *Episode);
+		TSharedRef<FDelegateHandle> Handle = MakeShared<FDelegateHandle>();
+		*Handle = VizManager->OnEpisodeCached.AddWeakLambda(this, [this, VizManager, Handle](const FString& Id, bool bSuccess)
+		{
+			if (!Id.Equals(Episode))
+			{
+				return;
+			}
+			VizManager->OnEpisodeCached.Remove(*Handle);
+			if (bSuccess)
+			{
+				ExecuteOnCachedEpisode(VizManager);
+			}
+			else
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s::%d Could not cache episode %s::%s, execution aborted .."),
+					*FString(__FUNCTION__), __LINE__, *Task, *Episode);
+			}
+		});
+		return;
+	}
+
+	// Retrieve and cache episode (from the disk cache if it is up to date with the database)
+	FSLMongoEpisodeMetadata Metadata;
+	if (!VizManager->IsEpisodeCached(Episode)
+		&& !(MongoQueryManager->GetEpisodeMetadata(Task, Episode, Metadata) && VizManager->CacheEpisodeDataFromDisk(Task, Episode, Metadata)))
 	{
 		UE_LOG(LogTemp, Log, TEXT("%s::%d Collecting episode %s::%s .."),
 			*FString(__FUNCTION__), __LINE__, *Task, *Episode);
@@ -62,9 +101,26 @@ void USLVizQReplay::ExecuteImpl(ASLKnowrobManager* KRManager)
 				*FString(__FUNCTION__), __LINE__, *Task, *Episode);
 			return;
 		}
+		VizManager->WriteEpisodeDataToDisk(Task, Episode, Metadata);
 	}
 
-	// Execute task
+	ExecuteOnCachedEpisode(VizManager);
+}
+
+// Start caching the episode in the background as soon as the query tree is scheduled (the replay waits for it)
+bool USLVizQReplay::PreDispatch(ASLKnowrobManager* KRManager)
+{
+	ASLVizManager* VizManager = KRManager->GetVizManager();
+	if (!VizManager->IsEpisodeCached(Episode) && !VizManager->IsEpisodeBeingCached(Episode))
+	{
+		USLVizQCacheEpisodes::CacheEpisodeAsync(KRManager, Task, Episode);
+	}
+	return false;
+}
+
+// Goto or replay the cached episode
+void USLVizQReplay::ExecuteOnCachedEpisode(ASLVizManager* VizManager)
+{
 	if (Type == ESLVizQReplayType::Goto)
 	{
 		VizManager->GotoCachedEpisodeFrame(Episode, StartTime);		
@@ -77,6 +133,9 @@ void USLVizQReplay::ExecuteImpl(ASLKnowrobManager* KRManager)
 		Params.bLoop = bLoop;
 		Params.UpdateRate = UpdateRate;
 		Params.StepSize = StepSize;
+		Params.Speed = Speed;
+		Params.bInterpolate = bInterpolate;
+		Params.bFixedStep = bFixedStep;
 		VizManager->ReplayCachedEpisode(Episode, Params);
 	}
 }
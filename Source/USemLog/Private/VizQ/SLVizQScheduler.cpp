@@ -0,0 +1,195 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "VizQ/SLVizQScheduler.h"
+#include "VizQ/SLVizQBase.h"
+#include "Knowrob/SLKnowrobManager.h"
+#include "Async/Async.h"
+
+// Set the knowrob manager used for the execution
+void FSLVizQScheduler::Init(ASLKnowrobManager* InKRManager)
+{
+	KRManager = InKRManager;
+}
+
+// Schedule the query tree, returns false if nothing could be scheduled
+bool FSLVizQScheduler::Execute(USLVizQBase* Root)
+{
+	ASLKnowrobManager* KR = KRManager.Get();
+	if (!USLVizQBase::IsKRManagerValid(KR))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Knowrob manager is not valid/init, aborting execution.."),
+			*FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	TArray<USLVizQBase*> Order;
+	TSet<USLVizQBase*> Visited;
+	FlattenTree(Root, Order, Visited);
+	if (Order.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Nothing to execute.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	// The batch is added before the fetches start, their results are only processed on the game thread
+	FSLVizQScheduledBatch& Batch = Batches.AddDefaulted_GetRef();
+	Batch.Id = NextBatchId++;
+	Batch.ScheduleTime = FPlatformTime::Seconds();
+	const int32 BatchId = Batch.Id;
+
+	TArray<TPair<int32, FSLVizQFetchFunc>> FetchTasks;
+	for (USLVizQBase* Query : Order)
+	{
+		if (Query->PreDispatch(KR))
+		{
+			continue;
+		}
+
+		const int32 CommandIdx = Batch.Commands.Add(Query);
+		if (FSLVizQFetchFunc FetchFunc = Query->CreateFetchTask(KR))
+		{
+			FetchTasks.Emplace(CommandIdx, MoveTemp(FetchFunc));
+		}
+	}
+	Batch.ApplyFuncs.SetNum(Batch.Commands.Num());
+	Batch.NumPendingFetches = FetchTasks.Num();
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Scheduled batch %d with %d commands and %d background fetches.."),
+		*FString(__FUNCTION__), __LINE__, BatchId, Batch.Commands.Num(), FetchTasks.Num());
+
+	RunningFetches.RemoveAll([](const TFuture<void>& Fetch) { return Fetch.IsReady(); });
+	TWeakPtr<FSLVizQScheduler, ESPMode::ThreadSafe> WeakThis = AsShared();
+	for (auto& FetchTask : FetchTasks)
+	{
+		const int32 CommandIdx = FetchTask.Key;
+		RunningFetches.Add(Async(EAsyncExecution::TaskGraph, [WeakThis, BatchId, CommandIdx, FetchFunc = MoveTemp(FetchTask.Value)]()
+		{
+			FSLVizQApplyFunc ApplyFunc = FetchFunc();
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, BatchId, CommandIdx, ApplyFunc = MoveTemp(ApplyFunc)]() mutable
+			{
+				if (TSharedPtr<FSLVizQScheduler, ESPMode::ThreadSafe> Scheduler = WeakThis.Pin())
+				{
+					Scheduler->OnFetchDone(BatchId, CommandIdx, MoveTemp(ApplyFunc));
+				}
+			});
+		}));
+	}
+
+	// Without any fetches the batch can be applied right away
+	ApplyReadyBatches();
+	return true;
+}
+
+// Wait for the running fetches and drop the scheduled batches (the fetched results are ignored)
+void FSLVizQScheduler::Reset()
+{
+	// The fetches never wait on the game thread, blocking here cannot deadlock
+	for (TFuture<void>& Fetch : RunningFetches)
+	{
+		Fetch.Wait();
+	}
+	RunningFetches.Empty();
+	Batches.Empty();
+}
+
+// Flatten the tree into execution order (ignored commands and their children are skipped)
+void FSLVizQScheduler::FlattenTree(USLVizQBase* Query, TArray<USLVizQBase*>& OutOrder, TSet<USLVizQBase*>& Visited)
+{
+	if (!Query || !Query->IsValidLowLevel())
+	{
+		return;
+	}
+
+	if (Query->bIgnore)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is set to be ignored, skipping execution.."),
+			*FString(__FUNCTION__), __LINE__, *Query->GetName());
+		return;
+	}
+
+	bool bAlreadyVisited = false;
+	Visited.Add(Query, &bAlreadyVisited);
+	if (bAlreadyVisited)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d %s is referenced in a cycle, skipping repeated execution.."),
+			*FString(__FUNCTION__), __LINE__, *Query->GetName());
+		return;
+	}
+
+	if (Query->bExecuteChildrenFirst)
+	{
+		for (const auto C : Query->Children)
+		{
+			FlattenTree(C, OutOrder, Visited);
+		}
+		OutOrder.Add(Query);
+	}
+	else
+	{
+		OutOrder.Add(Query);
+		for (const auto C : Query->Children)
+		{
+			FlattenTree(C, OutOrder, Visited);
+		}
+	}
+
+	// Siblings can reference the same command, only cycles are not allowed
+	Visited.Remove(Query);
+}
+
+// Called on the game thread when a background fetch of the batch finished
+void FSLVizQScheduler::OnFetchDone(int32 BatchId, int32 CommandIdx, FSLVizQApplyFunc&& ApplyFunc)
+{
+	FSLVizQScheduledBatch* Batch = Batches.FindByPredicate(
+		[BatchId](const FSLVizQScheduledBatch& B) { return B.Id == BatchId; });
+	if (!Batch)
+	{
+		// Batch was reset in the meantime
+		return;
+	}
+
+	Batch->ApplyFuncs[CommandIdx] = MoveTemp(ApplyFunc);
+	Batch->NumPendingFetches--;
+	ApplyReadyBatches();
+}
+
+// Apply the scene changes of the finished batches (in schedule order)
+void FSLVizQScheduler::ApplyReadyBatches()
+{
+	while (Batches.Num() > 0 && Batches[0].NumPendingFetches == 0)
+	{
+		FSLVizQScheduledBatch Batch = MoveTemp(Batches[0]);
+		Batches.RemoveAt(0);
+
+		ASLKnowrobManager* KR = KRManager.Get();
+		if (!USLVizQBase::IsKRManagerValid(KR))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Knowrob manager is not valid/init anymore, dropping batch %d.."),
+				*FString(__FUNCTION__), __LINE__, Batch.Id);
+			continue;
+		}
+
+		const double FetchDuration = FPlatformTime::Seconds() - Batch.ScheduleTime;
+		for (int32 CommandIdx = 0; CommandIdx < Batch.Commands.Num(); ++CommandIdx)
+		{
+			USLVizQBase* Query = Batch.Commands[CommandIdx].Get();
+			if (!Query)
+			{
+				continue;
+			}
+
+			if (Batch.ApplyFuncs[CommandIdx])
+			{
+				Batch.ApplyFuncs[CommandIdx](KR);
+			}
+			else
+			{
+				Query->ExecuteImpl(KR);
+			}
+		}
+		UE_LOG(LogTemp, Log, TEXT("%s::%d Applied batch %d (fetch=[%f], apply=[%f] seconds).."),
+			*FString(__FUNCTION__), __LINE__, Batch.Id, FetchDuration,
+			FPlatformTime::Seconds() - Batch.ScheduleTime - FetchDuration);
+	}
+}
@@ -87,8 +87,20 @@ void USLVizQSemMap::ExecuteImpl(ASLKnowrobManager* KRManager)
 	{
 		KRManager->GetVizSemMapManager()->SetAllIndividualsHidden(bHide);
 	}
+	else if (bAllExcept)
+	{
+		KRManager->GetVizSemMapManager()->SetAllIndividualsHiddenExcept(Ids, Classes, Types, bHide);
+	}
 	else
 	{
 		KRManager->GetVizSemMapManager()->SetIndividualsHidden(Ids, bHide, bIterate, IterateInterval);
+		if (Classes.Num() > 0)
+		{
+			KRManager->GetVizSemMapManager()->SetClassesHidden(Classes, bHide);
+		}
+		if (Types.Num() > 0)
+		{
+			KRManager->GetVizSemMapManager()->SetTypesHidden(Types, bHide);
+		}
 	}
 }
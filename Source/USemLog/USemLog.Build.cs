@@ -69,6 +69,8 @@ public class USemLog : ModuleRules
 				"Landscape",
 				"WebSockets",
 				"CinematicCamera",
+				"ProceduralMeshComponent",	// trajectory markers
+				"MeshDescription", "StaticMeshDescription",	// bone mesh markers (runtime static meshes)
 				//"Landscape", "AIModule",	// whitelisted actors when setting the world to visual only
 				//"UConversions",				// SL_WITH_ROS_CONVERSIONS
 				"UMCGrasp",					// SL_WITH_MC_GRASP